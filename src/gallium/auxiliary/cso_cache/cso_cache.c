@@ -30,6 +30,7 @@
 
 #include "util/u_debug.h"
 
+#include "util/u_math.h"
 #include "util/u_memory.h"
 
 #include "cso_cache.h"
@@ -42,6 +43,11 @@ struct cso_cache {
 
    cso_sanitize_callback sanitize_cb;
    void                 *sanitize_data;
+
+   /** Incremented on every lookup, to timestamp entries for LRU eviction */
+   uint64_t lookups;
+
+   struct cso_cache_stats stats[CSO_CACHE_MAX];
 };
 
 #if 1
@@ -87,6 +93,73 @@ static INLINE struct cso_hash *_cso_hash_for_type(struct cso_cache *sc, enum cso
    return hash;
 }
 
+static INLINE uint64_t *cso_last_used(void *state, enum cso_cache_type type)
+{
+   switch (type) {
+   case CSO_BLEND:
+      return &((struct cso_blend *)state)->last_used;
+   case CSO_SAMPLER:
+      return &((struct cso_sampler *)state)->last_used;
+   case CSO_DEPTH_STENCIL_ALPHA:
+      return &((struct cso_depth_stencil_alpha *)state)->last_used;
+   case CSO_RASTERIZER:
+      return &((struct cso_rasterizer *)state)->last_used;
+   case CSO_VELEMENTS:
+      return &((struct cso_velements *)state)->last_used;
+   default:
+      assert(0);
+      return NULL;
+   }
+}
+
+uint64_t cso_cache_entry_last_used(void *state, enum cso_cache_type type)
+{
+   return *cso_last_used(state, type);
+}
+
+static int compare_stamps(const void *a, const void *b)
+{
+   uint64_t ua = *(const uint64_t *)a;
+   uint64_t ub = *(const uint64_t *)b;
+   return ua < ub ? -1 : ua > ub;
+}
+
+/**
+ * Return the last_used stamp such that at least count entries of the hash
+ * were last used at or before it.  Sanitize callbacks use this to remove the
+ * least recently used entries first.
+ */
+uint64_t cso_cache_lru_threshold(struct cso_hash *hash,
+                                 enum cso_cache_type type,
+                                 int count)
+{
+   int size = cso_hash_size(hash);
+   struct cso_hash_iter iter;
+   uint64_t *stamps;
+   uint64_t threshold;
+   int i = 0;
+
+   if (count <= 0 || !size)
+      return 0;
+
+   stamps = MALLOC(size * sizeof *stamps);
+   if (!stamps)
+      return ~(uint64_t) 0;
+
+   iter = cso_hash_first_node(hash);
+   while (!cso_hash_iter_is_null(iter)) {
+      stamps[i++] = cso_cache_entry_last_used(cso_hash_iter_data(iter), type);
+      iter = cso_hash_iter_next(iter);
+   }
+   assert(i == size);
+
+   qsort(stamps, size, sizeof *stamps, compare_stamps);
+   threshold = stamps[MIN2(count, size) - 1];
+
+   FREE(stamps);
+   return threshold;
+}
+
 static void delete_blend_state(void *state, void *data)
 {
    struct cso_blend *cso = (struct cso_blend *)state;
@@ -157,8 +230,11 @@ static INLINE void sanitize_hash(struct cso_cache *sc,
                                  enum cso_cache_type type,
                                  int max_size)
 {
-   if (sc->sanitize_cb)
+   if (sc->sanitize_cb) {
+      int size = cso_hash_size(hash);
       sc->sanitize_cb(hash, type, max_size, sc->sanitize_data);
+      sc->stats[type].evictions += size - cso_hash_size(hash);
+   }
 }
 
 
@@ -170,15 +246,20 @@ static INLINE void sanitize_cb(struct cso_hash *hash, enum cso_cache_type type,
    int hash_size = cso_hash_size(hash);
    int max_entries = (max_size > hash_size) ? max_size : hash_size;
    int to_remove =  (max_size < max_entries) * max_entries/4;
+   struct cso_hash_iter iter = cso_hash_first_node(hash);
+   uint64_t threshold;
    if (hash_size > max_size)
       to_remove += hash_size - max_size;
-   while (to_remove) {
-      /*remove elements until we're good */
-      /*fixme: currently we pick the nodes to remove at random*/
-      struct cso_hash_iter iter = cso_hash_first_node(hash);
-      void  *cso = cso_hash_take(hash, cso_hash_iter_key(iter));
-      delete_cso(cso, type);
-      --to_remove;
+   threshold = cso_cache_lru_threshold(hash, type, to_remove);
+   while (to_remove && !cso_hash_iter_is_null(iter)) {
+      /* remove the least recently used elements until we're good */
+      void *cso = cso_hash_iter_data(iter);
+      if (cso_cache_entry_last_used(cso, type) <= threshold) {
+         iter = cso_hash_erase(hash, iter);
+         delete_cso(cso, type);
+         --to_remove;
+      } else
+         iter = cso_hash_iter_next(iter);
    }
 }
 
@@ -190,9 +271,20 @@ cso_insert_state(struct cso_cache *sc,
    struct cso_hash *hash = _cso_hash_for_type(sc, type);
    sanitize_hash(sc, hash, type, sc->max_size);
 
+   *cso_last_used(state, type) = ++sc->lookups;
+
    return cso_hash_insert(hash, hash_key, state);
 }
 
+/**
+ * Mark a state as just used, when it was found without a lookup.
+ */
+void cso_cache_touch(struct cso_cache *sc, void *state,
+                     enum cso_cache_type type)
+{
+   *cso_last_used(state, type) = ++sc->lookups;
+}
+
 struct cso_hash_iter
 cso_find_state(struct cso_cache *sc,
                unsigned hash_key, enum cso_cache_type type)
@@ -229,10 +321,14 @@ struct cso_hash_iter cso_find_state_template(struct cso_cache *sc,
    struct cso_hash_iter iter = cso_find_state(sc, hash_key, type);
    while (!cso_hash_iter_is_null(iter)) {
       void *iter_data = cso_hash_iter_data(iter);
-      if (!memcmp(iter_data, templ, size))
+      if (!memcmp(iter_data, templ, size)) {
+         *cso_last_used(iter_data, type) = ++sc->lookups;
+         sc->stats[type].hits++;
          return iter;
+      }
       iter = cso_hash_iter_next(iter);
    }
+   sc->stats[type].misses++;
    return iter;
 }
 
@@ -257,6 +353,9 @@ struct cso_cache *cso_cache_create(void)
    sc->sanitize_cb        = sanitize_cb;
    sc->sanitize_data      = 0;
 
+   sc->lookups            = 0;
+   memset(sc->stats, 0, sizeof sc->stats);
+
    return sc;
 }
 
@@ -320,3 +419,9 @@ void cso_cache_set_sanitize_callback(struct cso_cache *sc,
    sc->sanitize_data = user_data;
 }
 
+void cso_cache_get_stats(const struct cso_cache *sc,
+                         enum cso_cache_type type,
+                         struct cso_cache_stats *stats)
+{
+   *stats = sc->stats[type];
+}
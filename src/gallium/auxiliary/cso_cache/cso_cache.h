@@ -108,6 +108,8 @@ struct cso_blend {
    void *data;
    cso_state_callback delete_state;
    struct pipe_context *context;
+   /** Cache lookup count when last found, for LRU eviction */
+   uint64_t last_used;
 };
 
 struct cso_depth_stencil_alpha {
@@ -115,6 +117,7 @@ struct cso_depth_stencil_alpha {
    void *data;
    cso_state_callback delete_state;
    struct pipe_context *context;
+   uint64_t last_used;
 };
 
 struct cso_rasterizer {
@@ -122,6 +125,7 @@ struct cso_rasterizer {
    void *data;
    cso_state_callback delete_state;
    struct pipe_context *context;
+   uint64_t last_used;
 };
 
 struct cso_sampler {
@@ -129,6 +133,7 @@ struct cso_sampler {
    void *data;
    cso_state_callback delete_state;
    struct pipe_context *context;
+   uint64_t last_used;
 };
 
 struct cso_velems_state {
@@ -141,6 +146,13 @@ struct cso_velements {
    void *data;
    cso_state_callback delete_state;
    struct pipe_context *context;
+   uint64_t last_used;
+};
+
+struct cso_cache_stats {
+   unsigned hits;
+   unsigned misses;
+   unsigned evictions;
 };
 
 unsigned cso_construct_key(void *item, int item_size);
@@ -168,6 +180,17 @@ void * cso_take_state(struct cso_cache *sc, unsigned hash_key,
 void cso_set_maximum_cache_size(struct cso_cache *sc, int number);
 int cso_maximum_cache_size(const struct cso_cache *sc);
 
+uint64_t cso_cache_lru_threshold(struct cso_hash *hash,
+                                 enum cso_cache_type type,
+                                 int count);
+uint64_t cso_cache_entry_last_used(void *state, enum cso_cache_type type);
+void cso_cache_touch(struct cso_cache *sc, void *state,
+                     enum cso_cache_type type);
+
+void cso_cache_get_stats(const struct cso_cache *sc,
+                         enum cso_cache_type type,
+                         struct cso_cache_stats *stats);
+
 #ifdef	__cplusplus
 }
 #endif
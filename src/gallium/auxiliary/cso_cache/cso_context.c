@@ -72,6 +72,9 @@ struct sampler_info
 
    struct pipe_sampler_view *views_saved[PIPE_MAX_SAMPLERS];
    unsigned nr_views_saved;
+
+   /** Last CSO found for each sampler slot, see cso_context::blend_cso */
+   struct cso_sampler *cso[PIPE_MAX_SAMPLERS];
 };
 
 
@@ -109,6 +112,16 @@ struct cso_context {
    struct pipe_query *render_condition, *render_condition_saved;
    uint render_condition_mode, render_condition_mode_saved;
 
+   /** The last CSOs found in the cache.
+    * State trackers tend to set the same state over and over, so comparing
+    * against these first saves hashing the template and searching the cache.
+    * Cleared when the CSO is evicted.
+    */
+   struct cso_blend *blend_cso;
+   struct cso_depth_stencil_alpha *depth_stencil_cso;
+   struct cso_rasterizer *rasterizer_cso;
+   struct cso_velements *velements_cso;
+
    struct pipe_clip_state clip;
    struct pipe_clip_state clip_saved;
 
@@ -127,6 +140,9 @@ static boolean delete_blend_state(struct cso_context *ctx, void *state)
    if (ctx->blend == cso->data)
       return FALSE;
 
+   if (ctx->blend_cso == cso)
+      ctx->blend_cso = NULL;
+
    if (cso->delete_state)
       cso->delete_state(cso->context, cso->data);
    FREE(state);
@@ -141,6 +157,9 @@ static boolean delete_depth_stencil_state(struct cso_context *ctx, void *state)
    if (ctx->depth_stencil == cso->data)
       return FALSE;
 
+   if (ctx->depth_stencil_cso == cso)
+      ctx->depth_stencil_cso = NULL;
+
    if (cso->delete_state)
       cso->delete_state(cso->context, cso->data);
    FREE(state);
@@ -151,6 +170,27 @@ static boolean delete_depth_stencil_state(struct cso_context *ctx, void *state)
 static boolean delete_sampler_state(struct cso_context *ctx, void *state)
 {
    struct cso_sampler *cso = (struct cso_sampler *)state;
+   unsigned shader, i;
+
+   /* Keep samplers which are bound, about to be, or saved */
+   for (shader = 0; shader < PIPE_SHADER_TYPES; shader++) {
+      struct sampler_info *info = &ctx->samplers[shader];
+
+      for (i = 0; i < PIPE_MAX_SAMPLERS; i++) {
+         if (info->samplers[i] == cso->data ||
+             info->hw.samplers[i] == cso->data ||
+             info->samplers_saved[i] == cso->data)
+            return FALSE;
+      }
+   }
+
+   for (shader = 0; shader < PIPE_SHADER_TYPES; shader++) {
+      for (i = 0; i < PIPE_MAX_SAMPLERS; i++) {
+         if (ctx->samplers[shader].cso[i] == cso)
+            ctx->samplers[shader].cso[i] = NULL;
+      }
+   }
+
    if (cso->delete_state)
       cso->delete_state(cso->context, cso->data);
    FREE(state);
@@ -163,6 +203,8 @@ static boolean delete_rasterizer_state(struct cso_context *ctx, void *state)
 
    if (ctx->rasterizer == cso->data)
       return FALSE;
+   if (ctx->rasterizer_cso == cso)
+      ctx->rasterizer_cso = NULL;
    if (cso->delete_state)
       cso->delete_state(cso->context, cso->data);
    FREE(state);
@@ -177,6 +219,9 @@ static boolean delete_vertex_elements(struct cso_context *ctx,
    if (ctx->velements == cso->data)
       return FALSE;
 
+   if (ctx->velements_cso == cso)
+      ctx->velements_cso = NULL;
+
    if (cso->delete_state)
       cso->delete_state(cso->context, cso->data);
    FREE(state);
@@ -216,13 +261,16 @@ sanitize_hash(struct cso_hash *hash, enum cso_cache_type type,
    int max_entries = (max_size > hash_size) ? max_size : hash_size;
    int to_remove =  (max_size < max_entries) * max_entries/4;
    struct cso_hash_iter iter = cso_hash_first_node(hash);
+   uint64_t threshold;
    if (hash_size > max_size)
       to_remove += hash_size - max_size;
-   while (to_remove) {
-      /*remove elements until we're good */
-      /*fixme: currently we pick the nodes to remove at random*/
+   threshold = cso_cache_lru_threshold(hash, type, to_remove);
+   while (to_remove && !cso_hash_iter_is_null(iter)) {
+      /* remove the least recently used elements until we're good, skipping
+       * the bound ones */
       void *cso = cso_hash_iter_data(iter);
-      if (delete_cso(ctx, cso, type)) {
+      if (cso_cache_entry_last_used(cso, type) <= threshold &&
+          delete_cso(ctx, cso, type)) {
          iter = cso_hash_erase(hash, iter);
          --to_remove;
       } else
@@ -375,31 +423,38 @@ enum pipe_error cso_set_blend(struct cso_context *ctx,
    key_size = templ->independent_blend_enable ?
       sizeof(struct pipe_blend_state) :
       (char *)&(templ->rt[1]) - (char *)templ;
-   hash_key = cso_construct_key((void*)templ, key_size);
-   iter = cso_find_state_template(ctx->cache, hash_key, CSO_BLEND,
-                                  (void*)templ, key_size);
-
-   if (cso_hash_iter_is_null(iter)) {
-      struct cso_blend *cso = MALLOC(sizeof(struct cso_blend));
-      if (!cso)
-         return PIPE_ERROR_OUT_OF_MEMORY;
-
-      memset(&cso->state, 0, sizeof cso->state);
-      memcpy(&cso->state, templ, key_size);
-      cso->data = ctx->pipe->create_blend_state(ctx->pipe, &cso->state);
-      cso->delete_state = (cso_state_callback)ctx->pipe->delete_blend_state;
-      cso->context = ctx->pipe;
-
-      iter = cso_insert_state(ctx->cache, hash_key, CSO_BLEND, cso);
-      if (cso_hash_iter_is_null(iter)) {
-         FREE(cso);
-         return PIPE_ERROR_OUT_OF_MEMORY;
-      }
 
-      handle = cso->data;
+   if (ctx->blend_cso &&
+       !memcmp(&ctx->blend_cso->state, templ, key_size)) {
+      handle = ctx->blend_cso->data;
+      cso_cache_touch(ctx->cache, ctx->blend_cso, CSO_BLEND);
    }
    else {
-      handle = ((struct cso_blend *)cso_hash_iter_data(iter))->data;
+      hash_key = cso_construct_key((void*)templ, key_size);
+      iter = cso_find_state_template(ctx->cache, hash_key, CSO_BLEND,
+                                     (void*)templ, key_size);
+
+      if (cso_hash_iter_is_null(iter)) {
+         struct cso_blend *cso = MALLOC(sizeof(struct cso_blend));
+         if (!cso)
+            return PIPE_ERROR_OUT_OF_MEMORY;
+
+         memset(&cso->state, 0, sizeof cso->state);
+         memcpy(&cso->state, templ, key_size);
+         cso->data = ctx->pipe->create_blend_state(ctx->pipe, &cso->state);
+         cso->delete_state =
+            (cso_state_callback)ctx->pipe->delete_blend_state;
+         cso->context = ctx->pipe;
+
+         iter = cso_insert_state(ctx->cache, hash_key, CSO_BLEND, cso);
+         if (cso_hash_iter_is_null(iter)) {
+            FREE(cso);
+            return PIPE_ERROR_OUT_OF_MEMORY;
+         }
+      }
+
+      ctx->blend_cso = (struct cso_blend *)cso_hash_iter_data(iter);
+      handle = ctx->blend_cso->data;
    }
 
    if (ctx->blend != handle) {
@@ -431,38 +486,45 @@ cso_set_depth_stencil_alpha(struct cso_context *ctx,
                             const struct pipe_depth_stencil_alpha_state *templ)
 {
    unsigned key_size = sizeof(struct pipe_depth_stencil_alpha_state);
-   unsigned hash_key = cso_construct_key((void*)templ, key_size);
-   struct cso_hash_iter iter = cso_find_state_template(ctx->cache,
-                                                       hash_key,
-                                                       CSO_DEPTH_STENCIL_ALPHA,
-                                                       (void*)templ, key_size);
    void *handle;
 
-   if (cso_hash_iter_is_null(iter)) {
-      struct cso_depth_stencil_alpha *cso =
-         MALLOC(sizeof(struct cso_depth_stencil_alpha));
-      if (!cso)
-         return PIPE_ERROR_OUT_OF_MEMORY;
-
-      memcpy(&cso->state, templ, sizeof(*templ));
-      cso->data = ctx->pipe->create_depth_stencil_alpha_state(ctx->pipe,
-                                                              &cso->state);
-      cso->delete_state =
-         (cso_state_callback)ctx->pipe->delete_depth_stencil_alpha_state;
-      cso->context = ctx->pipe;
-
-      iter = cso_insert_state(ctx->cache, hash_key,
-                              CSO_DEPTH_STENCIL_ALPHA, cso);
+   if (ctx->depth_stencil_cso &&
+       !memcmp(&ctx->depth_stencil_cso->state, templ, key_size)) {
+      handle = ctx->depth_stencil_cso->data;
+      cso_cache_touch(ctx->cache, ctx->depth_stencil_cso,
+                      CSO_DEPTH_STENCIL_ALPHA);
+   }
+   else {
+      unsigned hash_key = cso_construct_key((void*)templ, key_size);
+      struct cso_hash_iter iter =
+         cso_find_state_template(ctx->cache, hash_key,
+                                 CSO_DEPTH_STENCIL_ALPHA,
+                                 (void*)templ, key_size);
+
       if (cso_hash_iter_is_null(iter)) {
-         FREE(cso);
-         return PIPE_ERROR_OUT_OF_MEMORY;
+         struct cso_depth_stencil_alpha *cso =
+            MALLOC(sizeof(struct cso_depth_stencil_alpha));
+         if (!cso)
+            return PIPE_ERROR_OUT_OF_MEMORY;
+
+         memcpy(&cso->state, templ, sizeof(*templ));
+         cso->data = ctx->pipe->create_depth_stencil_alpha_state(ctx->pipe,
+                                                                 &cso->state);
+         cso->delete_state =
+            (cso_state_callback)ctx->pipe->delete_depth_stencil_alpha_state;
+         cso->context = ctx->pipe;
+
+         iter = cso_insert_state(ctx->cache, hash_key,
+                                 CSO_DEPTH_STENCIL_ALPHA, cso);
+         if (cso_hash_iter_is_null(iter)) {
+            FREE(cso);
+            return PIPE_ERROR_OUT_OF_MEMORY;
+         }
       }
 
-      handle = cso->data;
-   }
-   else {
-      handle = ((struct cso_depth_stencil_alpha *)
-                cso_hash_iter_data(iter))->data;
+      ctx->depth_stencil_cso =
+         (struct cso_depth_stencil_alpha *)cso_hash_iter_data(iter);
+      handle = ctx->depth_stencil_cso->data;
    }
 
    if (ctx->depth_stencil != handle) {
@@ -494,34 +556,40 @@ enum pipe_error cso_set_rasterizer(struct cso_context *ctx,
                                    const struct pipe_rasterizer_state *templ)
 {
    unsigned key_size = sizeof(struct pipe_rasterizer_state);
-   unsigned hash_key = cso_construct_key((void*)templ, key_size);
-   struct cso_hash_iter iter = cso_find_state_template(ctx->cache,
-                                                       hash_key,
-                                                       CSO_RASTERIZER,
-                                                       (void*)templ, key_size);
    void *handle = NULL;
 
-   if (cso_hash_iter_is_null(iter)) {
-      struct cso_rasterizer *cso = MALLOC(sizeof(struct cso_rasterizer));
-      if (!cso)
-         return PIPE_ERROR_OUT_OF_MEMORY;
-
-      memcpy(&cso->state, templ, sizeof(*templ));
-      cso->data = ctx->pipe->create_rasterizer_state(ctx->pipe, &cso->state);
-      cso->delete_state =
-         (cso_state_callback)ctx->pipe->delete_rasterizer_state;
-      cso->context = ctx->pipe;
+   if (ctx->rasterizer_cso &&
+       !memcmp(&ctx->rasterizer_cso->state, templ, key_size)) {
+      handle = ctx->rasterizer_cso->data;
+      cso_cache_touch(ctx->cache, ctx->rasterizer_cso, CSO_RASTERIZER);
+   }
+   else {
+      unsigned hash_key = cso_construct_key((void*)templ, key_size);
+      struct cso_hash_iter iter =
+         cso_find_state_template(ctx->cache, hash_key, CSO_RASTERIZER,
+                                 (void*)templ, key_size);
 
-      iter = cso_insert_state(ctx->cache, hash_key, CSO_RASTERIZER, cso);
       if (cso_hash_iter_is_null(iter)) {
-         FREE(cso);
-         return PIPE_ERROR_OUT_OF_MEMORY;
+         struct cso_rasterizer *cso = MALLOC(sizeof(struct cso_rasterizer));
+         if (!cso)
+            return PIPE_ERROR_OUT_OF_MEMORY;
+
+         memcpy(&cso->state, templ, sizeof(*templ));
+         cso->data = ctx->pipe->create_rasterizer_state(ctx->pipe,
+                                                        &cso->state);
+         cso->delete_state =
+            (cso_state_callback)ctx->pipe->delete_rasterizer_state;
+         cso->context = ctx->pipe;
+
+         iter = cso_insert_state(ctx->cache, hash_key, CSO_RASTERIZER, cso);
+         if (cso_hash_iter_is_null(iter)) {
+            FREE(cso);
+            return PIPE_ERROR_OUT_OF_MEMORY;
+         }
       }
 
-      handle = cso->data;
-   }
-   else {
-      handle = ((struct cso_rasterizer *)cso_hash_iter_data(iter))->data;
+      ctx->rasterizer_cso = (struct cso_rasterizer *)cso_hash_iter_data(iter);
+      handle = ctx->rasterizer_cso->data;
    }
 
    if (ctx->rasterizer != handle) {
@@ -847,32 +915,38 @@ cso_set_vertex_elements(struct cso_context *ctx,
    velems_state.count = count;
    memcpy(velems_state.velems, states,
           sizeof(struct pipe_vertex_element) * count);
-   hash_key = cso_construct_key((void*)&velems_state, key_size);
-   iter = cso_find_state_template(ctx->cache, hash_key, CSO_VELEMENTS,
-                                  (void*)&velems_state, key_size);
 
-   if (cso_hash_iter_is_null(iter)) {
-      struct cso_velements *cso = MALLOC(sizeof(struct cso_velements));
-      if (!cso)
-         return PIPE_ERROR_OUT_OF_MEMORY;
+   if (ctx->velements_cso &&
+       !memcmp(&ctx->velements_cso->state, &velems_state, key_size)) {
+      handle = ctx->velements_cso->data;
+      cso_cache_touch(ctx->cache, ctx->velements_cso, CSO_VELEMENTS);
+   }
+   else {
+      hash_key = cso_construct_key((void*)&velems_state, key_size);
+      iter = cso_find_state_template(ctx->cache, hash_key, CSO_VELEMENTS,
+                                     (void*)&velems_state, key_size);
 
-      memcpy(&cso->state, &velems_state, key_size);
-      cso->data = ctx->pipe->create_vertex_elements_state(ctx->pipe, count,
+      if (cso_hash_iter_is_null(iter)) {
+         struct cso_velements *cso = MALLOC(sizeof(struct cso_velements));
+         if (!cso)
+            return PIPE_ERROR_OUT_OF_MEMORY;
+
+         memcpy(&cso->state, &velems_state, key_size);
+         cso->data = ctx->pipe->create_vertex_elements_state(ctx->pipe, count,
                                                       &cso->state.velems[0]);
-      cso->delete_state =
-         (cso_state_callback) ctx->pipe->delete_vertex_elements_state;
-      cso->context = ctx->pipe;
+         cso->delete_state =
+            (cso_state_callback) ctx->pipe->delete_vertex_elements_state;
+         cso->context = ctx->pipe;
 
-      iter = cso_insert_state(ctx->cache, hash_key, CSO_VELEMENTS, cso);
-      if (cso_hash_iter_is_null(iter)) {
-         FREE(cso);
-         return PIPE_ERROR_OUT_OF_MEMORY;
+         iter = cso_insert_state(ctx->cache, hash_key, CSO_VELEMENTS, cso);
+         if (cso_hash_iter_is_null(iter)) {
+            FREE(cso);
+            return PIPE_ERROR_OUT_OF_MEMORY;
+         }
       }
 
-      handle = cso->data;
-   }
-   else {
-      handle = ((struct cso_velements *)cso_hash_iter_data(iter))->data;
+      ctx->velements_cso = (struct cso_velements *)cso_hash_iter_data(iter);
+      handle = ctx->velements_cso->data;
    }
 
    if (ctx->velements != handle) {
@@ -981,6 +1055,17 @@ unsigned cso_get_aux_vertex_buffer_slot(struct cso_context *ctx)
    return ctx->aux_vertex_buffer_index;
 }
 
+/**
+ * Hits and misses only count lookups in the cache, not rebinding the state
+ * last set.
+ */
+void cso_get_cache_stats(struct cso_context *ctx,
+                         enum cso_cache_type type,
+                         struct cso_cache_stats *stats)
+{
+   cso_cache_get_stats(ctx->cache, type, stats);
+}
+
 
 /**************** fragment/vertex sampler view state *************************/
 
@@ -994,33 +1079,40 @@ single_sampler(struct cso_context *ctx,
 
    if (templ != NULL) {
       unsigned key_size = sizeof(struct pipe_sampler_state);
-      unsigned hash_key = cso_construct_key((void*)templ, key_size);
-      struct cso_hash_iter iter =
-         cso_find_state_template(ctx->cache,
-                                 hash_key, CSO_SAMPLER,
-                                 (void *) templ, key_size);
 
-      if (cso_hash_iter_is_null(iter)) {
-         struct cso_sampler *cso = MALLOC(sizeof(struct cso_sampler));
-         if (!cso)
-            return PIPE_ERROR_OUT_OF_MEMORY;
-
-         memcpy(&cso->state, templ, sizeof(*templ));
-         cso->data = ctx->pipe->create_sampler_state(ctx->pipe, &cso->state);
-         cso->delete_state =
-            (cso_state_callback) ctx->pipe->delete_sampler_state;
-         cso->context = ctx->pipe;
+      if (info->cso[idx] &&
+          !memcmp(&info->cso[idx]->state, templ, key_size)) {
+         handle = info->cso[idx]->data;
+         cso_cache_touch(ctx->cache, info->cso[idx], CSO_SAMPLER);
+      }
+      else {
+         unsigned hash_key = cso_construct_key((void*)templ, key_size);
+         struct cso_hash_iter iter =
+            cso_find_state_template(ctx->cache,
+                                    hash_key, CSO_SAMPLER,
+                                    (void *) templ, key_size);
 
-         iter = cso_insert_state(ctx->cache, hash_key, CSO_SAMPLER, cso);
          if (cso_hash_iter_is_null(iter)) {
-            FREE(cso);
-            return PIPE_ERROR_OUT_OF_MEMORY;
+            struct cso_sampler *cso = MALLOC(sizeof(struct cso_sampler));
+            if (!cso)
+               return PIPE_ERROR_OUT_OF_MEMORY;
+
+            memcpy(&cso->state, templ, sizeof(*templ));
+            cso->data = ctx->pipe->create_sampler_state(ctx->pipe,
+                                                        &cso->state);
+            cso->delete_state =
+               (cso_state_callback) ctx->pipe->delete_sampler_state;
+            cso->context = ctx->pipe;
+
+            iter = cso_insert_state(ctx->cache, hash_key, CSO_SAMPLER, cso);
+            if (cso_hash_iter_is_null(iter)) {
+               FREE(cso);
+               return PIPE_ERROR_OUT_OF_MEMORY;
+            }
          }
 
-         handle = cso->data;
-      }
-      else {
-         handle = ((struct cso_sampler *)cso_hash_iter_data(iter))->data;
+         info->cso[idx] = (struct cso_sampler *)cso_hash_iter_data(iter);
+         handle = info->cso[idx]->data;
       }
    }
 
@@ -32,6 +32,7 @@
 #include "pipe/p_context.h"
 #include "pipe/p_state.h"
 #include "pipe/p_defines.h"
+#include "cso_cache/cso_cache.h"
 
 
 #ifdef	__cplusplus
@@ -47,6 +48,10 @@ void cso_release_all( struct cso_context *ctx );
 
 void cso_destroy_context( struct cso_context *cso );
 
+void cso_get_cache_stats( struct cso_context *cso,
+                          enum cso_cache_type type,
+                          struct cso_cache_stats *stats );
+
 
 
 enum pipe_error cso_set_blend( struct cso_context *cso,
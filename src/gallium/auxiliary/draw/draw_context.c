@@ -859,3 +859,15 @@ draw_get_shader_param(unsigned shader, enum pipe_shader_cap param)
    return draw_get_shader_param_no_llvm(shader, param);
 }
 
+
+
+/**
+ * Return one of the stage timers, which only advance while timers are
+ * enabled with util_perf_timers_enable().
+ */
+const struct util_perf_timer *
+draw_get_timer(const struct draw_context *draw, enum draw_timer timer)
+{
+   assert(timer < DRAW_TIMER_COUNT);
+   return &draw->timers[timer];
+}
@@ -282,4 +282,21 @@ draw_get_shader_param(unsigned shader, enum pipe_shader_cap param);
 int
 draw_get_shader_param_no_llvm(unsigned shader, enum pipe_shader_cap param);
 
+
+/*******************************************************************************
+ * Instrumentation, see util/u_perf_timer.h
+ */
+enum draw_timer {
+   DRAW_TIMER_FETCH,    /**< vertex fetch, part of SHADE with LLVM */
+   DRAW_TIMER_SHADE,    /**< vertex and geometry shading */
+   DRAW_TIMER_CLIP,     /**< clip test and the primitive pipeline */
+   DRAW_TIMER_COMPILE,  /**< generating vertex shader variants */
+   DRAW_TIMER_COUNT
+};
+
+struct util_perf_timer;
+
+const struct util_perf_timer *
+draw_get_timer(const struct draw_context *draw, enum draw_timer timer);
+
 #endif /* DRAW_CONTEXT_H */
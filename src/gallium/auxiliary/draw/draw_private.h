@@ -44,7 +44,9 @@
 #include "pipe/p_state.h"
 #include "pipe/p_defines.h"
 
+#include "draw/draw_context.h"
 #include "tgsi/tgsi_scan.h"
+#include "util/u_perf_timer.h"
 
 #ifdef HAVE_LLVM
 struct draw_llvm;
@@ -313,6 +315,9 @@ struct draw_context
    const struct pipe_sampler_state *samplers[PIPE_SHADER_TYPES][PIPE_MAX_SAMPLERS];
    unsigned num_samplers[PIPE_SHADER_TYPES];
 
+   /** Per-stage timers, indexed by DRAW_TIMER_x */
+   struct util_perf_timer timers[DRAW_TIMER_COUNT];
+
    void *driver_private;
 };
 
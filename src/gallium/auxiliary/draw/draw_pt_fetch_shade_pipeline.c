@@ -229,6 +229,7 @@ static void fetch_pipeline_generic( struct draw_pt_middle_end *middle,
    struct draw_vertex_info gs_vert_info;
    struct draw_vertex_info *vert_info;
    unsigned opt = fpme->opt;
+   int64_t start;
 
    fetched_vert_info.count = fetch_info->count;
    fetched_vert_info.vertex_size = fpme->vertex_size;
@@ -243,7 +244,9 @@ static void fetch_pipeline_generic( struct draw_pt_middle_end *middle,
 
    /* Fetch into our vertex buffer.
     */
+   start = util_perf_timer_begin();
    fetch( fpme->fetch, fetch_info, (char *)fetched_vert_info.verts );
+   util_perf_timer_end(&draw->timers[DRAW_TIMER_FETCH], start);
 
    /* Finished with fetch:
     */
@@ -253,6 +256,7 @@ static void fetch_pipeline_generic( struct draw_pt_middle_end *middle,
    /* Run the shader, note that this overwrites the data[] parts of
     * the pipeline verts.
     */
+   start = util_perf_timer_begin();
    if (fpme->opt & PT_SHADE) {
       draw_vertex_shader_run(vshader,
                              draw->pt.user.vs_constants,
@@ -278,6 +282,7 @@ static void fetch_pipeline_generic( struct draw_pt_middle_end *middle,
       vert_info = &gs_vert_info;
       prim_info = &gs_prim_info;
    }
+   util_perf_timer_end(&draw->timers[DRAW_TIMER_SHADE], start);
 
 
    /* Stream output needs to be done before clipping.
@@ -293,6 +298,8 @@ static void fetch_pipeline_generic( struct draw_pt_middle_end *middle,
     */
    if (draw_current_shader_position_output(draw) != -1) {
 
+      start = util_perf_timer_begin();
+
       if (draw_pt_post_vs_run( fpme->post_vs, vert_info ))
       {
          opt |= PT_PIPELINE;
@@ -302,8 +309,10 @@ static void fetch_pipeline_generic( struct draw_pt_middle_end *middle,
        */
       if (opt & PT_PIPELINE) {
          pipeline( fpme, vert_info, prim_info );
+         util_perf_timer_end(&draw->timers[DRAW_TIMER_CLIP], start);
       }
       else {
+         util_perf_timer_end(&draw->timers[DRAW_TIMER_CLIP], start);
          emit( fpme->emit, vert_info, prim_info );
       }
    }
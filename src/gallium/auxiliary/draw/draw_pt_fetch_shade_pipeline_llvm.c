@@ -147,6 +147,7 @@ llvm_middle_end_prepare( struct draw_pt_middle_end *middle,
       }
       else {
          /* Need to create new variant */
+         int64_t start;
 
          /* First check if we've created too many variants.  If so, free
           * 25% of the LRU to avoid using too much memory.
@@ -167,7 +168,9 @@ llvm_middle_end_prepare( struct draw_pt_middle_end *middle,
             }
          }
 
+         start = util_perf_timer_begin();
          variant = draw_llvm_create_variant(fpme->llvm, nr, key);
+         util_perf_timer_end(&draw->timers[DRAW_TIMER_COMPILE], start);
 
          if (variant) {
             insert_at_head(&shader->variants, &variant->list_item_local);
@@ -251,6 +254,7 @@ llvm_pipeline_generic( struct draw_pt_middle_end *middle,
    struct draw_vertex_info *vert_info;
    unsigned opt = fpme->opt;
    unsigned clipped = 0;
+   int64_t start;
 
    llvm_vert_info.count = fetch_info->count;
    llvm_vert_info.vertex_size = fpme->vertex_size;
@@ -263,6 +267,9 @@ llvm_pipeline_generic( struct draw_pt_middle_end *middle,
       return;
    }
 
+   /* The generated code fetches, shades and clip tests in one go */
+   start = util_perf_timer_begin();
+
    if (fetch_info->linear)
       clipped = fpme->current_variant->jit_func( &fpme->llvm->jit_context,
                                        llvm_vert_info.verts,
@@ -303,6 +310,7 @@ llvm_pipeline_generic( struct draw_pt_middle_end *middle,
       vert_info = &gs_vert_info;
       prim_info = &gs_prim_info;
    }
+   util_perf_timer_end(&draw->timers[DRAW_TIMER_SHADE], start);
 
    /* stream output needs to be done before clipping */
    draw_pt_so_emit( fpme->so_emit, vert_info, prim_info );
@@ -312,6 +320,7 @@ llvm_pipeline_generic( struct draw_pt_middle_end *middle,
     * will try to access non-existent position output.
     */
    if (draw_current_shader_position_output(draw) != -1) {
+      start = util_perf_timer_begin();
       if ((opt & PT_SHADE) && gshader) {
          clipped = draw_pt_post_vs_run( fpme->post_vs, vert_info );
       }
@@ -323,8 +332,10 @@ llvm_pipeline_generic( struct draw_pt_middle_end *middle,
        */
       if (opt & PT_PIPELINE) {
          pipeline( fpme, vert_info, prim_info );
+         util_perf_timer_end(&draw->timers[DRAW_TIMER_CLIP], start);
       }
       else {
+         util_perf_timer_end(&draw->timers[DRAW_TIMER_CLIP], start);
          emit( fpme->emit, vert_info, prim_info );
       }
    }
@@ -67,6 +67,9 @@ lp_build_fetch_rgba_aos(struct gallivm_state *gallivm,
                         LLVMValueRef i,
                         LLVMValueRef j);
 
+void
+lp_build_format_cache_invalidate(void);
+
 LLVMValueRef
 lp_build_fetch_rgba_aos_array(struct gallivm_state *gallivm,
                         const struct util_format_description *format_desc,
@@ -33,6 +33,7 @@
  */
 
 
+#include "util/u_atomic.h"
 #include "util/u_format.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
@@ -362,6 +363,110 @@ lp_build_pack_rgba_aos(struct gallivm_state *gallivm,
 
 
 
+/**
+ * \name Decoded block cache for compressed formats
+ *
+ * The C fetch functions of compressed formats decode a good part of the
+ * block to return a single texel, and neighbouring texels usually come
+ * from the same block.  So instead, keep the last few decoded blocks of
+ * each thread, keyed on the block's address.
+ *
+ * Since nothing tells us when texture memory is written, drivers must call
+ * lp_build_format_cache_invalidate() whenever they do, which throws away
+ * the cached blocks of all threads.
+ *
+ * The cache needs thread-local storage, so it is only built where that is
+ * available, as with GLX_USE_TLS.
+ */
+/*@{*/
+
+#if defined(GLX_USE_TLS)
+#define LP_FORMAT_CACHE 1
+#define LP_FORMAT_CACHE_SIZE 64
+
+struct lp_format_block_cache
+{
+   int32_t epoch;
+   const uint8_t *tags[LP_FORMAT_CACHE_SIZE];
+   const struct util_format_description *formats[LP_FORMAT_CACHE_SIZE];
+   uint8_t texels[LP_FORMAT_CACHE_SIZE][4 * 4 * 4];
+};
+
+static int32_t lp_format_cache_epoch = 1;
+
+static __thread struct lp_format_block_cache lp_format_cache;
+
+
+/**
+ * Called from generated code instead of
+ * util_format_description::fetch_rgba_8unorm().
+ */
+static void
+lp_fetch_cached_rgba_8unorm(uint8_t *dst, const uint8_t *src,
+                            unsigned i, unsigned j,
+                            const struct util_format_description *desc)
+{
+   struct lp_format_block_cache *cache = &lp_format_cache;
+   const int32_t epoch = p_atomic_read(&lp_format_cache_epoch);
+   const uintptr_t addr = (uintptr_t) src;
+   const unsigned slot = ((addr >> 3) ^ (addr >> 9)) % LP_FORMAT_CACHE_SIZE;
+
+   if (cache->epoch != epoch) {
+      memset(cache->tags, 0, sizeof cache->tags);
+      cache->epoch = epoch;
+   }
+
+   if (cache->tags[slot] != src || cache->formats[slot] != desc) {
+      desc->unpack_rgba_8unorm(cache->texels[slot], 4 * 4, src, 0, 4, 4);
+      cache->tags[slot] = src;
+      cache->formats[slot] = desc;
+   }
+
+   memcpy(dst, &cache->texels[slot][(j * 4 + i) * 4], 4);
+}
+#endif /* GLX_USE_TLS */
+
+
+void
+lp_build_format_cache_invalidate(void)
+{
+#ifdef LP_FORMAT_CACHE
+   p_atomic_inc(&lp_format_cache_epoch);
+#endif
+}
+
+
+static boolean
+lp_format_cache_supported(const struct util_format_description *format_desc)
+{
+#ifdef LP_FORMAT_CACHE
+   if (format_desc->block.width != 4 ||
+       format_desc->block.height != 4 ||
+       !format_desc->unpack_rgba_8unorm)
+      return FALSE;
+
+   switch (format_desc->format) {
+   case PIPE_FORMAT_RGTC1_SNORM:
+   case PIPE_FORMAT_RGTC2_SNORM:
+   case PIPE_FORMAT_LATC1_SNORM:
+   case PIPE_FORMAT_LATC2_SNORM:
+      /* 8unorm would clamp the negative values */
+      return FALSE;
+   default:
+      break;
+   }
+
+   return format_desc->layout == UTIL_FORMAT_LAYOUT_S3TC ||
+          format_desc->layout == UTIL_FORMAT_LAYOUT_RGTC ||
+          format_desc->layout == UTIL_FORMAT_LAYOUT_ETC;
+#else
+   return FALSE;
+#endif
+}
+
+/*@}*/
+
+
 /**
  * Fetch a pixel into a 4 float AoS.
  *
@@ -514,6 +619,105 @@ lp_build_fetch_rgba_aos(struct gallivm_state *gallivm,
       return tmp;
    }
 
+#ifdef LP_FORMAT_CACHE
+   /*
+    * Compressed formats, through the decoded block cache.
+    */
+
+   if (lp_format_cache_supported(format_desc)) {
+      LLVMTypeRef i8t = LLVMInt8TypeInContext(gallivm->context);
+      LLVMTypeRef pi8t = LLVMPointerType(i8t, 0);
+      LLVMTypeRef i32t = LLVMInt32TypeInContext(gallivm->context);
+      struct lp_type tmp_type;
+      LLVMValueRef function;
+      LLVMValueRef desc_ptr;
+      LLVMValueRef tmp_ptr;
+      LLVMValueRef tmp;
+      LLVMValueRef res;
+      unsigned k;
+
+      memset(&tmp_type, 0, sizeof tmp_type);
+      tmp_type.width = 8;
+      tmp_type.length = num_pixels * 4;
+      tmp_type.norm = TRUE;
+
+      {
+         /*
+          * Function to call looks like:
+          *   fetch(uint8_t *dst, const uint8_t *src, unsigned i, unsigned j,
+          *         const struct util_format_description *desc)
+          */
+         LLVMTypeRef ret_type;
+         LLVMTypeRef arg_types[5];
+         LLVMTypeRef function_type;
+
+         ret_type = LLVMVoidTypeInContext(gallivm->context);
+         arg_types[0] = pi8t;
+         arg_types[1] = pi8t;
+         arg_types[2] = i32t;
+         arg_types[3] = i32t;
+         arg_types[4] = pi8t;
+         function_type = LLVMFunctionType(ret_type, arg_types,
+                                          Elements(arg_types), 0);
+
+         function = lp_build_const_int_pointer(gallivm,
+            func_to_pointer((func_pointer) lp_fetch_cached_rgba_8unorm));
+
+         function = LLVMBuildBitCast(builder, function,
+                                     LLVMPointerType(function_type, 0),
+                                     "cast callee");
+      }
+
+      desc_ptr = lp_build_const_int_pointer(gallivm, format_desc);
+      desc_ptr = LLVMBuildBitCast(builder, desc_ptr, pi8t, "");
+
+      tmp_ptr = lp_build_alloca(gallivm, i32t, "");
+
+      res = LLVMGetUndef(LLVMVectorType(i32t, num_pixels));
+
+      for (k = 0; k < num_pixels; ++k) {
+         LLVMValueRef index = lp_build_const_int32(gallivm, k);
+         LLVMValueRef args[5];
+
+         args[0] = LLVMBuildBitCast(builder, tmp_ptr, pi8t, "");
+         args[1] = lp_build_gather_elem_ptr(gallivm, num_pixels,
+                                            base_ptr, offset, k);
+
+         if (num_pixels == 1) {
+            args[2] = i;
+            args[3] = j;
+         }
+         else {
+            args[2] = LLVMBuildExtractElement(builder, i, index, "");
+            args[3] = LLVMBuildExtractElement(builder, j, index, "");
+         }
+
+         args[4] = desc_ptr;
+
+         LLVMBuildCall(builder, function, args, Elements(args), "");
+
+         tmp = LLVMBuildLoad(builder, tmp_ptr, "");
+
+         if (num_pixels == 1) {
+            res = tmp;
+         }
+         else {
+            res = LLVMBuildInsertElement(builder, res, tmp, index, "");
+         }
+      }
+
+      /* Bitcast from <n x i32> to <4n x i8> */
+      res = LLVMBuildBitCast(builder, res,
+                             lp_build_vec_type(gallivm, tmp_type), "");
+
+      lp_build_conv(gallivm,
+                    tmp_type, type,
+                    &res, 1, &res, 1);
+
+      return res;
+   }
+#endif /* LP_FORMAT_CACHE */
+
    /*
     * Fallback to util_format_description::fetch_rgba_8unorm().
     */
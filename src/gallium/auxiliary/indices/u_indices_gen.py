@@ -75,6 +75,8 @@ def prolog():
 #include "util/u_debug.h"
 #include "pipe/p_defines.h"
 #include "util/u_memory.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_sse.h"
 
 
 static unsigned out_size_idx( unsigned index_size )
@@ -130,14 +132,18 @@ def do_line( intype, outtype, ptr, v0, v1, inpv, outpv ):
     else:
         line( intype, outtype, ptr, v1, v0 )
 
-def do_tri( intype, outtype, ptr, v0, v1, v2, inpv, outpv ):
+def tri_verts( v0, v1, v2, inpv, outpv ):
     if inpv == outpv:
-        tri( intype, outtype, ptr, v0, v1, v2 )
-    else: 
+        return v0, v1, v2
+    else:
         if inpv == FIRST:
-            tri( intype, outtype, ptr, v1, v2, v0 )
+            return v1, v2, v0
         else:
-            tri( intype, outtype, ptr, v2, v0, v1 )
+            return v2, v0, v1
+
+def do_tri( intype, outtype, ptr, v0, v1, v2, inpv, outpv ):
+    v0, v1, v2 = tri_verts( v0, v1, v2, inpv, outpv )
+    tri( intype, outtype, ptr, v0, v1, v2 )
 
 def do_quad( intype, outtype, ptr, v0, v1, v2, v3, inpv, outpv ):
     do_tri( intype, outtype, ptr+'+0',  v0, v1, v3, inpv, outpv );
@@ -166,8 +172,128 @@ def postamble():
     print '}'
 
 
+#
+# SSE2 paths.
+#
+# Widening index conversions, and the decomposition of quads, quad strips and
+# triangle strips into triangles, are vectorized.  The vector loops run ahead
+# of the scalar ones, which then finish off the remainder.
+#
+
+def sse2_widen(intype, outtype, prim, inpv, outpv):
+    """Whether the translation is a plain element-wise conversion."""
+    if intype == GENERATE or intype == outtype:
+        return False
+    if intype == UINT or outtype == UBYTE:
+        return False
+    return prim == 'points' or (prim in ('lines', 'tris') and inpv == outpv)
+
+def sse2_window(intype, outtype, prim, inpv, outpv):
+    """For translations which emit two triangles from each window of four
+    consecutive input indices, return the distance between windows and, for
+    each of the six output indices, the position within the window it comes
+    from.  Return None otherwise."""
+    if intype == GENERATE or intype != outtype:
+        return None
+    if prim == 'quads':
+        stride = 4
+        verts = tri_verts(0, 1, 3, inpv, outpv) + tri_verts(1, 2, 3, inpv, outpv)
+    elif prim == 'quadstrip':
+        stride = 2
+        verts = tri_verts(2, 0, 3, inpv, outpv) + tri_verts(0, 1, 3, inpv, outpv)
+    elif prim == 'tristrip':
+        # Two consecutive triangles, the first one with even i
+        stride = 2
+        tris = []
+        for i in (0, 1):
+            if inpv == FIRST:
+                v = (i, i + 1 + (i & 1), i + 2 - (i & 1))
+            else:
+                v = (i + (i & 1), i + 1 - (i & 1), i + 2)
+            tris += tri_verts(v[0], v[1], v[2], inpv, outpv)
+        verts = tuple(tris)
+    else:
+        return None
+    return stride, verts
+
+def mm_shuffle(sel):
+    return '_MM_SHUFFLE(%u, %u, %u, %u)' % (sel[3], sel[2], sel[1], sel[0])
+
+def emit_sse2_widen(intype, outtype):
+    print '#if defined(PIPE_ARCH_SSE)'
+    print '  if (util_cpu_caps.has_sse2) {'
+    print '    const __m128i zero = _mm_setzero_si128();'
+    if intype == UBYTE:
+        print '    for (i = 0; i + 16 <= nr; i += 16) {'
+        print '      __m128i v = _mm_loadu_si128((const __m128i *)&in[i]);'
+        print '      __m128i lo = _mm_unpacklo_epi8(v, zero);'
+        print '      __m128i hi = _mm_unpackhi_epi8(v, zero);'
+        if outtype == USHORT:
+            print '      _mm_storeu_si128((__m128i *)&out[i + 0], lo);'
+            print '      _mm_storeu_si128((__m128i *)&out[i + 8], hi);'
+        else:
+            print '      _mm_storeu_si128((__m128i *)&out[i + 0], _mm_unpacklo_epi16(lo, zero));'
+            print '      _mm_storeu_si128((__m128i *)&out[i + 4], _mm_unpackhi_epi16(lo, zero));'
+            print '      _mm_storeu_si128((__m128i *)&out[i + 8], _mm_unpacklo_epi16(hi, zero));'
+            print '      _mm_storeu_si128((__m128i *)&out[i + 12], _mm_unpackhi_epi16(hi, zero));'
+    else:
+        print '    for (i = 0; i + 8 <= nr; i += 8) {'
+        print '      __m128i v = _mm_loadu_si128((const __m128i *)&in[i]);'
+        print '      _mm_storeu_si128((__m128i *)&out[i + 0], _mm_unpacklo_epi16(v, zero));'
+        print '      _mm_storeu_si128((__m128i *)&out[i + 4], _mm_unpackhi_epi16(v, zero));'
+    print '    }'
+    print '    for (; i < nr; i++)'
+    print '      out[i] = ' + vert( intype, outtype, 'i' ) + ';'
+    print '    return;'
+    print '  }'
+    print '#endif'
+
+def emit_sse2_window(intype, stride, verts):
+    sel_lo = verts[0:4]
+    sel_hi = (verts[4], verts[5], verts[4], verts[5])
+    print '#if defined(PIPE_ARCH_SSE)'
+    print '  if (util_cpu_caps.has_sse2) {'
+    if intype == USHORT:
+        # Two windows per vector, four windows per iteration
+        print '    for (; j + 24 <= nr; j += 24, i += %u) {' % (4 * stride)
+        print '      __m128i a, b, pa, ra, pb, rb;'
+        print '      __m128 m, n;'
+        if stride == 4:
+            print '      a = _mm_loadu_si128((const __m128i *)&in[i + 0]);'
+            print '      b = _mm_loadu_si128((const __m128i *)&in[i + 8]);'
+        else:
+            print '      a = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)&in[i + 0]),'
+            print '                             _mm_loadl_epi64((const __m128i *)&in[i + 2]));'
+            print '      b = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)&in[i + 4]),'
+            print '                             _mm_loadl_epi64((const __m128i *)&in[i + 6]));'
+        for v in ('a', 'b'):
+            print '      p%s = _mm_shufflehi_epi16(_mm_shufflelo_epi16(%s, %s), %s);' % (v, v, mm_shuffle(sel_lo), mm_shuffle(sel_lo))
+            print '      r%s = _mm_shufflehi_epi16(_mm_shufflelo_epi16(%s, %s), %s);' % (v, v, mm_shuffle(sel_hi), mm_shuffle(sel_hi))
+        # Interleave the 32-bit pairs of indices into the output order
+        print '      m = _mm_shuffle_ps(_mm_castsi128_ps(ra), _mm_castsi128_ps(pa), _MM_SHUFFLE(3, 2, 2, 0));'
+        print '      n = _mm_shuffle_ps(_mm_castsi128_ps(rb), _mm_castsi128_ps(pb), _MM_SHUFFLE(3, 2, 2, 0));'
+        print '      _mm_storeu_si128((__m128i *)&out[j + 0], _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(pa), m, _MM_SHUFFLE(2, 0, 1, 0))));'
+        print '      _mm_storeu_si128((__m128i *)&out[j + 8], _mm_castps_si128(_mm_shuffle_ps(m, _mm_castsi128_ps(pb), _MM_SHUFFLE(1, 0, 1, 3))));'
+        print '      _mm_storeu_si128((__m128i *)&out[j + 16], _mm_castps_si128(_mm_shuffle_ps(n, n, _MM_SHUFFLE(1, 3, 2, 0))));'
+    else:
+        # One window per vector, two windows per iteration
+        print '    for (; j + 12 <= nr; j += 12, i += %u) {' % (2 * stride)
+        print '      __m128i a, b, pb;'
+        print '      a = _mm_loadu_si128((const __m128i *)&in[i + 0]);'
+        print '      b = _mm_loadu_si128((const __m128i *)&in[i + %u]);' % stride
+        print '      pb = _mm_shuffle_epi32(b, %s);' % mm_shuffle(sel_lo)
+        print '      _mm_storeu_si128((__m128i *)&out[j + 0], _mm_shuffle_epi32(a, %s));' % mm_shuffle(sel_lo)
+        print '      _mm_storeu_si128((__m128i *)&out[j + 4], _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(_mm_shuffle_epi32(a, %s)), _mm_castsi128_ps(pb), _MM_SHUFFLE(1, 0, 1, 0))));' % mm_shuffle(sel_hi)
+        print '      _mm_storeu_si128((__m128i *)&out[j + 8], _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(pb), _mm_castsi128_ps(_mm_shuffle_epi32(b, %s)), _MM_SHUFFLE(1, 0, 3, 2))));' % mm_shuffle(sel_hi)
+    print '    }'
+    print '  }'
+    print '#endif'
+
+
 def points(intype, outtype, inpv, outpv):
     preamble(intype, outtype, inpv, outpv, prim='points')
+    if sse2_widen(intype, outtype, 'points', inpv, outpv):
+        emit_sse2_widen(intype, outtype)
     print '  for (i = 0; i < nr; i++) { '
     do_point( intype, outtype, 'out+i',  'i' );
     print '   }'
@@ -175,6 +301,8 @@ def points(intype, outtype, inpv, outpv):
 
 def lines(intype, outtype, inpv, outpv):
     preamble(intype, outtype, inpv, outpv, prim='lines')
+    if sse2_widen(intype, outtype, 'lines', inpv, outpv):
+        emit_sse2_widen(intype, outtype)
     print '  for (i = 0; i < nr; i+=2) { '
     do_line( intype, outtype, 'out+i',  'i', 'i+1', inpv, outpv );
     print '   }'
@@ -197,6 +325,8 @@ def lineloop(intype, outtype, inpv, outpv):
 
 def tris(intype, outtype, inpv, outpv):
     preamble(intype, outtype, inpv, outpv, prim='tris')
+    if sse2_widen(intype, outtype, 'tris', inpv, outpv):
+        emit_sse2_widen(intype, outtype)
     print '  for (i = 0; i < nr; i+=3) { '
     do_tri( intype, outtype, 'out+i',  'i', 'i+1', 'i+2', inpv, outpv );
     print '   }'
@@ -205,7 +335,11 @@ def tris(intype, outtype, inpv, outpv):
 
 def tristrip(intype, outtype, inpv, outpv):
     preamble(intype, outtype, inpv, outpv, prim='tristrip')
-    print '  for (j = i = 0; j < nr; j+=3, i++) { '
+    print '  j = i = 0;'
+    window = sse2_window(intype, outtype, 'tristrip', inpv, outpv)
+    if window:
+        emit_sse2_window(intype, window[0], window[1])
+    print '  for (; j < nr; j+=3, i++) { '
     if inpv == FIRST:
         do_tri( intype, outtype, 'out+j',  'i', 'i+1+(i&1)', 'i+2-(i&1)', inpv, outpv );
     else:
@@ -236,7 +370,11 @@ def polygon(intype, outtype, inpv, outpv):
 
 def quads(intype, outtype, inpv, outpv):
     preamble(intype, outtype, inpv, outpv, prim='quads')
-    print '  for (j = i = 0; j < nr; j+=6, i+=4) { '
+    print '  j = i = 0;'
+    window = sse2_window(intype, outtype, 'quads', inpv, outpv)
+    if window:
+        emit_sse2_window(intype, window[0], window[1])
+    print '  for (; j < nr; j+=6, i+=4) { '
     do_quad( intype, outtype, 'out+j', 'i+0', 'i+1', 'i+2', 'i+3', inpv, outpv );
     print '   }'
     postamble()
@@ -244,7 +382,11 @@ def quads(intype, outtype, inpv, outpv):
 
 def quadstrip(intype, outtype, inpv, outpv):
     preamble(intype, outtype, inpv, outpv, prim='quadstrip')
-    print '  for (j = i = 0; j < nr; j+=6, i+=2) { '
+    print '  j = i = 0;'
+    window = sse2_window(intype, outtype, 'quadstrip', inpv, outpv)
+    if window:
+        emit_sse2_window(intype, window[0], window[1])
+    print '  for (; j < nr; j+=6, i+=2) { '
     do_quad( intype, outtype, 'out+j', 'i+2', 'i+0', 'i+1', 'i+3', inpv, outpv );
     print '   }'
     postamble()
@@ -298,6 +440,7 @@ def emit_init():
     print '  static int firsttime = 1;'
     print '  if (!firsttime) return;'
     print '  firsttime = 0;'
+    print '  util_cpu_detect();'
     emit_all_inits()
     print '}'
 
@@ -65,6 +65,8 @@ def prolog():
 #include "util/u_debug.h"
 #include "pipe/p_defines.h"
 #include "util/u_memory.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_sse.h"
 
 
 static unsigned out_size_idx( unsigned index_size )
@@ -140,6 +142,49 @@ def postamble():
     print '}'
 
 
+#
+# SSE2 paths.
+#
+# Quads and quad strips emit the four edges of each window of four input
+# indices, which is a plain shuffle when the index size doesn't change.  The
+# vector loops run ahead of the scalar ones, which finish off the remainder.
+#
+
+def mm_shuffle(sel):
+    return '_MM_SHUFFLE(%u, %u, %u, %u)' % (sel[3], sel[2], sel[1], sel[0])
+
+def emit_sse2_quad_edges(intype, outtype, stride, quad):
+    if intype == GENERATE or intype != outtype:
+        return
+    v0, v1, v2, v3 = quad
+    sel_lo = (v0, v1, v1, v2)
+    sel_hi = (v2, v3, v3, v0)
+    print '#if defined(PIPE_ARCH_SSE)'
+    print '  if (util_cpu_caps.has_sse2) {'
+    if intype == USHORT:
+        # Two windows per vector
+        print '    for (; j + 16 <= nr; j += 16, i += %u) {' % (2 * stride)
+        print '      __m128i v, lo, hi;'
+        if stride == 4:
+            print '      v = _mm_loadu_si128((const __m128i *)&in[i]);'
+        else:
+            print '      v = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)&in[i + 0]),'
+            print '                             _mm_loadl_epi64((const __m128i *)&in[i + 2]));'
+        print '      lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, %s), %s);' % (mm_shuffle(sel_lo), mm_shuffle(sel_lo))
+        print '      hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, %s), %s);' % (mm_shuffle(sel_hi), mm_shuffle(sel_hi))
+        print '      _mm_storeu_si128((__m128i *)&out[j + 0], _mm_unpacklo_epi64(lo, hi));'
+        print '      _mm_storeu_si128((__m128i *)&out[j + 8], _mm_unpackhi_epi64(lo, hi));'
+    else:
+        # One window per vector
+        print '    for (; j + 8 <= nr; j += 8, i += %u) {' % stride
+        print '      __m128i v = _mm_loadu_si128((const __m128i *)&in[i]);'
+        print '      _mm_storeu_si128((__m128i *)&out[j + 0], _mm_shuffle_epi32(v, %s));' % mm_shuffle(sel_lo)
+        print '      _mm_storeu_si128((__m128i *)&out[j + 4], _mm_shuffle_epi32(v, %s));' % mm_shuffle(sel_hi)
+    print '    }'
+    print '  }'
+    print '#endif'
+
+
 def tris(intype, outtype):
     preamble(intype, outtype, prim='tris')
     print '  for (j = i = 0; j < nr; j+=6, i+=3) { '
@@ -175,7 +220,9 @@ def polygon(intype, outtype):
 
 def quads(intype, outtype):
     preamble(intype, outtype, prim='quads')
-    print '  for (j = i = 0; j < nr; j+=8, i+=4) { '
+    print '  j = i = 0;'
+    emit_sse2_quad_edges(intype, outtype, 4, (0, 1, 2, 3))
+    print '  for (; j < nr; j+=8, i+=4) { '
     do_quad( intype, outtype, 'out+j', 'i+0', 'i+1', 'i+2', 'i+3' );
     print '   }'
     postamble()
@@ -183,7 +230,9 @@ def quads(intype, outtype):
 
 def quadstrip(intype, outtype):
     preamble(intype, outtype, prim='quadstrip')
-    print '  for (j = i = 0; j < nr; j+=8, i+=2) { '
+    print '  j = i = 0;'
+    emit_sse2_quad_edges(intype, outtype, 2, (2, 0, 1, 3))
+    print '  for (; j < nr; j+=8, i+=2) { '
     do_quad( intype, outtype, 'out+j', 'i+2', 'i+0', 'i+1', 'i+3' );
     print '   }'
     postamble()
@@ -225,6 +274,7 @@ def emit_init():
     print '  static int firsttime = 1;'
     print '  if (!firsttime) return;'
     print '  firsttime = 0;'
+    print '  util_cpu_detect();'
     emit_all_inits()
     print '}'
 
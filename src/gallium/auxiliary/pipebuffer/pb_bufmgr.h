@@ -164,6 +164,31 @@ pb_cache_manager_create(struct pb_manager *provider,
                      	unsigned usecs); 
 
 
+/**
+ * Buffer cache statistics.
+ */
+struct pb_cache_stats
+{
+   /** Buffer requests satisfied from / not found in the cache */
+   uint64_t hits;
+   uint64_t misses;
+
+   /** Cached buffers freed because they weren't reused in time */
+   uint64_t evictions;
+
+   /** Buffers currently in the cache, and their total size */
+   unsigned buffers_cached;
+   uint64_t bytes_cached;
+};
+
+/**
+ * Get the statistics of a manager made by pb_cache_manager_create().
+ */
+void
+pb_cache_manager_get_stats(struct pb_manager *mgr,
+                           struct pb_cache_stats *stats);
+
+
 struct pb_fence_ops;
 
 /** 
@@ -28,6 +28,11 @@
 /**
  * \file
  * Buffer cache.
+ *
+ * Destroyed buffers are kept in a list ordered by expiration time, so that
+ * expired buffers can be freed from its head, and in a per size bucket list
+ * with the same order, so that looking for a buffer to reuse only needs to
+ * look at buffers of about the right size.
  * 
  * \author Jose Fonseca <jrfonseca-at-tungstengraphics-dot-com>
  * \author Thomas Hellström <thomas-at-tungstengraphics-dot-com>
@@ -39,6 +44,7 @@
 #include "os/os_thread.h"
 #include "util/u_memory.h"
 #include "util/u_double_list.h"
+#include "util/u_math.h"
 #include "util/u_time.h"
 
 #include "pb_buffer.h"
@@ -51,6 +57,12 @@
 #define SUPER(__derived) (&(__derived)->base)
 
 
+/**
+ * Buffers are bucketed by the log2 of their size.
+ */
+#define PB_CACHE_NUM_BUCKETS (sizeof(pb_size) * 8)
+
+
 struct pb_cache_manager;
 
 
@@ -67,7 +79,11 @@ struct pb_cache_buffer
    /** Caching time interval */
    int64_t start, end;
 
+   /** Link in pb_cache_manager::delayed */
    struct list_head head;
+
+   /** Link in pb_cache_manager::buckets */
+   struct list_head bucket_head;
 };
 
 
@@ -82,6 +98,10 @@ struct pb_cache_manager
    
    struct list_head delayed;
    pb_size numDelayed;
+
+   struct list_head buckets[PB_CACHE_NUM_BUCKETS];
+
+   struct pb_cache_stats stats;
 };
 
 
@@ -101,17 +121,37 @@ pb_cache_manager(struct pb_manager *mgr)
 }
 
 
+static INLINE unsigned
+pb_cache_bucket(pb_size size)
+{
+   return util_logbase2(size);
+}
+
+
 /**
- * Actually destroy the buffer.
+ * Take the buffer out of the cache lists.
  */
 static INLINE void
-_pb_cache_buffer_destroy(struct pb_cache_buffer *buf)
+_pb_cache_buffer_remove(struct pb_cache_buffer *buf)
 {
    struct pb_cache_manager *mgr = buf->mgr;
 
    LIST_DEL(&buf->head);
+   LIST_DEL(&buf->bucket_head);
    assert(mgr->numDelayed);
    --mgr->numDelayed;
+   assert(mgr->stats.bytes_cached >= buf->base.size);
+   mgr->stats.bytes_cached -= buf->base.size;
+}
+
+
+/**
+ * Actually destroy the buffer.
+ */
+static INLINE void
+_pb_cache_buffer_destroy(struct pb_cache_buffer *buf)
+{
+   _pb_cache_buffer_remove(buf);
    assert(!pipe_is_referenced(&buf->base.reference));
    pb_reference(&buf->buffer, NULL);
    FREE(buf);
@@ -139,6 +179,7 @@ _pb_cache_buffer_list_check_free(struct pb_cache_manager *mgr)
 	 break;
 	 
       _pb_cache_buffer_destroy(buf);
+      ++mgr->stats.evictions;
 
       curr = next; 
       next = curr->next;
@@ -160,7 +201,10 @@ pb_cache_buffer_destroy(struct pb_buffer *_buf)
    buf->start = os_time_get();
    buf->end = buf->start + mgr->usecs;
    LIST_ADDTAIL(&buf->head, &mgr->delayed);
+   LIST_ADDTAIL(&buf->bucket_head,
+                &mgr->buckets[pb_cache_bucket(buf->base.size)]);
    ++mgr->numDelayed;
+   mgr->stats.bytes_cached += buf->base.size;
    pipe_mutex_unlock(mgr->mutex);
 }
 
@@ -256,6 +300,35 @@ pb_cache_is_buffer_compat(struct pb_cache_buffer *buf,
 }
 
 
+/**
+ * Look for a buffer to reuse in one size bucket.
+ */
+static struct pb_cache_buffer *
+_pb_cache_bucket_find(struct pb_cache_manager *mgr,
+                      unsigned bucket,
+                      pb_size size,
+                      const struct pb_desc *desc)
+{
+   struct list_head *list = &mgr->buckets[bucket];
+   struct list_head *curr;
+
+   for (curr = list->next; curr != list; curr = curr->next) {
+      struct pb_cache_buffer *buf =
+         LIST_ENTRY(struct pb_cache_buffer, curr, bucket_head);
+      int ret = pb_cache_is_buffer_compat(buf, size, desc);
+
+      if (ret > 0)
+         return buf;
+
+      /* Newer buffers are even more likely to be busy. */
+      if (ret == -1)
+         break;
+   }
+
+   return NULL;
+}
+
+
 static struct pb_buffer *
 pb_cache_manager_create_buffer(struct pb_manager *_mgr, 
                                pb_size size,
@@ -263,60 +336,31 @@ pb_cache_manager_create_buffer(struct pb_manager *_mgr,
 {
    struct pb_cache_manager *mgr = pb_cache_manager(_mgr);
    struct pb_cache_buffer *buf;
-   struct pb_cache_buffer *curr_buf;
-   struct list_head *curr, *next;
-   int64_t now;
-   int ret = 0;
+   unsigned bucket;
 
    pipe_mutex_lock(mgr->mutex);
 
-   buf = NULL;
-   curr = mgr->delayed.next;
-   next = curr->next;
-   
-   /* search in the expired buffers, freeing them in the process */
-   now = os_time_get();
-   while(curr != &mgr->delayed) {
-      curr_buf = LIST_ENTRY(struct pb_cache_buffer, curr, head);
-      if(!buf && (ret = pb_cache_is_buffer_compat(curr_buf, size, desc) > 0))
-         buf = curr_buf;
-      else if(os_time_timeout(curr_buf->start, curr_buf->end, now))
-         _pb_cache_buffer_destroy(curr_buf);
-      else
-         /* This buffer (and all hereafter) are still hot in cache */
-         break;
-      if (ret == -1)
-         break;
-      curr = next; 
-      next = curr->next;
-   }
+   _pb_cache_buffer_list_check_free(mgr);
+
+   /*
+    * Compatible buffers are at least size and less than 2*size big, so
+    * they're either in the same bucket as size, or in the next one.
+    */
+   bucket = pb_cache_bucket(size);
+   buf = _pb_cache_bucket_find(mgr, bucket, size, desc);
+   if (!buf && bucket + 1 < PB_CACHE_NUM_BUCKETS)
+      buf = _pb_cache_bucket_find(mgr, bucket + 1, size, desc);
 
-   /* keep searching in the hot buffers */
-   if(!buf && ret != -1) {
-      while(curr != &mgr->delayed) {
-         curr_buf = LIST_ENTRY(struct pb_cache_buffer, curr, head);
-         ret = pb_cache_is_buffer_compat(curr_buf, size, desc);
-         if (ret > 0) {
-            buf = curr_buf;
-            break;
-         }
-         if (ret == -1)
-            break;
-         /* no need to check the timeout here */
-         curr = next;
-         next = curr->next;
-      }
-   }
-   
    if(buf) {
-      LIST_DEL(&buf->head);
-      --mgr->numDelayed;
+      _pb_cache_buffer_remove(buf);
+      ++mgr->stats.hits;
       pipe_mutex_unlock(mgr->mutex);
       /* Increase refcount */
       pipe_reference_init(&buf->base.reference, 1);
       return &buf->base;
    }
-   
+
+   ++mgr->stats.misses;
    pipe_mutex_unlock(mgr->mutex);
 
    buf = CALLOC_STRUCT(pb_cache_buffer);
@@ -390,6 +434,7 @@ pb_cache_manager_create(struct pb_manager *provider,
                      	unsigned usecs) 
 {
    struct pb_cache_manager *mgr;
+   unsigned i;
 
    if(!provider)
       return NULL;
@@ -405,7 +450,22 @@ pb_cache_manager_create(struct pb_manager *provider,
    mgr->usecs = usecs;
    LIST_INITHEAD(&mgr->delayed);
    mgr->numDelayed = 0;
+   for (i = 0; i < PB_CACHE_NUM_BUCKETS; ++i)
+      LIST_INITHEAD(&mgr->buckets[i]);
    pipe_mutex_init(mgr->mutex);
       
    return &mgr->base;
 }
+
+
+void
+pb_cache_manager_get_stats(struct pb_manager *_mgr,
+                           struct pb_cache_stats *stats)
+{
+   struct pb_cache_manager *mgr = pb_cache_manager(_mgr);
+
+   pipe_mutex_lock(mgr->mutex);
+   *stats = mgr->stats;
+   stats->buffers_cached = mgr->numDelayed;
+   pipe_mutex_unlock(mgr->mutex);
+}
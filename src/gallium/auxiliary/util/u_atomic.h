@@ -74,6 +74,12 @@ p_atomic_cmpxchg(int32_t *v, int32_t old, int32_t _new)
    return __sync_val_compare_and_swap(v, old, _new);
 }
 
+static INLINE void *
+p_atomic_cmpxchg_ptr(void **v, void *old, void *_new)
+{
+   return __sync_val_compare_and_swap(v, old, _new);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -121,6 +127,12 @@ p_atomic_cmpxchg(int32_t *v, int32_t old, int32_t _new)
    return __sync_val_compare_and_swap(v, old, _new);
 }
 
+static INLINE void *
+p_atomic_cmpxchg_ptr(void **v, void *old, void *_new)
+{
+   return __sync_val_compare_and_swap(v, old, _new);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -166,6 +178,12 @@ p_atomic_cmpxchg(int32_t *v, int32_t old, int32_t _new)
    return __sync_val_compare_and_swap(v, old, _new);
 }
 
+static INLINE void *
+p_atomic_cmpxchg_ptr(void **v, void *old, void *_new)
+{
+   return __sync_val_compare_and_swap(v, old, _new);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -186,7 +204,33 @@ p_atomic_cmpxchg(int32_t *v, int32_t old, int32_t _new)
 #define p_atomic_dec_zero(_v) ((boolean) --(*(_v)))
 #define p_atomic_inc(_v) ((void) (*(_v))++)
 #define p_atomic_dec(_v) ((void) (*(_v))--)
-#define p_atomic_cmpxchg(_v, old, _new) (*(_v) == old ? *(_v) = (_new) : *(_v))
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Like the locked versions, these return the previous value */
+static INLINE int32_t
+p_atomic_cmpxchg(int32_t *v, int32_t old, int32_t _new)
+{
+   int32_t orig = *v;
+   if (orig == old)
+      *v = _new;
+   return orig;
+}
+
+static INLINE void *
+p_atomic_cmpxchg_ptr(void **v, void *old, void *_new)
+{
+   void *orig = *v;
+   if (orig == old)
+      *v = _new;
+   return orig;
+}
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif
 
@@ -252,6 +296,14 @@ p_atomic_cmpxchg(int32_t *v, int32_t old, int32_t _new)
    return orig;
 }
 
+static INLINE void *
+p_atomic_cmpxchg_ptr(void **v, void *old, void *_new)
+{
+   return (void *)(intptr_t)p_atomic_cmpxchg((int32_t *)v,
+                                             (int32_t)(intptr_t)old,
+                                             (int32_t)(intptr_t)_new);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -268,6 +320,7 @@ p_atomic_cmpxchg(int32_t *v, int32_t old, int32_t _new)
 #pragma intrinsic(_InterlockedIncrement)
 #pragma intrinsic(_InterlockedDecrement)
 #pragma intrinsic(_InterlockedCompareExchange)
+#pragma intrinsic(_InterlockedCompareExchangePointer)
 
 #ifdef __cplusplus
 extern "C" {
@@ -300,6 +353,12 @@ p_atomic_cmpxchg(int32_t *v, int32_t old, int32_t _new)
    return _InterlockedCompareExchange((long *)v, _new, old);
 }
 
+static INLINE void *
+p_atomic_cmpxchg_ptr(void **v, void *old, void *_new)
+{
+   return _InterlockedCompareExchangePointer(v, _new, old);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -333,6 +392,9 @@ p_atomic_dec_zero(int32_t *v)
 #define p_atomic_cmpxchg(_v, _old, _new) \
 	atomic_cas_32( (uint32_t *) _v, (uint32_t) _old, (uint32_t) _new)
 
+#define p_atomic_cmpxchg_ptr(_v, _old, _new) \
+	atomic_cas_ptr( (void *) _v, (void *) _old, (void *) _new)
+
 #ifdef __cplusplus
 }
 #endif
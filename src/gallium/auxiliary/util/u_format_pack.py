@@ -594,6 +594,9 @@ def generate_format_unpack(format, dst_channel, dst_native_type, dst_suffix):
 
     if is_format_supported(format):
         print '   unsigned x, y;'
+        if has_sse2_unpack(format):
+            generate_sse2_dispatch('util_format_%s_unpack_%s' % (name, dst_suffix),
+                                   'dst_row, dst_stride, src_row, src_stride, width, height')
         print '   for(y = 0; y < height; y += %u) {' % (format.block_height,)
         print '      %s *dst = dst_row;' % (dst_native_type)
         print '      const uint8_t *src = src_row;'
@@ -623,6 +626,9 @@ def generate_format_pack(format, src_channel, src_native_type, src_suffix):
     
     if is_format_supported(format):
         print '   unsigned x, y;'
+        if has_sse2_pack(format):
+            generate_sse2_dispatch('util_format_%s_pack_%s' % (name, src_suffix),
+                                   'dst_row, dst_stride, src_row, src_stride, width, height')
         print '   for(y = 0; y < height; y += %u) {' % (format.block_height,)
         print '      const %s *src = src_row;' % (src_native_type)
         print '      uint8_t *dst = dst_row;'
@@ -641,6 +647,333 @@ def generate_format_pack(format, src_channel, src_native_type, src_suffix):
     print
     
 
+def is_format_sse2(format):
+    '''Whether SSE2 row kernels are generated for this format.
+
+    These are the common unorm RGB formats, with either four 8-bit
+    channels, or packed into 16 bits (565, 5551, 4444, 88, etc).  The
+    kernels give exactly the same results as the scalar code.'''
+
+    if format.layout != PLAIN or format.colorspace != RGB:
+        return False
+    if not format.is_bitmask() or format.block_size() not in (16, 32):
+        return False
+    for channel in format.channels:
+        if channel.type == VOID:
+            continue
+        if channel.type != UNSIGNED or not channel.norm:
+            return False
+        if format.block_size() == 32 and channel.size != 8:
+            return False
+    if format.block_size() == 32:
+        for channel in format.channels:
+            if channel.size != 8:
+                return False
+    return True
+
+
+def sse2_byte_permute(dst, src, sel):
+    '''Generate the statement to rearrange the bytes within each 32-bit lane.
+
+    sel[i] is the source byte for destination byte i, None for zero, or
+    SWIZZLE_1 for 0xff.'''
+
+    deltas = {}
+    ones = 0
+    for i in range(4):
+        if sel[i] is None:
+            continue
+        if sel[i] == SWIZZLE_1:
+            ones |= 0xff << (8*i)
+            continue
+        deltas.setdefault(i - sel[i], []).append(i)
+
+    terms = []
+    for delta in sorted(deltas.keys()):
+        bytes = deltas[delta]
+        mask = 0
+        for i in bytes:
+            mask |= 0xff << (8*i)
+        if delta > 0:
+            term = '_mm_slli_epi32(%s, %u)' % (src, 8*delta)
+            needs_mask = bytes != range(delta, 4)
+        elif delta < 0:
+            term = '_mm_srli_epi32(%s, %u)' % (src, -8*delta)
+            needs_mask = bytes != range(0, 4 + delta)
+        else:
+            term = src
+            needs_mask = bytes != range(0, 4)
+        if needs_mask:
+            term = '_mm_and_si128(%s, _mm_set1_epi32(0x%08x))' % (term, mask)
+        terms.append(term)
+    if ones:
+        terms.append('_mm_set1_epi32(0x%08x)' % ones)
+
+    if not terms:
+        value = '_mm_setzero_si128()'
+    else:
+        value = terms[0]
+        for term in terms[1:]:
+            value = '_mm_or_si128(%s, %s)' % (value, term)
+    print '         %s = %s;' % (dst, value)
+
+
+def sse2_unpack_sel(format):
+    '''Source byte for each RGBA byte, for formats with four 8-bit channels.'''
+    sel = []
+    for i in range(4):
+        swizzle = format.swizzles[i]
+        if swizzle < 4:
+            sel.append(swizzle)
+        elif swizzle == SWIZZLE_1:
+            sel.append(SWIZZLE_1)
+        else:
+            sel.append(None)
+    return sel
+
+
+def sse2_expand_16bit_channel(format, swizzle, dst_channel):
+    '''Generate the expression for 8 channel values from a 16-bit pixel vector,
+    converted to 8 bit unorm, or unconverted if dst_channel is FLOAT.'''
+
+    if swizzle == SWIZZLE_1:
+        if dst_channel.type == FLOAT:
+            return None
+        return '_mm_set1_epi16(0xff)'
+    if swizzle >= 4:
+        return '_mm_setzero_si128()'
+
+    shift = 0
+    for i in range(swizzle):
+        shift += format.channels[i].size
+    size = format.channels[swizzle].size
+
+    value = 'p'
+    if shift:
+        value = '_mm_srli_epi16(%s, %u)' % (value, shift)
+    if shift + size < 16:
+        value = '_mm_and_si128(%s, _mm_set1_epi16(0x%x))' % (value, (1 << size) - 1)
+
+    if dst_channel.type == FLOAT:
+        return value
+
+    # Same as the scalar (v * 0xff / max), using a multiplication by the
+    # reciprocal, checked here to be exact for all possible values.
+    max = (1 << size) - 1
+    if size > 8:
+        value = '_mm_srli_epi16(%s, %u)' % (value, size - 8)
+    elif 0xff % max == 0:
+        if max != 0xff:
+            value = '_mm_mullo_epi16(%s, _mm_set1_epi16(0x%x))' % (value, 0xff / max)
+    else:
+        for shift in range(8):
+            m = ((1 << (16 + shift)) + max - 1) / max
+            if m < 0x10000 and \
+               all([(v * 0xff * m) >> (16 + shift) == v * 0xff / max for v in range(max + 1)]):
+                break
+        else:
+            assert False
+        value = '_mm_mulhi_epu16(_mm_mullo_epi16(%s, _mm_set1_epi16(0xff)), _mm_set1_epi16((short)0x%x))' % (value, m)
+        if shift:
+            value = '_mm_srli_epi16(%s, %u)' % (value, shift)
+    return value
+
+
+def generate_sse2_unpack_kernel(format, dst_channel, dst_native_type):
+    '''Generate the SSE2 code to unpack one vector of pixels.'''
+
+    print '         __m128i p = _mm_loadu_si128((const __m128i *)src);'
+
+    if format.block_size() == 32:
+        if dst_channel.type != FLOAT:
+            print '         __m128i rgba;'
+            sse2_byte_permute('rgba', 'p', sse2_unpack_sel(format))
+            print '         _mm_storeu_si128((__m128i *)dst, rgba);'
+            return
+
+        # Leave the ones out and OR the 1.0f in after converting
+        sel = sse2_unpack_sel(format)
+        ones = ['0'] * 4
+        for i in range(4):
+            if sel[i] == SWIZZLE_1:
+                sel[i] = None
+                ones[i] = '1.0f'
+        print '         const __m128i zero = _mm_setzero_si128();'
+        print '         const __m128 scale = _mm_set1_ps(1.0f/0xff);'
+        if '1.0f' in ones:
+            print '         const __m128 ones = _mm_setr_ps(%s);' % ', '.join(ones)
+        print '         __m128i rgba, lo, hi;'
+        sse2_byte_permute('rgba', 'p', sel)
+        print '         lo = _mm_unpacklo_epi8(rgba, zero);'
+        print '         hi = _mm_unpackhi_epi8(rgba, zero);'
+        for i, half, unpack in ((0, 'lo', 'lo'), (1, 'lo', 'hi'), (2, 'hi', 'lo'), (3, 'hi', 'hi')):
+            value = '_mm_cvtepi32_ps(_mm_unpack%s_epi16(%s, zero))' % (unpack, half)
+            value = '_mm_mul_ps(%s, scale)' % value
+            if '1.0f' in ones:
+                value = '_mm_or_ps(%s, ones)' % value
+            print '         _mm_storeu_ps(dst + %u, %s);' % (4*i, value)
+        return
+
+    assert format.block_size() == 16
+
+    if dst_channel.type != FLOAT:
+        print '         __m128i r, g, b, a, rg, ba;'
+        for i in range(4):
+            value = sse2_expand_16bit_channel(format, format.swizzles[i], dst_channel)
+            print '         %s = %s;' % ('rgba'[i], value)
+        print '         rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));'
+        print '         ba = _mm_or_si128(b, _mm_slli_epi16(a, 8));'
+        print '         _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(rg, ba));'
+        print '         _mm_storeu_si128((__m128i *)(dst + 16), _mm_unpackhi_epi16(rg, ba));'
+        return
+
+    print '         const __m128i zero = _mm_setzero_si128();'
+    print '         __m128 r[2], g[2], b[2], a[2];'
+    print '         __m128i c;'
+    print '         unsigned i;'
+    for i in range(4):
+        swizzle = format.swizzles[i]
+        name = 'rgba'[i]
+        if swizzle == SWIZZLE_1:
+            print '         %s[0] = %s[1] = _mm_set1_ps(1.0f);' % (name, name)
+        elif swizzle >= 4:
+            print '         %s[0] = %s[1] = _mm_setzero_ps();' % (name, name)
+        else:
+            max = (1 << format.channels[swizzle].size) - 1
+            print '         c = %s;' % sse2_expand_16bit_channel(format, swizzle, dst_channel)
+            for j, half in ((0, 'lo'), (1, 'hi')):
+                print '         %s[%u] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpack%s_epi16(c, zero)), _mm_set1_ps(1.0f/0x%x));' % (name, j, half, max)
+    print '         for(i = 0; i < 2; ++i) {'
+    print '            _MM_TRANSPOSE4_PS(r[i], g[i], b[i], a[i]);'
+    print '            _mm_storeu_ps(dst + 16*i + 0, r[i]);'
+    print '            _mm_storeu_ps(dst + 16*i + 4, g[i]);'
+    print '            _mm_storeu_ps(dst + 16*i + 8, b[i]);'
+    print '            _mm_storeu_ps(dst + 16*i + 12, a[i]);'
+    print '         }'
+
+
+def generate_sse2_pack_kernel(format, src_channel, src_native_type):
+    '''Generate the SSE2 code to pack one vector of pixels.'''
+
+    assert format.block_size() == 32
+
+    sel = format.inv_swizzles()
+
+    if src_channel.type != FLOAT:
+        print '         __m128i rgba = _mm_loadu_si128((const __m128i *)src);'
+        print '         __m128i p;'
+        sse2_byte_permute('p', 'rgba', sel)
+        print '         _mm_storeu_si128((__m128i *)dst, p);'
+        return
+
+    # Same as float_to_ubyte()
+    print '         const __m128 scale = _mm_set1_ps(255.0f/256.0f);'
+    print '         const __m128 bias = _mm_set1_ps(32768.0f);'
+    print '         const __m128i zero = _mm_setzero_si128();'
+    print '         const __m128i max = _mm_set1_epi32(0x3f7effff);'
+    print '         const __m128i ff = _mm_set1_epi32(0xff);'
+    print '         __m128i c[4], rgba, p;'
+    print '         unsigned i;'
+    print '         for(i = 0; i < 4; ++i) {'
+    print '            __m128 f = _mm_loadu_ps(src + 4*i);'
+    print '            __m128i fi = _mm_castps_si128(f);'
+    print '            __m128i ub = _mm_and_si128(_mm_castps_si128(_mm_add_ps(_mm_mul_ps(f, scale), bias)), ff);'
+    print '            __m128i sat = _mm_cmpgt_epi32(fi, max);'
+    print '            ub = _mm_or_si128(_mm_andnot_si128(sat, ub), _mm_and_si128(sat, ff));'
+    print '            c[i] = _mm_andnot_si128(_mm_cmplt_epi32(fi, zero), ub);'
+    print '         }'
+    print '         rgba = _mm_packus_epi16(_mm_packs_epi32(c[0], c[1]), _mm_packs_epi32(c[2], c[3]));'
+    sse2_byte_permute('p', 'rgba', sel)
+    print '         _mm_storeu_si128((__m128i *)dst, p);'
+
+
+def generate_format_unpack_sse2(format, dst_channel, dst_native_type, dst_suffix):
+    '''Generate the SSE2 function to unpack pixels from a particular format'''
+
+    name = format.short_name()
+    pixels = 128 / format.block_size()
+
+    print 'static void'
+    print 'util_format_%s_unpack_%s_sse2(%s *dst_row, unsigned dst_stride, const uint8_t *src_row, unsigned src_stride, unsigned width, unsigned height)' % (name, dst_suffix, dst_native_type)
+    print '{'
+    print '   unsigned x, y;'
+    print '   for(y = 0; y < height; y += 1) {'
+    print '      %s *dst = dst_row;' % (dst_native_type)
+    print '      const uint8_t *src = src_row;'
+    print '      for(x = 0; x + %u <= width; x += %u) {' % (pixels, pixels)
+
+    generate_sse2_unpack_kernel(format, dst_channel, dst_native_type)
+
+    print '         src += 16;'
+    print '         dst += %u;' % (4 * pixels,)
+    print '      }'
+    print '      for(; x < width; x += 1) {'
+
+    generate_unpack_kernel(format, dst_channel, dst_native_type)
+
+    print '         src += %u;' % (format.block_size() / 8,)
+    print '         dst += 4;'
+    print '      }'
+    print '      src_row += src_stride;'
+    print '      dst_row += dst_stride/sizeof(*dst_row);'
+    print '   }'
+    print '}'
+    print
+
+
+def generate_format_pack_sse2(format, src_channel, src_native_type, src_suffix):
+    '''Generate the SSE2 function to pack pixels to a particular format'''
+
+    name = format.short_name()
+    pixels = 128 / format.block_size()
+
+    print 'static void'
+    print 'util_format_%s_pack_%s_sse2(uint8_t *dst_row, unsigned dst_stride, const %s *src_row, unsigned src_stride, unsigned width, unsigned height)' % (name, src_suffix, src_native_type)
+    print '{'
+    print '   unsigned x, y;'
+    print '   for(y = 0; y < height; y += 1) {'
+    print '      const %s *src = src_row;' % (src_native_type)
+    print '      uint8_t *dst = dst_row;'
+    print '      for(x = 0; x + %u <= width; x += %u) {' % (pixels, pixels)
+
+    generate_sse2_pack_kernel(format, src_channel, src_native_type)
+
+    print '         src += %u;' % (4 * pixels,)
+    print '         dst += 16;'
+    print '      }'
+    print '      for(; x < width; x += 1) {'
+
+    generate_pack_kernel(format, src_channel, src_native_type)
+
+    print '         src += 4;'
+    print '         dst += %u;' % (format.block_size() / 8,)
+    print '      }'
+    print '      dst_row += dst_stride;'
+    print '      src_row += src_stride/sizeof(*src_row);'
+    print '   }'
+    print '}'
+    print
+
+
+def has_sse2_unpack(format):
+    return is_format_sse2(format)
+
+
+def has_sse2_pack(format):
+    # Packing into 16-bit formats needs rounding divisions which don't
+    # vectorize exactly with SSE2, so only the 8-bit channel ones for now.
+    return is_format_sse2(format) and format.block_size() == 32
+
+
+def generate_sse2_dispatch(function, args):
+    print '#if defined(PIPE_ARCH_SSE)'
+    print '   if (util_cpu_caps.has_sse2) {'
+    print '      %s_sse2(%s);' % (function, args)
+    print '      return;'
+    print '   }'
+    print '#endif'
+
+
 def generate_format_fetch(format, dst_channel, dst_native_type, dst_suffix):
     '''Generate the function to unpack pixels from a particular format'''
 
@@ -671,6 +1004,8 @@ def generate(formats):
     print '#include "u_format_srgb.h"'
     print '#include "u_format_yuv.h"'
     print '#include "u_format_zs.h"'
+    print '#include "u_cpu_detect.h"'
+    print '#include "u_sse.h"'
     print
 
     for format in formats:
@@ -708,6 +1043,19 @@ def generate(formats):
                 generate_format_unpack(format, channel, native_type, suffix)
                 generate_format_pack(format, channel, native_type, suffix)   
             else:
+                if is_format_sse2(format):
+                    print '#if defined(PIPE_ARCH_SSE)'
+                    print
+                    for channel, native_type, suffix in (
+                            (Channel(FLOAT, False, False, 32), 'float', 'rgba_float'),
+                            (Channel(UNSIGNED, True, False, 8), 'uint8_t', 'rgba_8unorm')):
+                        if has_sse2_unpack(format):
+                            generate_format_unpack_sse2(format, channel, native_type, suffix)
+                        if has_sse2_pack(format):
+                            generate_format_pack_sse2(format, channel, native_type, suffix)
+                    print '#endif /* PIPE_ARCH_SSE */'
+                    print
+
                 channel = Channel(FLOAT, False, False, 32)
                 native_type = 'float'
                 suffix = 'rgba_float'
@@ -0,0 +1,104 @@
+/**************************************************************************
+ *
+ * Copyright 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/**
+ * @file
+ * Accumulating timers for instrumenting hot paths.
+ *
+ * A stage is bracketed with util_perf_timer_begin() and
+ * util_perf_timer_end().  The clock is only read while timers are enabled,
+ * which drivers do while a query sampling them is active, so a disabled
+ * timer costs a single well predicted branch.
+ *
+ * Timers are never reset.  Queries sample them when they begin and end and
+ * report the difference, so any number of queries may overlap.
+ */
+
+#ifndef U_PERF_TIMER_H
+#define U_PERF_TIMER_H
+
+#include "pipe/p_compiler.h"
+#include "os/os_time.h"
+#include "util/u_atomic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+struct util_perf_timer {
+   uint64_t time;    /**< accumulated time, in nanoseconds */
+   uint64_t count;   /**< number of timed intervals */
+};
+
+
+/** Number of users which currently need timers, see util_perf_timers_enable */
+extern int32_t util_perf_timers_enabled;
+
+
+static INLINE void
+util_perf_timers_enable(void)
+{
+   p_atomic_inc(&util_perf_timers_enabled);
+}
+
+
+static INLINE void
+util_perf_timers_disable(void)
+{
+   p_atomic_dec(&util_perf_timers_enabled);
+}
+
+
+/**
+ * Start timing an interval.  Returns zero when timers are disabled, which
+ * makes the matching util_perf_timer_end() a no-op.
+ */
+static INLINE int64_t
+util_perf_timer_begin(void)
+{
+   if (unlikely(p_atomic_read(&util_perf_timers_enabled)))
+      return os_time_get_nano();
+   return 0;
+}
+
+
+static INLINE void
+util_perf_timer_end(struct util_perf_timer *timer, int64_t start)
+{
+   if (unlikely(start)) {
+      timer->time += os_time_get_nano() - start;
+      timer->count++;
+   }
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* U_PERF_TIMER_H */
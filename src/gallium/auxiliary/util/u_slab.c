@@ -22,6 +22,7 @@
 
 #include "util/u_slab.h"
 
+#include "util/u_atomic.h"
 #include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_simple_list.h"
@@ -169,3 +170,216 @@ void util_slab_destroy(struct util_slab_mempool *pool)
 
    pipe_mutex_destroy(pool->mutex);
 }
+
+
+/* A block of a util_slab_cache. */
+struct util_slab_cache_block {
+   struct util_slab_cache_block *next_free;
+
+   /* The cache the block was allocated from. */
+   struct util_slab_cache *cache;
+};
+
+struct util_slab_cache_page {
+   struct util_slab_cache_page *next;
+};
+
+struct util_slab_cache {
+   /* Only accessed by the owning thread. */
+   struct util_slab_cache_block *first_free;
+   struct util_slab_cache_page *pages;
+
+   /* Blocks freed by other threads, or UTIL_SLAB_CACHE_ORPHANED once the
+    * cache has been destroyed. */
+   struct util_slab_cache_block *migrated;
+
+   /* Number of blocks still in use after the cache has been destroyed,
+    * plus one for the destroying thread itself. */
+   int32_t orphaned_blocks;
+
+   unsigned block_size;
+   unsigned num_blocks;
+   unsigned num_pages;
+};
+
+#define UTIL_SLAB_CACHE_ORPHANED ((struct util_slab_cache_block *)(intptr_t)1)
+
+static struct util_slab_cache_block *
+util_slab_cache_get_block(struct util_slab_cache *cache,
+                          struct util_slab_cache_page *page, unsigned index)
+{
+   return (struct util_slab_cache_block*)
+          ((uint8_t*)page + sizeof(struct util_slab_cache_page) +
+           (cache->block_size * index));
+}
+
+static boolean
+util_slab_cache_add_new_page(struct util_slab_cache *cache)
+{
+   struct util_slab_cache_page *page;
+   struct util_slab_cache_block *block;
+   unsigned i;
+
+   page = MALLOC(sizeof(struct util_slab_cache_page) +
+                 cache->num_blocks * cache->block_size);
+   if (!page)
+      return FALSE;
+
+   page->next = cache->pages;
+   cache->pages = page;
+
+   for (i = 0; i < cache->num_blocks; i++) {
+      block = util_slab_cache_get_block(cache, page, i);
+      block->next_free = i + 1 < cache->num_blocks ?
+                         util_slab_cache_get_block(cache, page, i + 1) :
+                         cache->first_free;
+      block->cache = cache;
+   }
+
+   cache->first_free = util_slab_cache_get_block(cache, page, 0);
+   cache->num_pages++;
+
+   return TRUE;
+}
+
+/**
+ * Atomically replace the list of migrated blocks and return the old one.
+ */
+static struct util_slab_cache_block *
+util_slab_cache_take_migrated(struct util_slab_cache *cache,
+                              struct util_slab_cache_block *replacement)
+{
+   struct util_slab_cache_block *head;
+
+   do {
+      head = p_atomic_read(&cache->migrated);
+   } while (p_atomic_cmpxchg_ptr((void **)&cache->migrated,
+                                 head, replacement) != head);
+
+   return head;
+}
+
+static void
+util_slab_cache_release(struct util_slab_cache *cache)
+{
+   struct util_slab_cache_page *page, *next;
+
+   for (page = cache->pages; page; page = next) {
+      next = page->next;
+      FREE(page);
+   }
+
+   FREE(cache);
+}
+
+/**
+ * Drop some of the references held on a destroyed cache.
+ */
+static void
+util_slab_cache_unref_orphaned(struct util_slab_cache *cache, int32_t count)
+{
+   int32_t old;
+
+   if (count > 1) {
+      do {
+         old = p_atomic_read(&cache->orphaned_blocks);
+      } while (p_atomic_cmpxchg(&cache->orphaned_blocks,
+                                old, old - (count - 1)) != old);
+   }
+
+   if (count && p_atomic_dec_zero(&cache->orphaned_blocks))
+      util_slab_cache_release(cache);
+}
+
+struct util_slab_cache *
+util_slab_cache_create(unsigned item_size, unsigned num_blocks)
+{
+   struct util_slab_cache *cache = CALLOC_STRUCT(util_slab_cache);
+
+   if (!cache)
+      return NULL;
+
+   item_size = align(item_size, sizeof(intptr_t));
+
+   cache->block_size = sizeof(struct util_slab_cache_block) + item_size;
+   cache->block_size = align(cache->block_size, sizeof(intptr_t));
+   cache->num_blocks = MAX2(num_blocks, 1);
+
+   return cache;
+}
+
+void
+util_slab_cache_destroy(struct util_slab_cache *cache)
+{
+   struct util_slab_cache_block *block;
+   int32_t num_free = 0;
+
+   if (!cache)
+      return;
+
+   /* Every block not known to be free now holds a reference, and the
+    * threads freeing them will drop it once they see the cache is gone. */
+   p_atomic_set(&cache->orphaned_blocks,
+                cache->num_pages * cache->num_blocks + 1);
+
+   for (block = cache->first_free; block; block = block->next_free)
+      num_free++;
+
+   block = util_slab_cache_take_migrated(cache, UTIL_SLAB_CACHE_ORPHANED);
+   for (; block; block = block->next_free)
+      num_free++;
+
+   util_slab_cache_unref_orphaned(cache, num_free + 1);
+}
+
+void *
+util_slab_cache_alloc(struct util_slab_cache *cache)
+{
+   struct util_slab_cache_block *block = cache->first_free;
+
+   if (!block) {
+      block = util_slab_cache_take_migrated(cache, NULL);
+      if (!block) {
+         if (!util_slab_cache_add_new_page(cache))
+            return NULL;
+         block = cache->first_free;
+      }
+   }
+
+   assert(block->cache == cache);
+   cache->first_free = block->next_free;
+
+   return (uint8_t*)block + sizeof(struct util_slab_cache_block);
+}
+
+void
+util_slab_cache_free(struct util_slab_cache *cache, void *ptr)
+{
+   struct util_slab_cache_block *block, *head;
+   struct util_slab_cache *owner;
+
+   if (!ptr)
+      return;
+
+   block = (struct util_slab_cache_block*)
+           ((uint8_t*)ptr - sizeof(struct util_slab_cache_block));
+   owner = block->cache;
+
+   if (owner == cache) {
+      block->next_free = cache->first_free;
+      cache->first_free = block;
+      return;
+   }
+
+   /* Pushing onto the list is safe against ABA, as the owner only ever
+    * takes the whole list at once. */
+   do {
+      head = p_atomic_read(&owner->migrated);
+      if (head == UTIL_SLAB_CACHE_ORPHANED) {
+         util_slab_cache_unref_orphaned(owner, 1);
+         return;
+      }
+      block->next_free = head;
+   } while (p_atomic_cmpxchg_ptr((void **)&owner->migrated,
+                                 head, block) != head);
+}
@@ -30,6 +30,12 @@
  *
  * Candidates: transfer_map
  *
+ * util_slab_cache is a variant for objects which are allocated by one thread
+ * (usually the one owning a context) but may be freed by any thread.
+ * Allocations and frees on the owning thread take no locks and no atomic
+ * operations, while frees from other threads push the block lock-free onto
+ * a list which the owner takes back once it runs out of free blocks.
+ *
  * @author Marek Olšák
  */
 
@@ -84,4 +90,22 @@ void util_slab_set_thread_safety(struct util_slab_mempool *pool,
 #define util_slab_alloc(pool)     (pool)->alloc(pool)
 #define util_slab_free(pool, ptr) (pool)->free(pool, ptr)
 
+
+/* Per-thread slab cache. */
+struct util_slab_cache;
+
+struct util_slab_cache *
+util_slab_cache_create(unsigned item_size, unsigned num_blocks);
+
+/* Blocks which are still in use when the cache is destroyed remain valid,
+ * and the cache memory is released once the last of them is freed. */
+void util_slab_cache_destroy(struct util_slab_cache *cache);
+
+/* Must only be called by the thread owning the cache. */
+void *util_slab_cache_alloc(struct util_slab_cache *cache);
+
+/* The cache is the one owned by the calling thread, if any, which may be
+ * NULL or different from the cache the block was allocated from. */
+void util_slab_cache_free(struct util_slab_cache *cache, void *ptr);
+
 #endif
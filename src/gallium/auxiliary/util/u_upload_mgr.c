@@ -32,12 +32,28 @@
 #include "pipe/p_defines.h"
 #include "util/u_inlines.h"
 #include "pipe/p_context.h"
+#include "pipe/p_screen.h"
 #include "util/u_memory.h"
 #include "util/u_math.h"
 
 #include "u_upload_mgr.h"
 
 
+/* Number of submitted ranges of a ring buffer tracked separately.  Older
+ * ranges are merged together beyond that. */
+#define U_UPLOAD_MAX_RANGES 32
+
+/* How much larger than the default size a ring buffer may grow. */
+#define U_UPLOAD_MAX_RING_GROWTH 16
+
+
+/* A range of the ring buffer submitted for rendering. */
+struct u_upload_range {
+   unsigned size;                     /* Bytes, including any padding. */
+   struct pipe_fence_handle *fence;   /* Signalled once the range is idle. */
+};
+
+
 struct u_upload_mgr {
    struct pipe_context *pipe;
 
@@ -51,6 +67,15 @@ struct u_upload_mgr {
    unsigned size;   /* Actual size of the upload buffer. */
    unsigned offset; /* Aligned offset to the upload buffer, pointing
                      * at the first unused byte. */
+
+   /* Ring mode, see u_upload_create_ring(). */
+   boolean ring;
+   boolean persistent; /* Keep the buffer mapped across u_upload_unmap(). */
+   unsigned used;      /* Bytes in use, ending at offset and wrapping around. */
+   unsigned fenced;    /* Bytes of used which belong to the ranges below. */
+   unsigned dirty;     /* Bytes written but not flushed yet, ending at offset. */
+   struct u_upload_range ranges[U_UPLOAD_MAX_RANGES];
+   unsigned first_range, num_ranges;
 };
 
 
@@ -72,8 +97,131 @@ struct u_upload_mgr *u_upload_create( struct pipe_context *pipe,
    return upload;
 }
 
+struct u_upload_mgr *u_upload_create_ring( struct pipe_context *pipe,
+                                           unsigned size,
+                                           unsigned alignment,
+                                           unsigned bind )
+{
+   struct pipe_screen *screen = pipe->screen;
+   struct u_upload_mgr *upload = u_upload_create(pipe, size, alignment, bind);
+   if (!upload)
+      return NULL;
+
+   upload->ring = TRUE;
+   upload->persistent =
+      screen->get_param(screen, PIPE_CAP_BUFFER_MAP_PERSISTENT);
+
+   return upload;
+}
+
+/* Flush the bytes written to the ring buffer since the last flush.
+ */
+static void u_upload_ring_flush_dirty( struct u_upload_mgr *upload )
+{
+   unsigned dirty = upload->dirty;
+
+   if (!dirty)
+      return;
+
+   if (dirty > upload->offset) {
+      /* Wrapped around */
+      pipe_buffer_flush_mapped_range(upload->pipe, upload->transfer,
+                                     upload->size - (dirty - upload->offset),
+                                     dirty - upload->offset);
+      dirty = upload->offset;
+   }
+
+   if (dirty) {
+      pipe_buffer_flush_mapped_range(upload->pipe, upload->transfer,
+                                     upload->offset - dirty, dirty);
+   }
+
+   upload->dirty = 0;
+}
+
+static enum pipe_error u_upload_ring_map( struct u_upload_mgr *upload )
+{
+   /* Ranges still being rendered from are never written, so the whole
+    * buffer can be mapped without waiting. */
+   upload->map = pipe_buffer_map_range(upload->pipe, upload->buffer,
+                                       0, upload->size,
+                                       PIPE_TRANSFER_WRITE |
+                                       PIPE_TRANSFER_FLUSH_EXPLICIT |
+                                       PIPE_TRANSFER_UNSYNCHRONIZED,
+                                       &upload->transfer);
+   if (!upload->map) {
+      upload->transfer = NULL;
+      return PIPE_ERROR_OUT_OF_MEMORY;
+   }
+
+   return PIPE_OK;
+}
+
+/* Forget about all ranges and release the ring buffer.
+ */
+static void u_upload_ring_release( struct u_upload_mgr *upload )
+{
+   struct pipe_screen *screen = upload->pipe->screen;
+
+   if (upload->transfer) {
+      u_upload_ring_flush_dirty(upload);
+      pipe_transfer_unmap(upload->pipe, upload->transfer);
+      upload->transfer = NULL;
+      upload->map = NULL;
+   }
+
+   while (upload->num_ranges) {
+      struct u_upload_range *range = &upload->ranges[upload->first_range];
+      screen->fence_reference(screen, &range->fence, NULL);
+      upload->first_range = (upload->first_range + 1) % U_UPLOAD_MAX_RANGES;
+      upload->num_ranges--;
+   }
+
+   pipe_resource_reference(&upload->buffer, NULL);
+   upload->offset = 0;
+   upload->used = 0;
+   upload->fenced = 0;
+   upload->dirty = 0;
+}
+
+/* Retire the oldest submitted range if rendering is done with it.
+ */
+static boolean u_upload_ring_retire( struct u_upload_mgr *upload )
+{
+   struct pipe_screen *screen = upload->pipe->screen;
+   struct u_upload_range *range;
+
+   if (!upload->num_ranges)
+      return FALSE;
+
+   /* A range without a fence was submitted by a flush which didn't return
+    * one, so it is busy until a later fence covers it too. */
+   range = &upload->ranges[upload->first_range];
+   if (!range->fence || !screen->fence_signalled(screen, range->fence))
+      return FALSE;
+
+   screen->fence_reference(screen, &range->fence, NULL);
+   upload->used -= range->size;
+   upload->fenced -= range->size;
+   upload->first_range = (upload->first_range + 1) % U_UPLOAD_MAX_RANGES;
+   upload->num_ranges--;
+   return TRUE;
+}
+
 void u_upload_unmap( struct u_upload_mgr *upload )
 {
+   if (upload->ring) {
+      if (upload->transfer) {
+         u_upload_ring_flush_dirty(upload);
+         if (!upload->persistent) {
+            pipe_transfer_unmap(upload->pipe, upload->transfer);
+            upload->transfer = NULL;
+            upload->map = NULL;
+         }
+      }
+      return;
+   }
+
    if (upload->transfer) {
       struct pipe_box *box = &upload->transfer->box;
       if ((int) upload->offset > box->x) {
@@ -100,6 +248,8 @@ void u_upload_flush( struct u_upload_mgr *upload )
 {
    /* Unmap and unreference the upload buffer. */
    u_upload_unmap(upload);
+   if (upload->ring)
+      return;
    pipe_resource_reference( &upload->buffer, NULL );
    upload->size = 0;
 }
@@ -107,7 +257,10 @@ void u_upload_flush( struct u_upload_mgr *upload )
 
 void u_upload_destroy( struct u_upload_mgr *upload )
 {
-   u_upload_flush( upload );
+   if (upload->ring)
+      u_upload_ring_release( upload );
+   else
+      u_upload_flush( upload );
    FREE( upload );
 }
 
@@ -152,6 +305,131 @@ u_upload_alloc_buffer( struct u_upload_mgr *upload,
    return PIPE_OK;
 }
 
+void u_upload_fence( struct u_upload_mgr *upload,
+                     struct pipe_fence_handle *fence )
+{
+   struct pipe_screen *screen = upload->pipe->screen;
+   unsigned size = upload->used - upload->fenced;
+   struct u_upload_range *range;
+
+   if (!upload->ring || !size)
+      return;
+
+   if (upload->num_ranges == U_UPLOAD_MAX_RANGES) {
+      /* Fences signal in order, so the newest range can simply be extended
+       * to also cover the new one. */
+      range = &upload->ranges[(upload->first_range + upload->num_ranges - 1) %
+                              U_UPLOAD_MAX_RANGES];
+      range->size += size;
+   }
+   else {
+      range = &upload->ranges[(upload->first_range + upload->num_ranges) %
+                              U_UPLOAD_MAX_RANGES];
+      range->size = size;
+      range->fence = NULL;
+      upload->num_ranges++;
+   }
+
+   screen->fence_reference(screen, &range->fence, fence);
+   upload->fenced += size;
+
+   /* Fences signal in order, so a real fence also covers the ranges
+    * submitted before without one. */
+   if (fence) {
+      unsigned i;
+      for (i = 0; i < upload->num_ranges; i++) {
+         range = &upload->ranges[(upload->first_range + i) %
+                                 U_UPLOAD_MAX_RANGES];
+         if (!range->fence)
+            screen->fence_reference(screen, &range->fence, fence);
+      }
+   }
+}
+
+/* Create a new ring buffer, large enough for min_size bytes.
+ */
+static enum pipe_error
+u_upload_ring_alloc_buffer( struct u_upload_mgr *upload,
+                            unsigned min_size )
+{
+   unsigned size = upload->default_size;
+
+   /* Needing a new buffer while the old one was not full means that
+    * rendering is lagging behind, so grow the ring to cover more frames. */
+   if (upload->size)
+      size = MIN2(upload->size * 2,
+                  upload->default_size * U_UPLOAD_MAX_RING_GROWTH);
+
+   size = align(MAX2(size, min_size), 4096);
+
+   u_upload_ring_release( upload );
+
+   upload->buffer = pipe_buffer_create( upload->pipe->screen,
+                                        upload->bind,
+                                        PIPE_USAGE_STREAM,
+                                        size );
+   if (upload->buffer == NULL) {
+      upload->size = 0;
+      return PIPE_ERROR_OUT_OF_MEMORY;
+   }
+
+   upload->size = size;
+   return PIPE_OK;
+}
+
+/* Find room for a sub-allocation in the ring buffer.
+ */
+static enum pipe_error
+u_upload_ring_alloc( struct u_upload_mgr *upload,
+                     unsigned alloc_offset,
+                     unsigned alloc_size,
+                     unsigned *out_offset )
+{
+   unsigned offset, required;
+   enum pipe_error ret;
+
+   if (!upload->buffer || alloc_offset + alloc_size > upload->size) {
+      ret = u_upload_ring_alloc_buffer(upload, alloc_offset + alloc_size);
+      if (ret != PIPE_OK)
+         return ret;
+   }
+
+   for (;;) {
+      offset = MAX2(upload->offset, alloc_offset);
+      if (offset + alloc_size > upload->size) {
+         /* Wrap around, skipping the rest of the buffer */
+         offset = alloc_offset;
+         required = upload->size - upload->offset + offset + alloc_size;
+      }
+      else {
+         required = offset + alloc_size - upload->offset;
+      }
+
+      if (upload->size - upload->used >= required)
+         break;
+
+      /* Only wrap onto ranges rendering is done with.  Rather than waiting
+       * for the others, or for data which hasn't even been submitted yet,
+       * start over with a new buffer. */
+      if (!u_upload_ring_retire(upload)) {
+         ret = u_upload_ring_alloc_buffer(upload, alloc_offset + alloc_size);
+         if (ret != PIPE_OK)
+            return ret;
+      }
+   }
+
+   if (!upload->map) {
+      ret = u_upload_ring_map(upload);
+      if (ret != PIPE_OK)
+         return ret;
+   }
+
+   upload->used += required;
+   upload->dirty = MIN2(upload->dirty + required, upload->size);
+   *out_offset = offset;
+   return PIPE_OK;
+}
+
 enum pipe_error u_upload_alloc( struct u_upload_mgr *upload,
                                 unsigned min_out_offset,
                                 unsigned size,
@@ -170,6 +448,20 @@ enum pipe_error u_upload_alloc( struct u_upload_mgr *upload,
    pipe_resource_reference(outbuf, NULL);
    *ptr = NULL;
 
+   if (upload->ring) {
+      enum pipe_error ret = u_upload_ring_alloc(upload, alloc_offset,
+                                                alloc_size, &offset);
+      if (ret != PIPE_OK)
+         return ret;
+
+      *ptr = upload->map + offset;
+      pipe_resource_reference( outbuf, upload->buffer );
+      *out_offset = offset;
+
+      upload->offset = offset + alloc_size;
+      return PIPE_OK;
+   }
+
    /* Make sure we have enough space in the upload buffer
     * for the sub-allocation. */
    if (MAX2(upload->offset, alloc_offset) + alloc_size > upload->size) {
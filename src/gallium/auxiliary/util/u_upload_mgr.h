@@ -35,6 +35,7 @@
 #include "pipe/p_compiler.h"
 
 struct pipe_context;
+struct pipe_fence_handle;
 struct pipe_resource;
 
 
@@ -51,6 +52,25 @@ struct u_upload_mgr *u_upload_create( struct pipe_context *pipe,
                                       unsigned alignment,
                                       unsigned bind );
 
+/**
+ * Create an upload manager which reuses a single buffer as a ring.
+ *
+ * Sub-allocations are handed out from the buffer in order, wrapping around
+ * to its start once rendering is done with the data there, as known from
+ * the fences passed to u_upload_fence().  When that is not the case yet, a
+ * new and larger buffer is started instead of waiting.  If the driver
+ * supports PIPE_CAP_BUFFER_MAP_PERSISTENT the buffer also stays mapped.
+ *
+ * \param pipe          Pipe driver.
+ * \param size          Initial size of the ring buffer, in bytes.
+ * \param alignment     Alignment of each suballocation in the upload buffer.
+ * \param bind          Bitmask of PIPE_BIND_* flags.
+ */
+struct u_upload_mgr *u_upload_create_ring( struct pipe_context *pipe,
+                                           unsigned size,
+                                           unsigned alignment,
+                                           unsigned bind );
+
 /**
  * Destroy the upload manager.
  */
@@ -63,9 +83,19 @@ void u_upload_destroy( struct u_upload_mgr *upload );
  * recycling. This should be called on real hardware flushes on systems
  * that don't support the PIPE_TRANSFER_UNSYNCHRONIZED flag, as otherwise
  * the next u_upload_buffer will cause a sync on the buffer.
+ *
+ * In ring mode the buffer is kept, so this is the same as u_upload_unmap().
  */
 void u_upload_flush( struct u_upload_mgr *upload );
 
+/**
+ * Tag the sub-allocations made since the previous call with the fence of
+ * the flush which submitted them.  Does nothing unless in ring mode.
+ * A NULL fence leaves them busy until a later call passes a real one.
+ */
+void u_upload_fence( struct u_upload_mgr *upload,
+                     struct pipe_fence_handle *fence );
+
 /**
  * Unmap upload buffer
  *
@@ -75,6 +105,8 @@ void u_upload_flush( struct u_upload_mgr *upload );
  * which references the upload buffer, as many memory managers either
  * don't like firing a mapped buffer or cause subsequent maps of a
  * fired buffer to wait.
+ *
+ * A persistently mapped ring buffer only has the written range flushed.
  */
 void u_upload_unmap( struct u_upload_mgr *upload );
 
@@ -37,14 +37,17 @@
 #include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_simple_list.h"
+#include "util/u_slab.h"
 #include "lp_clear.h"
 #include "lp_context.h"
+#include "lp_debug.h"
 #include "lp_flush.h"
 #include "lp_perf.h"
 #include "lp_state.h"
 #include "lp_surface.h"
 #include "lp_query.h"
 #include "lp_setup.h"
+#include "lp_texture.h"
 
 
 /** shared by all contexts */
@@ -57,6 +60,10 @@ static void llvmpipe_destroy( struct pipe_context *pipe )
    uint i, j;
 
    lp_print_counters();
+   lp_print_timers(llvmpipe);
+
+   if (LP_DEBUG & DEBUG_COUNTERS)
+      util_perf_timers_disable();
 
    if (llvmpipe->blitter) {
       util_blitter_destroy(llvmpipe->blitter);
@@ -67,6 +74,8 @@ static void llvmpipe_destroy( struct pipe_context *pipe )
    if (llvmpipe->draw)
       draw_destroy( llvmpipe->draw );
 
+   llvmpipe_free_retired_buffers(llvmpipe);
+
    for (i = 0; i < PIPE_MAX_COLOR_BUFS; i++) {
       pipe_surface_reference(&llvmpipe->framebuffer.cbufs[i], NULL);
    }
@@ -93,6 +102,9 @@ static void llvmpipe_destroy( struct pipe_context *pipe )
 
    lp_delete_setup_variants(llvmpipe);
 
+   util_slab_cache_destroy(llvmpipe->transfer_cache);
+   util_slab_cache_destroy(llvmpipe->query_cache);
+
    align_free( llvmpipe );
 }
 
@@ -133,6 +145,9 @@ llvmpipe_create_context( struct pipe_screen *screen, void *priv )
 
    make_empty_list(&llvmpipe->setup_variants_list);
 
+   /* Time all stages for lp_print_timers() */
+   if (LP_DEBUG & DEBUG_COUNTERS)
+      util_perf_timers_enable();
 
    llvmpipe->pipe.screen = screen;
    llvmpipe->pipe.priv = priv;
@@ -159,6 +174,13 @@ llvmpipe_create_context( struct pipe_screen *screen, void *priv )
    llvmpipe_init_context_resource_funcs( &llvmpipe->pipe );
    llvmpipe_init_surface_functions(llvmpipe);
 
+   llvmpipe->transfer_cache =
+      util_slab_cache_create(sizeof(struct llvmpipe_transfer), 16);
+   llvmpipe->query_cache =
+      util_slab_cache_create(sizeof(struct llvmpipe_query), 16);
+   if (!llvmpipe->transfer_cache || !llvmpipe->query_cache)
+      goto fail;
+
    /*
     * Create drawing context and plug our rendering stage into it.
     */
@@ -38,12 +38,14 @@
 
 #include "lp_tex_sample.h"
 #include "lp_jit.h"
+#include "lp_perf.h"
 #include "lp_setup.h"
 #include "lp_state_fs.h"
 #include "lp_state_setup.h"
 
 
 struct llvmpipe_vbuf_render;
+struct lp_retired_buffer;
 struct draw_context;
 struct draw_stage;
 struct lp_fragment_shader;
@@ -52,6 +54,7 @@ struct lp_blend_state;
 struct lp_setup_context;
 struct lp_setup_variant;
 struct lp_velems_state;
+struct util_slab_cache;
 
 struct llvmpipe_context {
    struct pipe_context pipe;  /**< base class */
@@ -135,9 +138,35 @@ struct llvmpipe_context {
    struct lp_setup_variant_list_item setup_variants_list;
    unsigned nr_setup_variants;
 
+   /** Stage timers, sampled by driver queries */
+   struct lp_timers timers;
+
    /** Conditional query object and mode */
    struct pipe_query *render_cond_query;
    uint render_cond_mode;
+
+   /**
+    * Storage taken away from buffers by discarding maps which no scene
+    * reads anymore, by log2 of the size.  It is reused for the next buffer
+    * of the same size renamed.
+    */
+   struct lp_retired_buffer *retired_buffers[LP_MAX_RETIRED_BUCKETS];
+   unsigned retired_buffer_bytes;
+
+   /** Allocators for the transfers and queries of this context */
+   struct util_slab_cache *transfer_cache;
+   struct util_slab_cache *query_cache;
+};
+
+
+/**
+ * Old storage of a buffer renamed by llvmpipe_transfer_map().
+ */
+struct lp_retired_buffer
+{
+   struct lp_retired_buffer *next;
+   void *data;
+   unsigned size;
 };
 
 
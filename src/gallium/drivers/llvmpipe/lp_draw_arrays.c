@@ -36,6 +36,7 @@
 #include "util/u_prim.h"
 
 #include "lp_context.h"
+#include "lp_flush.h"
 #include "lp_state.h"
 #include "lp_query.h"
 
@@ -89,7 +90,14 @@ llvmpipe_draw_vbo(struct pipe_context *pipe, const struct pipe_draw_info *info)
    }
 
    for (i = 0; i < lp->num_so_targets; i++) {
-      void *buf = llvmpipe_resource(lp->so_targets[i]->target.buffer)->data;
+      struct pipe_resource *buffer = lp->so_targets[i]->target.buffer;
+      void *buf;
+
+      /* The scene may read constants from the buffer in place */
+      llvmpipe_flush_resource(pipe, buffer, 0, FALSE, FALSE, FALSE,
+                              __FUNCTION__);
+
+      buf = llvmpipe_resource(buffer)->data;
       lp->so_targets[i]->mapping = buf;
    }
    draw_set_mapped_so_targets(draw, lp->num_so_targets,
@@ -28,6 +28,7 @@
 
 #include "pipe/p_screen.h"
 #include "util/u_memory.h"
+#include "util/u_slab.h"
 #include "lp_debug.h"
 #include "lp_fence.h"
 
@@ -39,17 +40,20 @@
  * thread hits a fence command, it'll increment the fence counter.  When
  * the counter == the rank, the fence is finished.
  *
+ * \param cache  allocator of the thread creating the fence
  * \param rank  the expected finished value of the fence counter.
  */
 struct lp_fence *
-lp_fence_create(unsigned rank)
+lp_fence_create(struct util_slab_cache *cache, unsigned rank)
 {
    static int fence_id;
-   struct lp_fence *fence = CALLOC_STRUCT(lp_fence);
+   struct lp_fence *fence = util_slab_cache_alloc(cache);
 
    if (!fence)
       return NULL;
 
+   memset(fence, 0, sizeof *fence);
+
    pipe_reference_init(&fence->reference, 1);
 
    pipe_mutex_init(fence->mutex);
@@ -65,7 +69,10 @@ lp_fence_create(unsigned rank)
 }
 
 
-/** Destroy a fence.  Called when refcount hits zero. */
+/**
+ * Destroy a fence.  Called when refcount hits zero, which may happen in any
+ * thread, so the fence is handed back to the cache it came from.
+ */
 void
 lp_fence_destroy(struct lp_fence *fence)
 {
@@ -74,7 +81,7 @@ lp_fence_destroy(struct lp_fence *fence)
 
    pipe_mutex_destroy(fence->mutex);
    pipe_condvar_destroy(fence->signalled);
-   FREE(fence);
+   util_slab_cache_free(NULL, fence);
 }
 
 
@@ -36,6 +36,7 @@
 
 
 struct pipe_screen;
+struct util_slab_cache;
 
 
 struct lp_fence
@@ -53,7 +54,7 @@ struct lp_fence
 
 
 struct lp_fence *
-lp_fence_create(unsigned rank);
+lp_fence_create(struct util_slab_cache *cache, unsigned rank);
 
 
 void
@@ -91,4 +91,24 @@
  */
 #define LP_MAX_SETUP_VARIANTS 64
 
+
+/**
+ * Buckets (one per power of two size) of buffer storage waiting to be
+ * reused after a discarding map renamed the buffer.
+ */
+#define LP_MAX_RETIRED_BUCKETS 32
+
+/**
+ * Above this much idle storage of renamed buffers, storage is freed rather
+ * than kept around for reuse.
+ */
+#define LP_MAX_RETIRED_BYTES (64 * 1024 * 1024)
+
+/**
+ * Buffers up to this size which a scene reads get a copy of their storage
+ * when written, rather than waiting for the scene.  Fragment shader
+ * constants in larger buffers are copied into the scene instead.
+ */
+#define LP_MAX_RENAME_COPY_SIZE (64 * 1024)
+
 #endif /* LP_LIMITS_H */
@@ -34,6 +34,8 @@
 #define LP_PERF_H
 
 #include "pipe/p_compiler.h"
+#include "util/u_perf_timer.h"
+#include "lp_limits.h"
 
 /**
  * Various counters
@@ -80,6 +82,32 @@ extern struct lp_counters lp_count;
 #endif
 
 
+/**
+ * Stage timers.  Unlike the counters above these are present in release
+ * builds, and only run while a driver query samples them (see lp_query.c)
+ * or LP_DEBUG=counters is set.
+ */
+enum lp_timer
+{
+   LP_TIMER_SETUP,       /**< primitive setup and binning */
+   LP_TIMER_COMPILE,     /**< generating fragment shader and setup variants */
+   LP_TIMER_TEX_LAYOUT,  /**< converting texture tiles between layouts */
+   LP_TIMER_FLUSH_WAIT,  /**< waiting on scenes being rasterized */
+   LP_TIMER_COUNT
+};
+
+/**
+ * The timers of one context.  Rasterizer threads work on a scene
+ * concurrently, so each of them has its own.
+ */
+struct lp_timers
+{
+   struct util_perf_timer stage[LP_TIMER_COUNT];
+   struct util_perf_timer rast[LP_MAX_THREADS];
+   struct util_perf_timer rast_tex_layout[LP_MAX_THREADS];
+};
+
+
 extern void
 lp_reset_counters(void);
 
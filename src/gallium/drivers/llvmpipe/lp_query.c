@@ -33,30 +33,95 @@
 #include "draw/draw_context.h"
 #include "pipe/p_defines.h"
 #include "util/u_memory.h"
+#include "util/u_slab.h"
 #include "os/os_time.h"
 #include "lp_context.h"
+#include "lp_debug.h"
 #include "lp_flush.h"
 #include "lp_fence.h"
+#include "lp_perf.h"
 #include "lp_query.h"
 #include "lp_state.h"
 
 
+static const struct pipe_driver_query_info lp_driver_queries[] = {
+   { "draw-fetch", LP_QUERY_DRAW_FETCH, 0, FALSE },
+   { "draw-shade", LP_QUERY_DRAW_SHADE, 0, FALSE },
+   { "draw-clip", LP_QUERY_DRAW_CLIP, 0, FALSE },
+   { "setup", LP_QUERY_SETUP, 0, FALSE },
+   { "rasterization", LP_QUERY_RAST, 0, FALSE },
+   { "jit-compile", LP_QUERY_COMPILE, 0, FALSE },
+   { "texture-layout", LP_QUERY_TEX_LAYOUT, 0, FALSE },
+   { "flush-wait", LP_QUERY_FLUSH_WAIT, 0, FALSE }
+};
+
+
 static struct llvmpipe_query *llvmpipe_query( struct pipe_query *p )
 {
    return (struct llvmpipe_query *)p;
 }
 
+
+static INLINE boolean
+is_driver_query(unsigned type)
+{
+   return type >= LP_QUERY_DRAW_FETCH && type < LP_QUERY_DRIVER_END;
+}
+
+
+/**
+ * Return the total time spent so far in the stage of a driver query.
+ * Times of the rasterizer threads are summed.
+ */
+static uint64_t
+sample_timer(struct llvmpipe_context *lp, unsigned type)
+{
+   uint64_t time = 0;
+   unsigned i;
+
+   switch (type) {
+   case LP_QUERY_DRAW_FETCH:
+      return draw_get_timer(lp->draw, DRAW_TIMER_FETCH)->time;
+   case LP_QUERY_DRAW_SHADE:
+      return draw_get_timer(lp->draw, DRAW_TIMER_SHADE)->time;
+   case LP_QUERY_DRAW_CLIP:
+      return draw_get_timer(lp->draw, DRAW_TIMER_CLIP)->time;
+   case LP_QUERY_SETUP:
+      return lp->timers.stage[LP_TIMER_SETUP].time;
+   case LP_QUERY_RAST:
+      for (i = 0; i < LP_MAX_THREADS; i++) {
+         time += lp->timers.rast[i].time;
+      }
+      return time;
+   case LP_QUERY_COMPILE:
+      return lp->timers.stage[LP_TIMER_COMPILE].time +
+             draw_get_timer(lp->draw, DRAW_TIMER_COMPILE)->time;
+   case LP_QUERY_TEX_LAYOUT:
+      time = lp->timers.stage[LP_TIMER_TEX_LAYOUT].time;
+      for (i = 0; i < LP_MAX_THREADS; i++) {
+         time += lp->timers.rast_tex_layout[i].time;
+      }
+      return time;
+   case LP_QUERY_FLUSH_WAIT:
+      return lp->timers.stage[LP_TIMER_FLUSH_WAIT].time;
+   default:
+      assert(0);
+      return 0;
+   }
+}
+
 static struct pipe_query *
 llvmpipe_create_query(struct pipe_context *pipe, 
                       unsigned type)
 {
    struct llvmpipe_query *pq;
 
-   assert(type < PIPE_QUERY_TYPES);
+   assert(type < PIPE_QUERY_TYPES || is_driver_query(type));
 
-   pq = CALLOC_STRUCT( llvmpipe_query );
+   pq = util_slab_cache_alloc(llvmpipe_context(pipe)->query_cache);
 
    if (pq) {
+      memset(pq, 0, sizeof *pq);
       pq->type = type;
    }
 
@@ -69,6 +134,9 @@ llvmpipe_destroy_query(struct pipe_context *pipe, struct pipe_query *q)
 {
    struct llvmpipe_query *pq = llvmpipe_query(q);
 
+   if (pq->timer_active)
+      util_perf_timers_disable();
+
    /* Ideally we would refcount queries & not get destroyed until the
     * last scene had finished with us.
     */
@@ -82,7 +150,7 @@ llvmpipe_destroy_query(struct pipe_context *pipe, struct pipe_query *q)
       lp_fence_reference(&pq->fence, NULL);
    }
 
-   FREE(pq);
+   util_slab_cache_free(llvmpipe_context(pipe)->query_cache, pq);
 }
 
 
@@ -96,6 +164,12 @@ llvmpipe_get_query_result(struct pipe_context *pipe,
    uint64_t *result = (uint64_t *)vresult;
    int i;
 
+   if (is_driver_query(pq->type)) {
+      /* already resolved by end_query */
+      *result = pq->timer_elapsed;
+      return TRUE;
+   }
+
    if (!pq->fence) {
       /* no fence because there was no scene, so results is zero */
       *result = 0;
@@ -152,6 +226,20 @@ llvmpipe_begin_query(struct pipe_context *pipe, struct pipe_query *q)
    struct llvmpipe_context *llvmpipe = llvmpipe_context( pipe );
    struct llvmpipe_query *pq = llvmpipe_query(q);
 
+   if (is_driver_query(pq->type)) {
+      /* Finish pending work, so that only the stages of the draws
+       * between begin and end are accounted for.
+       */
+      llvmpipe_finish(pipe, __FUNCTION__);
+
+      if (!pq->timer_active) {
+         util_perf_timers_enable();
+         pq->timer_active = TRUE;
+      }
+      pq->timer_start = sample_timer(llvmpipe, pq->type);
+      return;
+   }
+
    /* Check if the query is already in the scene.  If so, we need to
     * flush the scene now.  Real apps shouldn't re-use a query in a
     * frame of rendering.
@@ -187,6 +275,18 @@ llvmpipe_end_query(struct pipe_context *pipe, struct pipe_query *q)
    struct llvmpipe_context *llvmpipe = llvmpipe_context( pipe );
    struct llvmpipe_query *pq = llvmpipe_query(q);
 
+   if (is_driver_query(pq->type)) {
+      /* The draws of the query are only rasterized when flushed */
+      llvmpipe_finish(pipe, __FUNCTION__);
+
+      pq->timer_elapsed = sample_timer(llvmpipe, pq->type) - pq->timer_start;
+      if (pq->timer_active) {
+         util_perf_timers_disable();
+         pq->timer_active = FALSE;
+      }
+      return;
+   }
+
    lp_setup_end_query(llvmpipe->setup, pq);
 
    if (pq->type == PIPE_QUERY_PRIMITIVES_EMITTED) {
@@ -223,6 +323,40 @@ llvmpipe_check_render_cond(struct llvmpipe_context *lp)
       return TRUE;
 }
 
+int
+llvmpipe_get_driver_query_info(struct pipe_screen *screen,
+                               unsigned index,
+                               struct pipe_driver_query_info *info)
+{
+   if (!info)
+      return Elements(lp_driver_queries);
+
+   if (index >= Elements(lp_driver_queries))
+      return 0;
+
+   *info = lp_driver_queries[index];
+   return 1;
+}
+
+
+/**
+ * Print the time spent in every stage, for LP_DEBUG=counters.
+ */
+void
+lp_print_timers(struct llvmpipe_context *lp)
+{
+   if ((LP_DEBUG & DEBUG_COUNTERS) && lp->draw) {
+      unsigned i;
+
+      for (i = 0; i < Elements(lp_driver_queries); i++) {
+         debug_printf("llvmpipe: %-16s time:             %.2f sec\n",
+                      lp_driver_queries[i].name,
+                      sample_timer(lp, lp_driver_queries[i].query_type) / 1e9);
+      }
+   }
+}
+
+
 void llvmpipe_init_query_funcs(struct llvmpipe_context *llvmpipe )
 {
    llvmpipe->pipe.create_query = llvmpipe_create_query;
@@ -35,10 +35,29 @@
 
 #include <limits.h>
 #include "os/os_thread.h"
+#include "pipe/p_defines.h"
 #include "lp_limits.h"
 
 
 struct llvmpipe_context;
+struct pipe_screen;
+
+
+/**
+ * Driver-specific queries.  Each returns the nanoseconds spent in one stage
+ * between begin_query and end_query.
+ */
+enum lp_driver_query {
+   LP_QUERY_DRAW_FETCH = PIPE_QUERY_DRIVER_SPECIFIC,
+   LP_QUERY_DRAW_SHADE,
+   LP_QUERY_DRAW_CLIP,
+   LP_QUERY_SETUP,
+   LP_QUERY_RAST,
+   LP_QUERY_COMPILE,
+   LP_QUERY_TEX_LAYOUT,
+   LP_QUERY_FLUSH_WAIT,
+   LP_QUERY_DRIVER_END
+};
 
 
 struct llvmpipe_query {
@@ -47,6 +66,9 @@ struct llvmpipe_query {
    unsigned type;                   /* PIPE_QUERY_* */
    unsigned num_primitives_generated;
    unsigned num_primitives_written;
+   uint64_t timer_start;            /* stage time at begin_query */
+   uint64_t timer_elapsed;          /* stage time between begin and end */
+   boolean timer_active;
 };
 
 
@@ -54,4 +76,12 @@ extern void llvmpipe_init_query_funcs(struct llvmpipe_context * );
 
 extern boolean llvmpipe_check_render_cond(struct llvmpipe_context *);
 
+extern int
+llvmpipe_get_driver_query_info(struct pipe_screen *screen,
+                               unsigned index,
+                               struct pipe_driver_query_info *info);
+
+extern void
+lp_print_timers(struct llvmpipe_context *lp);
+
 #endif /* LP_QUERY_H */
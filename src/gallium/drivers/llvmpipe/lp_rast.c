@@ -91,6 +91,7 @@ lp_rast_tile_begin(struct lp_rasterizer_task *task,
 {
    const struct lp_scene *scene = task->scene;
    enum lp_texture_usage usage;
+   int64_t t0;
 
    LP_DBG(DEBUG_RAST, "%s %d,%d\n", __FUNCTION__, bin->x, bin->y);
 
@@ -115,12 +116,15 @@ lp_rast_tile_begin(struct lp_rasterizer_task *task,
          /* "prime" the tile: convert data from linear to tiled if necessary
           * and update the tile's layout info.
           */
+         t0 = util_perf_timer_begin();
          (void) llvmpipe_get_texture_tile(lpt,
                                           zsbuf->u.tex.first_layer,
                                           zsbuf->u.tex.level,
                                           usage,
                                           task->x,
                                           task->y);
+         util_perf_timer_end(&scene->timers->rast_tex_layout[
+                                task->thread_index], t0);
          /* Get actual pointer to the tile data.  Note that depth/stencil
           * data is tiled differently than color data.
           */
@@ -641,6 +645,8 @@ static void
 rasterize_scene(struct lp_rasterizer_task *task,
                 struct lp_scene *scene)
 {
+   int64_t t0 = util_perf_timer_begin();
+
    task->scene = scene;
 
    if (!task->rast->no_rast && !scene->discard) {
@@ -669,6 +675,8 @@ rasterize_scene(struct lp_rasterizer_task *task,
    }
 
 
+   util_perf_timer_end(&scene->timers->rast[task->thread_index], t0);
+
    if (scene->fence) {
       lp_fence_signal(scene->fence);
    }
@@ -34,6 +34,7 @@
 #include "lp_scene.h"
 #include "lp_fence.h"
 #include "lp_debug.h"
+#include "lp_perf.h"
 
 
 #define RESOURCE_REF_SZ 32
@@ -89,6 +90,7 @@ lp_scene_create( struct pipe_context *pipe )
 void
 lp_scene_destroy(struct lp_scene *scene)
 {
+   llvmpipe_release_retired_buffers(scene->pipe, scene->retired_buffers);
    lp_fence_reference(&scene->fence, NULL);
    pipe_mutex_destroy(scene->mutex);
    assert(scene->data.head->next == NULL);
@@ -150,6 +152,7 @@ void
 lp_scene_begin_rasterization(struct lp_scene *scene)
 {
    const struct pipe_framebuffer_state *fb = &scene->fb;
+   int64_t t0 = util_perf_timer_begin();
    int i;
 
    //LP_DBG(DEBUG_RAST, "%s\n", __FUNCTION__);
@@ -189,6 +192,8 @@ lp_scene_begin_rasterization(struct lp_scene *scene)
                                                LP_TEX_USAGE_READ_WRITE,
                                                LP_TEX_LAYOUT_NONE);
    }
+
+   util_perf_timer_end(&scene->timers->stage[LP_TIMER_TEX_LAYOUT], t0);
 }
 
 
@@ -200,6 +205,7 @@ lp_scene_begin_rasterization(struct lp_scene *scene)
 void
 lp_scene_end_rasterization(struct lp_scene *scene )
 {
+   int64_t t0 = util_perf_timer_begin();
    int i, j;
 
    /* Unmap color buffers */
@@ -224,6 +230,8 @@ lp_scene_end_rasterization(struct lp_scene *scene )
       scene->zsbuf.map = NULL;
    }
 
+   util_perf_timer_end(&scene->timers->stage[LP_TIMER_TEX_LAYOUT], t0);
+
    /* Reset all command lists:
     */
    for (i = 0; i < scene->tiles_x; i++) {
@@ -280,6 +288,11 @@ lp_scene_end_rasterization(struct lp_scene *scene )
       list->head->used = 0;
    }
 
+   /* Renamed buffer storage isn't read anymore
+    */
+   llvmpipe_release_retired_buffers(scene->pipe, scene->retired_buffers);
+   scene->retired_buffers = NULL;
+
    lp_fence_reference(&scene->fence, NULL);
 
    scene->resources = NULL;
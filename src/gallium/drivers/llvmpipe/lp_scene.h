@@ -41,6 +41,7 @@
 
 struct lp_scene_queue;
 struct lp_rast_state;
+struct lp_timers;
 
 /* We're limited to 2K by 2K for 32bit fixed point rasterization.
  * Will need a 64-bit version for larger framebuffers.
@@ -118,6 +119,7 @@ struct data_block_list {
 };
 
 struct resource_ref;
+struct lp_retired_buffer;
 
 /**
  * All bins and bin data are contained here.
@@ -131,6 +133,9 @@ struct lp_scene {
    struct pipe_context *pipe;
    struct lp_fence *fence;
 
+   /** Timers of the context the scene belongs to */
+   struct lp_timers *timers;
+
    /* Framebuffer mappings - valid only between begin_rasterization()
     * and end_rasterization().
     */
@@ -146,6 +151,9 @@ struct lp_scene {
    /** list of resources referenced by the scene commands */
    struct resource_ref *resources;
 
+   /** Old storage of buffers renamed while the scene was binning */
+   struct lp_retired_buffer *retired_buffers;
+
    /** Total memory used by the scene (in bytes).  This sums all the
     * data blocks and counts all bins, state, resource references and
     * other random allocations within the scene.
@@ -39,9 +39,11 @@
 #include "util/u_inlines.h"
 #include "util/u_memory.h"
 #include "util/u_pack_color.h"
+#include "util/u_slab.h"
 #include "draw/draw_pipe.h"
 #include "lp_context.h"
 #include "lp_memory.h"
+#include "lp_perf.h"
 #include "lp_scene.h"
 #include "lp_texture.h"
 #include "lp_debug.h"
@@ -76,11 +78,15 @@ lp_setup_get_empty_scene(struct lp_setup_context *setup)
    setup->scene = setup->scenes[setup->scene_idx];
 
    if (setup->scene->fence) {
+      int64_t t0;
+
       if (LP_DEBUG & DEBUG_SETUP)
          debug_printf("%s: wait for scene %d\n",
                       __FUNCTION__, setup->scene->fence->id);
 
+      t0 = util_perf_timer_begin();
       lp_fence_wait(setup->scene->fence);
+      util_perf_timer_end(&setup->timers->stage[LP_TIMER_FLUSH_WAIT], t0);
    }
 
    lp_scene_begin_binning(setup->scene, &setup->fb, discard);
@@ -154,6 +160,7 @@ lp_setup_rasterize_scene( struct lp_setup_context *setup )
 {
    struct lp_scene *scene = setup->scene;
    struct llvmpipe_screen *screen = llvmpipe_screen(scene->pipe->screen);
+   int64_t t0;
 
    lp_scene_end_binning(scene);
 
@@ -162,10 +169,12 @@ lp_setup_rasterize_scene( struct lp_setup_context *setup )
    if (setup->last_fence)
       setup->last_fence->issued = TRUE;
 
+   t0 = util_perf_timer_begin();
    pipe_mutex_lock(screen->rast_mutex);
    lp_rast_queue_scene(screen->rast, scene);
    lp_rast_finish(screen->rast);
    pipe_mutex_unlock(screen->rast_mutex);
+   util_perf_timer_end(&setup->timers->stage[LP_TIMER_FLUSH_WAIT], t0);
 
    lp_scene_end_rasterization(setup->scene);
    lp_setup_reset( setup );
@@ -188,7 +197,8 @@ begin_binning( struct lp_setup_context *setup )
 
    /* Always create a fence:
     */
-   scene->fence = lp_fence_create(MAX2(1, setup->num_threads));
+   scene->fence = lp_fence_create(setup->fence_cache,
+                                  MAX2(1, setup->num_threads));
    if (!scene->fence)
       return FALSE;
 
@@ -690,6 +700,7 @@ lp_setup_set_fragment_sampler_views(struct lp_setup_context *setup,
             int j;
             unsigned first_level = 0;
             unsigned last_level = 0;
+            int64_t t0;
 
             if (llvmpipe_resource_is_texture(res)) {
                first_level = view->u.tex.first_level;
@@ -701,9 +712,12 @@ lp_setup_set_fragment_sampler_views(struct lp_setup_context *setup,
                 * The complexity here is only necessary for depth textures which
                 * still are tiled.
                 */
+               t0 = util_perf_timer_begin();
                mip_ptr = llvmpipe_get_texture_image_all(lp_tex, first_level,
                                                         LP_TEX_USAGE_READ,
                                                         LP_TEX_LAYOUT_LINEAR);
+               util_perf_timer_end(&setup->timers->stage[LP_TIMER_TEX_LAYOUT],
+                                   t0);
                jit_tex->base = lp_tex->linear_img.data;
             }
             else {
@@ -733,9 +747,12 @@ lp_setup_set_fragment_sampler_views(struct lp_setup_context *setup,
 
                if (llvmpipe_resource_is_texture(res)) {
                   for (j = first_level; j <= last_level; j++) {
+                     t0 = util_perf_timer_begin();
                      mip_ptr = llvmpipe_get_texture_image_all(lp_tex, j,
                                                               LP_TEX_USAGE_READ,
                                                               LP_TEX_LAYOUT_LINEAR);
+                     util_perf_timer_end(&setup->timers->stage[
+                                            LP_TIMER_TEX_LAYOUT], t0);
                      jit_tex->mip_offsets[j] = (uint8_t *)mip_ptr - (uint8_t *)jit_tex->base;
                      /*
                       * could get mip offset directly but need call above to
@@ -867,6 +884,46 @@ lp_setup_is_resource_referenced( const struct lp_setup_context *setup,
 }
 
 
+/**
+ * Whether the current scene can keep \p size more bytes of retired buffer
+ * storage.  Retired storage counts against the same limit as the resources
+ * the scene references, so a scene can't hold on to an unbounded amount of
+ * memory when a buffer keeps being renamed.
+ */
+boolean
+lp_setup_can_retire_buffer( const struct lp_setup_context *setup,
+                            unsigned size )
+{
+   const struct lp_scene *scene = setup->scene;
+
+   return scene &&
+          scene->resource_reference_size + size < LP_SCENE_MAX_RESOURCE_SIZE;
+}
+
+
+/**
+ * Keep the old storage of a renamed buffer until the current scene, which
+ * may still read it, has been rasterized.
+ */
+void
+lp_setup_retire_buffer( struct lp_setup_context *setup,
+                        struct lp_retired_buffer *retired )
+{
+   struct lp_scene *scene = setup->scene;
+
+   /* Only the scene being binned can reference the buffer */
+   assert(scene);
+
+   retired->next = scene->retired_buffers;
+   scene->retired_buffers = retired;
+
+   /* Also makes lp_scene_add_resource_reference() advise a flush once the
+    * scene holds too much memory.
+    */
+   scene->resource_reference_size += retired->size;
+}
+
+
 /**
  * Called by vbuf code when we're about to draw something.
  */
@@ -920,6 +977,26 @@ try_update_scene_state( struct lp_setup_context *setup )
          const unsigned current_size = setup->constants[i].current.buffer_size;
          const ubyte *current_data = NULL;
 
+         if (buffer &&
+             (buffer->bind & PIPE_BIND_CONSTANT_BUFFER) &&
+             llvmpipe_buffer_can_rename(buffer, TRUE)) {
+            /* Read the constants in place.  The scene references the
+             * buffer, so writing it later gives it new storage.
+             */
+            if (!lp_scene_add_resource_reference(scene, buffer, new_scene)) {
+               assert(!new_scene);
+               return FALSE;
+            }
+
+            setup->constants[i].stored_size = 0;
+            setup->constants[i].stored_data = NULL;
+            setup->fs.current.jit_context.constants[i] =
+               (const float *) ((ubyte *) llvmpipe_resource_data(buffer) +
+                                setup->constants[i].current.buffer_offset);
+            setup->dirty |= LP_SETUP_NEW_FS;
+            continue;
+         }
+
          if (buffer) {
             /* resource buffer */
             current_data = (ubyte *) llvmpipe_resource_data(buffer);
@@ -1122,6 +1199,8 @@ lp_setup_destroy( struct lp_setup_context *setup )
 
    lp_fence_reference(&setup->last_fence, NULL);
 
+   util_slab_cache_destroy(setup->fence_cache);
+
    FREE( setup );
 }
 
@@ -1150,8 +1229,16 @@ lp_setup_create( struct pipe_context *pipe,
     */
    setup->pipe = pipe;
 
+   setup->timers = &llvmpipe_context(pipe)->timers;
 
    setup->num_threads = screen->num_threads;
+
+   setup->fence_cache = util_slab_cache_create(sizeof(struct lp_fence),
+                                               MAX_SCENES * 2);
+   if (!setup->fence_cache) {
+      goto no_fence_cache;
+   }
+
    setup->vbuf = draw_vbuf_stage(draw, &setup->base);
    if (!setup->vbuf) {
       goto no_vbuf;
@@ -1166,6 +1253,7 @@ lp_setup_create( struct pipe_context *pipe,
       if (!setup->scenes[i]) {
          goto no_scenes;
       }
+      setup->scenes[i]->timers = setup->timers;
    }
 
    setup->triangle = first_triangle;
@@ -1185,6 +1273,8 @@ no_scenes:
 
    setup->vbuf->destroy(setup->vbuf);
 no_vbuf:
+   util_slab_cache_destroy(setup->fence_cache);
+no_fence_cache:
    FREE(setup);
 no_setup:
    return NULL;
@@ -42,6 +42,7 @@ struct pipe_screen;
 struct pipe_framebuffer_state;
 struct lp_fragment_shader_variant;
 struct lp_jit_context;
+struct lp_retired_buffer;
 struct llvmpipe_query;
 struct pipe_fence_handle;
 struct lp_setup_variant;
@@ -133,6 +134,14 @@ unsigned
 lp_setup_is_resource_referenced( const struct lp_setup_context *setup,
                                 const struct pipe_resource *texture );
 
+boolean
+lp_setup_can_retire_buffer( const struct lp_setup_context *setup,
+                            unsigned size );
+
+void
+lp_setup_retire_buffer( struct lp_setup_context *setup,
+                        struct lp_retired_buffer *retired );
+
 void
 lp_setup_set_flatshade_first( struct lp_setup_context *setup, 
                               boolean flatshade_first );
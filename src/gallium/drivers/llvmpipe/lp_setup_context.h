@@ -50,6 +50,7 @@
 
 
 struct lp_setup_variant;
+struct util_slab_cache;
 
 
 /** Max number of scenes */
@@ -71,6 +72,7 @@ struct lp_setup_context
    struct vbuf_render base;
 
    struct pipe_context *pipe;
+   struct lp_timers *timers;  /**< of the llvmpipe context */
    struct vertex_info *vertex_info;
    uint prim;
    uint vertex_size;
@@ -89,6 +91,7 @@ struct lp_setup_context
    struct lp_scene *scene;               /**< current scene being built */
 
    struct lp_fence *last_fence;
+   struct util_slab_cache *fence_cache;
    struct llvmpipe_query *active_query[PIPE_QUERY_TYPES];
 
    boolean flatshade_first;
@@ -38,6 +38,7 @@
 
 #include "lp_setup_context.h"
 #include "lp_context.h"
+#include "lp_perf.h"
 #include "draw/draw_vbuf.h"
 #include "draw/draw_vertex.h"
 #include "util/u_memory.h"
@@ -140,12 +141,15 @@ lp_setup_draw_elements(struct vbuf_render *vbr, const ushort *indices, uint nr)
    const void *vertex_buffer = setup->vertex_buffer;
    const boolean flatshade_first = setup->flatshade_first;
    unsigned i;
+   int64_t t0;
 
    assert(setup->setup.variant);
 
    if (!lp_setup_update_state(setup, TRUE))
       return;
 
+   t0 = util_perf_timer_begin();
+
    switch (setup->prim) {
    case PIPE_PRIM_POINTS:
       for (i = 0; i < nr; i++) {
@@ -324,6 +328,8 @@ lp_setup_draw_elements(struct vbuf_render *vbr, const ushort *indices, uint nr)
    default:
       assert(0);
    }
+
+   util_perf_timer_end(&setup->timers->stage[LP_TIMER_SETUP], t0);
 }
 
 
@@ -340,10 +346,13 @@ lp_setup_draw_arrays(struct vbuf_render *vbr, uint start, uint nr)
       (void *) get_vert(setup->vertex_buffer, start, stride);
    const boolean flatshade_first = setup->flatshade_first;
    unsigned i;
+   int64_t t0;
 
    if (!lp_setup_update_state(setup, TRUE))
       return;
 
+   t0 = util_perf_timer_begin();
+
    switch (setup->prim) {
    case PIPE_PRIM_POINTS:
       for (i = 0; i < nr; i++) {
@@ -519,6 +528,8 @@ lp_setup_draw_arrays(struct vbuf_render *vbr, uint start, uint nr)
    default:
       assert(0);
    }
+
+   util_perf_timer_end(&setup->timers->stage[LP_TIMER_SETUP], t0);
 }
 
 
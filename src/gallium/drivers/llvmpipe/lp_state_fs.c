@@ -2579,6 +2579,9 @@ llvmpipe_set_constant_buffer(struct pipe_context *pipe,
    /* note: reference counting */
    util_copy_constant_buffer(&llvmpipe->constants[shader][index], cb);
 
+   if (constants)
+      llvmpipe_resource_note_context(constants, pipe);
+
    if (shader == PIPE_SHADER_VERTEX ||
        shader == PIPE_SHADER_GEOMETRY) {
       /* Pass the constants to the 'draw' module */
@@ -2802,7 +2805,7 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
    }
    else {
       /* variant not found, create it now */
-      int64_t t0, t1, dt;
+      int64_t t0, t1, dt, start;
       unsigned i;
       unsigned variants_to_cull;
 
@@ -2850,9 +2853,11 @@ llvmpipe_update_fs(struct llvmpipe_context *lp)
       /*
        * Generate the new variant.
        */
+      start = util_perf_timer_begin();
       t0 = os_time_get();
       variant = generate_variant(lp, shader, &key);
       t1 = os_time_get();
+      util_perf_timer_end(&lp->timers.stage[LP_TIMER_COMPILE], start);
       dt = t1 - t0;
       LP_COUNT_ADD(llvm_compile_time, dt);
       LP_COUNT_ADD(nr_llvm_compiles, 2);  /* emit vs. omit in/out test */
@@ -161,6 +161,8 @@ llvmpipe_set_sampler_views(struct pipe_context *pipe,
    for (i = 0; i < num; i++) {
       pipe_sampler_view_reference(&llvmpipe->sampler_views[shader][start + i],
                                   views[i]);
+      if (views[i])
+         llvmpipe_resource_note_context(views[i]->texture, pipe);
    }
 
    /* find highest non-null sampler_views[] entry */
@@ -289,6 +291,7 @@ llvmpipe_prepare_vertex_sampling(struct llvmpipe_context *lp,
             struct pipe_resource *res = view->texture;
             int j;
             void *mip_ptr;
+            int64_t t0;
 
             if (llvmpipe_resource_is_texture(res)) {
                first_level = view->u.tex.first_level;
@@ -298,15 +301,20 @@ llvmpipe_prepare_vertex_sampling(struct llvmpipe_context *lp,
 
                /* must trigger allocation first before we can get base ptr */
                /* XXX this may fail due to OOM ? */
+               t0 = util_perf_timer_begin();
                mip_ptr = llvmpipe_get_texture_image_all(lp_tex, view->u.tex.first_level,
                                                         LP_TEX_USAGE_READ,
                                                         LP_TEX_LAYOUT_LINEAR);
+               util_perf_timer_end(&lp->timers.stage[LP_TIMER_TEX_LAYOUT], t0);
                addr = lp_tex->linear_img.data;
 
                for (j = first_level; j <= last_level; j++) {
+                  t0 = util_perf_timer_begin();
                   mip_ptr = llvmpipe_get_texture_image_all(lp_tex, j,
                                                            LP_TEX_USAGE_READ,
                                                            LP_TEX_LAYOUT_LINEAR);
+                  util_perf_timer_end(&lp->timers.stage[LP_TIMER_TEX_LAYOUT],
+                                      t0);
                   mip_offsets[j] = (uint8_t *)mip_ptr - (uint8_t *)addr;
                   /*
                    * could get mip offset directly but need call above to
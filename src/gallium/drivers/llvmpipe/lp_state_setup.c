@@ -918,11 +918,15 @@ llvmpipe_update_setup(struct llvmpipe_context *lp)
       move_to_head(&lp->setup_variants_list, &variant->list_item_global);
    }
    else {
+      int64_t t0;
+
       if (lp->nr_setup_variants >= LP_MAX_SETUP_VARIANTS) {
 	 cull_setup_variants(lp);
       }
 
+      t0 = util_perf_timer_begin();
       variant = generate_setup_variant(key, lp);
+      util_perf_timer_end(&lp->timers.stage[LP_TIMER_COMPILE], t0);
       if (variant) {
          insert_at_head(&lp->setup_variants_list, &variant->list_item_global);
          lp->nr_setup_variants++;
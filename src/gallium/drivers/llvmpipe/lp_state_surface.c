@@ -50,6 +50,7 @@ llvmpipe_set_framebuffer_state(struct pipe_context *pipe,
                                const struct pipe_framebuffer_state *fb)
 {
    struct llvmpipe_context *lp = llvmpipe_context(pipe);
+   unsigned i;
 
    boolean changed = !util_framebuffer_state_equal(&lp->framebuffer, fb);
 
@@ -60,6 +61,13 @@ llvmpipe_set_framebuffer_state(struct pipe_context *pipe,
 
       util_copy_framebuffer_state(&lp->framebuffer, fb);
 
+      for (i = 0; i < fb->nr_cbufs; i++) {
+         if (fb->cbufs[i])
+            llvmpipe_resource_note_context(fb->cbufs[i]->texture, pipe);
+      }
+      if (fb->zsbuf)
+         llvmpipe_resource_note_context(fb->zsbuf->texture, pipe);
+
       if (LP_PERF & PERF_NO_DEPTH) {
 	 pipe_surface_reference(&lp->framebuffer.zsbuf, NULL);
       }
@@ -27,6 +27,7 @@
 
 #include "util/u_rect.h"
 #include "util/u_surface.h"
+#include "gallivm/lp_bld_format.h"
 #include "lp_context.h"
 #include "lp_flush.h"
 #include "lp_limits.h"
@@ -64,6 +65,7 @@ lp_resource_copy(struct pipe_context *pipe,
    unsigned height = src_box->height;
    unsigned depth = src_box->depth;
    unsigned z;
+   int64_t t0;
 
    llvmpipe_flush_resource(pipe,
                            dst, dst_level,
@@ -93,6 +95,8 @@ lp_resource_copy(struct pipe_context *pipe,
           src_box->width, src_box->height, src_box->depth);
    */
 
+   t0 = util_perf_timer_begin();
+
    for (z = 0; z < src_box->depth; z++){
 
       /* set src tiles to linear layout */
@@ -149,6 +153,9 @@ lp_resource_copy(struct pipe_context *pipe,
       }
    }
 
+   util_perf_timer_end(&llvmpipe_context(pipe)->timers.stage[
+                          LP_TIMER_TEX_LAYOUT], t0);
+
    /* copy */
    {
       const ubyte *src_linear_ptr
@@ -170,6 +177,9 @@ lp_resource_copy(struct pipe_context *pipe,
                        llvmpipe_resource_stride(&src_tex->base, src_level),
                        src_tex->img_stride[src_level],
                        src_box->x, src_box->y, 0);
+
+         if (util_format_is_compressed(format))
+            lp_build_format_cache_invalidate();
       }
    }
 }
@@ -41,8 +41,12 @@
 #include "util/u_math.h"
 #include "util/u_memory.h"
 #include "util/u_simple_list.h"
+#include "util/u_slab.h"
 #include "util/u_transfer.h"
 
+#include "draw/draw_context.h"
+#include "gallivm/lp_bld_format.h"
+
 #include "lp_context.h"
 #include "lp_flush.h"
 #include "lp_screen.h"
@@ -622,6 +626,156 @@ llvmpipe_surface_destroy(struct pipe_context *pipe,
 }
 
 
+/**
+ * Free idle storage of renamed buffers beyond what we want to keep around.
+ */
+static void
+llvmpipe_trim_retired_buffers(struct llvmpipe_context *llvmpipe)
+{
+   unsigned i;
+
+   for (i = 0; i < LP_MAX_RETIRED_BUCKETS; i++) {
+      while (llvmpipe->retired_buffers[i] &&
+             llvmpipe->retired_buffer_bytes > LP_MAX_RETIRED_BYTES) {
+         struct lp_retired_buffer *retired = llvmpipe->retired_buffers[i];
+
+         llvmpipe->retired_buffers[i] = retired->next;
+         llvmpipe->retired_buffer_bytes -= retired->size;
+         align_free(retired->data);
+         FREE(retired);
+      }
+   }
+}
+
+
+/**
+ * Give a buffer new storage so that a map writing it doesn't have to wait
+ * for the scene being binned, which still reads the old storage.  Unless
+ * the map discards the contents, they are copied to the new storage.
+ *
+ * The old storage is kept with that scene until it has been rasterized,
+ * and is then reused for buffers of the same size.  Nothing is flushed.
+ *
+ * \return FALSE if out of memory or if the scene already holds too much
+ *         memory, in which case the caller has to flush and wait.
+ */
+static boolean
+llvmpipe_rename_buffer(struct llvmpipe_context *llvmpipe,
+                       struct llvmpipe_resource *lpr,
+                       boolean copy)
+{
+   const unsigned size = lpr->base.width0;
+   struct lp_retired_buffer **prev =
+      &llvmpipe->retired_buffers[util_logbase2(size)];
+   struct lp_retired_buffer *retired = NULL;
+   void *data = NULL;
+   unsigned shader, i;
+
+   if (!lp_setup_can_retire_buffer(llvmpipe->setup, size))
+      return FALSE;
+
+   /* Look for idle storage of the same size */
+   for (; *prev; prev = &(*prev)->next) {
+      if ((*prev)->size == size) {
+         retired = *prev;
+         *prev = retired->next;
+         llvmpipe->retired_buffer_bytes -= size;
+         data = retired->data;
+         break;
+      }
+   }
+
+   if (!data) {
+      retired = CALLOC_STRUCT(lp_retired_buffer);
+      if (!retired)
+         return FALSE;
+
+      data = align_malloc(size, 16);
+      if (!data) {
+         FREE(retired);
+         return FALSE;
+      }
+   }
+
+   if (copy)
+      memcpy(data, lpr->data, size);
+
+   retired->data = lpr->data;
+   retired->size = size;
+   lp_setup_retire_buffer(llvmpipe->setup, retired);
+
+   lpr->data = data;
+
+   /* Sampler views and constants point at the buffer's storage */
+   llvmpipe->dirty |= LP_NEW_SAMPLER_VIEW | LP_NEW_CONSTANTS;
+
+   /* The draw module was handed the storage of vertex and geometry shader
+    * constant buffers when they were bound, so hand it the new one.
+    */
+   for (shader = 0; shader < PIPE_SHADER_TYPES; shader++) {
+      if (shader != PIPE_SHADER_VERTEX && shader != PIPE_SHADER_GEOMETRY)
+         continue;
+
+      for (i = 0; i < Elements(llvmpipe->constants[shader]); i++) {
+         const struct pipe_constant_buffer *cb = &llvmpipe->constants[shader][i];
+
+         if (cb->buffer == &lpr->base) {
+            draw_set_mapped_constant_buffer(llvmpipe->draw, shader, i,
+                                            (ubyte *) data + cb->buffer_offset,
+                                            cb->buffer_size);
+         }
+      }
+   }
+
+   return TRUE;
+}
+
+
+/**
+ * Take back the old storage of buffers renamed while a scene was binning,
+ * once the scene has been rasterized.
+ */
+void
+llvmpipe_release_retired_buffers(struct pipe_context *pipe,
+                                 struct lp_retired_buffer *retired)
+{
+   struct llvmpipe_context *llvmpipe = llvmpipe_context(pipe);
+
+   while (retired) {
+      struct lp_retired_buffer *next = retired->next;
+      const unsigned bucket = util_logbase2(retired->size);
+
+      retired->next = llvmpipe->retired_buffers[bucket];
+      llvmpipe->retired_buffers[bucket] = retired;
+      llvmpipe->retired_buffer_bytes += retired->size;
+      retired = next;
+   }
+
+   llvmpipe_trim_retired_buffers(llvmpipe);
+}
+
+
+/**
+ * Free all idle storage of renamed buffers, at context destruction.
+ */
+void
+llvmpipe_free_retired_buffers(struct llvmpipe_context *llvmpipe)
+{
+   unsigned i;
+
+   for (i = 0; i < LP_MAX_RETIRED_BUCKETS; i++) {
+      while (llvmpipe->retired_buffers[i]) {
+         struct lp_retired_buffer *retired = llvmpipe->retired_buffers[i];
+
+         llvmpipe->retired_buffers[i] = retired->next;
+         align_free(retired->data);
+         FREE(retired);
+      }
+   }
+   llvmpipe->retired_buffer_bytes = 0;
+}
+
+
 static void *
 llvmpipe_transfer_map( struct pipe_context *pipe,
                        struct pipe_resource *resource,
@@ -639,15 +793,30 @@ llvmpipe_transfer_map( struct pipe_context *pipe,
    enum pipe_format format;
    enum lp_texture_usage tex_usage;
    const char *mode;
+   boolean discard = !!(usage & PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE);
+   boolean renamed = FALSE;
+   int64_t t0;
 
    assert(resource);
    assert(level <= resource->last_level);
 
    /*
     * Transfers, like other pipe operations, must happen in order, so flush the
-    * context if necessary.
+    * context if necessary.  Buffers which the scene only reads can get
+    * fresh storage instead, with a copy of the old contents unless the map
+    * discards them.
     */
-   if (!(usage & PIPE_TRANSFER_UNSYNCHRONIZED)) {
+   if ((usage & PIPE_TRANSFER_WRITE) &&
+       !(usage & PIPE_TRANSFER_UNSYNCHRONIZED) &&
+       llvmpipe_buffer_can_rename(resource, !discard) &&
+       llvmpipe_is_resource_referenced(pipe, resource, level) ==
+          LP_REFERENCED_FOR_READ &&
+       llvmpipe_rename_buffer(llvmpipe, lpr, !discard)) {
+      /* The new storage isn't used by anything yet */
+      renamed = TRUE;
+   }
+
+   if (!renamed && !(usage & PIPE_TRANSFER_UNSYNCHRONIZED)) {
       boolean read_only = !(usage & PIPE_TRANSFER_WRITE);
       boolean do_not_block = !!(usage & PIPE_TRANSFER_DONTBLOCK);
       if (!llvmpipe_flush_resource(pipe, resource,
@@ -671,9 +840,10 @@ llvmpipe_transfer_map( struct pipe_context *pipe,
       llvmpipe->dirty |= LP_NEW_CONSTANTS;
    }
 
-   lpt = CALLOC_STRUCT(llvmpipe_transfer);
+   lpt = util_slab_cache_alloc(llvmpipe->transfer_cache);
    if (!lpt)
       return NULL;
+   memset(lpt, 0, sizeof *lpt);
    pt = &lpt->base;
    pipe_resource_reference(&pt->resource, resource);
    pt->box = *box;
@@ -708,10 +878,12 @@ llvmpipe_transfer_map( struct pipe_context *pipe,
 
    format = lpr->base.format;
 
+   t0 = util_perf_timer_begin();
    map = llvmpipe_resource_map(resource,
                                level,
                                box->z,
                                tex_usage, LP_TEX_LAYOUT_LINEAR);
+   util_perf_timer_end(&llvmpipe->timers.stage[LP_TIMER_TEX_LAYOUT], t0);
 
 
    /* May want to do different things here depending on read/write nature
@@ -735,11 +907,24 @@ static void
 llvmpipe_transfer_unmap(struct pipe_context *pipe,
                         struct pipe_transfer *transfer)
 {
+   int64_t t0;
+
    assert(transfer->resource);
 
+   t0 = util_perf_timer_begin();
    llvmpipe_resource_unmap(transfer->resource,
                            transfer->level,
                            transfer->box.z);
+   util_perf_timer_end(&llvmpipe_context(pipe)->timers.stage[
+                          LP_TIMER_TEX_LAYOUT], t0);
+
+   /* Forget about blocks decoded from the previous contents.  Doing this
+    * at map time would let the rasterizer threads decode the old contents
+    * again before they are overwritten.
+    */
+   if ((transfer->usage & PIPE_TRANSFER_WRITE) &&
+       util_format_is_compressed(transfer->resource->format))
+      lp_build_format_cache_invalidate();
 
    /* Effectively do the texture_update work here - if texture images
     * needed post-processing to put them into hardware layout, this is
@@ -747,7 +932,7 @@ llvmpipe_transfer_unmap(struct pipe_context *pipe,
     */
    assert (transfer->resource);
    pipe_resource_reference(&transfer->resource, NULL);
-   FREE(transfer);
+   util_slab_cache_free(llvmpipe_context(pipe)->transfer_cache, transfer);
 }
 
 unsigned int
@@ -765,7 +950,8 @@ llvmpipe_is_resource_referenced( struct pipe_context *pipe,
     */
    if (!(presource->bind & (PIPE_BIND_DEPTH_STENCIL |
                             PIPE_BIND_RENDER_TARGET |
-                            PIPE_BIND_SAMPLER_VIEW)))
+                            PIPE_BIND_SAMPLER_VIEW |
+                            PIPE_BIND_CONSTANT_BUFFER)))
       return LP_UNREFERENCED;
 
    return lp_setup_is_resource_referenced(llvmpipe->setup, presource);
@@ -30,6 +30,7 @@
 
 
 #include "pipe/p_state.h"
+#include "util/u_atomic.h"
 #include "util/u_debug.h"
 #include "lp_limits.h"
 
@@ -55,6 +56,7 @@ enum lp_texture_layout
 struct pipe_context;
 struct pipe_screen;
 struct llvmpipe_context;
+struct lp_retired_buffer;
 
 struct sw_displaytarget;
 
@@ -121,6 +123,14 @@ struct llvmpipe_resource
    boolean userBuffer;  /** Is this a user-space buffer? */
    unsigned timestamp;
 
+   /**
+    * The first context which kept a pointer to the storage of the resource
+    * past the call that bound it, and whether any other context did as
+    * well.  The storage of shared buffers is never renamed.
+    */
+   struct pipe_context *context;
+   boolean shared;
+
    unsigned id;  /**< temporary, for debugging */
 
 #ifdef DEBUG
@@ -163,6 +173,11 @@ llvmpipe_transfer(struct pipe_transfer *pt)
 void llvmpipe_init_screen_resource_funcs(struct pipe_screen *screen);
 void llvmpipe_init_context_resource_funcs(struct pipe_context *pipe);
 
+void llvmpipe_release_retired_buffers(struct pipe_context *pipe,
+                                      struct lp_retired_buffer *retired);
+
+void llvmpipe_free_retired_buffers(struct llvmpipe_context *llvmpipe);
+
 
 static INLINE boolean
 llvmpipe_resource_is_texture(const struct pipe_resource *resource)
@@ -185,6 +200,40 @@ llvmpipe_resource_is_texture(const struct pipe_resource *resource)
 }
 
 
+/**
+ * Note that a context keeps a pointer to the storage of a resource past the
+ * current call, e.g. because the resource is bound to it.
+ */
+static INLINE void
+llvmpipe_resource_note_context(struct pipe_resource *resource,
+                               struct pipe_context *pipe)
+{
+   struct llvmpipe_resource *lpr = llvmpipe_resource(resource);
+
+   if (lpr->context != pipe &&
+       p_atomic_cmpxchg_ptr((void **) &lpr->context, NULL, pipe) != NULL)
+      lpr->shared = TRUE;
+}
+
+
+/**
+ * Whether a buffer which a scene reads may get new storage when written,
+ * rather than waiting for the scene.  Copying the old contents to the new
+ * storage is only done for small buffers.
+ */
+static INLINE boolean
+llvmpipe_buffer_can_rename(const struct pipe_resource *resource,
+                           boolean copy)
+{
+   const struct llvmpipe_resource *lpr = llvmpipe_resource_const(resource);
+
+   return resource->target == PIPE_BUFFER &&
+          !lpr->userBuffer &&
+          !lpr->shared &&
+          (!copy || resource->width0 <= LP_MAX_RENAME_COPY_SIZE);
+}
+
+
 static INLINE unsigned
 llvmpipe_resource_stride(struct pipe_resource *resource,
                         unsigned level)
@@ -584,6 +584,8 @@ static int r600_get_param(struct pipe_screen* pscreen, enum pipe_cap param)
 	case PIPE_CAP_VERTEX_COLOR_CLAMPED:
 	case PIPE_CAP_USER_VERTEX_BUFFERS:
 	case PIPE_CAP_TEXTURE_BUFFER_OFFSET_ALIGNMENT:
+	case PIPE_CAP_BUFFER_MAP_PERSISTENT:
+	case PIPE_CAP_BUFFER_MAP_DISCARD_RENAMES:
 		return 0;
 
 	/* Stream output. */
@@ -33,6 +33,7 @@
 #include "os/os_time.h"
 #include "pipe/p_defines.h"
 #include "util/u_memory.h"
+#include "util/u_perf_timer.h"
 #include "sp_context.h"
 #include "sp_query.h"
 #include "sp_state.h"
@@ -43,6 +44,14 @@ struct softpipe_query {
    uint64_t end;
    struct pipe_query_data_so_statistics so;
    unsigned num_primitives_generated;
+   boolean timer_active;
+};
+
+
+static const struct pipe_driver_query_info sp_driver_queries[] = {
+   { "draw-fetch", SP_QUERY_DRAW_FETCH, 0, FALSE },
+   { "draw-shade", SP_QUERY_DRAW_SHADE, 0, FALSE },
+   { "draw-clip", SP_QUERY_DRAW_CLIP, 0, FALSE }
 };
 
 
@@ -51,6 +60,30 @@ static struct softpipe_query *softpipe_query( struct pipe_query *p )
    return (struct softpipe_query *)p;
 }
 
+
+static INLINE boolean
+is_driver_query(unsigned type)
+{
+   return type >= SP_QUERY_DRAW_FETCH && type < SP_QUERY_DRIVER_END;
+}
+
+
+/**
+ * Return the total time spent so far in the draw stage of a driver query.
+ */
+static uint64_t
+sample_timer(struct softpipe_context *softpipe, unsigned type)
+{
+   static const enum draw_timer timers[] = {
+      DRAW_TIMER_FETCH,
+      DRAW_TIMER_SHADE,
+      DRAW_TIMER_CLIP
+   };
+
+   return draw_get_timer(softpipe->draw,
+                         timers[type - SP_QUERY_DRAW_FETCH])->time;
+}
+
 static struct pipe_query *
 softpipe_create_query(struct pipe_context *pipe, 
 		      unsigned type)
@@ -64,7 +97,8 @@ softpipe_create_query(struct pipe_context *pipe,
           type == PIPE_QUERY_PRIMITIVES_GENERATED ||
           type == PIPE_QUERY_GPU_FINISHED ||
           type == PIPE_QUERY_TIMESTAMP ||
-          type == PIPE_QUERY_TIMESTAMP_DISJOINT);
+          type == PIPE_QUERY_TIMESTAMP_DISJOINT ||
+          is_driver_query(type));
    sq = CALLOC_STRUCT( softpipe_query );
    sq->type = type;
 
@@ -75,6 +109,9 @@ softpipe_create_query(struct pipe_context *pipe,
 static void
 softpipe_destroy_query(struct pipe_context *pipe, struct pipe_query *q)
 {
+   if (softpipe_query(q)->timer_active)
+      util_perf_timers_disable();
+
    FREE(q);
 }
 
@@ -85,6 +122,15 @@ softpipe_begin_query(struct pipe_context *pipe, struct pipe_query *q)
    struct softpipe_context *softpipe = softpipe_context( pipe );
    struct softpipe_query *sq = softpipe_query(q);
 
+   if (is_driver_query(sq->type)) {
+      if (!sq->timer_active) {
+         util_perf_timers_enable();
+         sq->timer_active = TRUE;
+      }
+      sq->start = sample_timer(softpipe, sq->type);
+      return;
+   }
+
    switch (sq->type) {
    case PIPE_QUERY_OCCLUSION_COUNTER:
       sq->start = softpipe->occlusion_count;
@@ -121,6 +167,15 @@ softpipe_end_query(struct pipe_context *pipe, struct pipe_query *q)
    struct softpipe_context *softpipe = softpipe_context( pipe );
    struct softpipe_query *sq = softpipe_query(q);
 
+   if (is_driver_query(sq->type)) {
+      sq->end = sample_timer(softpipe, sq->type);
+      if (sq->timer_active) {
+         util_perf_timers_disable();
+         sq->timer_active = FALSE;
+      }
+      return;
+   }
+
    softpipe->active_query_count--;
    switch (sq->type) {
    case PIPE_QUERY_OCCLUSION_COUNTER:
@@ -220,6 +275,22 @@ softpipe_check_render_cond(struct softpipe_context *sp)
 }
 
 
+int
+softpipe_get_driver_query_info(struct pipe_screen *screen,
+                               unsigned index,
+                               struct pipe_driver_query_info *info)
+{
+   if (!info)
+      return Elements(sp_driver_queries);
+
+   if (index >= Elements(sp_driver_queries))
+      return 0;
+
+   *info = sp_driver_queries[index];
+   return 1;
+}
+
+
 void softpipe_init_query_funcs(struct softpipe_context *softpipe )
 {
    softpipe->pipe.create_query = softpipe_create_query;
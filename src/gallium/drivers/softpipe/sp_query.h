@@ -32,6 +32,8 @@
 #ifndef SP_QUERY_H
 #define SP_QUERY_H
 
+#include "pipe/p_defines.h"
+
 extern boolean
 softpipe_check_render_cond(struct softpipe_context *sp);
 
@@ -40,4 +42,23 @@ struct softpipe_context;
 extern void softpipe_init_query_funcs(struct softpipe_context * );
 
 
+/**
+ * Driver-specific queries, returning the nanoseconds spent in a draw module
+ * stage between begin_query and end_query.
+ */
+enum sp_driver_query {
+   SP_QUERY_DRAW_FETCH = PIPE_QUERY_DRIVER_SPECIFIC,
+   SP_QUERY_DRAW_SHADE,
+   SP_QUERY_DRAW_CLIP,
+   SP_QUERY_DRIVER_END
+};
+
+struct pipe_screen;
+struct pipe_driver_query_info;
+extern int
+softpipe_get_driver_query_info(struct pipe_screen *screen,
+                               unsigned index,
+                               struct pipe_driver_query_info *info);
+
+
 #endif /* SP_QUERY_H */
@@ -45,6 +45,7 @@
 #include "sp_context.h"
 #include "sp_fence.h"
 #include "sp_public.h"
+#include "sp_query.h"
 
 DEBUG_GET_ONCE_BOOL_OPTION(use_llvm, "SOFTPIPE_USE_LLVM", FALSE)
 
@@ -173,6 +174,10 @@ softpipe_get_param(struct pipe_screen *screen, enum pipe_cap param)
       return 1;
    case PIPE_CAP_TEXTURE_BUFFER_OFFSET_ALIGNMENT:
       return 0;
+   case PIPE_CAP_BUFFER_MAP_PERSISTENT:
+      return 1;
+   case PIPE_CAP_BUFFER_MAP_DISCARD_RENAMES:
+      return 0;
    }
    /* should only get here on unhandled cases */
    debug_printf("Unexpected PIPE_CAP %d query\n", param);
@@ -392,6 +397,7 @@ softpipe_create_screen(struct sw_winsys *winsys)
    screen->base.get_paramf = softpipe_get_paramf;
    screen->base.get_video_param = softpipe_get_video_param;
    screen->base.get_timestamp = softpipe_get_timestamp;
+   screen->base.get_driver_query_info = softpipe_get_driver_query_info;
    screen->base.is_format_supported = softpipe_is_format_supported;
    screen->base.is_video_format_supported = vl_video_buffer_is_format_supported;
    screen->base.context_create = softpipe_create_context;
@@ -72,6 +72,11 @@ void svga_hwtnl_destroy( struct svga_hwtnl *hwtnl )
       }
    }
 
+   for (i = 0; i < IDX_TRANSLATE_CACHE_MAX; i++) {
+      pipe_resource_reference( &hwtnl->translate_cache[i].src, NULL );
+      pipe_resource_reference( &hwtnl->translate_cache[i].buffer, NULL );
+   }
+
    for (i = 0; i < hwtnl->cmd.vdecl_count; i++)
       pipe_resource_reference(&hwtnl->cmd.vdecl_vb[i], NULL);
 
@@ -92,6 +92,66 @@ fail:
 }
 
 
+/**
+ * Like translate_indices(), but reuse the results of earlier translations
+ * of the same indices if the source buffer hasn't been written since.
+ */
+static enum pipe_error
+retrieve_or_translate_indices( struct svga_hwtnl *hwtnl,
+                               struct pipe_resource *src,
+                               unsigned offset,
+                               unsigned nr,
+                               unsigned index_size,
+                               u_translate_func translate,
+                               struct pipe_resource **out_buf )
+{
+   struct svga_buffer *sbuf = svga_buffer(src);
+   struct translate_cache *entry;
+   struct translate_cache *oldest = &hwtnl->translate_cache[0];
+   enum pipe_error ret;
+   unsigned i;
+
+   /* User buffers may change at any time, and streamed buffers are rarely
+    * drawn twice with the same contents.
+    */
+   if (sbuf->user || src->usage == PIPE_USAGE_STREAM)
+      return translate_indices( hwtnl, src, offset, nr, index_size,
+                                translate, out_buf );
+
+   for (i = 0; i < IDX_TRANSLATE_CACHE_MAX; i++) {
+      entry = &hwtnl->translate_cache[i];
+
+      if (entry->src == src &&
+          entry->src_generation == sbuf->generation &&
+          entry->offset == offset &&
+          entry->nr == nr &&
+          entry->translate == translate) {
+         entry->last_used = ++hwtnl->translate_cache_age;
+         pipe_resource_reference( out_buf, entry->buffer );
+         return PIPE_OK;
+      }
+
+      if (entry->last_used < oldest->last_used)
+         oldest = entry;
+   }
+
+   ret = translate_indices( hwtnl, src, offset, nr, index_size,
+                            translate, out_buf );
+   if (ret != PIPE_OK)
+      return ret;
+
+   pipe_resource_reference( &oldest->src, src );
+   pipe_resource_reference( &oldest->buffer, *out_buf );
+   oldest->src_generation = sbuf->generation;
+   oldest->offset = offset;
+   oldest->nr = nr;
+   oldest->translate = translate;
+   oldest->last_used = ++hwtnl->translate_cache_age;
+
+   return PIPE_OK;
+}
+
+
 
 
 
@@ -213,19 +273,16 @@ svga_hwtnl_draw_range_elements( struct svga_hwtnl *hwtnl,
       struct pipe_resource *gen_buf = NULL;
 
       /* Need to allocate a new index buffer and run the translate
-       * func to populate it.  Could potentially cache this translated
-       * index buffer with the original to avoid future
-       * re-translations.  Not much point if we're just accelerating
-       * GL though, as index buffers are typically used only once
-       * there.
+       * func to populate it, unless the same indices were translated
+       * before.
        */
-      ret = translate_indices( hwtnl,
-                               index_buffer,
-                               start * index_size,
-                               gen_nr,
-                               gen_size,
-                               gen_func,
-                               &gen_buf );
+      ret = retrieve_or_translate_indices( hwtnl,
+                                           index_buffer,
+                                           start * index_size,
+                                           gen_nr,
+                                           gen_size,
+                                           gen_func,
+                                           &gen_buf );
       if (ret != PIPE_OK)
          goto done;
 
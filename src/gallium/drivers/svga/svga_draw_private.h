@@ -94,6 +94,23 @@ struct index_cache {
 };
 
 
+/**
+ * A translated copy of (part of) an index buffer.
+ */
+struct translate_cache {
+   u_translate_func translate;
+
+   /* Source of the translation, and its generation at the time */
+   struct pipe_resource *src;
+   unsigned src_generation;
+   unsigned offset;
+   unsigned nr;
+
+   struct pipe_resource *buffer;
+   unsigned last_used;
+};
+
+
 /** Max number of primitives per draw call */
 #define QSZ SVGA3D_MAX_DRAW_PRIMITIVE_RANGES
 
@@ -112,6 +129,7 @@ struct draw_cmd {
 };
 
 #define IDX_CACHE_MAX  8
+#define IDX_TRANSLATE_CACHE_MAX  8
 
 struct svga_hwtnl {
    struct svga_context *svga;
@@ -135,6 +153,12 @@ struct svga_hwtnl {
     */
    struct index_cache index_cache[PIPE_PRIM_MAX][IDX_CACHE_MAX];
 
+   /* Cache the results of translating index buffers which don't change
+    * often, so that static geometry is only translated once.
+    */
+   struct translate_cache translate_cache[IDX_TRANSLATE_CACHE_MAX];
+   unsigned translate_cache_age;
+
    /* Try to build the maximal draw command packet before emitting:
     */
    struct draw_cmd cmd;
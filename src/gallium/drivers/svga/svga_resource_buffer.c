@@ -87,6 +87,8 @@ svga_buffer_transfer_map(struct pipe_context *pipe,
    transfer->box = *box;
 
    if (usage & PIPE_TRANSFER_WRITE) {
+      sbuf->generation++;
+
       if (usage & PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE) {
          /*
           * Flush any pending primitives, finish writing any pending DMA
@@ -177,6 +177,13 @@ struct svga_buffer
     * a context. It is only valid if the dma.pending is set above.
     */
    struct list_head head;
+
+   /**
+    * Incremented every time the buffer is mapped for writing, so that data
+    * derived from the buffer contents (such as translated index buffers)
+    * can tell whether it is still valid.
+    */
+   unsigned generation;
 };
 
 
@@ -193,6 +193,8 @@ trace_context_get_query_result(struct pipe_context *_pipe,
    trace_dump_call_begin("pipe_context", "get_query_result");
 
    trace_dump_arg(ptr, pipe);
+   trace_dump_arg(ptr, query);
+   trace_dump_arg(bool, wait);
 
    _result = pipe->get_query_result(pipe, query, wait, presult);
    /* XXX this depends on the query type */
@@ -1092,6 +1094,8 @@ trace_context_create_stream_output_target(struct pipe_context *_pipe,
    result = pipe->create_stream_output_target(pipe,
                                               res, buffer_offset, buffer_size);
 
+   trace_dump_ret(ptr, result);
+
    trace_dump_call_end();
 
    return result;
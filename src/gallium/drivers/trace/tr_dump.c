@@ -30,10 +30,11 @@
  * @file
  * Trace dumping functions.
  *
- * For now we just use standard XML for dumping the trace calls, as this is
- * simple to write, parse, and visually inspect, but the actual representation
- * is abstracted out of this file, so that we can switch to a binary
- * representation if/when it becomes justified.
+ * By default we use standard XML for dumping the trace calls, as this is
+ * simple to write, parse, and visually inspect.  Setting
+ * GALLIUM_TRACE_FORMAT=binary selects a compact binary encoding of the same
+ * information instead, which is much cheaper to write, see "Binary encoding"
+ * below.
  *
  * @author Jose Fonseca <jrfonseca@tungstengraphics.com>
  */
@@ -47,6 +48,8 @@
 #include "os/os_thread.h"
 #include "os/os_time.h"
 #include "util/u_debug.h"
+#include "util/u_hash.h"
+#include "util/u_hash_table.h"
 #include "util/u_memory.h"
 #include "util/u_string.h"
 #include "util/u_math.h"
@@ -63,6 +66,7 @@ static unsigned refcount = 0;
 pipe_static_mutex(call_mutex);
 static long unsigned call_no = 0;
 static boolean dumping = FALSE;
+static boolean binary = FALSE;
 
 
 static INLINE void
@@ -118,6 +122,301 @@ trace_dump_escape(const char *str)
 }
 
 
+/*
+ * Binary encoding
+ *
+ * The trace starts with TRACE_BIN_MAGIC and the format version, followed by
+ * a stream of tokens: a one byte opcode and its operands.  Integers are
+ * LEB128 encoded (signed ones zigzag encoded first), floats are little
+ * endian IEEE doubles.
+ *
+ * Values are written as in the XML format, except that the end of args,
+ * members, elements and the time are implied.  Names (of classes, methods,
+ * args, structs, members and enums) are sent once with TRACE_BIN_STRING_DEF
+ * and then referred to by number.  Likewise the contents of blobs are only
+ * written the first time they are seen, so uploading the same data
+ * repeatedly costs nothing.  Blobs are told apart by their contents, of
+ * which a copy is kept for up to TRACE_BIN_MAX_BLOB_BYTES.
+ *
+ * src/gallium/tools/trace/parse.py reads both formats.
+ */
+
+#define TRACE_BIN_MAGIC "GTRB"
+#define TRACE_BIN_VERSION 1
+
+/** Blobs beyond this many bytes in total are written every time */
+#define TRACE_BIN_MAX_BLOB_BYTES (256 * 1024 * 1024)
+
+enum trace_bin_op {
+   TRACE_BIN_CALL_BEGIN = 0x01,  /* no, class id, method id */
+   TRACE_BIN_CALL_END = 0x02,    /* time */
+   TRACE_BIN_ARG = 0x03,         /* name id, value */
+   TRACE_BIN_RET = 0x04,         /* value */
+
+   TRACE_BIN_NULL = 0x10,
+   TRACE_BIN_BOOL = 0x11,        /* byte */
+   TRACE_BIN_INT = 0x12,         /* signed */
+   TRACE_BIN_UINT = 0x13,        /* unsigned */
+   TRACE_BIN_FLOAT = 0x14,       /* double */
+   TRACE_BIN_STRING = 0x15,      /* length, bytes */
+   TRACE_BIN_ENUM = 0x16,        /* name id */
+   TRACE_BIN_BYTES = 0x17,       /* blob id */
+   TRACE_BIN_PTR = 0x18,         /* unsigned */
+   TRACE_BIN_ARRAY_BEGIN = 0x19, /* values... */
+   TRACE_BIN_ARRAY_END = 0x1a,
+   TRACE_BIN_STRUCT_BEGIN = 0x1b,/* name id, members... */
+   TRACE_BIN_MEMBER = 0x1c,      /* name id, value */
+   TRACE_BIN_STRUCT_END = 0x1d,
+
+   TRACE_BIN_STRING_DEF = 0x20,  /* id, length, bytes */
+   TRACE_BIN_BLOB_DEF = 0x21     /* id, size, bytes */
+};
+
+struct trace_bin_blob_key
+{
+   uint32_t crc32;
+   uint32_t fnv1a;
+   size_t size;
+   const void *data;
+};
+
+static struct util_hash_table *bin_strings = NULL;
+static struct util_hash_table *bin_blobs = NULL;
+static unsigned bin_num_strings = 0;
+static unsigned bin_num_blobs = 0;
+static size_t bin_blob_bytes = 0;
+
+
+static INLINE void
+trace_bin_byte(uint8_t value)
+{
+   trace_dump_write((const char *)&value, 1);
+}
+
+
+static void
+trace_bin_uint(uint64_t value)
+{
+   uint8_t buf[10];
+   unsigned len = 0;
+
+   do {
+      uint8_t byte = value & 0x7f;
+      value >>= 7;
+      if (value)
+         byte |= 0x80;
+      buf[len++] = byte;
+   } while (value);
+
+   trace_dump_write((const char *)buf, len);
+}
+
+
+static INLINE void
+trace_bin_int(int64_t value)
+{
+   trace_bin_uint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+
+static void
+trace_bin_double(double value)
+{
+   uint8_t buf[8];
+   uint64_t bits;
+   unsigned i;
+
+   memcpy(&bits, &value, sizeof bits);
+   for (i = 0; i < 8; ++i) {
+      buf[i] = bits & 0xff;
+      bits >>= 8;
+   }
+
+   trace_dump_write((const char *)buf, 8);
+}
+
+
+static unsigned
+trace_bin_string_hash(void *key)
+{
+   const char *str = key;
+   return util_hash_crc32(str, strlen(str));
+}
+
+
+static int
+trace_bin_string_compare(void *key1, void *key2)
+{
+   return strcmp(key1, key2);
+}
+
+
+static uint32_t
+trace_bin_fnv1a(const void *data, size_t size)
+{
+   const uint8_t *p = data;
+   uint32_t hash = 2166136261u;
+
+   while (size--) {
+      hash ^= *p++;
+      hash *= 16777619u;
+   }
+
+   return hash;
+}
+
+
+static unsigned
+trace_bin_blob_hash(void *key)
+{
+   const struct trace_bin_blob_key *blob = key;
+   return blob->crc32 ^ blob->fnv1a;
+}
+
+
+static int
+trace_bin_blob_compare(void *key1, void *key2)
+{
+   const struct trace_bin_blob_key *blob1 = key1;
+   const struct trace_bin_blob_key *blob2 = key2;
+
+   return blob1->crc32 != blob2->crc32 ||
+          blob1->fnv1a != blob2->fnv1a ||
+          blob1->size != blob2->size ||
+          memcmp(blob1->data, blob2->data, blob1->size) != 0;
+}
+
+
+static enum pipe_error
+trace_bin_free_key(void *key, void *value, void *data)
+{
+   FREE(key);
+   return PIPE_OK;
+}
+
+
+/**
+ * Get the number of a name, defining it first if it's new.
+ *
+ * Definitions must not appear in the middle of a token, so this must be
+ * called before writing the opcode referring to the name.
+ */
+static uintptr_t
+trace_bin_name(const char *name)
+{
+   uintptr_t id = (uintptr_t) util_hash_table_get(bin_strings, (void *)name);
+
+   if (!id) {
+      size_t len = strlen(name);
+      char *key = MALLOC(len + 1);
+
+      id = ++bin_num_strings;
+      if (key) {
+         memcpy(key, name, len + 1);
+         util_hash_table_set(bin_strings, key, (void *)id);
+      }
+
+      trace_bin_byte(TRACE_BIN_STRING_DEF);
+      trace_bin_uint(id);
+      trace_bin_uint(len);
+      trace_dump_write(name, len);
+   }
+
+   return id;
+}
+
+
+static void
+trace_bin_named(enum trace_bin_op op, const char *name)
+{
+   uintptr_t id = trace_bin_name(name);
+
+   trace_bin_byte(op);
+   trace_bin_uint(id);
+}
+
+
+/**
+ * Write a blob reference, defining the blob first if its contents haven't
+ * been seen yet.
+ */
+static void
+trace_bin_bytes(const void *data, size_t size)
+{
+   struct trace_bin_blob_key key;
+   uintptr_t id;
+
+   key.crc32 = util_hash_crc32(data, size);
+   key.fnv1a = trace_bin_fnv1a(data, size);
+   key.size = size;
+   key.data = data;
+
+   id = (uintptr_t) util_hash_table_get(bin_blobs, &key);
+   if (!id) {
+      struct trace_bin_blob_key *new_key = NULL;
+
+      /* Keep a copy of the contents to compare later blobs against */
+      if (bin_blob_bytes + size <= TRACE_BIN_MAX_BLOB_BYTES)
+         new_key = MALLOC(sizeof *new_key + size);
+
+      id = ++bin_num_blobs;
+      if (new_key) {
+         *new_key = key;
+         new_key->data = new_key + 1;
+         memcpy(new_key + 1, data, size);
+         bin_blob_bytes += size;
+         util_hash_table_set(bin_blobs, new_key, (void *)id);
+      }
+
+      trace_bin_byte(TRACE_BIN_BLOB_DEF);
+      trace_bin_uint(id);
+      trace_bin_uint(size);
+      trace_dump_write(data, size);
+   }
+
+   trace_bin_byte(TRACE_BIN_BYTES);
+   trace_bin_uint(id);
+}
+
+
+static boolean
+trace_bin_begin(void)
+{
+   bin_strings = util_hash_table_create(trace_bin_string_hash,
+                                        trace_bin_string_compare);
+   bin_blobs = util_hash_table_create(trace_bin_blob_hash,
+                                      trace_bin_blob_compare);
+   if (!bin_strings || !bin_blobs)
+      return FALSE;
+
+   trace_dump_writes(TRACE_BIN_MAGIC);
+   trace_bin_uint(TRACE_BIN_VERSION);
+
+   return TRUE;
+}
+
+
+static void
+trace_bin_end(void)
+{
+   if (bin_strings) {
+      util_hash_table_foreach(bin_strings, trace_bin_free_key, NULL);
+      util_hash_table_destroy(bin_strings);
+      bin_strings = NULL;
+   }
+
+   if (bin_blobs) {
+      util_hash_table_foreach(bin_blobs, trace_bin_free_key, NULL);
+      util_hash_table_destroy(bin_blobs);
+      bin_blobs = NULL;
+   }
+
+   bin_num_strings = 0;
+   bin_num_blobs = 0;
+   bin_blob_bytes = 0;
+}
+
+
 static INLINE void
 trace_dump_indent(unsigned level)
 {
@@ -228,7 +527,12 @@ static void
 trace_dump_trace_close(void)
 {
    if(stream) {
-      trace_dump_writes("</trace>\n");
+      if (binary) {
+         trace_bin_end();
+         fflush(stream);
+      }
+      else
+         trace_dump_writes("</trace>\n");
       if (close_stream) {
          fclose(stream);
          close_stream = FALSE;
@@ -263,6 +567,9 @@ trace_dump_trace_begin(void)
       return FALSE;
 
    if(!stream) {
+      const char *format = debug_get_option("GALLIUM_TRACE_FORMAT", "xml");
+
+      binary = strcmp(format, "binary") == 0;
 
       if (strcmp(filename, "stderr") == 0) {
          close_stream = FALSE;
@@ -274,14 +581,25 @@ trace_dump_trace_begin(void)
       }
       else {
          close_stream = TRUE;
-         stream = fopen(filename, "wt");
+         stream = fopen(filename, binary ? "wb" : "wt");
          if (!stream)
             return FALSE;
       }
 
-      trace_dump_writes("<?xml version='1.0' encoding='UTF-8'?>\n");
-      trace_dump_writes("<?xml-stylesheet type='text/xsl' href='trace.xsl'?>\n");
-      trace_dump_writes("<trace version='0.1'>\n");
+      if (binary) {
+         if (!trace_bin_begin()) {
+            trace_bin_end();
+            if (close_stream)
+               fclose(stream);
+            stream = NULL;
+            return FALSE;
+         }
+      }
+      else {
+         trace_dump_writes("<?xml version='1.0' encoding='UTF-8'?>\n");
+         trace_dump_writes("<?xml-stylesheet type='text/xsl' href='trace.xsl'?>\n");
+         trace_dump_writes("<trace version='0.1'>\n");
+      }
 
 #if defined(PIPE_OS_LINUX) || defined(PIPE_OS_BSD) || defined(PIPE_OS_SOLARIS) || defined(PIPE_OS_APPLE)
       /* Linux applications rarely cleanup GL / Gallium resources so catch
@@ -375,6 +693,19 @@ void trace_dump_call_begin_locked(const char *klass, const char *method)
       return;
 
    ++call_no;
+
+   if (binary) {
+      uintptr_t klass_id = trace_bin_name(klass);
+      uintptr_t method_id = trace_bin_name(method);
+
+      trace_bin_byte(TRACE_BIN_CALL_BEGIN);
+      trace_bin_uint(call_no);
+      trace_bin_uint(klass_id);
+      trace_bin_uint(method_id);
+      call_start_time = os_time_get();
+      return;
+   }
+
    trace_dump_indent(1);
    trace_dump_writes("<call no=\'");
    trace_dump_writef("%lu", call_no);
@@ -397,6 +728,13 @@ void trace_dump_call_end_locked(void)
 
    call_end_time = os_time_get();
 
+   if (binary) {
+      /* No fflush here, that's most of the cost of tracing. */
+      trace_bin_byte(TRACE_BIN_CALL_END);
+      trace_bin_int(call_end_time - call_start_time);
+      return;
+   }
+
    trace_dump_call_time(call_end_time - call_start_time);
    trace_dump_indent(1);
    trace_dump_tag_end("call");
@@ -421,6 +759,11 @@ void trace_dump_arg_begin(const char *name)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_bin_named(TRACE_BIN_ARG, name);
+      return;
+   }
+
    trace_dump_indent(2);
    trace_dump_tag_begin1("arg", "name", name);
 }
@@ -430,6 +773,9 @@ void trace_dump_arg_end(void)
    if (!dumping)
       return;
 
+   if (binary)
+      return;
+
    trace_dump_tag_end("arg");
    trace_dump_newline();
 }
@@ -439,6 +785,11 @@ void trace_dump_ret_begin(void)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_bin_byte(TRACE_BIN_RET);
+      return;
+   }
+
    trace_dump_indent(2);
    trace_dump_tag_begin("ret");
 }
@@ -448,6 +799,9 @@ void trace_dump_ret_end(void)
    if (!dumping)
       return;
 
+   if (binary)
+      return;
+
    trace_dump_tag_end("ret");
    trace_dump_newline();
 }
@@ -457,6 +811,12 @@ void trace_dump_bool(int value)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_bin_byte(TRACE_BIN_BOOL);
+      trace_bin_byte(value ? 1 : 0);
+      return;
+   }
+
    trace_dump_writef("<bool>%c</bool>", value ? '1' : '0');
 }
 
@@ -465,6 +825,12 @@ void trace_dump_int(long long int value)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_bin_byte(TRACE_BIN_INT);
+      trace_bin_int(value);
+      return;
+   }
+
    trace_dump_writef("<int>%lli</int>", value);
 }
 
@@ -473,6 +839,12 @@ void trace_dump_uint(long long unsigned value)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_bin_byte(TRACE_BIN_UINT);
+      trace_bin_uint(value);
+      return;
+   }
+
    trace_dump_writef("<uint>%llu</uint>", value);
 }
 
@@ -481,6 +853,12 @@ void trace_dump_float(double value)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_bin_byte(TRACE_BIN_FLOAT);
+      trace_bin_double(value);
+      return;
+   }
+
    trace_dump_writef("<float>%g</float>", value);
 }
 
@@ -494,6 +872,11 @@ void trace_dump_bytes(const void *data,
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_bin_bytes(data, size);
+      return;
+   }
+
    trace_dump_writes("<bytes>");
    for(i = 0; i < size; ++i) {
       uint8_t byte = *p++;
@@ -529,6 +912,14 @@ void trace_dump_string(const char *str)
    if (!dumping)
       return;
 
+   if (binary) {
+      size_t len = strlen(str);
+      trace_bin_byte(TRACE_BIN_STRING);
+      trace_bin_uint(len);
+      trace_dump_write(str, len);
+      return;
+   }
+
    trace_dump_writes("<string>");
    trace_dump_escape(str);
    trace_dump_writes("</string>");
@@ -539,6 +930,11 @@ void trace_dump_enum(const char *value)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_bin_named(TRACE_BIN_ENUM, value);
+      return;
+   }
+
    trace_dump_writes("<enum>");
    trace_dump_escape(value);
    trace_dump_writes("</enum>");
@@ -549,6 +945,11 @@ void trace_dump_array_begin(void)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_bin_byte(TRACE_BIN_ARRAY_BEGIN);
+      return;
+   }
+
    trace_dump_writes("<array>");
 }
 
@@ -557,6 +958,11 @@ void trace_dump_array_end(void)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_bin_byte(TRACE_BIN_ARRAY_END);
+      return;
+   }
+
    trace_dump_writes("</array>");
 }
 
@@ -565,6 +971,9 @@ void trace_dump_elem_begin(void)
    if (!dumping)
       return;
 
+   if (binary)
+      return;
+
    trace_dump_writes("<elem>");
 }
 
@@ -573,6 +982,9 @@ void trace_dump_elem_end(void)
    if (!dumping)
       return;
 
+   if (binary)
+      return;
+
    trace_dump_writes("</elem>");
 }
 
@@ -581,6 +993,11 @@ void trace_dump_struct_begin(const char *name)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_bin_named(TRACE_BIN_STRUCT_BEGIN, name);
+      return;
+   }
+
    trace_dump_writef("<struct name='%s'>", name);
 }
 
@@ -589,6 +1006,11 @@ void trace_dump_struct_end(void)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_bin_byte(TRACE_BIN_STRUCT_END);
+      return;
+   }
+
    trace_dump_writes("</struct>");
 }
 
@@ -597,6 +1019,11 @@ void trace_dump_member_begin(const char *name)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_bin_named(TRACE_BIN_MEMBER, name);
+      return;
+   }
+
    trace_dump_writef("<member name='%s'>", name);
 }
 
@@ -605,6 +1032,9 @@ void trace_dump_member_end(void)
    if (!dumping)
       return;
 
+   if (binary)
+      return;
+
    trace_dump_writes("</member>");
 }
 
@@ -613,6 +1043,11 @@ void trace_dump_null(void)
    if (!dumping)
       return;
 
+   if (binary) {
+      trace_bin_byte(TRACE_BIN_NULL);
+      return;
+   }
+
    trace_dump_writes("<null/>");
 }
 
@@ -621,6 +1056,16 @@ void trace_dump_ptr(const void *value)
    if (!dumping)
       return;
 
+   if (binary) {
+      if (value) {
+         trace_bin_byte(TRACE_BIN_PTR);
+         trace_bin_uint((uintptr_t)value);
+      }
+      else
+         trace_bin_byte(TRACE_BIN_NULL);
+      return;
+   }
+
    if(value)
       trace_dump_writef("<ptr>0x%08lx</ptr>", (unsigned long)(uintptr_t)value);
    else
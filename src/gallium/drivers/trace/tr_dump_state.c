@@ -253,7 +253,7 @@ void trace_dump_clip_state(const struct pipe_clip_state *state)
 
 void trace_dump_shader_state(const struct pipe_shader_state *state)
 {
-   static char str[8192];
+   static char str[64 * 1024];
    unsigned i;
 
    if (!trace_dumping_enabled_locked())
@@ -613,6 +613,7 @@ void trace_dump_vertex_buffer(const struct pipe_vertex_buffer *state)
    trace_dump_member(uint, state, stride);
    trace_dump_member(uint, state, buffer_offset);
    trace_dump_member(resource_ptr, state, buffer);
+   trace_dump_member(ptr, state, user_buffer);
 
    trace_dump_struct_end();
 }
@@ -633,6 +634,7 @@ void trace_dump_index_buffer(const struct pipe_index_buffer *state)
    trace_dump_member(uint, state, index_size);
    trace_dump_member(uint, state, offset);
    trace_dump_member(resource_ptr, state, buffer);
+   trace_dump_member(ptr, state, user_buffer);
 
    trace_dump_struct_end();
 }
@@ -674,6 +676,15 @@ void trace_dump_constant_buffer(const struct pipe_constant_buffer *state)
    trace_dump_member(ptr, state, buffer);
    trace_dump_member(uint, state, buffer_offset);
    trace_dump_member(uint, state, buffer_size);
+
+   /* User constants are small and can't be recovered any other way */
+   trace_dump_member_begin("user_buffer");
+   if (state->user_buffer)
+      trace_dump_bytes(state->user_buffer, state->buffer_size);
+   else
+      trace_dump_null();
+   trace_dump_member_end();
+
    trace_dump_struct_end();
 }
 
@@ -98,6 +98,12 @@ trace_screen_get_param(struct pipe_screen *_screen,
 
    result = screen->get_param(screen, param);
 
+   /* Buffer contents are only dumped at unmap, so writes through a mapping
+    * kept across draws would be missing from the trace.
+    */
+   if (param == PIPE_CAP_BUFFER_MAP_PERSISTENT)
+      result = 0;
+
    trace_dump_ret(int, result);
 
    trace_dump_call_end();
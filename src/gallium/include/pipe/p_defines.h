@@ -397,6 +397,9 @@ enum pipe_flush_flags {
 #define PIPE_QUERY_PIPELINE_STATISTICS  10
 #define PIPE_QUERY_TYPES                11
 
+/* start of driver queries, see pipe_screen::get_driver_query_info */
+#define PIPE_QUERY_DRIVER_SPECIFIC     256
+
 
 /**
  * Conditional rendering modes
@@ -498,7 +501,9 @@ enum pipe_cap {
    PIPE_CAP_MIN_MAP_BUFFER_ALIGNMENT = 75,
    PIPE_CAP_CUBE_MAP_ARRAY = 76,
    PIPE_CAP_TEXTURE_BUFFER_OBJECTS = 77,
-   PIPE_CAP_TEXTURE_BUFFER_OFFSET_ALIGNMENT = 78
+   PIPE_CAP_TEXTURE_BUFFER_OFFSET_ALIGNMENT = 78,
+   PIPE_CAP_BUFFER_MAP_PERSISTENT = 79,
+   PIPE_CAP_BUFFER_MAP_DISCARD_RENAMES = 80
 };
 
 /**
@@ -628,6 +633,7 @@ union pipe_query_result
    /* PIPE_QUERY_TIME_ELAPSED */
    /* PIPE_QUERY_PRIMITIVES_GENERATED */
    /* PIPE_QUERY_PRIMITIVES_EMITTED */
+   /* PIPE_QUERY_DRIVER_SPECIFIC */
    uint64_t u64;
 
    /* PIPE_QUERY_SO_STATISTICS */
@@ -640,6 +646,18 @@ union pipe_query_result
    struct pipe_query_data_pipeline_statistics pipeline_statistics;
 };
 
+/**
+ * Description of a driver-specific query, as returned by
+ * pipe_screen::get_driver_query_info.
+ */
+struct pipe_driver_query_info
+{
+   const char *name;
+   unsigned query_type;       /**< PIPE_QUERY_DRIVER_SPECIFIC + i */
+   uint64_t max_value;        /**< max value for a HUD graph, 0 if unknown */
+   boolean uses_byte_units;   /**< whether the result is in bytes */
+};
+
 union pipe_color_union
 {
    float f[4];
@@ -60,6 +60,12 @@ PUBLIC struct pipe_screen *graw_create_window_and_screen( int x,
                                                           enum pipe_format format,
                                                           void **handle);
 
+/* Returns a screen which only renders to memory, for running tests and
+ * benchmarks without a window system.  Render targets must not have
+ * PIPE_BIND_DISPLAY_TARGET set.
+ */
+PUBLIC struct pipe_screen *graw_create_headless_screen( void );
+
 PUBLIC void graw_set_display_func( void (*func)( void ) );
 PUBLIC void graw_main_loop( void );
 
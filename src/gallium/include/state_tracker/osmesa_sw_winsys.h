@@ -0,0 +1,57 @@
+/**************************************************************************
+ *
+ * Copyright 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+#ifndef OSMESA_SW_WINSYS_H
+#define OSMESA_SW_WINSYS_H
+
+#include "pipe/p_compiler.h"
+#include "state_tracker/sw_winsys.h"
+
+
+/* Software winsys for off-screen rendering into application memory.
+ *
+ * Display targets are normally allocated by the winsys, but before
+ * creating the color texture of a framebuffer the state tracker may offer
+ * the application's buffer.  The next display target created takes it if
+ * it is large and aligned enough for what the driver asks for, so that
+ * the driver renders straight into it.
+ */
+struct sw_winsys *osmesa_create_sw_winsys( void );
+
+void
+osmesa_sw_winsys_offer_buffer( struct sw_winsys *ws,
+                               void *data,
+                               unsigned stride,
+                               unsigned rows );
+
+/* Withdraw the offer.  Returns TRUE if a display target took the buffer.
+ */
+boolean
+osmesa_sw_winsys_withdraw_buffer( struct sw_winsys *ws );
+
+
+#endif
@@ -308,6 +308,13 @@ struct st_framebuffer_iface
     */
    const struct st_visual *visual;
 
+   /**
+    * Whether the first row of the attachments is the bottom of the image,
+    * like textures, rather than the top.  The state tracker picks changes up
+    * when the stamp changes.
+    */
+   boolean y0_bottom;
+
    /**
     * Flush the front buffer.
     *
@@ -0,0 +1,1028 @@
+/**************************************************************************
+ *
+ * Copyright 2013 VMware, Inc.
+ * All Rights Reserved.
+ * Copyright 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Off-Screen rendering into client memory.
+ * State tracker for gallium (for [OS]Mesa)
+ *
+ * The color buffer of an OSMesa framebuffer is a display target of the
+ * osmesa software winsys.  Whenever the layout of the application's buffer
+ * allows it, the display target wraps that buffer and the driver renders
+ * into it directly.  Otherwise the driver renders into a texture which is
+ * copied into the application's buffer when rendering is flushed (glFlush,
+ * glFinish).  Rendering goes directly into the buffer when:
+ *
+ * - the driver can render to the buffer's pixel format, eg. OSMESA_RGBA
+ *   or OSMESA_BGRA with GL_UNSIGNED_BYTE,
+ * - the buffer and its rows are 16 byte aligned,
+ * - the buffer is large enough for the driver's padding.  llvmpipe renders
+ *   whole 64x64 pixel tiles, so there the height must be a multiple of 64
+ *   and the row length (OSMESA_ROW_LENGTH) at least the width rounded up
+ *   to a multiple of 64.
+ *
+ * Rows may be stored either way (OSMESA_Y_UP).  The default bottom to top
+ * layout is that of textures, so then the state tracker renders the way it
+ * renders to FBOs, with Y not flipped, while top to bottom buffers are
+ * rendered to like windows.  In both cases rendering starts out from the
+ * buffer's previous contents.
+ *
+ * As with the other gallium drivers, rendering may proceed asynchronously,
+ * so the application must call glFlush or glFinish before looking at its
+ * buffer.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include "GL/osmesa.h"
+
+#include "os/os_thread.h"
+
+#include "pipe/p_context.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_state.h"
+
+#include "util/u_atomic.h"
+#include "util/u_box.h"
+#include "util/u_format.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+
+#include "state_tracker/st_api.h"
+#include "state_tracker/st_gl_api.h"
+#include "state_tracker/osmesa_sw_winsys.h"
+
+#include "osmesa_public.h"
+
+
+struct osmesa_buffer
+{
+   struct st_framebuffer_iface *stfb;
+   struct st_visual visual;
+
+   /** The application's buffer, as given to OSMesaMakeCurrent */
+   void *map;
+   unsigned width, height;
+   unsigned stride;        /**< bytes per row */
+   boolean y_up;           /**< row 0 is the bottom row */
+
+   /** Whether the color texture is the application's buffer */
+   boolean direct;
+
+   struct pipe_resource *textures[ST_ATTACHMENT_COUNT];
+};
+
+
+struct osmesa_context
+{
+   struct st_context_iface *stctx;
+
+   struct osmesa_buffer buffer;
+
+   GLenum format;          /**< User-specified context format */
+   GLenum type;            /**< Buffer's data type */
+   GLint user_row_length;  /**< user-specified number of pixels per row */
+   GLboolean y_up;         /**< TRUE  -> Y increases upward
+                                FALSE -> Y increases downward */
+
+   /** Layout of the application's buffer */
+   enum pipe_format user_format;
+
+   /** Mapping returned by OSMesaGetDepthBuffer() */
+   struct pipe_transfer *depth_transfer;
+};
+
+
+static struct sw_winsys *osmesa_winsys = NULL;
+static struct st_manager *osmesa_stmgr = NULL;
+static struct st_api *osmesa_stapi = NULL;
+
+/** Protects the globals above and the winsys' buffer offers */
+pipe_static_mutex(osmesa_mutex);
+
+
+static int
+osmesa_st_get_param(struct st_manager *smapi,
+                    enum st_manager_param param)
+{
+   /* no-op */
+   return 0;
+}
+
+
+/**
+ * Create the API, winsys and screen shared by all contexts, on first use.
+ */
+static boolean
+osmesa_init(void)
+{
+   pipe_mutex_lock(osmesa_mutex);
+
+   if (!osmesa_stmgr) {
+      struct st_manager *stmgr;
+
+      if (!osmesa_winsys)
+         osmesa_winsys = osmesa_create_sw_winsys();
+
+      stmgr = CALLOC_STRUCT(st_manager);
+      if (osmesa_winsys && stmgr) {
+         stmgr->screen = osmesa_create_screen(osmesa_winsys);
+         stmgr->get_param = osmesa_st_get_param;
+         stmgr->get_egl_image = NULL;
+      }
+
+      if (stmgr && stmgr->screen)
+         osmesa_stmgr = stmgr;
+      else
+         FREE(stmgr);
+   }
+
+   if (!osmesa_stapi)
+      osmesa_stapi = st_gl_api_create();
+
+   pipe_mutex_unlock(osmesa_mutex);
+
+   return osmesa_stmgr && osmesa_stapi;
+}
+
+
+static INLINE struct osmesa_context *
+osmesa_context(struct st_framebuffer_iface *stfbi)
+{
+   return (struct osmesa_context *) stfbi->st_manager_private;
+}
+
+
+/**
+ * Return the pipe_format describing the application's buffer.
+ */
+static enum pipe_format
+osmesa_choose_user_format(GLenum format, GLenum type)
+{
+   if (type == GL_UNSIGNED_SHORT_5_6_5)
+      return format == OSMESA_RGB_565 ? PIPE_FORMAT_B5G6R5_UNORM :
+                                        PIPE_FORMAT_NONE;
+
+   if (type != GL_UNSIGNED_BYTE)
+      return PIPE_FORMAT_NONE;
+
+   switch (format) {
+   case OSMESA_RGBA:
+      return PIPE_FORMAT_R8G8B8A8_UNORM;
+   case OSMESA_BGRA:
+      return PIPE_FORMAT_B8G8R8A8_UNORM;
+   case OSMESA_ARGB:
+      return PIPE_FORMAT_A8R8G8B8_UNORM;
+   case OSMESA_RGB:
+      return PIPE_FORMAT_R8G8B8_UNORM;
+   case OSMESA_BGR:
+      /* There's no pipe format for this layout.  It's rendered as BGRA,
+       * see osmesa_copy_to_user().
+       */
+      return PIPE_FORMAT_R8G8B8_UNORM;
+   default:
+      return PIPE_FORMAT_NONE;
+   }
+}
+
+
+/**
+ * Return the format to render to for the given OSMesa format.
+ */
+static enum pipe_format
+osmesa_choose_color_format(struct pipe_screen *screen, GLenum format)
+{
+   const unsigned bind = PIPE_BIND_RENDER_TARGET | PIPE_BIND_DISPLAY_TARGET;
+   enum pipe_format pf;
+
+   switch (format) {
+   case OSMESA_RGBA:
+      pf = PIPE_FORMAT_R8G8B8A8_UNORM;
+      break;
+   case OSMESA_BGRA:
+   case OSMESA_BGR:
+      pf = PIPE_FORMAT_B8G8R8A8_UNORM;
+      break;
+   case OSMESA_ARGB:
+      pf = PIPE_FORMAT_A8R8G8B8_UNORM;
+      break;
+   case OSMESA_RGB:
+      pf = PIPE_FORMAT_R8G8B8A8_UNORM;
+      break;
+   case OSMESA_RGB_565:
+      pf = PIPE_FORMAT_B5G6R5_UNORM;
+      break;
+   default:
+      return PIPE_FORMAT_NONE;
+   }
+
+   if (!screen->is_format_supported(screen, pf, PIPE_TEXTURE_2D, 0, bind)) {
+      /* everybody renders to this one */
+      pf = PIPE_FORMAT_B8G8R8A8_UNORM;
+   }
+
+   return pf;
+}
+
+
+static enum pipe_format
+osmesa_choose_depth_stencil_format(struct pipe_screen *screen,
+                                   GLint depthBits, GLint stencilBits)
+{
+   static const enum pipe_format z24s8[] = {
+      PIPE_FORMAT_Z24_UNORM_S8_UINT,
+      PIPE_FORMAT_S8_UINT_Z24_UNORM
+   };
+   static const enum pipe_format z32[] = {
+      PIPE_FORMAT_Z32_UNORM,
+      PIPE_FORMAT_Z24X8_UNORM,
+      PIPE_FORMAT_X8Z24_UNORM
+   };
+   static const enum pipe_format z24[] = {
+      PIPE_FORMAT_Z24X8_UNORM,
+      PIPE_FORMAT_X8Z24_UNORM,
+      PIPE_FORMAT_Z24_UNORM_S8_UINT
+   };
+   static const enum pipe_format z16[] = {
+      PIPE_FORMAT_Z16_UNORM,
+      PIPE_FORMAT_Z24X8_UNORM
+   };
+   const enum pipe_format *formats;
+   unsigned count, i;
+
+   if (stencilBits > 0) {
+      formats = z24s8;
+      count = Elements(z24s8);
+   }
+   else if (depthBits > 24) {
+      formats = z32;
+      count = Elements(z32);
+   }
+   else if (depthBits > 16) {
+      formats = z24;
+      count = Elements(z24);
+   }
+   else if (depthBits > 0) {
+      formats = z16;
+      count = Elements(z16);
+   }
+   else {
+      return PIPE_FORMAT_NONE;
+   }
+
+   for (i = 0; i < count; i++) {
+      if (screen->is_format_supported(screen, formats[i], PIPE_TEXTURE_2D, 0,
+                                      PIPE_BIND_DEPTH_STENCIL))
+         return formats[i];
+   }
+
+   return PIPE_FORMAT_NONE;
+}
+
+
+/**
+ * Unmap the depth buffer returned by OSMesaGetDepthBuffer(), if any.
+ */
+static void
+osmesa_unmap_depth_buffer(struct osmesa_context *osmesa)
+{
+   if (osmesa->depth_transfer) {
+      struct pipe_context *pipe = osmesa->stctx->pipe;
+
+      pipe->transfer_unmap(pipe, osmesa->depth_transfer);
+      osmesa->depth_transfer = NULL;
+   }
+}
+
+
+/**
+ * Release the framebuffer textures so that they get recreated at the next
+ * validation, eg. because the application's buffer changed.
+ */
+static void
+osmesa_buffer_invalidate(struct osmesa_buffer *osbuffer)
+{
+   unsigned i;
+
+   for (i = 0; i < ST_ATTACHMENT_COUNT; i++)
+      pipe_resource_reference(&osbuffer->textures[i], NULL);
+
+   osbuffer->direct = FALSE;
+
+   osbuffer->stfb->y0_bottom = osbuffer->y_up;
+   p_atomic_inc(&osbuffer->stfb->stamp);
+}
+
+
+/**
+ * Initialize a color texture from the application's buffer, converting it
+ * as needed.  This is the reverse of osmesa_copy_to_user().
+ */
+static void
+osmesa_copy_from_user(struct osmesa_context *osmesa,
+                      struct pipe_context *pipe,
+                      struct pipe_resource *tex)
+{
+   struct osmesa_buffer *osbuffer = &osmesa->buffer;
+   enum pipe_format dst_format = tex->format;
+   struct pipe_transfer *transfer;
+   struct pipe_box box;
+   ubyte *dst;
+
+   u_box_2d(0, 0, osbuffer->width, osbuffer->height, &box);
+
+   dst = pipe->transfer_map(pipe, tex, 0,
+                            PIPE_TRANSFER_WRITE |
+                            PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE,
+                            &box, &transfer);
+   if (!dst)
+      return;
+
+   /* Unpacking BGR as if it was RGB yields BGRA texels. */
+   if (osmesa->format == OSMESA_BGR &&
+       dst_format == PIPE_FORMAT_B8G8R8A8_UNORM)
+      dst_format = PIPE_FORMAT_R8G8B8A8_UNORM;
+
+   /* The texture's rows are in the same order as the buffer's, see
+    * st_framebuffer_iface::y0_bottom.
+    */
+   util_format_translate(dst_format, dst, transfer->stride, 0, 0,
+                         osmesa->user_format, osbuffer->map, osbuffer->stride,
+                         0, 0, osbuffer->width, osbuffer->height);
+
+   pipe->transfer_unmap(pipe, transfer);
+}
+
+
+/**
+ * Create the color texture, wrapping the application's buffer when
+ * possible.  Either way the texture starts out with the buffer's contents,
+ * as the application may render on top of an image of its own.
+ */
+static struct pipe_resource *
+osmesa_create_color_texture(struct osmesa_context *osmesa,
+                            const struct pipe_resource *templat)
+{
+   struct osmesa_buffer *osbuffer = &osmesa->buffer;
+   struct pipe_screen *screen = osmesa_stmgr->screen;
+   struct pipe_resource templ = *templat;
+   struct pipe_resource *tex;
+   const unsigned size = osbuffer->stride * osbuffer->height;
+   void *saved = NULL;
+
+   osbuffer->direct = FALSE;
+
+   /* The application's buffer must be in the format we render to.  Drivers
+    * clear new display targets, so the contents are saved around the
+    * creation.
+    */
+   if (osmesa->user_format == templ.format &&
+       screen->is_format_supported(screen, templ.format, templ.target, 0,
+                                   PIPE_BIND_RENDER_TARGET |
+                                   PIPE_BIND_DISPLAY_TARGET))
+      saved = MALLOC(size);
+
+   if (saved) {
+      memcpy(saved, osbuffer->map, size);
+
+      templ.bind = PIPE_BIND_RENDER_TARGET | PIPE_BIND_DISPLAY_TARGET;
+
+      pipe_mutex_lock(osmesa_mutex);
+      osmesa_sw_winsys_offer_buffer(osmesa_winsys, osbuffer->map,
+                                    osbuffer->stride, osbuffer->height);
+      tex = screen->resource_create(screen, &templ);
+      osbuffer->direct = osmesa_sw_winsys_withdraw_buffer(osmesa_winsys);
+      pipe_mutex_unlock(osmesa_mutex);
+
+      memcpy(osbuffer->map, saved, size);
+      FREE(saved);
+
+      if (osbuffer->direct)
+         return tex;
+
+      /* The buffer didn't fit the driver's padding.  We copy from the
+       * texture anyway, so don't bother with a display target.
+       */
+      pipe_resource_reference(&tex, NULL);
+   }
+
+   templ.bind = PIPE_BIND_RENDER_TARGET | PIPE_BIND_SAMPLER_VIEW;
+   tex = screen->resource_create(screen, &templ);
+   if (tex)
+      osmesa_copy_from_user(osmesa, osmesa->stctx->pipe, tex);
+
+   return tex;
+}
+
+
+/**
+ * Called via st_framebuffer_iface::validate()
+ */
+static boolean
+osmesa_st_framebuffer_validate(struct st_framebuffer_iface *stfbi,
+                               const enum st_attachment_type *statts,
+                               unsigned count,
+                               struct pipe_resource **out)
+{
+   struct osmesa_context *osmesa = osmesa_context(stfbi);
+   struct osmesa_buffer *osbuffer = &osmesa->buffer;
+   struct pipe_screen *screen = osmesa_stmgr->screen;
+   struct pipe_resource templ;
+   unsigned i;
+
+   /* Validation precedes every draw, see OSMesaGetDepthBuffer(). */
+   osmesa_unmap_depth_buffer(osmesa);
+
+   memset(&templ, 0, sizeof(templ));
+   if (screen->get_param(screen, PIPE_CAP_NPOT_TEXTURES))
+      templ.target = PIPE_TEXTURE_2D;
+   else
+      templ.target = PIPE_TEXTURE_RECT;
+   templ.width0 = osbuffer->width;
+   templ.height0 = osbuffer->height;
+   templ.depth0 = 1;
+   templ.array_size = 1;
+   templ.last_level = 0;
+
+   for (i = 0; i < count; i++) {
+      enum st_attachment_type statt = statts[i];
+
+      out[i] = NULL;
+
+      if (!osbuffer->textures[statt]) {
+         switch (statt) {
+         case ST_ATTACHMENT_FRONT_LEFT:
+         case ST_ATTACHMENT_BACK_LEFT:
+            templ.format = osbuffer->visual.color_format;
+            osbuffer->textures[statt] =
+               osmesa_create_color_texture(osmesa, &templ);
+            break;
+         case ST_ATTACHMENT_DEPTH_STENCIL:
+            templ.format = osbuffer->visual.depth_stencil_format;
+            templ.bind = PIPE_BIND_DEPTH_STENCIL;
+            osbuffer->textures[statt] =
+               screen->resource_create(screen, &templ);
+            break;
+         case ST_ATTACHMENT_ACCUM:
+            templ.format = osbuffer->visual.accum_format;
+            templ.bind = PIPE_BIND_RENDER_TARGET;
+            osbuffer->textures[statt] =
+               screen->resource_create(screen, &templ);
+            break;
+         default:
+            continue;
+         }
+
+         if (!osbuffer->textures[statt])
+            return FALSE;
+      }
+
+      pipe_resource_reference(&out[i], osbuffer->textures[statt]);
+   }
+
+   return TRUE;
+}
+
+
+/**
+ * Copy the rendered image into the application's buffer, converting it as
+ * needed.
+ */
+static void
+osmesa_copy_to_user(struct osmesa_context *osmesa,
+                    struct pipe_context *pipe,
+                    struct pipe_resource *tex)
+{
+   struct osmesa_buffer *osbuffer = &osmesa->buffer;
+   enum pipe_format src_format = tex->format;
+   struct pipe_transfer *transfer;
+   struct pipe_box box;
+   const ubyte *src;
+
+   u_box_2d(0, 0, osbuffer->width, osbuffer->height, &box);
+
+   src = pipe->transfer_map(pipe, tex, 0, PIPE_TRANSFER_READ, &box,
+                            &transfer);
+   if (!src)
+      return;
+
+   /* Packing BGRA texels as if they were RGBA yields BGR. */
+   if (osmesa->format == OSMESA_BGR &&
+       src_format == PIPE_FORMAT_B8G8R8A8_UNORM)
+      src_format = PIPE_FORMAT_R8G8B8A8_UNORM;
+
+   util_format_translate(osmesa->user_format, osbuffer->map, osbuffer->stride,
+                         0, 0, src_format, src, transfer->stride, 0, 0,
+                         osbuffer->width, osbuffer->height);
+
+   pipe->transfer_unmap(pipe, transfer);
+}
+
+
+/**
+ * Called via st_framebuffer_iface::flush_front(), on glFlush and glFinish.
+ *
+ * Make sure the application's buffer holds the rendered image by the time
+ * this returns.
+ */
+static boolean
+osmesa_st_framebuffer_flush_front(struct st_context_iface *stctx,
+                                  struct st_framebuffer_iface *stfbi,
+                                  enum st_attachment_type statt)
+{
+   struct osmesa_context *osmesa = osmesa_context(stfbi);
+   struct osmesa_buffer *osbuffer = &osmesa->buffer;
+   struct pipe_resource *tex = osbuffer->textures[statt];
+   struct pipe_screen *screen = osmesa_stmgr->screen;
+
+   osmesa_unmap_depth_buffer(osmesa);
+
+   if (!tex)
+      return TRUE;
+
+   if (osbuffer->direct) {
+      struct pipe_fence_handle *fence = NULL;
+
+      stctx->flush(stctx, 0, &fence);
+      if (fence) {
+         screen->fence_finish(screen, fence, PIPE_TIMEOUT_INFINITE);
+         screen->fence_reference(screen, &fence, NULL);
+      }
+   }
+   else {
+      osmesa_copy_to_user(osmesa, stctx->pipe, tex);
+   }
+
+   return TRUE;
+}
+
+
+
+/**
+ * Create an Off-Screen Mesa rendering context.  The only attribute needed is
+ * an RGBA vs Color-Index mode flag.
+ *
+ * Input:  format - Must be GL_RGBA
+ *         sharelist - specifies another OSMesaContext with which to share
+ *                     display lists.  NULL indicates no sharing.
+ * Return:  an OSMesaContext or 0 if error
+ */
+GLAPI OSMesaContext GLAPIENTRY
+OSMesaCreateContext(GLenum format, OSMesaContext sharelist)
+{
+   return OSMesaCreateContextExt(format, 24, 8, 0, sharelist);
+}
+
+
+/**
+ * New in Mesa 3.5
+ *
+ * Create context and specify size of ancillary buffers.
+ */
+GLAPI OSMesaContext GLAPIENTRY
+OSMesaCreateContextExt(GLenum format, GLint depthBits, GLint stencilBits,
+                       GLint accumBits, OSMesaContext sharelist)
+{
+   OSMesaContext osmesa;
+   struct pipe_screen *screen;
+   struct st_framebuffer_iface *stfbi;
+   struct st_context_iface *st_shared;
+   struct st_context_attribs attribs;
+   struct st_visual *visual;
+   enum st_context_error st_error = 0;
+
+   if (!osmesa_init())
+      return NULL;
+
+   screen = osmesa_stmgr->screen;
+
+   osmesa = (OSMesaContext) CALLOC_STRUCT(osmesa_context);
+   stfbi = CALLOC_STRUCT(st_framebuffer_iface);
+   if (!osmesa || !stfbi) {
+      FREE(osmesa);
+      FREE(stfbi);
+      return NULL;
+   }
+
+   visual = &osmesa->buffer.visual;
+   visual->buffer_mask = ST_ATTACHMENT_FRONT_LEFT_MASK;
+   visual->color_format = osmesa_choose_color_format(screen, format);
+   visual->depth_stencil_format =
+      osmesa_choose_depth_stencil_format(screen, depthBits, stencilBits);
+   visual->accum_format = (accumBits > 0) ?
+      PIPE_FORMAT_R16G16B16A16_SNORM : PIPE_FORMAT_NONE;
+   visual->samples = 0;
+   visual->render_buffer = ST_ATTACHMENT_FRONT_LEFT;
+
+   if (visual->color_format == PIPE_FORMAT_NONE) {
+      FREE(osmesa);
+      FREE(stfbi);
+      return NULL;
+   }
+
+   if (visual->depth_stencil_format != PIPE_FORMAT_NONE)
+      visual->buffer_mask |= ST_ATTACHMENT_DEPTH_STENCIL_MASK;
+   if (visual->accum_format != PIPE_FORMAT_NONE)
+      visual->buffer_mask |= ST_ATTACHMENT_ACCUM_MASK;
+
+   stfbi->visual = visual;
+   stfbi->flush_front = osmesa_st_framebuffer_flush_front;
+   stfbi->validate = osmesa_st_framebuffer_validate;
+   p_atomic_set(&stfbi->stamp, 1);
+   stfbi->st_manager_private = (void *) osmesa;
+
+   osmesa->buffer.stfb = stfbi;
+   osmesa->format = format;
+   osmesa->user_row_length = 0;
+   osmesa->y_up = GL_TRUE;
+   stfbi->y0_bottom = osmesa->y_up;
+
+   memset(&attribs, 0, sizeof(attribs));
+   attribs.profile = ST_PROFILE_DEFAULT;
+   attribs.major = 1;
+   attribs.minor = 0;
+   attribs.visual = *visual;
+
+   st_shared = sharelist ? sharelist->stctx : NULL;
+
+   osmesa->stctx = osmesa_stapi->create_context(osmesa_stapi, osmesa_stmgr,
+                                                &attribs, &st_error,
+                                                st_shared);
+   if (!osmesa->stctx) {
+      FREE(osmesa);
+      FREE(stfbi);
+      return NULL;
+   }
+
+   osmesa->stctx->st_manager_private = osmesa;
+
+   return osmesa;
+}
+
+
+/**
+ * Destroy an Off-Screen Mesa rendering context.
+ *
+ * \param osmesa  the context to destroy
+ */
+GLAPI void GLAPIENTRY
+OSMesaDestroyContext(OSMesaContext osmesa)
+{
+   unsigned i;
+
+   if (!osmesa)
+      return;
+
+   osmesa_unmap_depth_buffer(osmesa);
+
+   if (osmesa_stapi->get_current(osmesa_stapi) == osmesa->stctx)
+      osmesa_stapi->make_current(osmesa_stapi, NULL, NULL, NULL);
+
+   osmesa->stctx->destroy(osmesa->stctx);
+
+   for (i = 0; i < ST_ATTACHMENT_COUNT; i++)
+      pipe_resource_reference(&osmesa->buffer.textures[i], NULL);
+
+   FREE(osmesa->buffer.stfb);
+   FREE(osmesa);
+}
+
+
+/**
+ * Bind an OSMesaContext to an image buffer.  The image buffer is just a
+ * block of memory which the client provides.  Its size must be at least
+ * as large as width*height*pixelSize.  Its address should be a multiple
+ * of 4 if using RGBA mode.
+ *
+ * By default, image data is stored in the order of glDrawPixels: row-major
+ * order with the lower-left image pixel stored in the first array position
+ * (ie. bottom-to-top).  See the top of this file for the layouts which are
+ * rendered to without an extra copy.
+ *
+ * If the context's viewport hasn't been initialized yet, it will now be
+ * initialized to (0,0,width,height).
+ *
+ * Input:  osmesa - the rendering context
+ *         buffer - the image buffer memory
+ *         type - data type for pixel components
+ *                GL_UNSIGNED_BYTE, or GL_UNSIGNED_SHORT_5_6_5 for
+ *                OSMESA_RGB_565
+ *         width, height - size of image buffer in pixels, at least 1
+ * Return:  GL_TRUE if success, GL_FALSE if error because of invalid osmesa,
+ *          invalid type, invalid size, etc.
+ */
+GLAPI GLboolean GLAPIENTRY
+OSMesaMakeCurrent(OSMesaContext osmesa, void *buffer, GLenum type,
+                  GLsizei width, GLsizei height)
+{
+   struct osmesa_buffer *osbuffer;
+   struct pipe_screen *screen;
+   enum pipe_format user_format;
+   unsigned max_size, row_length, stride;
+
+   if (!osmesa && !buffer) {
+      if (osmesa_stapi)
+         osmesa_stapi->make_current(osmesa_stapi, NULL, NULL, NULL);
+      return GL_TRUE;
+   }
+
+   if (!osmesa || !buffer || width < 1 || height < 1)
+      return GL_FALSE;
+
+   screen = osmesa_stmgr->screen;
+   max_size = 1 << (screen->get_param(screen,
+                                      PIPE_CAP_MAX_TEXTURE_2D_LEVELS) - 1);
+   if (width > max_size || height > max_size)
+      return GL_FALSE;
+
+   user_format = osmesa_choose_user_format(osmesa->format, type);
+   if (user_format == PIPE_FORMAT_NONE)
+      return GL_FALSE;
+
+   osmesa_unmap_depth_buffer(osmesa);
+
+   row_length = osmesa->user_row_length ? osmesa->user_row_length : width;
+   stride = util_format_get_stride(user_format, row_length);
+
+   osbuffer = &osmesa->buffer;
+   if (osbuffer->map != buffer ||
+       osbuffer->width != width ||
+       osbuffer->height != height ||
+       osbuffer->stride != stride ||
+       osbuffer->y_up != osmesa->y_up ||
+       osmesa->user_format != user_format) {
+      osbuffer->map = buffer;
+      osbuffer->width = width;
+      osbuffer->height = height;
+      osbuffer->stride = stride;
+      osbuffer->y_up = osmesa->y_up;
+      osmesa->user_format = user_format;
+
+      osmesa_buffer_invalidate(osbuffer);
+   }
+
+   osmesa->type = type;
+
+   return osmesa_stapi->make_current(osmesa_stapi, osmesa->stctx,
+                                     osbuffer->stfb, osbuffer->stfb);
+}
+
+
+
+GLAPI OSMesaContext GLAPIENTRY
+OSMesaGetCurrentContext(void)
+{
+   struct st_context_iface *stctx;
+
+   if (!osmesa_stapi)
+      return NULL;
+
+   stctx = osmesa_stapi->get_current(osmesa_stapi);
+   return stctx ? (OSMesaContext) stctx->st_manager_private : NULL;
+}
+
+
+
+GLAPI void GLAPIENTRY
+OSMesaPixelStore(GLint pname, GLint value)
+{
+   OSMesaContext osmesa = OSMesaGetCurrentContext();
+   struct osmesa_buffer *osbuffer;
+
+   if (!osmesa)
+      return;
+
+   osbuffer = &osmesa->buffer;
+
+   switch (pname) {
+   case OSMESA_ROW_LENGTH:
+      if (value < 0)
+         return;
+      osmesa->user_row_length = value;
+      if (osbuffer->map) {
+         unsigned row_length = value ? value : osbuffer->width;
+         osbuffer->stride = util_format_get_stride(osmesa->user_format,
+                                                   row_length);
+      }
+      break;
+   case OSMESA_Y_UP:
+      osmesa->y_up = value ? GL_TRUE : GL_FALSE;
+      osbuffer->y_up = osmesa->y_up;
+      break;
+   default:
+      return;
+   }
+
+   /* The color texture may no longer be able to wrap the buffer. */
+   if (osbuffer->map)
+      osmesa_buffer_invalidate(osbuffer);
+}
+
+
+GLAPI void GLAPIENTRY
+OSMesaGetIntegerv(GLint pname, GLint *value)
+{
+   OSMesaContext osmesa = OSMesaGetCurrentContext();
+   struct pipe_screen *screen;
+
+   if (!osmesa)
+      return;
+
+   switch (pname) {
+   case OSMESA_WIDTH:
+      *value = osmesa->buffer.width;
+      return;
+   case OSMESA_HEIGHT:
+      *value = osmesa->buffer.height;
+      return;
+   case OSMESA_FORMAT:
+      *value = osmesa->format;
+      return;
+   case OSMESA_TYPE:
+      /* current color buffer's data type */
+      *value = osmesa->type;
+      return;
+   case OSMESA_ROW_LENGTH:
+      *value = osmesa->user_row_length;
+      return;
+   case OSMESA_Y_UP:
+      *value = osmesa->y_up;
+      return;
+   case OSMESA_MAX_WIDTH:
+      /* fall-through */
+   case OSMESA_MAX_HEIGHT:
+      screen = osmesa_stmgr->screen;
+      *value = 1 << (screen->get_param(screen,
+                                       PIPE_CAP_MAX_TEXTURE_2D_LEVELS) - 1);
+      return;
+   default:
+      return;
+   }
+}
+
+
+/**
+ * Return the depth buffer associated with an OSMesa context.
+ * Input:  c - the OSMesa context
+ * Output:  width, height - size of buffer in pixels
+ *          bytesPerValue - bytes per depth value (2 or 4)
+ *          buffer - pointer to depth buffer values
+ * Return:  GL_TRUE or GL_FALSE to indicate success or failure.
+ *
+ * The depth buffer is mapped by this call, and unmapped again before the
+ * next drawing command, when rendering is flushed to the color buffer, and
+ * by OSMesaMakeCurrent, OSMesaDestroyContext or the next call of this
+ * function.  The pointer is only valid until then.  Rows are stored in the
+ * same order as those of the color buffer (OSMESA_Y_UP).
+ */
+GLAPI GLboolean GLAPIENTRY
+OSMesaGetDepthBuffer(OSMesaContext c, GLint *width, GLint *height,
+                     GLint *bytesPerValue, void **buffer)
+{
+   struct osmesa_buffer *osbuffer = &c->buffer;
+   struct pipe_context *pipe = c->stctx->pipe;
+   struct pipe_resource *res =
+      osbuffer->textures[ST_ATTACHMENT_DEPTH_STENCIL];
+   struct pipe_box box;
+
+   osmesa_unmap_depth_buffer(c);
+
+   if (!res) {
+      *width = 0;
+      *height = 0;
+      *bytesPerValue = 0;
+      *buffer = NULL;
+      return GL_FALSE;
+   }
+
+   *width = res->width0;
+   *height = res->height0;
+   *bytesPerValue = util_format_get_blocksize(res->format);
+
+   u_box_2d(0, 0, res->width0, res->height0, &box);
+
+   *buffer = pipe->transfer_map(pipe, res, 0, PIPE_TRANSFER_READ, &box,
+                                &c->depth_transfer);
+   if (!*buffer)
+      return GL_FALSE;
+
+   /* Have the state tracker validate the framebuffer before the next draw,
+    * so that the mapping doesn't stay around while rendering.
+    */
+   p_atomic_inc(&osbuffer->stfb->stamp);
+
+   return GL_TRUE;
+}
+
+
+/**
+ * Return the color buffer associated with an OSMesa context.
+ * Input:  c - the OSMesa context
+ * Output:  width, height - size of buffer in pixels
+ *          format - the pixel format (OSMESA_FORMAT)
+ *          buffer - pointer to color buffer values
+ * Return:  GL_TRUE or GL_FALSE to indicate success or failure.
+ */
+GLAPI GLboolean GLAPIENTRY
+OSMesaGetColorBuffer(OSMesaContext osmesa, GLint *width,
+                     GLint *height, GLint *format, void **buffer)
+{
+   struct osmesa_buffer *osbuffer = &osmesa->buffer;
+
+   if (osbuffer->map) {
+      *width = osbuffer->width;
+      *height = osbuffer->height;
+      *format = osmesa->format;
+      *buffer = osbuffer->map;
+      return GL_TRUE;
+   }
+   else {
+      *width = 0;
+      *height = 0;
+      *format = 0;
+      *buffer = NULL;
+      return GL_FALSE;
+   }
+}
+
+
+struct name_function
+{
+   const char *Name;
+   OSMESAproc Function;
+};
+
+static struct name_function functions[] = {
+   { "OSMesaCreateContext", (OSMESAproc) OSMesaCreateContext },
+   { "OSMesaCreateContextExt", (OSMESAproc) OSMesaCreateContextExt },
+   { "OSMesaDestroyContext", (OSMESAproc) OSMesaDestroyContext },
+   { "OSMesaMakeCurrent", (OSMESAproc) OSMesaMakeCurrent },
+   { "OSMesaGetCurrentContext", (OSMESAproc) OSMesaGetCurrentContext },
+   { "OSMesaPixelsStore", (OSMESAproc) OSMesaPixelStore },
+   { "OSMesaGetIntegerv", (OSMESAproc) OSMesaGetIntegerv },
+   { "OSMesaGetDepthBuffer", (OSMESAproc) OSMesaGetDepthBuffer },
+   { "OSMesaGetColorBuffer", (OSMESAproc) OSMesaGetColorBuffer },
+   { "OSMesaGetProcAddress", (OSMESAproc) OSMesaGetProcAddress },
+   { "OSMesaColorClamp", (OSMESAproc) OSMesaColorClamp },
+   { NULL, NULL }
+};
+
+
+GLAPI OSMESAproc GLAPIENTRY
+OSMesaGetProcAddress(const char *funcName)
+{
+   int i;
+
+   for (i = 0; functions[i].Name; i++) {
+      if (strcmp(functions[i].Name, funcName) == 0)
+         return functions[i].Function;
+   }
+
+   if (!osmesa_init())
+      return NULL;
+
+   return (OSMESAproc) osmesa_stapi->get_proc_address(osmesa_stapi, funcName);
+}
+
+
+GLAPI void GLAPIENTRY
+OSMesaColorClamp(GLboolean enable)
+{
+   typedef void (GLAPIENTRY *clamp_color_func)(GLenum target, GLenum clamp);
+   clamp_color_func clamp_color;
+
+   if (!OSMesaGetCurrentContext())
+      return;
+
+   clamp_color = (clamp_color_func)
+      osmesa_stapi->get_proc_address(osmesa_stapi, "glClampColorARB");
+   if (clamp_color)
+      clamp_color(GL_CLAMP_FRAGMENT_COLOR_ARB,
+                  enable ? GL_TRUE : GL_FIXED_ONLY_ARB);
+}
@@ -27,6 +27,7 @@
  **************************************************************************/
 
 #include "gdi/gdi_sw_winsys.h"
+#include "null/null_sw_winsys.h"
 #include "pipe/p_screen.h"
 #include "state_tracker/graw.h"
 #include "target-helpers/inline_debug_helper.h"
@@ -56,6 +57,19 @@ static struct {
    void (* draw)(void);
 } graw;
 
+struct pipe_screen *
+graw_create_headless_screen(void)
+{
+   struct sw_winsys *winsys;
+
+   winsys = null_sw_create();
+   if (winsys == NULL)
+      return NULL;
+
+   return debug_screen_wrap(sw_screen_create(winsys));
+}
+
+
 struct pipe_screen *
 graw_create_window_and_screen(int x,
                               int y,
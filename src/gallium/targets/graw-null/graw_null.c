@@ -1,3 +1,7 @@
+#include "pipe/p_screen.h"
+#include "sw/null/null_sw_winsys.h"
+#include "target-helpers/inline_debug_helper.h"
+#include "target-helpers/inline_sw_helper.h"
 #include "state_tracker/graw.h"
 
 
@@ -15,6 +19,19 @@ graw_create_window_and_screen( int x,
 }
 
 
+struct pipe_screen *
+graw_create_headless_screen( void )
+{
+   struct sw_winsys *winsys;
+
+   winsys = null_sw_create();
+   if (winsys == NULL)
+      return NULL;
+
+   return debug_screen_wrap(sw_screen_create(winsys));
+}
+
+
 
 void 
 graw_set_display_func( void (*draw)( void ) )
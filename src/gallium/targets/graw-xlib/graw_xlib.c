@@ -6,6 +6,7 @@
 #include "target-helpers/inline_sw_helper.h"
 #include "target-helpers/inline_debug_helper.h"
 #include "state_tracker/xlib_sw_winsys.h"
+#include "sw/null/null_sw_winsys.h"
 #include "state_tracker/graw.h"
 
 #include <X11/Xlib.h>
@@ -40,6 +41,19 @@ graw_create_screen( void )
 }
 
 
+struct pipe_screen *
+graw_create_headless_screen( void )
+{
+   struct sw_winsys *winsys;
+
+   winsys = null_sw_create();
+   if (winsys == NULL)
+      return NULL;
+
+   return debug_screen_wrap(sw_screen_create(winsys));
+}
+
+
 struct pipe_screen *
 graw_create_window_and_screen( int x,
                                int y,
@@ -0,0 +1,963 @@
+/* Micro-benchmarks for the software rasterizers.
+ *
+ * Renders offscreen with graw_create_headless_screen(), so no window
+ * system is needed.  The driver is picked with GALLIUM_DRIVER as usual.
+ * Every test is run for a minimum amount of time and the results are
+ * printed as JSON on stdout, so that they can be compared between runs:
+ *
+ *   {
+ *     "driver": "llvmpipe",
+ *     "results": [
+ *       { "test": "fill-rate", "config": "opaque", "value": 512.3, "unit": "Mpixels/s" },
+ *       ...
+ *     ]
+ *   }
+ *
+ * Usage: bench [-t <msecs>] [test ...]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "graw_util.h"
+
+#include "os/os_time.h"
+#include "util/u_sampler.h"
+#include "util/u_string.h"
+
+
+#define WIDTH 512
+#define HEIGHT 512
+
+/* Small draws issued per iteration of the overhead tests */
+#define DRAWS_PER_ITERATION 1000
+
+/* Full screen quads drawn per iteration of the fill tests */
+#define QUADS_PER_ITERATION 8
+
+#define TEX_SIZE 256
+#define TEX_LAST_LEVEL 8
+/* Texture repeats across the screen, so that sampling minifies */
+#define TEX_REPEAT 3.0f
+
+#define VERTEX_COUNT (3 * 16384)
+
+static struct graw_info info;
+
+static int64_t min_time = 250 * 1000000LL;
+static int num_selected;
+static char **selected;
+static boolean first_result = TRUE;
+
+struct vertex {
+   float position[4];
+   float texcoord[4];
+};
+
+static struct vertex vertices[] =
+{
+   /* A triangle covering a single pixel */
+   { { 0.0f, 0.0f, 0.5f, 1.0f }, { 0, 0, 0, 1 } },
+   { { 4.0f / WIDTH, 0.0f, 0.5f, 1.0f }, { 1, 0, 0, 1 } },
+   { { 0.0f, 4.0f / HEIGHT, 0.5f, 1.0f }, { 0, 1, 0, 1 } },
+
+   /* A full screen quad, as a triangle strip */
+   { { -1.0f, -1.0f, 0.5f, 1.0f }, { 0, 0, 0, 1 } },
+   { {  1.0f, -1.0f, 0.5f, 1.0f }, { TEX_REPEAT, 0, 0, 1 } },
+   { { -1.0f,  1.0f, 0.5f, 1.0f }, { 0, TEX_REPEAT, 0, 1 } },
+   { {  1.0f,  1.0f, 0.5f, 1.0f }, { TEX_REPEAT, TEX_REPEAT, 0, 1 } },
+};
+
+#define TRIANGLE_START 0
+#define QUAD_START 3
+
+static struct pipe_vertex_buffer vbuf[2];
+static struct pipe_resource *ibuf;
+static struct pipe_constant_buffer cbuf[2];
+static struct pipe_resource *small_tex[2];
+static struct pipe_sampler_view *small_view[2];
+
+static void *ve;
+static void *vs, *vs_position;
+static void *fs_color, *fs_tex, *fs_const;
+static void *blend[2], *dsa[2], *rasterizer[2], *rasterizer_flat;
+static void *sampler;
+
+
+static void
+report(const char *test, const char *config, double value, const char *unit)
+{
+   printf("%s\n    { \"test\": \"%s\", \"config\": \"%s\", "
+          "\"value\": %.3f, \"unit\": \"%s\" }",
+          first_result ? "" : ",", test, config, value, unit);
+   fflush(stdout);
+   first_result = FALSE;
+}
+
+
+/**
+ * Wait for all rendering to complete.
+ */
+static void
+finish(void)
+{
+   struct pipe_fence_handle *fence = NULL;
+
+   info.ctx->flush(info.ctx, &fence, 0);
+   if (fence) {
+      info.screen->fence_finish(info.screen, fence, PIPE_TIMEOUT_INFINITE);
+      info.screen->fence_reference(info.screen, &fence, NULL);
+   }
+}
+
+
+/**
+ * Call func repeatedly for at least min_time and return the number of calls
+ * per second.  func must wait for its own rendering to complete.
+ */
+static double
+measure(void (*func)(const void *data), const void *data)
+{
+   unsigned iterations = 0;
+   int64_t start, end;
+
+   /* Warm up, so that shader compiles and allocations aren't measured */
+   func(data);
+
+   start = os_time_get_nano();
+   do {
+      func(data);
+      ++iterations;
+      end = os_time_get_nano();
+   } while (end - start < min_time);
+
+   return iterations * 1e9 / (end - start);
+}
+
+
+static void *
+create_blend(boolean enable)
+{
+   struct pipe_blend_state state;
+
+   memset(&state, 0, sizeof state);
+   state.rt[0].blend_enable = enable;
+   state.rt[0].rgb_func = PIPE_BLEND_ADD;
+   state.rt[0].rgb_src_factor = PIPE_BLENDFACTOR_SRC_ALPHA;
+   state.rt[0].rgb_dst_factor = PIPE_BLENDFACTOR_INV_SRC_ALPHA;
+   state.rt[0].alpha_func = PIPE_BLEND_ADD;
+   state.rt[0].alpha_src_factor = PIPE_BLENDFACTOR_ONE;
+   state.rt[0].alpha_dst_factor = PIPE_BLENDFACTOR_INV_SRC_ALPHA;
+   state.rt[0].colormask = PIPE_MASK_RGBA;
+
+   return info.ctx->create_blend_state(info.ctx, &state);
+}
+
+
+static void *
+create_dsa(boolean enable, unsigned func, boolean write)
+{
+   struct pipe_depth_stencil_alpha_state state;
+
+   memset(&state, 0, sizeof state);
+   state.depth.enabled = enable;
+   state.depth.func = func;
+   state.depth.writemask = write;
+
+   return info.ctx->create_depth_stencil_alpha_state(info.ctx, &state);
+}
+
+
+static void *
+create_rasterizer(unsigned cull_face, boolean flatshade)
+{
+   struct pipe_rasterizer_state state;
+
+   memset(&state, 0, sizeof state);
+   state.cull_face = cull_face;
+   state.flatshade = flatshade;
+   state.gl_rasterization_rules = 1;
+
+   return info.ctx->create_rasterizer_state(info.ctx, &state);
+}
+
+
+static void *
+create_sampler(unsigned img_filter, unsigned mip_filter)
+{
+   struct pipe_sampler_state state;
+
+   memset(&state, 0, sizeof state);
+   state.wrap_s = PIPE_TEX_WRAP_REPEAT;
+   state.wrap_t = PIPE_TEX_WRAP_REPEAT;
+   state.wrap_r = PIPE_TEX_WRAP_REPEAT;
+   state.min_img_filter = img_filter;
+   state.mag_img_filter = img_filter;
+   state.min_mip_filter = mip_filter;
+   state.normalized_coords = 1;
+   state.max_lod = TEX_LAST_LEVEL;
+
+   return info.ctx->create_sampler_state(info.ctx, &state);
+}
+
+
+/**
+ * Create a square texture filled with random colors in all its levels.
+ */
+static struct pipe_resource *
+create_texture(enum pipe_format format, unsigned size, unsigned last_level)
+{
+   struct pipe_resource templat, *tex;
+   unsigned level, i;
+
+   memset(&templat, 0, sizeof templat);
+   templat.target = PIPE_TEXTURE_2D;
+   templat.format = format;
+   templat.width0 = size;
+   templat.height0 = size;
+   templat.depth0 = 1;
+   templat.array_size = 1;
+   templat.last_level = last_level;
+   templat.nr_samples = 1;
+   templat.bind = PIPE_BIND_SAMPLER_VIEW;
+
+   tex = info.screen->resource_create(info.screen, &templat);
+   if (!tex)
+      return NULL;
+
+   for (level = 0; level <= last_level; level++) {
+      unsigned width = u_minify(size, level);
+      unsigned stride = util_format_get_stride(format, width);
+      float *colors = MALLOC(width * width * 4 * sizeof(float));
+      void *data = MALLOC(util_format_get_2d_size(format, stride, width));
+      struct pipe_box box;
+
+      if (colors && data) {
+         for (i = 0; i < width * width * 4; i++)
+            colors[i] = (float) rand() / RAND_MAX;
+
+         util_format_write_4f(format, colors, width * 4 * sizeof(float),
+                              data, stride, 0, 0, width, width);
+
+         u_box_2d(0, 0, width, width, &box);
+         info.ctx->transfer_inline_write(info.ctx, tex, level,
+                                         PIPE_TRANSFER_WRITE, &box, data,
+                                         stride, 0);
+      }
+
+      FREE(colors);
+      FREE(data);
+   }
+
+   return tex;
+}
+
+
+static struct pipe_sampler_view *
+create_view(struct pipe_resource *tex)
+{
+   struct pipe_sampler_view templat;
+
+   u_sampler_view_default_template(&templat, tex, tex->format);
+
+   return info.ctx->create_sampler_view(info.ctx, tex, &templat);
+}
+
+
+static void
+set_vertex_buffer(unsigned i)
+{
+   info.ctx->set_vertex_buffers(info.ctx, 0, 1, &vbuf[i]);
+}
+
+
+static void
+set_default_state(void)
+{
+   info.ctx->bind_blend_state(info.ctx, blend[0]);
+   info.ctx->bind_depth_stencil_alpha_state(info.ctx, dsa[0]);
+   info.ctx->bind_rasterizer_state(info.ctx, rasterizer[0]);
+   info.ctx->bind_vertex_elements_state(info.ctx, ve);
+   info.ctx->bind_vs_state(info.ctx, vs);
+   info.ctx->bind_fs_state(info.ctx, fs_color);
+   info.ctx->bind_fragment_sampler_states(info.ctx, 1, &sampler);
+   info.ctx->set_fragment_sampler_views(info.ctx, 1, &small_view[0]);
+   info.ctx->set_constant_buffer(info.ctx, PIPE_SHADER_FRAGMENT, 0,
+                                 &cbuf[0]);
+   set_vertex_buffer(0);
+}
+
+
+static void
+init(void)
+{
+   static float constants[2][4] = {
+      { 1.0f, 0.5f, 0.25f, 1.0f },
+      { 0.25f, 0.5f, 1.0f, 1.0f }
+   };
+   static ushort indices[] = { 0, 1, 2 };
+   struct pipe_vertex_element elements[2];
+   unsigned i;
+
+   if (!graw_util_create_headless(&info, WIDTH, HEIGHT, 1, TRUE))
+      exit(1);
+
+   graw_util_default_state(&info, FALSE);
+   graw_util_viewport(&info, 0, 0, WIDTH, HEIGHT, 0.0f, 1.0f);
+
+   memset(elements, 0, sizeof elements);
+   elements[0].src_offset = Offset(struct vertex, position);
+   elements[0].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+   elements[1].src_offset = Offset(struct vertex, texcoord);
+   elements[1].src_format = PIPE_FORMAT_R32G32B32A32_FLOAT;
+   ve = info.ctx->create_vertex_elements_state(info.ctx, 2, elements);
+
+   for (i = 0; i < 2; i++) {
+      memset(&vbuf[i], 0, sizeof vbuf[i]);
+      vbuf[i].stride = sizeof(struct vertex);
+      vbuf[i].buffer = pipe_buffer_create_with_data(info.ctx,
+                                                    PIPE_BIND_VERTEX_BUFFER,
+                                                    PIPE_USAGE_STATIC,
+                                                    sizeof vertices,
+                                                    vertices);
+
+      memset(&cbuf[i], 0, sizeof cbuf[i]);
+      cbuf[i].buffer_size = sizeof constants[i];
+      cbuf[i].buffer = pipe_buffer_create_with_data(info.ctx,
+                                                    PIPE_BIND_CONSTANT_BUFFER,
+                                                    PIPE_USAGE_STATIC,
+                                                    sizeof constants[i],
+                                                    constants[i]);
+
+      small_tex[i] = create_texture(PIPE_FORMAT_B8G8R8A8_UNORM, 64, 0);
+      if (!small_tex[i])
+         exit(1);
+      small_view[i] = create_view(small_tex[i]);
+
+      blend[i] = create_blend(i != 0);
+      dsa[i] = create_dsa(i != 0, PIPE_FUNC_LEQUAL, TRUE);
+      rasterizer[i] = create_rasterizer(i ? PIPE_FACE_FRONT_AND_BACK
+                                          : PIPE_FACE_NONE, FALSE);
+   }
+
+   rasterizer_flat = create_rasterizer(PIPE_FACE_NONE, TRUE);
+
+   ibuf = pipe_buffer_create_with_data(info.ctx, PIPE_BIND_INDEX_BUFFER,
+                                       PIPE_USAGE_STATIC, sizeof indices,
+                                       indices);
+
+   sampler = create_sampler(PIPE_TEX_FILTER_NEAREST, PIPE_TEX_MIPFILTER_NONE);
+
+   vs = graw_parse_vertex_shader(info.ctx,
+      "VERT\n"
+      "DCL IN[0]\n"
+      "DCL IN[1]\n"
+      "DCL OUT[0], POSITION\n"
+      "DCL OUT[1], GENERIC[0]\n"
+      "  0: MOV OUT[0], IN[0]\n"
+      "  1: MOV OUT[1], IN[1]\n"
+      "  2: END\n");
+
+   vs_position = graw_parse_vertex_shader(info.ctx,
+      "VERT\n"
+      "DCL IN[0]\n"
+      "DCL OUT[0], POSITION\n"
+      "  0: MOV OUT[0], IN[0]\n"
+      "  1: END\n");
+
+   fs_color = graw_parse_fragment_shader(info.ctx,
+      "FRAG\n"
+      "DCL IN[0], GENERIC[0], LINEAR\n"
+      "DCL OUT[0], COLOR\n"
+      "  0: MOV OUT[0], IN[0]\n"
+      "  1: END\n");
+
+   fs_tex = graw_parse_fragment_shader(info.ctx,
+      "FRAG\n"
+      "DCL IN[0], GENERIC[0], LINEAR\n"
+      "DCL OUT[0], COLOR\n"
+      "DCL SAMP[0]\n"
+      "  0: TEX OUT[0], IN[0], SAMP[0], 2D\n"
+      "  1: END\n");
+
+   fs_const = graw_parse_fragment_shader(info.ctx,
+      "FRAG\n"
+      "DCL OUT[0], COLOR\n"
+      "DCL CONST[0]\n"
+      "  0: MOV OUT[0], CONST[0]\n"
+      "  1: END\n");
+
+   if (!vs || !vs_position || !fs_color || !fs_tex || !fs_const)
+      exit(1);
+
+   set_default_state();
+}
+
+
+/*
+ * Draw call overhead
+ */
+
+static void
+draw_triangles(const void *data)
+{
+   unsigned i;
+
+   for (i = 0; i < DRAWS_PER_ITERATION; i++)
+      util_draw_arrays(info.ctx, PIPE_PRIM_TRIANGLES, TRIANGLE_START, 3);
+
+   finish();
+}
+
+
+static void
+draw_indexed_triangles(const void *data)
+{
+   unsigned i;
+
+   for (i = 0; i < DRAWS_PER_ITERATION; i++)
+      util_draw_elements(info.ctx, TRIANGLE_START, PIPE_PRIM_TRIANGLES, 0, 3);
+
+   finish();
+}
+
+
+static void
+test_draw_overhead(const char *name)
+{
+   struct pipe_index_buffer ib;
+
+   report(name, "arrays", measure(draw_triangles, NULL) * DRAWS_PER_ITERATION,
+          "draws/s");
+
+   memset(&ib, 0, sizeof ib);
+   ib.index_size = 2;
+   ib.buffer = ibuf;
+   info.ctx->set_index_buffer(info.ctx, &ib);
+
+   report(name, "elements",
+          measure(draw_indexed_triangles, NULL) * DRAWS_PER_ITERATION,
+          "draws/s");
+
+   info.ctx->set_index_buffer(info.ctx, NULL);
+}
+
+
+/*
+ * State change throughput
+ */
+
+enum state_change {
+   CHANGE_NONE,
+   CHANGE_BLEND,
+   CHANGE_DEPTH_STENCIL,
+   CHANGE_RASTERIZER,
+   CHANGE_FRAGMENT_SHADER,
+   CHANGE_VERTEX_SHADER,
+   CHANGE_CONSTANT_BUFFER,
+   CHANGE_SAMPLER_VIEW,
+   CHANGE_VERTEX_BUFFER,
+   CHANGE_COUNT
+};
+
+static const char *state_change_names[CHANGE_COUNT] = {
+   "none",
+   "blend",
+   "depth-stencil",
+   "rasterizer",
+   "fragment-shader",
+   "vertex-shader",
+   "constant-buffer",
+   "sampler-view",
+   "vertex-buffer"
+};
+
+
+static void
+change_state(enum state_change change, unsigned i)
+{
+   switch (change) {
+   case CHANGE_BLEND:
+      info.ctx->bind_blend_state(info.ctx, blend[i]);
+      break;
+   case CHANGE_DEPTH_STENCIL:
+      info.ctx->bind_depth_stencil_alpha_state(info.ctx, dsa[i]);
+      break;
+   case CHANGE_RASTERIZER:
+      info.ctx->bind_rasterizer_state(info.ctx,
+                                      i ? rasterizer_flat : rasterizer[0]);
+      break;
+   case CHANGE_FRAGMENT_SHADER:
+      info.ctx->bind_fs_state(info.ctx, i ? fs_color : fs_tex);
+      break;
+   case CHANGE_VERTEX_SHADER:
+      info.ctx->bind_vs_state(info.ctx, i ? vs_position : vs);
+      break;
+   case CHANGE_CONSTANT_BUFFER:
+      info.ctx->set_constant_buffer(info.ctx, PIPE_SHADER_FRAGMENT, 0,
+                                    &cbuf[i]);
+      break;
+   case CHANGE_SAMPLER_VIEW:
+      info.ctx->set_fragment_sampler_views(info.ctx, 1, &small_view[i]);
+      break;
+   case CHANGE_VERTEX_BUFFER:
+      set_vertex_buffer(i);
+      break;
+   default:
+      break;
+   }
+}
+
+
+static void
+draw_with_state_changes(const void *data)
+{
+   const enum state_change change = *(const enum state_change *) data;
+   unsigned i;
+
+   for (i = 0; i < DRAWS_PER_ITERATION; i++) {
+      change_state(change, i & 1);
+      util_draw_arrays(info.ctx, PIPE_PRIM_TRIANGLES, TRIANGLE_START, 3);
+   }
+
+   finish();
+}
+
+
+static void
+test_state_change(const char *name)
+{
+   enum state_change change;
+
+   for (change = CHANGE_NONE; change < CHANGE_COUNT; change++) {
+      /* Use a shader that depends on the state being changed */
+      if (change == CHANGE_CONSTANT_BUFFER || change == CHANGE_VERTEX_SHADER)
+         info.ctx->bind_fs_state(info.ctx, fs_const);
+      else
+         info.ctx->bind_fs_state(info.ctx, fs_tex);
+
+      report(name, state_change_names[change],
+             measure(draw_with_state_changes, &change) * DRAWS_PER_ITERATION,
+             "draws/s");
+
+      set_default_state();
+   }
+}
+
+
+/*
+ * Fill rate
+ */
+
+struct fill_config {
+   const char *name;
+   boolean blend;
+   boolean depth;
+   unsigned depth_func;
+   boolean depth_write;
+   double clear_depth;
+};
+
+static const struct fill_config fill_configs[] = {
+   { "opaque",           FALSE, FALSE, PIPE_FUNC_ALWAYS, FALSE, 1.0 },
+   { "blend",            TRUE,  FALSE, PIPE_FUNC_ALWAYS, FALSE, 1.0 },
+   { "depth-pass",       FALSE, TRUE,  PIPE_FUNC_LEQUAL, TRUE,  1.0 },
+   { "depth-pass-nowrite", FALSE, TRUE, PIPE_FUNC_LEQUAL, FALSE, 1.0 },
+   { "depth-fail",       FALSE, TRUE,  PIPE_FUNC_LESS,   TRUE,  0.0 },
+   { "blend-depth-pass", TRUE,  TRUE,  PIPE_FUNC_LEQUAL, TRUE,  1.0 },
+};
+
+
+static void
+draw_quads(const void *data)
+{
+   const double clear_depth = *(const double *) data;
+   union pipe_color_union color;
+   unsigned i;
+
+   memset(&color, 0, sizeof color);
+   info.ctx->clear(info.ctx, PIPE_CLEAR_COLOR | PIPE_CLEAR_DEPTHSTENCIL,
+                   &color, clear_depth, 0);
+
+   for (i = 0; i < QUADS_PER_ITERATION; i++)
+      util_draw_arrays(info.ctx, PIPE_PRIM_TRIANGLE_STRIP, QUAD_START, 4);
+
+   finish();
+}
+
+
+static void
+test_fill_rate(const char *name)
+{
+   const double pixels = (double) WIDTH * HEIGHT * QUADS_PER_ITERATION;
+   unsigned i;
+
+   for (i = 0; i < Elements(fill_configs); i++) {
+      const struct fill_config *config = &fill_configs[i];
+      void *config_blend = create_blend(config->blend);
+      void *config_dsa = create_dsa(config->depth, config->depth_func,
+                                    config->depth_write);
+
+      info.ctx->bind_blend_state(info.ctx, config_blend);
+      info.ctx->bind_depth_stencil_alpha_state(info.ctx, config_dsa);
+
+      report(name, config->name,
+             measure(draw_quads, &config->clear_depth) * pixels / 1e6,
+             "Mpixels/s");
+
+      set_default_state();
+      info.ctx->delete_blend_state(info.ctx, config_blend);
+      info.ctx->delete_depth_stencil_alpha_state(info.ctx, config_dsa);
+   }
+}
+
+
+/*
+ * Texture sampling
+ */
+
+static const enum pipe_format texture_formats[] = {
+   PIPE_FORMAT_B8G8R8A8_UNORM,
+   PIPE_FORMAT_B8G8R8A8_SRGB,
+   PIPE_FORMAT_B5G6R5_UNORM,
+   PIPE_FORMAT_L8_UNORM,
+   PIPE_FORMAT_R16G16B16A16_FLOAT,
+   PIPE_FORMAT_R32G32B32A32_FLOAT
+};
+
+struct filter_config {
+   const char *name;
+   unsigned img_filter;
+   unsigned mip_filter;
+};
+
+static const struct filter_config filter_configs[] = {
+   { "nearest",   PIPE_TEX_FILTER_NEAREST, PIPE_TEX_MIPFILTER_NONE },
+   { "linear",    PIPE_TEX_FILTER_LINEAR,  PIPE_TEX_MIPFILTER_NONE },
+   { "trilinear", PIPE_TEX_FILTER_LINEAR,  PIPE_TEX_MIPFILTER_LINEAR },
+};
+
+
+static void
+test_texture_sampling(const char *name)
+{
+   const double texels = (double) WIDTH * HEIGHT * QUADS_PER_ITERATION;
+   const double clear_depth = 1.0;
+   unsigned i, j;
+
+   info.ctx->bind_fs_state(info.ctx, fs_tex);
+
+   for (i = 0; i < Elements(texture_formats); i++) {
+      const enum pipe_format format = texture_formats[i];
+      struct pipe_resource *tex;
+      struct pipe_sampler_view *view;
+
+      if (!info.screen->is_format_supported(info.screen, format,
+                                            PIPE_TEXTURE_2D, 0,
+                                            PIPE_BIND_SAMPLER_VIEW))
+         continue;
+
+      tex = create_texture(format, TEX_SIZE, TEX_LAST_LEVEL);
+      if (!tex)
+         continue;
+
+      view = create_view(tex);
+      info.ctx->set_fragment_sampler_views(info.ctx, 1, &view);
+
+      for (j = 0; j < Elements(filter_configs); j++) {
+         const struct filter_config *filter = &filter_configs[j];
+         void *config_sampler = create_sampler(filter->img_filter,
+                                               filter->mip_filter);
+         char config[64];
+
+         info.ctx->bind_fragment_sampler_states(info.ctx, 1, &config_sampler);
+
+         util_snprintf(config, sizeof config, "%s %s",
+                       util_format_short_name(format), filter->name);
+         report(name, config, measure(draw_quads, &clear_depth) * texels / 1e6,
+                "Mtexels/s");
+
+         info.ctx->bind_fragment_sampler_states(info.ctx, 1, &sampler);
+         info.ctx->delete_sampler_state(info.ctx, config_sampler);
+      }
+
+      info.ctx->set_fragment_sampler_views(info.ctx, 1, &small_view[0]);
+      pipe_sampler_view_reference(&view, NULL);
+      pipe_resource_reference(&tex, NULL);
+   }
+
+   set_default_state();
+}
+
+
+/*
+ * Vertex throughput
+ */
+
+static const enum pipe_format vertex_formats[] = {
+   PIPE_FORMAT_R32G32B32A32_FLOAT,
+   PIPE_FORMAT_R32G32B32_FLOAT,
+   PIPE_FORMAT_R32G32_FLOAT,
+   PIPE_FORMAT_R16G16B16A16_FLOAT,
+   PIPE_FORMAT_R16G16B16A16_SNORM,
+   PIPE_FORMAT_R8G8B8A8_SNORM
+};
+
+
+static void
+draw_vertices(const void *data)
+{
+   util_draw_arrays(info.ctx, PIPE_PRIM_TRIANGLES, 0, VERTEX_COUNT);
+
+   finish();
+}
+
+
+static void
+test_vertex_throughput(const char *name)
+{
+   float *positions;
+   unsigned i;
+
+   positions = MALLOC(VERTEX_COUNT * 4 * sizeof(float));
+   if (!positions)
+      return;
+
+   for (i = 0; i < VERTEX_COUNT; i++) {
+      positions[i * 4 + 0] = (float) rand() / RAND_MAX * 2.0f - 1.0f;
+      positions[i * 4 + 1] = (float) rand() / RAND_MAX * 2.0f - 1.0f;
+      positions[i * 4 + 2] = (float) rand() / RAND_MAX;
+      positions[i * 4 + 3] = 1.0f;
+   }
+
+   /* Cull everything, so that only vertex processing is measured */
+   info.ctx->bind_rasterizer_state(info.ctx, rasterizer[1]);
+   info.ctx->bind_vs_state(info.ctx, vs_position);
+   info.ctx->bind_fs_state(info.ctx, fs_const);
+
+   for (i = 0; i < Elements(vertex_formats); i++) {
+      const enum pipe_format format = vertex_formats[i];
+      const unsigned stride = util_format_get_blocksize(format);
+      struct pipe_vertex_element element;
+      struct pipe_vertex_buffer buffer;
+      void *elements;
+      void *data;
+
+      if (!info.screen->is_format_supported(info.screen, format,
+                                            PIPE_BUFFER, 0,
+                                            PIPE_BIND_VERTEX_BUFFER))
+         continue;
+
+      data = MALLOC(VERTEX_COUNT * stride);
+      if (!data)
+         continue;
+
+      util_format_write_4f(format, positions, VERTEX_COUNT * 4 * sizeof(float),
+                           data, VERTEX_COUNT * stride, 0, 0, VERTEX_COUNT, 1);
+
+      memset(&buffer, 0, sizeof buffer);
+      buffer.stride = stride;
+      buffer.buffer = pipe_buffer_create_with_data(info.ctx,
+                                                   PIPE_BIND_VERTEX_BUFFER,
+                                                   PIPE_USAGE_STATIC,
+                                                   VERTEX_COUNT * stride,
+                                                   data);
+      FREE(data);
+
+      memset(&element, 0, sizeof element);
+      element.src_format = format;
+      elements = info.ctx->create_vertex_elements_state(info.ctx, 1, &element);
+
+      info.ctx->bind_vertex_elements_state(info.ctx, elements);
+      info.ctx->set_vertex_buffers(info.ctx, 0, 1, &buffer);
+
+      report(name, util_format_short_name(format),
+             measure(draw_vertices, NULL) * VERTEX_COUNT / 1e6,
+             "Mvertices/s");
+
+      info.ctx->bind_vertex_elements_state(info.ctx, ve);
+      set_vertex_buffer(0);
+      info.ctx->delete_vertex_elements_state(info.ctx, elements);
+      pipe_resource_reference(&buffer.buffer, NULL);
+   }
+
+   set_default_state();
+   FREE(positions);
+}
+
+
+/*
+ * Readback bandwidth
+ */
+
+enum readback_source {
+   READBACK_IDLE,
+   READBACK_AFTER_CLEAR,
+   READBACK_AFTER_DRAW,
+   READBACK_COUNT
+};
+
+static const char *readback_names[READBACK_COUNT] = {
+   "idle",
+   "after-clear",
+   "after-draw"
+};
+
+static ubyte *readback_data;
+
+
+static void
+read_color_buffer(const void *data)
+{
+   const enum readback_source source = *(const enum readback_source *) data;
+   const unsigned row_size =
+      util_format_get_stride(info.color_buf[0]->format, WIDTH);
+   struct pipe_transfer *transfer;
+   union pipe_color_union color;
+   ubyte *map;
+   unsigned y;
+
+   if (source == READBACK_AFTER_CLEAR) {
+      memset(&color, 0, sizeof color);
+      info.ctx->clear(info.ctx, PIPE_CLEAR_COLOR, &color, 1.0, 0);
+   }
+   else if (source == READBACK_AFTER_DRAW) {
+      util_draw_arrays(info.ctx, PIPE_PRIM_TRIANGLE_STRIP, QUAD_START, 4);
+   }
+
+   /* The map waits for rendering to the color buffer */
+   map = pipe_transfer_map(info.ctx, info.color_buf[0], 0, 0,
+                           PIPE_TRANSFER_READ, 0, 0, WIDTH, HEIGHT,
+                           &transfer);
+   if (!map)
+      return;
+
+   for (y = 0; y < HEIGHT; y++)
+      memcpy(readback_data + y * row_size, map + y * transfer->stride,
+             row_size);
+
+   pipe_transfer_unmap(info.ctx, transfer);
+}
+
+
+static void
+test_readback(const char *name)
+{
+   const unsigned size =
+      util_format_get_2d_size(info.color_buf[0]->format,
+                              util_format_get_stride(info.color_buf[0]->format,
+                                                     WIDTH),
+                              HEIGHT);
+   enum readback_source source;
+
+   readback_data = MALLOC(size);
+   if (!readback_data)
+      return;
+
+   for (source = READBACK_IDLE; source < READBACK_COUNT; source++) {
+      report(name, readback_names[source],
+             measure(read_color_buffer, &source) * size / 1e6, "MB/s");
+   }
+
+   FREE(readback_data);
+   readback_data = NULL;
+}
+
+
+static const struct {
+   const char *name;
+   void (*func)(const char *name);
+} tests[] = {
+   { "draw-overhead", test_draw_overhead },
+   { "state-change", test_state_change },
+   { "fill-rate", test_fill_rate },
+   { "texture-sampling", test_texture_sampling },
+   { "vertex-throughput", test_vertex_throughput },
+   { "readback", test_readback },
+};
+
+
+static boolean
+is_selected(const char *name)
+{
+   int i;
+
+   if (!num_selected)
+      return TRUE;
+
+   for (i = 0; i < num_selected; i++) {
+      if (strcmp(selected[i], name) == 0)
+         return TRUE;
+   }
+
+   return FALSE;
+}
+
+
+static void
+usage(void)
+{
+   unsigned i;
+
+   fprintf(stderr, "usage: bench [-t <msecs>] [test ...]\n");
+   fprintf(stderr, "tests:");
+   for (i = 0; i < Elements(tests); i++)
+      fprintf(stderr, " %s", tests[i].name);
+   fprintf(stderr, "\n");
+   exit(1);
+}
+
+
+static void
+args(int argc, char *argv[])
+{
+   int i;
+
+   for (i = 1; i < argc; i++) {
+      if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+         min_time = atoi(argv[++i]) * 1000000LL;
+      }
+      else if (argv[i][0] == '-') {
+         usage();
+      }
+      else {
+         break;
+      }
+   }
+
+   selected = &argv[i];
+   num_selected = argc - i;
+
+   for (; i < argc; i++) {
+      unsigned j;
+
+      for (j = 0; j < Elements(tests); j++) {
+         if (strcmp(argv[i], tests[j].name) == 0)
+            break;
+      }
+      if (j == Elements(tests))
+         usage();
+   }
+}
+
+
+int main( int argc, char *argv[] )
+{
+   unsigned i;
+
+   args(argc, argv);
+   init();
+
+   printf("{\n  \"driver\": \"%s\",\n  \"results\": [",
+          info.screen->get_name(info.screen));
+
+   for (i = 0; i < Elements(tests); i++) {
+      if (is_selected(tests[i].name))
+         tests[i].func(tests[i].name);
+   }
+
+   printf("\n  ]\n}\n");
+
+   return 0;
+}
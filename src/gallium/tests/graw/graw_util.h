@@ -26,45 +26,20 @@ struct graw_info
 
 
 
+/**
+ * Create the color and Z buffers and bind them as the framebuffer.
+ */
 static INLINE boolean
-graw_util_create_window(struct graw_info *info,
-                        int width, int height,
-                        int num_cbufs, bool zstencil_buf)
+graw_util_create_framebuffer(struct graw_info *info,
+                             int width, int height,
+                             enum pipe_format format, unsigned bind,
+                             int num_cbufs)
 {
-   static const enum pipe_format formats[] = {
-      PIPE_FORMAT_R8G8B8A8_UNORM,
-      PIPE_FORMAT_B8G8R8A8_UNORM,
-      PIPE_FORMAT_NONE
-   };
-   enum pipe_format format;
    struct pipe_resource resource_temp;
    struct pipe_surface surface_temp;
    int i;
 
-   memset(info, 0, sizeof(*info));
-
-   /* It's hard to say whether window or screen should be created
-    * first.  Different environments would prefer one or the other.
-    *
-    * Also, no easy way of querying supported formats if the screen
-    * cannot be created first.
-    */
-   for (i = 0; info->window == NULL && formats[i] != PIPE_FORMAT_NONE; i++) {
-      info->screen = graw_create_window_and_screen(0, 0, width, height,
-                                                   formats[i],
-                                                   &info->window);
-      format = formats[i];
-   }
-   if (!info->screen || !info->window) {
-      debug_printf("graw: Failed to create screen/window\n");
-      return FALSE;
-   }
-   
-   info->ctx = info->screen->context_create(info->screen, NULL);
-   if (info->ctx == NULL) {
-      debug_printf("graw: Failed to create context\n");
-      return FALSE;
-   }
+   memset(&resource_temp, 0, sizeof resource_temp);
 
    for (i = 0; i < num_cbufs; i++) {
       /* create color texture */
@@ -76,8 +51,7 @@ graw_util_create_window(struct graw_info *info,
       resource_temp.array_size = 1;
       resource_temp.last_level = 0;
       resource_temp.nr_samples = 1;
-      resource_temp.bind = (PIPE_BIND_RENDER_TARGET |
-                            PIPE_BIND_DISPLAY_TARGET);
+      resource_temp.bind = bind;
       info->color_buf[i] = info->screen->resource_create(info->screen,
                                                          &resource_temp);
       if (info->color_buf[i] == NULL) {
@@ -144,6 +118,98 @@ graw_util_create_window(struct graw_info *info,
 }
 
 
+static INLINE boolean
+graw_util_create_window(struct graw_info *info,
+                        int width, int height,
+                        int num_cbufs, bool zstencil_buf)
+{
+   static const enum pipe_format formats[] = {
+      PIPE_FORMAT_R8G8B8A8_UNORM,
+      PIPE_FORMAT_B8G8R8A8_UNORM,
+      PIPE_FORMAT_NONE
+   };
+   enum pipe_format format;
+   int i;
+
+   memset(info, 0, sizeof(*info));
+
+   /* It's hard to say whether window or screen should be created
+    * first.  Different environments would prefer one or the other.
+    *
+    * Also, no easy way of querying supported formats if the screen
+    * cannot be created first.
+    */
+   for (i = 0; info->window == NULL && formats[i] != PIPE_FORMAT_NONE; i++) {
+      info->screen = graw_create_window_and_screen(0, 0, width, height,
+                                                   formats[i],
+                                                   &info->window);
+      format = formats[i];
+   }
+   if (!info->screen || !info->window) {
+      debug_printf("graw: Failed to create screen/window\n");
+      return FALSE;
+   }
+   
+   info->ctx = info->screen->context_create(info->screen, NULL);
+   if (info->ctx == NULL) {
+      debug_printf("graw: Failed to create context\n");
+      return FALSE;
+   }
+
+   return graw_util_create_framebuffer(info, width, height, format,
+                                       (PIPE_BIND_RENDER_TARGET |
+                                        PIPE_BIND_DISPLAY_TARGET),
+                                       num_cbufs);
+}
+
+
+/**
+ * Like graw_util_create_window(), but renders to memory only, so that no
+ * window system is needed.  The color buffers can be read back with
+ * transfers.
+ */
+static INLINE boolean
+graw_util_create_headless(struct graw_info *info,
+                          int width, int height,
+                          int num_cbufs, bool zstencil_buf)
+{
+   static const enum pipe_format formats[] = {
+      PIPE_FORMAT_B8G8R8A8_UNORM,
+      PIPE_FORMAT_R8G8B8A8_UNORM,
+      PIPE_FORMAT_NONE
+   };
+   const unsigned bind = PIPE_BIND_RENDER_TARGET | PIPE_BIND_SAMPLER_VIEW;
+   int i;
+
+   memset(info, 0, sizeof(*info));
+
+   info->screen = graw_create_headless_screen();
+   if (!info->screen) {
+      debug_printf("graw: Failed to create headless screen\n");
+      return FALSE;
+   }
+
+   for (i = 0; formats[i] != PIPE_FORMAT_NONE; i++) {
+      if (info->screen->is_format_supported(info->screen, formats[i],
+                                            PIPE_TEXTURE_2D, 1, bind))
+         break;
+   }
+   if (formats[i] == PIPE_FORMAT_NONE) {
+      debug_printf("graw: No supported color format\n");
+      return FALSE;
+   }
+
+   info->ctx = info->screen->context_create(info->screen, NULL);
+   if (info->ctx == NULL) {
+      debug_printf("graw: Failed to create context\n");
+      return FALSE;
+   }
+
+   return graw_util_create_framebuffer(info, width, height, formats[i],
+                                       bind, num_cbufs);
+}
+
+
 static INLINE void
 graw_util_default_state(struct graw_info *info, boolean depth_test)
 {
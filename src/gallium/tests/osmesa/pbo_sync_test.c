@@ -0,0 +1,153 @@
+/**************************************************************************
+ *
+ * Copyright 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/*
+ *  Test case for glReadPixels into a pixel pack buffer followed by a fence.
+ *
+ *  A second context sharing the buffer waits on the fence and then reads
+ *  the buffer, without the first context being involved anymore, so the
+ *  fence has to cover the read.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "GL/osmesa.h"
+#include "GL/glext.h"
+
+
+#define WIDTH 64
+#define HEIGHT 64
+
+
+static PFNGLGENBUFFERSPROC GenBuffers;
+static PFNGLDELETEBUFFERSPROC DeleteBuffers;
+static PFNGLBINDBUFFERPROC BindBuffer;
+static PFNGLBUFFERDATAPROC BufferData;
+static PFNGLMAPBUFFERPROC MapBuffer;
+static PFNGLUNMAPBUFFERPROC UnmapBuffer;
+static PFNGLFENCESYNCPROC FenceSync;
+static PFNGLCLIENTWAITSYNCPROC ClientWaitSync;
+static PFNGLDELETESYNCPROC DeleteSync;
+
+
+static GLboolean
+get_procs(void)
+{
+   GenBuffers = (PFNGLGENBUFFERSPROC) OSMesaGetProcAddress("glGenBuffers");
+   DeleteBuffers = (PFNGLDELETEBUFFERSPROC) OSMesaGetProcAddress("glDeleteBuffers");
+   BindBuffer = (PFNGLBINDBUFFERPROC) OSMesaGetProcAddress("glBindBuffer");
+   BufferData = (PFNGLBUFFERDATAPROC) OSMesaGetProcAddress("glBufferData");
+   MapBuffer = (PFNGLMAPBUFFERPROC) OSMesaGetProcAddress("glMapBuffer");
+   UnmapBuffer = (PFNGLUNMAPBUFFERPROC) OSMesaGetProcAddress("glUnmapBuffer");
+   FenceSync = (PFNGLFENCESYNCPROC) OSMesaGetProcAddress("glFenceSync");
+   ClientWaitSync = (PFNGLCLIENTWAITSYNCPROC) OSMesaGetProcAddress("glClientWaitSync");
+   DeleteSync = (PFNGLDELETESYNCPROC) OSMesaGetProcAddress("glDeleteSync");
+
+   return GenBuffers && DeleteBuffers && BindBuffer && BufferData &&
+          MapBuffer && UnmapBuffer && FenceSync && ClientWaitSync &&
+          DeleteSync;
+}
+
+
+int main(int argc, char **argv)
+{
+   static GLubyte buffer_a[WIDTH * HEIGHT * 4];
+   static GLubyte buffer_b[WIDTH * HEIGHT * 4];
+   OSMesaContext ctx_a, ctx_b;
+   const GLubyte *pixels;
+   GLuint pbo;
+   GLsync sync;
+   unsigned i, mismatches = 0;
+
+   ctx_a = OSMesaCreateContextExt(OSMESA_RGBA, 0, 0, 0, NULL);
+   ctx_b = OSMesaCreateContextExt(OSMESA_RGBA, 0, 0, 0, ctx_a);
+   if (!ctx_a || !ctx_b ||
+       !OSMesaMakeCurrent(ctx_a, buffer_a, GL_UNSIGNED_BYTE, WIDTH, HEIGHT)) {
+      printf("SKIPPED: no OSMesa context\n");
+      return 0;
+   }
+
+   if (!get_procs()) {
+      printf("SKIPPED: buffer objects or sync objects not supported\n");
+      return 0;
+   }
+
+   glClearColor(1.0f, 0.0f, 0.0f, 1.0f);
+   glClear(GL_COLOR_BUFFER_BIT);
+
+   GenBuffers(1, &pbo);
+   BindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+   BufferData(GL_PIXEL_PACK_BUFFER, sizeof buffer_a, NULL, GL_STREAM_READ);
+   glReadPixels(0, 0, WIDTH, HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+   BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+   /* Flushing the fence is all that's needed for another context to wait
+    * on it.
+    */
+   sync = FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+   ClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+   OSMesaMakeCurrent(ctx_b, buffer_b, GL_UNSIGNED_BYTE, WIDTH, HEIGHT);
+
+   if (ClientWaitSync(sync, 0, 10000000000ULL) == GL_TIMEOUT_EXPIRED) {
+      printf("FAILED: fence not signalled\n");
+      return 1;
+   }
+
+   BindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+   pixels = MapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+   if (!pixels) {
+      printf("FAILED: could not map the buffer\n");
+      return 1;
+   }
+
+   for (i = 0; i < WIDTH * HEIGHT; i++) {
+      if (pixels[i*4 + 0] != 0xff || pixels[i*4 + 1] != 0 ||
+          pixels[i*4 + 2] != 0 || pixels[i*4 + 3] != 0xff)
+         mismatches++;
+   }
+
+   UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+   BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+   DeleteBuffers(1, &pbo);
+   DeleteSync(sync);
+
+   OSMesaMakeCurrent(NULL, NULL, 0, 0, 0);
+   OSMesaDestroyContext(ctx_b);
+   OSMesaDestroyContext(ctx_a);
+
+   if (mismatches) {
+      printf("FAILED: %u of %u pixels not read back before the fence\n",
+             mismatches, WIDTH * HEIGHT);
+      return 1;
+   }
+
+   printf("PASSED\n");
+   return 0;
+}
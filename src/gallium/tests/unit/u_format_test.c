@@ -28,8 +28,12 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <float.h>
 
+#include "os/os_time.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_memory.h"
 #include "util/u_half.h"
 #include "util/u_format.h"
 #include "util/u_format_tests.h"
@@ -679,6 +683,144 @@ test_one_func(const struct util_format_description *format_desc,
 }
 
 
+/* Not a multiple of any vector width, so that the remainders get tested too */
+#define ROW_WIDTH 37
+
+/* Largest pixel, R64G64B64A64_FLOAT */
+#define ROW_MAX_PIXEL_BYTES 32
+
+
+/**
+ * Find which bytes of a pixel hold actual data, as packing leaves padding
+ * channels of non-bitmask formats undefined.
+ */
+static void
+get_pixel_mask(const struct util_format_description *format_desc,
+               uint8_t *mask)
+{
+   unsigned bytes = format_desc->block.bits/8;
+   unsigned offset = 0;
+   unsigned i;
+
+   memset(mask, 0xff, bytes);
+
+   if (format_desc->is_bitmask)
+      return;
+
+   for (i = 0; i < format_desc->nr_channels; ++i) {
+      const struct util_format_channel_description *channel =
+         &format_desc->channel[i];
+      if (channel->type == UTIL_FORMAT_TYPE_VOID)
+         memset(mask + offset/8, 0, channel->size/8);
+      offset += channel->size;
+   }
+}
+
+
+/**
+ * Check that converting a whole row gives exactly the same results as
+ * converting one pixel at a time, which exercises the vectorized row
+ * functions against the per-pixel code they fall back to at the end of rows.
+ */
+static boolean
+test_format_rows(const struct util_format_description *format_desc)
+{
+   unsigned bytes = format_desc->block.bits/8;
+   uint8_t packed[ROW_WIDTH * ROW_MAX_PIXEL_BYTES];
+   uint8_t packed_row[ROW_WIDTH * ROW_MAX_PIXEL_BYTES];
+   uint8_t packed_pixels[ROW_WIDTH * ROW_MAX_PIXEL_BYTES];
+   uint8_t mask[ROW_MAX_PIXEL_BYTES];
+   uint8_t unpacked_8unorm[2][ROW_WIDTH][4];
+   float unpacked_float[2][ROW_WIDTH][4];
+   unsigned x, i;
+   boolean success = TRUE;
+
+   for (i = 0; i < sizeof packed; ++i)
+      packed[i] = rand();
+
+   get_pixel_mask(format_desc, mask);
+
+   if (format_desc->unpack_rgba_8unorm) {
+      memset(unpacked_8unorm, 0, sizeof unpacked_8unorm);
+      format_desc->unpack_rgba_8unorm(&unpacked_8unorm[0][0][0], 0,
+                                      packed, 0, ROW_WIDTH, 1);
+      for (x = 0; x < ROW_WIDTH; ++x)
+         format_desc->unpack_rgba_8unorm(unpacked_8unorm[1][x], 0,
+                                         packed + x*bytes, 0, 1, 1);
+      if (memcmp(unpacked_8unorm[0], unpacked_8unorm[1],
+                 sizeof unpacked_8unorm[0])) {
+         printf("FAILED: util_format_%s_unpack_rgba_8unorm row\n",
+                format_desc->short_name);
+         success = FALSE;
+      }
+   }
+
+   if (format_desc->unpack_rgba_float) {
+      memset(unpacked_float, 0, sizeof unpacked_float);
+      format_desc->unpack_rgba_float(&unpacked_float[0][0][0], 0,
+                                     packed, 0, ROW_WIDTH, 1);
+      for (x = 0; x < ROW_WIDTH; ++x)
+         format_desc->unpack_rgba_float(unpacked_float[1][x], 0,
+                                        packed + x*bytes, 0, 1, 1);
+      if (memcmp(unpacked_float[0], unpacked_float[1],
+                 sizeof unpacked_float[0])) {
+         printf("FAILED: util_format_%s_unpack_rgba_float row\n",
+                format_desc->short_name);
+         success = FALSE;
+      }
+   }
+
+   if (format_desc->pack_rgba_8unorm) {
+      for (x = 0; x < ROW_WIDTH; ++x)
+         for (i = 0; i < 4; ++i)
+            unpacked_8unorm[0][x][i] = rand();
+
+      memset(packed_row, 0, sizeof packed_row);
+      memset(packed_pixels, 0, sizeof packed_pixels);
+      format_desc->pack_rgba_8unorm(packed_row, 0,
+                                    &unpacked_8unorm[0][0][0], 0,
+                                    ROW_WIDTH, 1);
+      for (x = 0; x < ROW_WIDTH; ++x)
+         format_desc->pack_rgba_8unorm(packed_pixels + x*bytes, 0,
+                                       unpacked_8unorm[0][x], 0, 1, 1);
+      for (i = 0; i < ROW_WIDTH*bytes; ++i) {
+         if ((packed_row[i] ^ packed_pixels[i]) & mask[i % bytes]) {
+            printf("FAILED: util_format_%s_pack_rgba_8unorm row\n",
+                   format_desc->short_name);
+            success = FALSE;
+            break;
+         }
+      }
+   }
+
+   if (format_desc->pack_rgba_float) {
+      /* Include some values out of the [0, 1] range */
+      for (x = 0; x < ROW_WIDTH; ++x)
+         for (i = 0; i < 4; ++i)
+            unpacked_float[0][x][i] = (float)rand() / RAND_MAX * 1.5f - 0.25f;
+
+      memset(packed_row, 0, sizeof packed_row);
+      memset(packed_pixels, 0, sizeof packed_pixels);
+      format_desc->pack_rgba_float(packed_row, 0,
+                                   &unpacked_float[0][0][0], 0,
+                                   ROW_WIDTH, 1);
+      for (x = 0; x < ROW_WIDTH; ++x)
+         format_desc->pack_rgba_float(packed_pixels + x*bytes, 0,
+                                      unpacked_float[0][x], 0, 1, 1);
+      for (i = 0; i < ROW_WIDTH*bytes; ++i) {
+         if ((packed_row[i] ^ packed_pixels[i]) & mask[i % bytes]) {
+            printf("FAILED: util_format_%s_pack_rgba_float row\n",
+                   format_desc->short_name);
+            success = FALSE;
+            break;
+         }
+      }
+   }
+
+   return success;
+}
+
+
 static boolean
 test_all(void)
 {
@@ -719,18 +861,129 @@ test_all(void)
       TEST_ONE_FUNC(pack_s_8uint);
 
 #     undef TEST_ONE_FUNC
+
+      if (format_desc->layout == UTIL_FORMAT_LAYOUT_PLAIN &&
+          format_desc->block.width == 1 &&
+          format_desc->block.height == 1) {
+         if (!test_format_rows(format_desc)) {
+            success = FALSE;
+         }
+      }
    }
 
    return success;
 }
 
 
+static double
+bench_func(void (*func)(void *dst, unsigned dst_stride,
+                        const void *src, unsigned src_stride,
+                        unsigned width, unsigned height),
+           void *dst, unsigned dst_stride,
+           const void *src, unsigned src_stride,
+           unsigned width, unsigned height)
+{
+   unsigned iterations = 0;
+   int64_t start, end;
+
+   start = os_time_get();
+   do {
+      func(dst, dst_stride, src, src_stride, width, height);
+      ++iterations;
+      end = os_time_get();
+   } while (end - start < 100000);
+
+   /* Mpixels per second */
+   return (double)width * height * iterations / (end - start);
+}
+
+
+typedef void (*row_func)(void *dst, unsigned dst_stride,
+                         const void *src, unsigned src_stride,
+                         unsigned width, unsigned height);
+
+
+/**
+ * Measure the throughput of row packing and unpacking for some common
+ * formats, with and without SIMD.
+ */
+static void
+bench_all(void)
+{
+   static const enum pipe_format formats[] = {
+      PIPE_FORMAT_B8G8R8A8_UNORM,
+      PIPE_FORMAT_B8G8R8X8_UNORM,
+      PIPE_FORMAT_R8G8B8A8_UNORM,
+      PIPE_FORMAT_A8R8G8B8_UNORM,
+      PIPE_FORMAT_B5G6R5_UNORM,
+      PIPE_FORMAT_B5G5R5A1_UNORM,
+      PIPE_FORMAT_B4G4R4A4_UNORM,
+      PIPE_FORMAT_L8A8_UNORM,
+      PIPE_FORMAT_R10G10B10A2_UNORM,
+      PIPE_FORMAT_R16G16B16A16_FLOAT,
+      PIPE_FORMAT_R32G32B32A32_FLOAT
+   };
+   const unsigned width = 512, height = 64;
+   const unsigned packed_stride = width * 16;
+   const unsigned unpacked_stride = width * 4 * sizeof(float);
+   void *packed = MALLOC(height * packed_stride);
+   void *unpacked = MALLOC(height * unpacked_stride);
+   struct util_cpu_caps caps = util_cpu_caps;
+   unsigned i, simd;
+
+   if (!packed || !unpacked)
+      goto out;
+
+   memset(packed, 0x55, height * packed_stride);
+   memset(unpacked, 0, height * unpacked_stride);
+
+   printf("%-24s %-6s %10s %10s %10s %10s\n", "format", "",
+          "unpack8", "pack8", "unpackf", "packf");
+
+   for (i = 0; i < Elements(formats); ++i) {
+      const struct util_format_description *format_desc =
+         util_format_description(formats[i]);
+
+      for (simd = 0; simd < 2; ++simd) {
+         util_cpu_caps.has_sse2 = simd ? caps.has_sse2 : 0;
+
+         printf("%-24s %-6s %10.1f %10.1f %10.1f %10.1f\n",
+                format_desc->short_name, simd ? "simd" : "scalar",
+                bench_func((row_func)format_desc->unpack_rgba_8unorm,
+                           unpacked, unpacked_stride,
+                           packed, packed_stride, width, height),
+                bench_func((row_func)format_desc->pack_rgba_8unorm,
+                           packed, packed_stride,
+                           unpacked, unpacked_stride, width, height),
+                bench_func((row_func)format_desc->unpack_rgba_float,
+                           unpacked, unpacked_stride,
+                           packed, packed_stride, width, height),
+                bench_func((row_func)format_desc->pack_rgba_float,
+                           packed, packed_stride,
+                           unpacked, unpacked_stride, width, height));
+      }
+   }
+
+   util_cpu_caps = caps;
+
+out:
+   FREE(packed);
+   FREE(unpacked);
+}
+
+
 int main(int argc, char **argv)
 {
    boolean success;
 
+   util_cpu_detect();
    util_format_s3tc_init();
 
+   if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+      bench_all();
+      return 0;
+   }
+
    success = test_all();
 
    return success ? 0 : 1;
@@ -0,0 +1,281 @@
+/**************************************************************************
+ *
+ * Copyright 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/*
+ *  Test case and benchmark for the index translators.
+ *
+ *  Every translator is run with and without SIMD on index lists of various
+ *  lengths, and the results must match exactly.  With "-b" the throughput
+ *  of every translator is printed instead.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pipe/p_defines.h"
+#include "os/os_time.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_memory.h"
+#include "util/u_prim.h"
+#include "util/u_string.h"
+#include "indices/u_indices.h"
+
+
+#define MAX_COUNT 4096
+#define BENCH_COUNT 4096
+
+/* Extra room to catch writes past the end of the output */
+#define GUARD_SIZE 64
+
+
+static const unsigned index_sizes[] = { 1, 2, 4 };
+
+static uint8_t input[MAX_COUNT * 4];
+
+
+struct translation {
+   u_translate_func func;
+   unsigned out_nr;
+   unsigned out_size;
+};
+
+
+/**
+ * Get the translator for a primitive.  When unfilled is set the polygon
+ * mode line translator is returned, otherwise the regular one.
+ */
+static boolean
+get_translation(unsigned prim, unsigned index_size, unsigned nr,
+                unsigned in_pv, unsigned out_pv, boolean unfilled,
+                struct translation *t)
+{
+   unsigned out_prim;
+   int ret;
+
+   if (unfilled) {
+      ret = u_unfilled_translator(prim, index_size, nr,
+                                  PIPE_POLYGON_MODE_LINE, &out_prim,
+                                  &t->out_size, &t->out_nr, &t->func);
+   }
+   else {
+      /* No native primitives, so that everything gets translated */
+      ret = u_index_translator(0, prim, index_size, nr, in_pv, out_pv,
+                               &out_prim, &t->out_size, &t->out_nr, &t->func);
+   }
+
+   return ret != U_TRANSLATE_ERROR && t->func != NULL;
+}
+
+
+/**
+ * Whether nr is a sensible vertex count for the primitive.  Incomplete
+ * primitives are trimmed before translation in practice.
+ */
+static boolean
+valid_count(unsigned prim, unsigned nr)
+{
+   unsigned trimmed = nr;
+
+   return u_trim_pipe_prim(prim, &trimmed) && trimmed == nr;
+}
+
+
+static void
+fill_input(unsigned index_size, unsigned nr)
+{
+   const unsigned max = index_size == 1 ? 0xff :
+                        index_size == 2 ? 0xffff : 0xffffffff;
+   unsigned i;
+
+   for (i = 0; i < nr; i++) {
+      unsigned value = (rand() << 16) ^ rand();
+      value &= max;
+      memcpy(&input[i * index_size], &value, index_size);
+   }
+}
+
+
+static boolean
+test_translation(unsigned prim, unsigned index_size, unsigned nr,
+                 unsigned in_pv, unsigned out_pv, boolean unfilled)
+{
+   static uint8_t scalar[MAX_COUNT * 6 * 4 + GUARD_SIZE];
+   static uint8_t simd[MAX_COUNT * 6 * 4 + GUARD_SIZE];
+   struct util_cpu_caps caps = util_cpu_caps;
+   struct translation t;
+   unsigned size;
+
+   if (!get_translation(prim, index_size, nr, in_pv, out_pv, unfilled, &t))
+      return TRUE;
+
+   size = t.out_nr * t.out_size;
+   memset(scalar, 0xcd, size + GUARD_SIZE);
+   memset(simd, 0xcd, size + GUARD_SIZE);
+
+   util_cpu_caps.has_sse2 = 0;
+   t.func(input, t.out_nr, scalar);
+   util_cpu_caps = caps;
+   t.func(input, t.out_nr, simd);
+
+   if (memcmp(scalar, simd, size + GUARD_SIZE) != 0) {
+      printf("FAILED: %s%s, %u byte indices, %u vertices, pv %u -> %u\n",
+             u_prim_name(prim), unfilled ? " (unfilled)" : "",
+             index_size, nr, in_pv, out_pv);
+      return FALSE;
+   }
+
+   return TRUE;
+}
+
+
+static boolean
+test_all(void)
+{
+   unsigned prim, i, nr, in_pv, out_pv;
+   boolean success = TRUE;
+
+   for (prim = PIPE_PRIM_POINTS; prim <= PIPE_PRIM_POLYGON; prim++) {
+      for (i = 0; i < Elements(index_sizes); i++) {
+         for (nr = 0; nr < MAX_COUNT; nr = nr < 80 ? nr + 1 : nr * 3 + 1) {
+            if (!valid_count(prim, nr))
+               continue;
+
+            fill_input(index_sizes[i], nr);
+
+            for (in_pv = PV_FIRST; in_pv < PV_COUNT; in_pv++) {
+               for (out_pv = PV_FIRST; out_pv < PV_COUNT; out_pv++) {
+                  success &= test_translation(prim, index_sizes[i], nr,
+                                              in_pv, out_pv, FALSE);
+               }
+            }
+
+            if (prim >= PIPE_PRIM_TRIANGLES) {
+               success &= test_translation(prim, index_sizes[i], nr,
+                                           PV_FIRST, PV_FIRST, TRUE);
+            }
+         }
+      }
+   }
+
+   return success;
+}
+
+
+/**
+ * Return the throughput of a translation in millions of output indices per
+ * second.
+ */
+static double
+bench_translation(const struct translation *t, void *out)
+{
+   unsigned iterations = 0;
+   int64_t start, end;
+
+   start = os_time_get();
+   do {
+      t->func(input, t->out_nr, out);
+      ++iterations;
+      end = os_time_get();
+   } while (end - start < 20000);
+
+   return (double)t->out_nr * iterations / (end - start);
+}
+
+
+static void
+bench_all(void)
+{
+   static const char *pv_names[] = { "first", "last" };
+   struct util_cpu_caps caps = util_cpu_caps;
+   void *out = MALLOC(BENCH_COUNT * 6 * 4);
+   unsigned prim, i, in_pv, out_pv, unfilled;
+
+   if (!out)
+      return;
+
+   printf("%-32s %4s %-12s %10s %10s\n", "primitive", "size", "pv",
+          "scalar", "simd");
+
+   for (unfilled = 0; unfilled < 2; unfilled++) {
+      for (prim = unfilled ? PIPE_PRIM_TRIANGLES : PIPE_PRIM_POINTS;
+           prim <= PIPE_PRIM_POLYGON; prim++) {
+         for (i = 0; i < Elements(index_sizes); i++) {
+            for (in_pv = PV_FIRST; in_pv < PV_COUNT; in_pv++) {
+               for (out_pv = PV_FIRST; out_pv < PV_COUNT; out_pv++) {
+                  struct translation t;
+                  char name[64], pv[16];
+                  unsigned nr = BENCH_COUNT;
+                  double scalar, simd;
+
+                  /* The unfilled translators don't care about the PV */
+                  if (unfilled && (in_pv != PV_FIRST || out_pv != PV_FIRST))
+                     continue;
+
+                  u_trim_pipe_prim(prim, &nr);
+                  if (!get_translation(prim, index_sizes[i], nr,
+                                       in_pv, out_pv, unfilled, &t))
+                     continue;
+
+                  fill_input(index_sizes[i], nr);
+
+                  util_cpu_caps.has_sse2 = 0;
+                  scalar = bench_translation(&t, out);
+                  util_cpu_caps = caps;
+                  simd = bench_translation(&t, out);
+
+                  util_snprintf(name, sizeof name, "%s%s", u_prim_name(prim),
+                                unfilled ? " (unfilled)" : "");
+                  util_snprintf(pv, sizeof pv, "%s->%s",
+                                pv_names[in_pv], pv_names[out_pv]);
+                  printf("%-32s %4u %-12s %10.1f %10.1f\n", name,
+                         index_sizes[i], unfilled ? "" : pv, scalar, simd);
+               }
+            }
+         }
+      }
+   }
+
+   FREE(out);
+}
+
+
+int main(int argc, char **argv)
+{
+   boolean success;
+
+   util_cpu_detect();
+
+   if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+      bench_all();
+      return 0;
+   }
+
+   success = test_all();
+
+   return success ? 0 : 1;
+}
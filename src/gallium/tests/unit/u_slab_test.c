@@ -0,0 +1,252 @@
+/**************************************************************************
+ *
+ * Copyright 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/*
+ *  Test case and benchmark for the slab allocators.
+ *
+ *  Every thread allocates a batch of objects, and then frees half of its own
+ *  objects and half of the objects of the next thread, so that both local
+ *  and cross-thread frees are exercised.  The test fails if an object is
+ *  handed out twice.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "os/os_thread.h"
+#include "os/os_time.h"
+#include "util/u_memory.h"
+#include "util/u_slab.h"
+
+
+#define MAX_THREADS 16
+#define BATCH_SIZE 256
+#define NUM_ROUNDS 2000
+#define OBJECT_SIZE 64
+
+
+enum allocator {
+   ALLOCATOR_MALLOC,
+   ALLOCATOR_SLAB,
+   ALLOCATOR_SLAB_CACHE
+};
+
+static const char *allocator_names[] = {
+   "malloc",
+   "util_slab",
+   "util_slab_cache"
+};
+
+struct thread_info {
+   unsigned id;
+   struct util_slab_cache *cache;
+   unsigned *objects[BATCH_SIZE];
+};
+
+static enum allocator allocator;
+static unsigned num_threads;
+static struct util_slab_mempool pool;
+static struct thread_info threads[MAX_THREADS];
+static pipe_barrier barrier;
+static boolean failed;
+
+
+static void *
+object_alloc(struct thread_info *info)
+{
+   switch (allocator) {
+   case ALLOCATOR_MALLOC:
+      return MALLOC(OBJECT_SIZE);
+   case ALLOCATOR_SLAB:
+      return util_slab_alloc(&pool);
+   default:
+      return util_slab_cache_alloc(info->cache);
+   }
+}
+
+
+static void
+object_free(struct thread_info *info, void *ptr)
+{
+   switch (allocator) {
+   case ALLOCATOR_MALLOC:
+      FREE(ptr);
+      break;
+   case ALLOCATOR_SLAB:
+      util_slab_free(&pool, ptr);
+      break;
+   default:
+      util_slab_cache_free(info->cache, ptr);
+      break;
+   }
+}
+
+
+static void
+check_objects(struct thread_info *info, unsigned first, unsigned step)
+{
+   unsigned i;
+
+   for (i = first; i < BATCH_SIZE; i += step) {
+      if (info->objects[i][0] != info->id ||
+          info->objects[i][OBJECT_SIZE/sizeof(unsigned) - 1] != i) {
+         failed = TRUE;
+      }
+   }
+}
+
+
+static PIPE_THREAD_ROUTINE(thread_function, thread_data)
+{
+   struct thread_info *info = (struct thread_info *) thread_data;
+   struct thread_info *next = &threads[(info->id + 1) % num_threads];
+   unsigned round, i;
+
+   for (round = 0; round < NUM_ROUNDS; round++) {
+      /* Allocate the objects freed in the previous round */
+      for (i = round ? 1 : 0; i < BATCH_SIZE; i += round ? 2 : 1) {
+         info->objects[i] = object_alloc(info);
+         info->objects[i][0] = info->id;
+         info->objects[i][OBJECT_SIZE/sizeof(unsigned) - 1] = i;
+      }
+      check_objects(info, 0, 1);
+
+      pipe_barrier_wait(&barrier);
+
+      /* Free the odd objects of the next thread */
+      check_objects(next, 1, 2);
+      for (i = 1; i < BATCH_SIZE; i += 2)
+         object_free(info, next->objects[i]);
+
+      pipe_barrier_wait(&barrier);
+   }
+
+   for (i = 0; i < BATCH_SIZE; i += 2)
+      object_free(info, info->objects[i]);
+
+   return NULL;
+}
+
+
+static double
+run(enum allocator a, unsigned n)
+{
+   pipe_thread handles[MAX_THREADS];
+   int64_t start, end;
+   unsigned i;
+
+   allocator = a;
+   num_threads = n;
+
+   if (allocator == ALLOCATOR_SLAB)
+      util_slab_create(&pool, OBJECT_SIZE, BATCH_SIZE,
+                       UTIL_SLAB_MULTITHREADED);
+
+   pipe_barrier_init(&barrier, num_threads);
+
+   for (i = 0; i < num_threads; i++) {
+      threads[i].id = i;
+      threads[i].cache = util_slab_cache_create(OBJECT_SIZE, BATCH_SIZE);
+   }
+
+   start = os_time_get();
+
+   for (i = 0; i < num_threads; i++)
+      handles[i] = pipe_thread_create(thread_function, &threads[i]);
+
+   for (i = 0; i < num_threads; i++)
+      pipe_thread_wait(handles[i]);
+
+   end = os_time_get();
+
+   for (i = 0; i < num_threads; i++)
+      util_slab_cache_destroy(threads[i].cache);
+
+   pipe_barrier_destroy(&barrier);
+
+   if (allocator == ALLOCATOR_SLAB)
+      util_slab_destroy(&pool);
+
+   /* Millions of allocations per second */
+   return (double)num_threads * NUM_ROUNDS * BATCH_SIZE / 2 / (end - start);
+}
+
+
+static void
+test_orphaned(void)
+{
+   struct util_slab_cache *cache, *other;
+   void *objects[BATCH_SIZE * 2];
+   unsigned i;
+
+   /* Blocks freed after their cache is gone must still be freed properly,
+    * which can be checked with valgrind. */
+   cache = util_slab_cache_create(OBJECT_SIZE, BATCH_SIZE);
+   other = util_slab_cache_create(OBJECT_SIZE, BATCH_SIZE);
+
+   for (i = 0; i < Elements(objects); i++)
+      objects[i] = util_slab_cache_alloc(cache);
+
+   for (i = 0; i < Elements(objects); i += 2)
+      util_slab_cache_free(other, objects[i]);
+
+   util_slab_cache_destroy(cache);
+
+   for (i = 1; i < Elements(objects); i += 2)
+      util_slab_cache_free(i & 2 ? other : NULL, objects[i]);
+
+   util_slab_cache_destroy(other);
+}
+
+
+int main(int argc, char **argv)
+{
+   unsigned n;
+   enum allocator a;
+
+   test_orphaned();
+
+   printf("%-8s", "threads");
+   for (a = ALLOCATOR_MALLOC; a <= ALLOCATOR_SLAB_CACHE; a++)
+      printf(" %16s", allocator_names[a]);
+   printf("\n");
+
+   for (n = 1; n <= MAX_THREADS; n *= 2) {
+      printf("%-8u", n);
+      for (a = ALLOCATOR_MALLOC; a <= ALLOCATOR_SLAB_CACHE; a++)
+         printf(" %16.1f", run(a, n));
+      printf("\n");
+   }
+
+   if (failed) {
+      printf("FAILED: an object was allocated twice\n");
+      return 1;
+   }
+
+   return 0;
+}
@@ -31,6 +31,7 @@ import sys
 import xml.parsers.expat
 import binascii
 import optparse
+import struct
 
 from model import *
 
@@ -188,13 +189,206 @@ class XmlParser:
         return data
 
 
+class PrefixedFile:
+    """File wrapper which gives back some already read data first."""
+
+    def __init__(self, prefix, fp):
+        self.prefix = prefix
+        self.fp = fp
+
+    def read(self, size):
+        if self.prefix:
+            data = self.prefix[:size]
+            self.prefix = self.prefix[size:]
+            if len(data) < size:
+                data += self.fp.read(size - len(data))
+            return data
+        return self.fp.read(size)
+
+
+BINARY_MAGIC = 'GTRB'
+BINARY_VERSION = 1
+
+# Keep in sync with enum trace_bin_op in src/gallium/drivers/trace/tr_dump.c
+BIN_CALL_BEGIN = 0x01
+BIN_CALL_END = 0x02
+BIN_ARG = 0x03
+BIN_RET = 0x04
+BIN_NULL = 0x10
+BIN_BOOL = 0x11
+BIN_INT = 0x12
+BIN_UINT = 0x13
+BIN_FLOAT = 0x14
+BIN_STRING = 0x15
+BIN_ENUM = 0x16
+BIN_BYTES = 0x17
+BIN_PTR = 0x18
+BIN_ARRAY_BEGIN = 0x19
+BIN_ARRAY_END = 0x1a
+BIN_STRUCT_BEGIN = 0x1b
+BIN_MEMBER = 0x1c
+BIN_STRUCT_END = 0x1d
+BIN_STRING_DEF = 0x20
+BIN_BLOB_DEF = 0x21
+
+
+class BinaryTraceError(Exception):
+    pass
+
+
+class BinaryTraceReader:
+    """Decoder for traces written with GALLIUM_TRACE_FORMAT=binary."""
+
+    def __init__(self, fp):
+        self.fp = fp
+        self.strings = {}
+        self.blobs = {}
+        self.buf = ''
+        self.pos = 0
+        version = self.read_uint()
+        if version != BINARY_VERSION:
+            raise BinaryTraceError('unsupported binary trace version %u' % version)
+
+    def fill(self, size):
+        if self.pos + size > len(self.buf):
+            data = self.fp.read(max(size, 64*1024))
+            self.buf = self.buf[self.pos:] + data
+            self.pos = 0
+        return self.pos + size <= len(self.buf)
+
+    def read(self, size):
+        if not self.fill(size):
+            raise BinaryTraceError('unexpected end of trace')
+        data = self.buf[self.pos:self.pos + size]
+        self.pos += size
+        return data
+
+    def read_byte(self):
+        return ord(self.read(1))
+
+    def read_uint(self):
+        value = 0
+        shift = 0
+        while True:
+            byte = self.read_byte()
+            value |= (byte & 0x7f) << shift
+            shift += 7
+            if not byte & 0x80:
+                return value
+
+    def read_int(self):
+        value = self.read_uint()
+        return (value >> 1) ^ -(value & 1)
+
+    def read_name(self):
+        return self.strings[self.read_uint()]
+
+    def read_op(self):
+        '''Next opcode after any definitions, or None at the end.'''
+        while self.fill(1):
+            op = self.read_byte()
+            if op == BIN_STRING_DEF:
+                id = self.read_uint()
+                self.strings[id] = self.read(self.read_uint())
+            elif op == BIN_BLOB_DEF:
+                id = self.read_uint()
+                self.blobs[id] = self.read(self.read_uint())
+            else:
+                return op
+        return None
+
+    def read_value(self, op = None):
+        if op is None:
+            op = self.read_op()
+        if op == BIN_NULL:
+            return Literal(None)
+        if op == BIN_BOOL:
+            return Literal(self.read_byte())
+        if op == BIN_INT:
+            return Literal(self.read_int())
+        if op == BIN_UINT:
+            return Literal(self.read_uint())
+        if op == BIN_FLOAT:
+            return Literal(struct.unpack('<d', self.read(8))[0])
+        if op == BIN_STRING:
+            return Literal(self.read(self.read_uint()))
+        if op == BIN_ENUM:
+            return NamedConstant(self.read_name())
+        if op == BIN_BYTES:
+            return Literal(self.blobs[self.read_uint()])
+        if op == BIN_PTR:
+            return Pointer('0x%08x' % self.read_uint())
+        if op == BIN_ARRAY_BEGIN:
+            elems = []
+            op = self.read_op()
+            while op != BIN_ARRAY_END:
+                elems.append(self.read_value(op))
+                op = self.read_op()
+            return Array(elems)
+        if op == BIN_STRUCT_BEGIN:
+            name = self.read_name()
+            members = []
+            op = self.read_op()
+            while op == BIN_MEMBER:
+                member = self.read_name()
+                members.append((member, self.read_value()))
+                op = self.read_op()
+            if op != BIN_STRUCT_END:
+                raise BinaryTraceError('unexpected opcode %r in struct' % op)
+            return Struct(name, members)
+        raise BinaryTraceError('unexpected opcode %r' % op)
+
+    def read_call(self):
+        '''Next call, or None at the end of the trace.'''
+        op = self.read_op()
+        if op is None:
+            return None
+        if op != BIN_CALL_BEGIN:
+            raise BinaryTraceError('unexpected opcode %r outside call' % op)
+        no = self.read_uint()
+        klass = self.read_name()
+        method = self.read_name()
+        args = []
+        ret = None
+        time = 0
+        while True:
+            op = self.read_op()
+            if op == BIN_ARG:
+                name = self.read_name()
+                args.append((name, self.read_value()))
+            elif op == BIN_RET:
+                ret = self.read_value()
+            elif op == BIN_CALL_END:
+                time = Literal(self.read_int())
+                break
+            elif op is None:
+                # truncated trace, e.g. the application crashed
+                break
+            else:
+                raise BinaryTraceError('unexpected opcode %r in call' % op)
+        return Call(no, klass, method, args, ret, time)
+
+
 class TraceParser(XmlParser):
 
     def __init__(self, fp):
-        XmlParser.__init__(self, fp)
+        magic = fp.read(len(BINARY_MAGIC))
+        if magic == BINARY_MAGIC:
+            self.binary = BinaryTraceReader(fp)
+        else:
+            self.binary = None
+            XmlParser.__init__(self, PrefixedFile(magic, fp))
         self.last_call_no = 0
-    
+
     def parse(self):
+        if self.binary is not None:
+            call = self.binary.read_call()
+            while call is not None:
+                self.last_call_no = call.no
+                self.handle_call(call)
+                call = self.binary.read_call()
+            return
+
         self.element_start('trace')
         while self.token.type not in (ELEMENT_END, EOF):
             call = self.parse_call()
@@ -379,12 +573,12 @@ class Main:
         for arg in args:
             if arg.endswith('.gz'):
                 from gzip import GzipFile
-                stream = GzipFile(arg, 'rt')
+                stream = GzipFile(arg, 'rb')
             elif arg.endswith('.bz2'):
                 from bz2 import BZ2File
-                stream = BZ2File(arg, 'rU')
+                stream = BZ2File(arg, 'rb')
             else:
-                stream = open(arg, 'rt')
+                stream = open(arg, 'rb')
             self.process_arg(stream, options)
 
     def get_optparser(self):
@@ -0,0 +1,2661 @@
+/**************************************************************************
+ *
+ * Copyright 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ **************************************************************************/
+
+
+/**
+ * @file
+ * Replay of binary gallium traces.
+ *
+ * Reads a trace written by the trace driver with GALLIUM_TRACE_FORMAT=binary
+ * and re-executes its pipe_context calls against a pipe_screen obtained from
+ * the pipe loader, timing every call.  Frames end at
+ * pipe_screen::flush_frontbuffer, where the context is flushed and waited
+ * for so that the frame time includes all the rendering.
+ *
+ * The whole trace is decoded before replaying it, so the times only cover
+ * the driver.  Draws reading user vertex or index buffers are skipped, as
+ * the trace doesn't record their contents.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pipe/p_context.h"
+#include "pipe/p_defines.h"
+#include "pipe/p_screen.h"
+#include "pipe/p_shader_tokens.h"
+#include "pipe/p_state.h"
+#include "os/os_time.h"
+#include "tgsi/tgsi_text.h"
+#include "util/u_double_list.h"
+#include "util/u_format.h"
+#include "util/u_hash_table.h"
+#include "util/u_inlines.h"
+#include "util/u_memory.h"
+#include "util/u_simple_shaders.h"
+#include "pipe-loader/pipe_loader.h"
+
+
+/* Must match src/gallium/drivers/trace/tr_dump.c */
+#define TRACE_BIN_MAGIC "GTRB"
+#define TRACE_BIN_VERSION 1
+
+enum trace_bin_op {
+   TRACE_BIN_CALL_BEGIN = 0x01,
+   TRACE_BIN_CALL_END = 0x02,
+   TRACE_BIN_ARG = 0x03,
+   TRACE_BIN_RET = 0x04,
+
+   TRACE_BIN_NULL = 0x10,
+   TRACE_BIN_BOOL = 0x11,
+   TRACE_BIN_INT = 0x12,
+   TRACE_BIN_UINT = 0x13,
+   TRACE_BIN_FLOAT = 0x14,
+   TRACE_BIN_STRING = 0x15,
+   TRACE_BIN_ENUM = 0x16,
+   TRACE_BIN_BYTES = 0x17,
+   TRACE_BIN_PTR = 0x18,
+   TRACE_BIN_ARRAY_BEGIN = 0x19,
+   TRACE_BIN_ARRAY_END = 0x1a,
+   TRACE_BIN_STRUCT_BEGIN = 0x1b,
+   TRACE_BIN_MEMBER = 0x1c,
+   TRACE_BIN_STRUCT_END = 0x1d,
+
+   TRACE_BIN_STRING_DEF = 0x20,
+   TRACE_BIN_BLOB_DEF = 0x21
+};
+
+
+enum replay_type {
+   REPLAY_NULL,
+   REPLAY_BOOL,
+   REPLAY_INT,
+   REPLAY_UINT,
+   REPLAY_FLOAT,
+   REPLAY_STRING,
+   REPLAY_ENUM,
+   REPLAY_BYTES,
+   REPLAY_PTR,
+   REPLAY_ARRAY,
+   REPLAY_STRUCT
+};
+
+struct replay_member;
+
+/**
+ * A decoded trace value.
+ */
+struct replay_value
+{
+   enum replay_type type;
+   unsigned num;     /**< string or blob size, number of elements or members */
+   const char *name; /**< enum or struct name */
+   union {
+      int64_t i;
+      uint64_t u;    /**< also bools and pointers */
+      double f;
+      const void *data;                /**< strings and blobs */
+      struct replay_value *elems;
+      struct replay_member *members;
+   } u;
+};
+
+struct replay_member
+{
+   const char *name;
+   struct replay_value value;
+};
+
+struct replay;
+struct replay_call;
+
+typedef void (*replay_func)(struct replay *r, const struct replay_call *call);
+
+struct replay_method
+{
+   const char *klass;
+   const char *method;
+   replay_func func;  /**< NULL for calls that don't need replaying */
+};
+
+struct replay_call
+{
+   unsigned no;
+   const char *klass;
+   const char *method;
+   int method_index;  /**< into replay_methods, or -1 if unknown */
+   unsigned num_args;
+   struct replay_member *args;
+   struct replay_value ret;
+   int64_t time;      /**< microseconds spent in the traced driver */
+};
+
+enum replay_object_type {
+   REPLAY_OBJECT_CONTEXT,
+   REPLAY_OBJECT_RESOURCE,
+   REPLAY_OBJECT_SURFACE,
+   REPLAY_OBJECT_SAMPLER_VIEW,
+   REPLAY_OBJECT_SO_TARGET,
+   REPLAY_OBJECT_FENCE,
+   REPLAY_OBJECT_OTHER
+};
+
+struct replay_context
+{
+   struct pipe_context *pipe;
+   unsigned user_vertex_buffers;  /**< mask of slots in untraced memory */
+   boolean user_index_buffer;
+};
+
+/**
+ * An object created during the replay, keyed by its address in the trace.
+ */
+struct replay_object
+{
+   struct list_head head;
+   uint64_t key;
+   enum replay_object_type type;
+   struct replay_context *ctx;  /**< owning context, if any */
+   void *obj;
+};
+
+struct replay_stats
+{
+   unsigned count;
+   uint64_t total;   /**< nanoseconds */
+   uint64_t max;
+   int64_t traced;   /**< microseconds in the traced driver */
+};
+
+struct replay_frame
+{
+   unsigned calls;
+   uint64_t driver;  /**< nanoseconds spent in the driver */
+   uint64_t wall;    /**< nanoseconds from the end of the previous frame */
+   int64_t traced;   /**< microseconds in the traced driver */
+};
+
+/**
+ * Arena for the decoded values, which live as long as the replay.
+ */
+struct replay_chunk
+{
+   struct replay_chunk *next;
+   size_t used;
+   size_t size;
+};
+
+#define REPLAY_CHUNK_SIZE (1024 * 1024)
+
+struct replay
+{
+   /* decoding */
+   const uint8_t *start;
+   const uint8_t *p;
+   const uint8_t *end;
+   boolean error;
+   char **strings;
+   unsigned max_strings;
+   const uint8_t **blobs;
+   size_t *blob_sizes;
+   unsigned max_blobs;
+   struct replay_chunk *chunks;
+
+   struct replay_call *calls;
+   unsigned num_calls;
+   unsigned max_calls;
+
+   /* replaying */
+   struct pipe_screen *screen;
+   struct replay_context *ctx;   /**< context of the last call */
+   struct util_hash_table *objects;
+   struct list_head object_list;
+   int64_t time_start;
+   uint64_t call_time;
+   unsigned skipped_draws;
+   unsigned unknown_calls;
+   boolean verbose;
+
+   /* results */
+   struct replay_stats *stats;
+   struct replay_frame *frames;
+   unsigned num_frames;
+   unsigned max_frames;
+   struct replay_frame frame;
+   int64_t frame_start;
+};
+
+
+static const struct replay_value replay_null = { REPLAY_NULL, 0, NULL, { 0 } };
+
+
+/*
+ * Decoding
+ */
+
+static void *
+replay_alloc(struct replay *r, size_t size)
+{
+   struct replay_chunk *chunk = r->chunks;
+   void *ptr;
+
+   size = align(size, 8);
+
+   if (!chunk || chunk->used + size > chunk->size) {
+      size_t chunk_size = MAX2(REPLAY_CHUNK_SIZE, size);
+      chunk = MALLOC(sizeof *chunk + chunk_size);
+      if (!chunk) {
+         fprintf(stderr, "error: out of memory\n");
+         exit(1);
+      }
+      chunk->next = r->chunks;
+      chunk->used = 0;
+      chunk->size = chunk_size;
+      r->chunks = chunk;
+   }
+
+   ptr = (uint8_t *)(chunk + 1) + chunk->used;
+   chunk->used += size;
+   return ptr;
+}
+
+
+static void
+replay_error(struct replay *r, const char *message)
+{
+   if (!r->error)
+      fprintf(stderr, "error: %s at offset %lu\n", message,
+              (unsigned long)(r->p - r->start));
+   r->error = TRUE;
+   r->p = r->end;
+}
+
+
+static const uint8_t *
+replay_read(struct replay *r, size_t size)
+{
+   const uint8_t *data = r->p;
+
+   if ((size_t)(r->end - r->p) < size) {
+      replay_error(r, "unexpected end of trace");
+      return NULL;
+   }
+
+   r->p += size;
+   return data;
+}
+
+
+static uint64_t
+replay_read_uint(struct replay *r)
+{
+   uint64_t value = 0;
+   unsigned shift = 0;
+
+   while (r->p < r->end) {
+      uint8_t byte = *r->p++;
+      if (shift < 64)
+         value |= (uint64_t)(byte & 0x7f) << shift;
+      shift += 7;
+      if (!(byte & 0x80))
+         return value;
+   }
+
+   replay_error(r, "unexpected end of trace");
+   return 0;
+}
+
+
+static int64_t
+replay_read_int(struct replay *r)
+{
+   uint64_t value = replay_read_uint(r);
+   return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+
+static double
+replay_read_double(struct replay *r)
+{
+   const uint8_t *buf = replay_read(r, 8);
+   uint64_t bits = 0;
+   double value;
+   unsigned i;
+
+   if (!buf)
+      return 0.0;
+
+   for (i = 0; i < 8; ++i)
+      bits |= (uint64_t)buf[i] << (8 * i);
+   memcpy(&value, &bits, sizeof value);
+   return value;
+}
+
+
+static const char *
+replay_read_name(struct replay *r)
+{
+   uint64_t id = replay_read_uint(r);
+
+   if (id >= r->max_strings || !r->strings[id]) {
+      replay_error(r, "undefined name");
+      return "";
+   }
+
+   return r->strings[id];
+}
+
+
+/**
+ * Grow an array indexed by id so that it can hold id.
+ */
+static void *
+replay_grow(void *array, unsigned *max, uint64_t id, size_t elem_size)
+{
+   unsigned old_max = *max;
+   unsigned new_max = MAX2(old_max * 2, 64);
+   uint8_t *new_array;
+
+   while (new_max <= id)
+      new_max *= 2;
+
+   new_array = REALLOC(array, old_max * elem_size, new_max * elem_size);
+   if (!new_array) {
+      fprintf(stderr, "error: out of memory\n");
+      exit(1);
+   }
+   memset(new_array + old_max * elem_size, 0,
+          (new_max - old_max) * elem_size);
+   *max = new_max;
+   return new_array;
+}
+
+
+/**
+ * Read the next opcode, handling any name and blob definitions before it.
+ *
+ * \return the opcode, or -1 at the end of the trace
+ */
+static int
+replay_read_op(struct replay *r)
+{
+   while (r->p < r->end) {
+      uint8_t op = *r->p++;
+
+      if (op == TRACE_BIN_STRING_DEF) {
+         uint64_t id = replay_read_uint(r);
+         uint64_t len = replay_read_uint(r);
+         const uint8_t *str = replay_read(r, len);
+         if (!str)
+            return -1;
+         if (id >= r->max_strings)
+            r->strings = replay_grow(r->strings, &r->max_strings, id,
+                                     sizeof *r->strings);
+         FREE(r->strings[id]);
+         r->strings[id] = MALLOC(len + 1);
+         memcpy(r->strings[id], str, len);
+         r->strings[id][len] = 0;
+      }
+      else if (op == TRACE_BIN_BLOB_DEF) {
+         uint64_t id = replay_read_uint(r);
+         uint64_t size = replay_read_uint(r);
+         const uint8_t *data = replay_read(r, size);
+         if (!data)
+            return -1;
+         if (id >= r->max_blobs) {
+            unsigned max = r->max_blobs;
+            r->blobs = replay_grow(r->blobs, &max, id, sizeof *r->blobs);
+            r->blob_sizes = replay_grow(r->blob_sizes, &r->max_blobs, id,
+                                        sizeof *r->blob_sizes);
+         }
+         r->blobs[id] = data;
+         r->blob_sizes[id] = size;
+      }
+      else {
+         return op;
+      }
+   }
+
+   return -1;
+}
+
+
+static void
+replay_read_value(struct replay *r, int op, struct replay_value *value);
+
+
+/**
+ * Read array elements or struct members into the arena.
+ */
+static void
+replay_read_list(struct replay *r, struct replay_value *value,
+                 boolean members)
+{
+   size_t elem_size = members ? sizeof(struct replay_member)
+                              : sizeof(struct replay_value);
+   unsigned max = 0;
+   unsigned num = 0;
+   uint8_t *list = NULL;
+   int op;
+
+   for (;;) {
+      op = replay_read_op(r);
+      if (op < 0 || r->error) {
+         replay_error(r, "unexpected end of trace");
+         break;
+      }
+      if (op == (members ? TRACE_BIN_STRUCT_END : TRACE_BIN_ARRAY_END))
+         break;
+
+      if (num >= max)
+         list = replay_grow(list, &max, num, elem_size);
+
+      if (members) {
+         struct replay_member *member = (struct replay_member *)list + num;
+         if (op != TRACE_BIN_MEMBER) {
+            replay_error(r, "unexpected opcode in struct");
+            break;
+         }
+         member->name = replay_read_name(r);
+         replay_read_value(r, replay_read_op(r), &member->value);
+      }
+      else {
+         replay_read_value(r, op, (struct replay_value *)list + num);
+      }
+      ++num;
+   }
+
+   value->num = num;
+   value->u.data = NULL;
+   if (num) {
+      void *copy = replay_alloc(r, num * elem_size);
+      memcpy(copy, list, num * elem_size);
+      if (members)
+         value->u.members = copy;
+      else
+         value->u.elems = copy;
+   }
+   FREE(list);
+}
+
+
+static void
+replay_read_value(struct replay *r, int op, struct replay_value *value)
+{
+   *value = replay_null;
+
+   switch (op) {
+   case TRACE_BIN_NULL:
+      break;
+   case TRACE_BIN_BOOL:
+      value->type = REPLAY_BOOL;
+      if (replay_read(r, 1))
+         value->u.u = r->p[-1];
+      break;
+   case TRACE_BIN_INT:
+      value->type = REPLAY_INT;
+      value->u.i = replay_read_int(r);
+      break;
+   case TRACE_BIN_UINT:
+      value->type = REPLAY_UINT;
+      value->u.u = replay_read_uint(r);
+      break;
+   case TRACE_BIN_FLOAT:
+      value->type = REPLAY_FLOAT;
+      value->u.f = replay_read_double(r);
+      break;
+   case TRACE_BIN_STRING:
+      {
+         uint64_t len = replay_read_uint(r);
+         const uint8_t *str = replay_read(r, len);
+         char *copy;
+         if (!str)
+            break;
+         copy = replay_alloc(r, len + 1);
+         memcpy(copy, str, len);
+         copy[len] = 0;
+         value->type = REPLAY_STRING;
+         value->num = len;
+         value->u.data = copy;
+      }
+      break;
+   case TRACE_BIN_ENUM:
+      value->type = REPLAY_ENUM;
+      value->name = replay_read_name(r);
+      break;
+   case TRACE_BIN_BYTES:
+      {
+         uint64_t id = replay_read_uint(r);
+         if (id >= r->max_blobs || !r->blobs[id]) {
+            replay_error(r, "undefined blob");
+            break;
+         }
+         value->type = REPLAY_BYTES;
+         value->num = r->blob_sizes[id];
+         value->u.data = r->blobs[id];
+      }
+      break;
+   case TRACE_BIN_PTR:
+      value->type = REPLAY_PTR;
+      value->u.u = replay_read_uint(r);
+      break;
+   case TRACE_BIN_ARRAY_BEGIN:
+      value->type = REPLAY_ARRAY;
+      replay_read_list(r, value, FALSE);
+      break;
+   case TRACE_BIN_STRUCT_BEGIN:
+      value->type = REPLAY_STRUCT;
+      value->name = replay_read_name(r);
+      replay_read_list(r, value, TRUE);
+      break;
+   default:
+      replay_error(r, op < 0 ? "unexpected end of trace" : "unexpected opcode");
+      break;
+   }
+}
+
+
+static int
+replay_find_method(const char *klass, const char *method);
+
+
+/**
+ * Decode the next call.
+ *
+ * \return FALSE at the end of the trace
+ */
+static boolean
+replay_read_call(struct replay *r, struct replay_call *call)
+{
+   struct replay_member args[32];
+   int op;
+
+   op = replay_read_op(r);
+   if (op < 0)
+      return FALSE;
+   if (op != TRACE_BIN_CALL_BEGIN) {
+      replay_error(r, "unexpected opcode outside call");
+      return FALSE;
+   }
+
+   memset(call, 0, sizeof *call);
+   call->no = replay_read_uint(r);
+   call->klass = replay_read_name(r);
+   call->method = replay_read_name(r);
+   call->method_index = replay_find_method(call->klass, call->method);
+
+   for (;;) {
+      op = replay_read_op(r);
+      if (op == TRACE_BIN_ARG) {
+         const char *name = replay_read_name(r);
+         struct replay_value value;
+         replay_read_value(r, replay_read_op(r), &value);
+         if (call->num_args < Elements(args)) {
+            args[call->num_args].name = name;
+            args[call->num_args].value = value;
+            ++call->num_args;
+         }
+      }
+      else if (op == TRACE_BIN_RET) {
+         replay_read_value(r, replay_read_op(r), &call->ret);
+      }
+      else if (op == TRACE_BIN_CALL_END) {
+         call->time = replay_read_int(r);
+         break;
+      }
+      else {
+         /* truncated trace, e.g. the application crashed */
+         if (op >= 0)
+            replay_error(r, "unexpected opcode in call");
+         return FALSE;
+      }
+   }
+
+   if (call->num_args) {
+      call->args = replay_alloc(r, call->num_args * sizeof *call->args);
+      memcpy(call->args, args, call->num_args * sizeof *call->args);
+   }
+
+   return !r->error;
+}
+
+
+static boolean
+replay_decode(struct replay *r, const uint8_t *data, size_t size)
+{
+   r->start = data;
+   r->p = data;
+   r->end = data + size;
+
+   if (size < 4 || memcmp(data, TRACE_BIN_MAGIC, 4) != 0) {
+      fprintf(stderr, "error: not a binary trace, capture it with "
+              "GALLIUM_TRACE_FORMAT=binary\n");
+      return FALSE;
+   }
+   r->p += 4;
+
+   if (replay_read_uint(r) != TRACE_BIN_VERSION) {
+      fprintf(stderr, "error: unsupported binary trace version\n");
+      return FALSE;
+   }
+
+   for (;;) {
+      if (r->num_calls >= r->max_calls)
+         r->calls = replay_grow(r->calls, &r->max_calls, r->num_calls,
+                                sizeof *r->calls);
+      if (!replay_read_call(r, &r->calls[r->num_calls]))
+         break;
+      ++r->num_calls;
+   }
+
+   return r->num_calls != 0;
+}
+
+
+/*
+ * Value accessors
+ */
+
+static const struct replay_value *
+replay_arg(const struct replay_call *call, const char *name)
+{
+   unsigned i;
+
+   for (i = 0; i < call->num_args; ++i) {
+      if (strcmp(call->args[i].name, name) == 0)
+         return &call->args[i].value;
+   }
+
+   return &replay_null;
+}
+
+
+static const struct replay_value *
+replay_member(const struct replay_value *value, const char *name)
+{
+   unsigned i;
+
+   if (value->type != REPLAY_STRUCT)
+      return &replay_null;
+
+   for (i = 0; i < value->num; ++i) {
+      if (strcmp(value->u.members[i].name, name) == 0)
+         return &value->u.members[i].value;
+   }
+
+   return &replay_null;
+}
+
+
+static const struct replay_value *
+replay_elem(const struct replay_value *value, unsigned i)
+{
+   if (value->type != REPLAY_ARRAY || i >= value->num)
+      return &replay_null;
+
+   return &value->u.elems[i];
+}
+
+
+static uint64_t
+replay_uint(const struct replay_value *value)
+{
+   switch (value->type) {
+   case REPLAY_BOOL:
+   case REPLAY_UINT:
+   case REPLAY_PTR:
+      return value->u.u;
+   case REPLAY_INT:
+      return (uint64_t)value->u.i;
+   case REPLAY_FLOAT:
+      return (uint64_t)value->u.f;
+   default:
+      return 0;
+   }
+}
+
+
+static int64_t
+replay_int(const struct replay_value *value)
+{
+   if (value->type == REPLAY_INT)
+      return value->u.i;
+   if (value->type == REPLAY_FLOAT)
+      return (int64_t)value->u.f;
+   return (int64_t)replay_uint(value);
+}
+
+
+static double
+replay_float(const struct replay_value *value)
+{
+   switch (value->type) {
+   case REPLAY_FLOAT:
+      return value->u.f;
+   case REPLAY_INT:
+      return (double)value->u.i;
+   default:
+      return (double)replay_uint(value);
+   }
+}
+
+
+static void
+replay_floats(const struct replay_value *value, float *dst, unsigned n)
+{
+   unsigned i;
+
+   for (i = 0; i < n; ++i)
+      dst[i] = (float)replay_float(replay_elem(value, i));
+}
+
+
+static enum pipe_format
+replay_format(const struct replay_value *value)
+{
+   unsigned format;
+
+   if (value->type != REPLAY_ENUM)
+      return (enum pipe_format)replay_uint(value);
+
+   for (format = 0; format < PIPE_FORMAT_COUNT; ++format) {
+      if (util_format_description(format) &&
+          strcmp(util_format_name(format), value->name) == 0)
+         return format;
+   }
+
+   return PIPE_FORMAT_NONE;
+}
+
+
+#define REPLAY_MEMBER(_state, _value, _member) \
+   (_state)->_member = replay_uint(replay_member(_value, #_member))
+
+#define REPLAY_MEMBER_INT(_state, _value, _member) \
+   (_state)->_member = replay_int(replay_member(_value, #_member))
+
+#define REPLAY_MEMBER_FLOAT(_state, _value, _member) \
+   (_state)->_member = replay_float(replay_member(_value, #_member))
+
+
+/*
+ * Objects
+ */
+
+static unsigned
+replay_object_hash(void *key)
+{
+   uintptr_t ptr = (uintptr_t)key;
+   return (unsigned)(ptr >> 4) * 2654435761u;
+}
+
+
+static int
+replay_object_compare(void *key1, void *key2)
+{
+   return key1 != key2;
+}
+
+
+static struct replay_object *
+replay_object_find(struct replay *r, const struct replay_value *value)
+{
+   uint64_t key = replay_uint(value);
+
+   if (value->type != REPLAY_PTR || !key)
+      return NULL;
+
+   return util_hash_table_get(r->objects, (void *)(uintptr_t)key);
+}
+
+
+static void *
+replay_object(struct replay *r, const struct replay_value *value)
+{
+   struct replay_object *object = replay_object_find(r, value);
+   return object ? object->obj : NULL;
+}
+
+
+static void
+replay_object_release(struct replay *r, struct replay_object *object)
+{
+   switch (object->type) {
+   case REPLAY_OBJECT_CONTEXT:
+      {
+         struct replay_context *ctx = object->obj;
+         ctx->pipe->destroy(ctx->pipe);
+         if (r->ctx == ctx)
+            r->ctx = NULL;
+         FREE(ctx);
+      }
+      break;
+   case REPLAY_OBJECT_RESOURCE:
+      {
+         struct pipe_resource *resource = object->obj;
+         pipe_resource_reference(&resource, NULL);
+      }
+      break;
+   case REPLAY_OBJECT_SURFACE:
+      {
+         struct pipe_surface *surface = object->obj;
+         pipe_surface_reference(&surface, NULL);
+      }
+      break;
+   case REPLAY_OBJECT_SAMPLER_VIEW:
+      {
+         struct pipe_sampler_view *view = object->obj;
+         pipe_sampler_view_reference(&view, NULL);
+      }
+      break;
+   case REPLAY_OBJECT_SO_TARGET:
+      {
+         struct pipe_stream_output_target *target = object->obj;
+         pipe_so_target_reference(&target, NULL);
+      }
+      break;
+   case REPLAY_OBJECT_FENCE:
+      {
+         struct pipe_fence_handle *fence = object->obj;
+         r->screen->fence_reference(r->screen, &fence, NULL);
+      }
+      break;
+   case REPLAY_OBJECT_OTHER:
+      /* state objects and queries go away with their context */
+      break;
+   }
+}
+
+
+static void
+replay_object_remove(struct replay *r, struct replay_object *object)
+{
+   util_hash_table_remove(r->objects, (void *)(uintptr_t)object->key);
+   LIST_DEL(&object->head);
+   FREE(object);
+}
+
+
+/**
+ * Record the object a call returned.  The trace address may be reused once
+ * the previous object at it is gone, so that one is forgotten.
+ */
+static void
+replay_object_add(struct replay *r, const struct replay_value *value,
+                  enum replay_object_type type, void *obj)
+{
+   uint64_t key = replay_uint(value);
+   struct replay_object *object;
+
+   if (value->type != REPLAY_PTR || !key || !obj)
+      return;
+
+   object = util_hash_table_get(r->objects, (void *)(uintptr_t)key);
+   if (object) {
+      replay_object_release(r, object);
+      replay_object_remove(r, object);
+   }
+
+   object = CALLOC_STRUCT(replay_object);
+   object->key = key;
+   object->type = type;
+   object->ctx = type == REPLAY_OBJECT_CONTEXT ? obj : r->ctx;
+   object->obj = obj;
+   LIST_ADDTAIL(&object->head, &r->object_list);
+   util_hash_table_set(r->objects, (void *)(uintptr_t)key, object);
+}
+
+
+/**
+ * Forget an object destroyed by the trace, releasing our reference.
+ */
+static void
+replay_object_destroy(struct replay *r, const struct replay_value *value)
+{
+   struct replay_object *object = replay_object_find(r, value);
+
+   if (object) {
+      replay_object_release(r, object);
+      replay_object_remove(r, object);
+   }
+}
+
+
+/**
+ * Release the objects a context left behind, or all of them if ctx is NULL.
+ * Views and surfaces go before their context, and resources last.
+ */
+static void
+replay_release_objects(struct replay *r, struct replay_context *ctx)
+{
+   struct replay_object *object, *next;
+   unsigned pass;
+
+   for (pass = 0; pass < 3; ++pass) {
+      LIST_FOR_EACH_ENTRY_SAFE(object, next, &r->object_list, head) {
+         boolean is_context = object->type == REPLAY_OBJECT_CONTEXT;
+         boolean is_resource = object->type == REPLAY_OBJECT_RESOURCE;
+
+         if (ctx && object->ctx != ctx)
+            continue;
+         if (ctx && is_resource)
+            continue;
+         if ((pass == 0 && (is_context || is_resource)) ||
+             (pass == 1 && !is_context) ||
+             (pass == 2 && !is_resource))
+            continue;
+
+         replay_object_release(r, object);
+         replay_object_remove(r, object);
+      }
+   }
+}
+
+
+static struct pipe_context *
+replay_context(struct replay *r, const struct replay_call *call)
+{
+   const char *names[] = { "pipe", "context", "_pipe" };
+   unsigned i;
+
+   for (i = 0; i < Elements(names); ++i) {
+      struct replay_object *object =
+         replay_object_find(r, replay_arg(call, names[i]));
+      if (object && object->type == REPLAY_OBJECT_CONTEXT) {
+         r->ctx = object->obj;
+         return r->ctx->pipe;
+      }
+   }
+
+   return r->ctx ? r->ctx->pipe : NULL;
+}
+
+
+/*
+ * Timing
+ */
+
+static INLINE void
+replay_time_begin(struct replay *r)
+{
+   r->time_start = os_time_get_nano();
+}
+
+
+static INLINE void
+replay_time_end(struct replay *r)
+{
+   r->call_time += os_time_get_nano() - r->time_start;
+}
+
+
+/*
+ * State
+ */
+
+static void
+replay_resource_template(const struct replay_value *value,
+                         struct pipe_resource *templat)
+{
+   memset(templat, 0, sizeof *templat);
+   templat->target = replay_uint(replay_member(value, "target"));
+   templat->format = replay_format(replay_member(value, "format"));
+   templat->width0 = replay_uint(replay_member(value, "width"));
+   templat->height0 = replay_uint(replay_member(value, "height"));
+   templat->depth0 = replay_uint(replay_member(value, "depth"));
+   templat->array_size = replay_uint(replay_member(value, "array_size"));
+   REPLAY_MEMBER(templat, value, last_level);
+   REPLAY_MEMBER(templat, value, nr_samples);
+   REPLAY_MEMBER(templat, value, usage);
+   REPLAY_MEMBER(templat, value, bind);
+   REPLAY_MEMBER(templat, value, flags);
+}
+
+
+static void
+replay_box(const struct replay_value *value, struct pipe_box *box)
+{
+   REPLAY_MEMBER_INT(box, value, x);
+   REPLAY_MEMBER_INT(box, value, y);
+   REPLAY_MEMBER_INT(box, value, z);
+   REPLAY_MEMBER_INT(box, value, width);
+   REPLAY_MEMBER_INT(box, value, height);
+   REPLAY_MEMBER_INT(box, value, depth);
+}
+
+
+static void
+replay_rasterizer_state(const struct replay_value *value,
+                        struct pipe_rasterizer_state *state)
+{
+   memset(state, 0, sizeof *state);
+   REPLAY_MEMBER(state, value, flatshade);
+   REPLAY_MEMBER(state, value, light_twoside);
+   REPLAY_MEMBER(state, value, clamp_vertex_color);
+   REPLAY_MEMBER(state, value, clamp_fragment_color);
+   REPLAY_MEMBER(state, value, front_ccw);
+   REPLAY_MEMBER(state, value, cull_face);
+   REPLAY_MEMBER(state, value, fill_front);
+   REPLAY_MEMBER(state, value, fill_back);
+   REPLAY_MEMBER(state, value, offset_point);
+   REPLAY_MEMBER(state, value, offset_line);
+   REPLAY_MEMBER(state, value, offset_tri);
+   REPLAY_MEMBER(state, value, scissor);
+   REPLAY_MEMBER(state, value, poly_smooth);
+   REPLAY_MEMBER(state, value, poly_stipple_enable);
+   REPLAY_MEMBER(state, value, point_smooth);
+   REPLAY_MEMBER(state, value, sprite_coord_enable);
+   REPLAY_MEMBER(state, value, sprite_coord_mode);
+   REPLAY_MEMBER(state, value, point_quad_rasterization);
+   REPLAY_MEMBER(state, value, point_size_per_vertex);
+   REPLAY_MEMBER(state, value, multisample);
+   REPLAY_MEMBER(state, value, line_smooth);
+   REPLAY_MEMBER(state, value, line_stipple_enable);
+   REPLAY_MEMBER(state, value, line_stipple_factor);
+   REPLAY_MEMBER(state, value, line_stipple_pattern);
+   REPLAY_MEMBER(state, value, line_last_pixel);
+   REPLAY_MEMBER(state, value, flatshade_first);
+   REPLAY_MEMBER(state, value, gl_rasterization_rules);
+   REPLAY_MEMBER(state, value, rasterizer_discard);
+   REPLAY_MEMBER(state, value, depth_clip);
+   REPLAY_MEMBER(state, value, clip_plane_enable);
+   REPLAY_MEMBER_FLOAT(state, value, line_width);
+   REPLAY_MEMBER_FLOAT(state, value, point_size);
+   REPLAY_MEMBER_FLOAT(state, value, offset_units);
+   REPLAY_MEMBER_FLOAT(state, value, offset_scale);
+   REPLAY_MEMBER_FLOAT(state, value, offset_clamp);
+}
+
+
+static void
+replay_depth_stencil_alpha_state(const struct replay_value *value,
+                                 struct pipe_depth_stencil_alpha_state *state)
+{
+   const struct replay_value *depth = replay_member(value, "depth");
+   const struct replay_value *stencil = replay_member(value, "stencil");
+   const struct replay_value *alpha = replay_member(value, "alpha");
+   unsigned i;
+
+   memset(state, 0, sizeof *state);
+
+   REPLAY_MEMBER(&state->depth, depth, enabled);
+   REPLAY_MEMBER(&state->depth, depth, writemask);
+   REPLAY_MEMBER(&state->depth, depth, func);
+
+   for (i = 0; i < Elements(state->stencil); ++i) {
+      const struct replay_value *s = replay_elem(stencil, i);
+      REPLAY_MEMBER(&state->stencil[i], s, enabled);
+      REPLAY_MEMBER(&state->stencil[i], s, func);
+      REPLAY_MEMBER(&state->stencil[i], s, fail_op);
+      REPLAY_MEMBER(&state->stencil[i], s, zpass_op);
+      REPLAY_MEMBER(&state->stencil[i], s, zfail_op);
+      REPLAY_MEMBER(&state->stencil[i], s, valuemask);
+      REPLAY_MEMBER(&state->stencil[i], s, writemask);
+   }
+
+   REPLAY_MEMBER(&state->alpha, alpha, enabled);
+   REPLAY_MEMBER(&state->alpha, alpha, func);
+   REPLAY_MEMBER_FLOAT(&state->alpha, alpha, ref_value);
+}
+
+
+static void
+replay_blend_state(const struct replay_value *value,
+                   struct pipe_blend_state *state)
+{
+   const struct replay_value *rt = replay_member(value, "rt");
+   unsigned i;
+
+   memset(state, 0, sizeof *state);
+   REPLAY_MEMBER(state, value, dither);
+   REPLAY_MEMBER(state, value, logicop_enable);
+   REPLAY_MEMBER(state, value, logicop_func);
+   REPLAY_MEMBER(state, value, independent_blend_enable);
+
+   for (i = 0; i < Elements(state->rt) && i < rt->num; ++i) {
+      const struct replay_value *b = replay_elem(rt, i);
+      REPLAY_MEMBER(&state->rt[i], b, blend_enable);
+      REPLAY_MEMBER(&state->rt[i], b, rgb_func);
+      REPLAY_MEMBER(&state->rt[i], b, rgb_src_factor);
+      REPLAY_MEMBER(&state->rt[i], b, rgb_dst_factor);
+      REPLAY_MEMBER(&state->rt[i], b, alpha_func);
+      REPLAY_MEMBER(&state->rt[i], b, alpha_src_factor);
+      REPLAY_MEMBER(&state->rt[i], b, alpha_dst_factor);
+      REPLAY_MEMBER(&state->rt[i], b, colormask);
+   }
+}
+
+
+static void
+replay_sampler_state(const struct replay_value *value,
+                     struct pipe_sampler_state *state)
+{
+   memset(state, 0, sizeof *state);
+   REPLAY_MEMBER(state, value, wrap_s);
+   REPLAY_MEMBER(state, value, wrap_t);
+   REPLAY_MEMBER(state, value, wrap_r);
+   REPLAY_MEMBER(state, value, min_img_filter);
+   REPLAY_MEMBER(state, value, min_mip_filter);
+   REPLAY_MEMBER(state, value, mag_img_filter);
+   REPLAY_MEMBER(state, value, compare_mode);
+   REPLAY_MEMBER(state, value, compare_func);
+   REPLAY_MEMBER(state, value, normalized_coords);
+   REPLAY_MEMBER(state, value, max_anisotropy);
+   REPLAY_MEMBER_FLOAT(state, value, lod_bias);
+   REPLAY_MEMBER_FLOAT(state, value, min_lod);
+   REPLAY_MEMBER_FLOAT(state, value, max_lod);
+   replay_floats(replay_member(value, "border_color.f"),
+                 state->border_color.f, 4);
+}
+
+
+/**
+ * Create a shader from the TGSI text in the trace, substituting a
+ * passthrough shader if the text doesn't assemble.
+ */
+static void *
+replay_shader_state(struct replay *r, struct pipe_context *pipe,
+                    unsigned shader, const struct replay_value *value)
+{
+   const struct replay_value *tokens = replay_member(value, "tokens");
+   const struct replay_value *so = replay_member(value, "stream_output");
+   const struct replay_value *outputs = replay_member(so, "output");
+   struct pipe_shader_state state;
+   struct tgsi_token *buf = NULL;
+   void *result = NULL;
+   unsigned i;
+
+   memset(&state, 0, sizeof state);
+
+   if (tokens->type == REPLAY_STRING) {
+      /* No TGSI instruction is shorter than the tokens it assembles to */
+      unsigned num_tokens = tokens->num + 16;
+      buf = MALLOC(num_tokens * sizeof *buf);
+      if (buf && tgsi_text_translate(tokens->u.data, buf, num_tokens))
+         state.tokens = buf;
+   }
+
+   REPLAY_MEMBER(&state.stream_output, so, num_outputs);
+   for (i = 0; i < Elements(state.stream_output.stride); ++i)
+      state.stream_output.stride[i] =
+         replay_uint(replay_elem(replay_member(so, "stride"), i));
+   for (i = 0; i < state.stream_output.num_outputs &&
+               i < Elements(state.stream_output.output); ++i) {
+      const struct replay_value *output = replay_elem(outputs, i);
+      REPLAY_MEMBER(&state.stream_output.output[i], output, register_index);
+      REPLAY_MEMBER(&state.stream_output.output[i], output, start_component);
+      REPLAY_MEMBER(&state.stream_output.output[i], output, num_components);
+      REPLAY_MEMBER(&state.stream_output.output[i], output, output_buffer);
+      REPLAY_MEMBER(&state.stream_output.output[i], output, dst_offset);
+   }
+
+   if (state.tokens) {
+      replay_time_begin(r);
+      switch (shader) {
+      case PIPE_SHADER_VERTEX:
+         result = pipe->create_vs_state(pipe, &state);
+         break;
+      case PIPE_SHADER_FRAGMENT:
+         result = pipe->create_fs_state(pipe, &state);
+         break;
+      case PIPE_SHADER_GEOMETRY:
+         result = pipe->create_gs_state(pipe, &state);
+         break;
+      }
+      replay_time_end(r);
+   }
+   else {
+      static const uint semantic_names[] = { TGSI_SEMANTIC_POSITION };
+      static const uint semantic_indexes[] = { 0 };
+
+      fprintf(stderr, "warning: could not assemble shader, using a "
+              "passthrough shader instead\n");
+      if (shader == PIPE_SHADER_VERTEX)
+         result = util_make_vertex_passthrough_shader(pipe, 1, semantic_names,
+                                                      semantic_indexes);
+      else if (shader == PIPE_SHADER_FRAGMENT)
+         result = util_make_fragment_passthrough_shader(pipe,
+                                                        TGSI_SEMANTIC_COLOR,
+                                                        TGSI_INTERPOLATE_PERSPECTIVE);
+   }
+
+   FREE(buf);
+   return result;
+}
+
+
+/*
+ * Screen calls
+ */
+
+static void
+replay_context_create(struct replay *r, const struct replay_call *call)
+{
+   struct replay_context *ctx = CALLOC_STRUCT(replay_context);
+
+   replay_time_begin(r);
+   ctx->pipe = r->screen->context_create(r->screen, NULL);
+   replay_time_end(r);
+
+   if (!ctx->pipe) {
+      fprintf(stderr, "error: failed to create a context\n");
+      FREE(ctx);
+      return;
+   }
+
+   replay_object_add(r, &call->ret, REPLAY_OBJECT_CONTEXT, ctx);
+   r->ctx = ctx;
+}
+
+
+static void
+replay_resource_create(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_resource templat;
+   struct pipe_resource *resource;
+
+   replay_resource_template(replay_arg(call, "templat"), &templat);
+
+   /* There is no window system to share or display anything with */
+   templat.bind &= ~(PIPE_BIND_DISPLAY_TARGET | PIPE_BIND_SCANOUT |
+                     PIPE_BIND_SHARED);
+
+   replay_time_begin(r);
+   resource = r->screen->resource_create(r->screen, &templat);
+   replay_time_end(r);
+
+   if (!resource)
+      fprintf(stderr, "warning: call %u: failed to create a resource\n",
+              call->no);
+
+   replay_object_add(r, &call->ret, REPLAY_OBJECT_RESOURCE, resource);
+}
+
+
+static void
+replay_resource_destroy(struct replay *r, const struct replay_call *call)
+{
+   replay_time_begin(r);
+   replay_object_destroy(r, replay_arg(call, "resource"));
+   replay_time_end(r);
+}
+
+
+static void
+replay_fence_finish(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_fence_handle *fence = replay_object(r, replay_arg(call, "fence"));
+
+   if (fence) {
+      replay_time_begin(r);
+      r->screen->fence_finish(r->screen, fence, PIPE_TIMEOUT_INFINITE);
+      replay_time_end(r);
+   }
+}
+
+
+/**
+ * The end of a frame.  Without a window system there is nothing to present
+ * to, so wait for the rendering instead.
+ */
+static void
+replay_flush_frontbuffer(struct replay *r, const struct replay_call *call)
+{
+   if (r->ctx) {
+      struct pipe_context *pipe = r->ctx->pipe;
+      struct pipe_fence_handle *fence = NULL;
+
+      replay_time_begin(r);
+      pipe->flush(pipe, &fence, 0);
+      if (fence) {
+         r->screen->fence_finish(r->screen, fence, PIPE_TIMEOUT_INFINITE);
+         r->screen->fence_reference(r->screen, &fence, NULL);
+      }
+      replay_time_end(r);
+   }
+}
+
+
+/*
+ * Context calls
+ */
+
+static void
+replay_destroy(struct replay *r, const struct replay_call *call)
+{
+   struct replay_object *object = replay_object_find(r, replay_arg(call, "pipe"));
+
+   if (object && object->type == REPLAY_OBJECT_CONTEXT) {
+      replay_time_begin(r);
+      replay_release_objects(r, object->obj);
+      replay_time_end(r);
+   }
+}
+
+
+static void
+replay_draw_vbo(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct replay_value *value = replay_arg(call, "info");
+   struct pipe_draw_info info;
+
+   if (!pipe)
+      return;
+
+   memset(&info, 0, sizeof info);
+   REPLAY_MEMBER(&info, value, indexed);
+   REPLAY_MEMBER(&info, value, mode);
+   REPLAY_MEMBER(&info, value, start);
+   REPLAY_MEMBER(&info, value, count);
+   REPLAY_MEMBER(&info, value, start_instance);
+   REPLAY_MEMBER(&info, value, instance_count);
+   REPLAY_MEMBER_INT(&info, value, index_bias);
+   REPLAY_MEMBER(&info, value, min_index);
+   REPLAY_MEMBER(&info, value, max_index);
+   REPLAY_MEMBER(&info, value, primitive_restart);
+   REPLAY_MEMBER(&info, value, restart_index);
+   info.count_from_stream_output =
+      replay_object(r, replay_member(value, "count_from_stream_output"));
+
+   if (r->ctx->user_vertex_buffers ||
+       (info.indexed && r->ctx->user_index_buffer)) {
+      ++r->skipped_draws;
+      return;
+   }
+
+   replay_time_begin(r);
+   pipe->draw_vbo(pipe, &info);
+   replay_time_end(r);
+}
+
+
+static void
+replay_create_query(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_query *query;
+
+   if (!pipe)
+      return;
+
+   replay_time_begin(r);
+   query = pipe->create_query(pipe, replay_uint(replay_arg(call, "query_type")));
+   replay_time_end(r);
+
+   replay_object_add(r, &call->ret, REPLAY_OBJECT_OTHER, query);
+}
+
+
+static void
+replay_destroy_query(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct replay_object *object = replay_object_find(r, replay_arg(call, "query"));
+
+   if (!pipe || !object)
+      return;
+
+   replay_time_begin(r);
+   pipe->destroy_query(pipe, object->obj);
+   replay_time_end(r);
+
+   replay_object_remove(r, object);
+}
+
+
+static void
+replay_begin_query(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_query *query = replay_object(r, replay_arg(call, "query"));
+
+   if (!pipe || !query)
+      return;
+
+   replay_time_begin(r);
+   pipe->begin_query(pipe, query);
+   replay_time_end(r);
+}
+
+
+static void
+replay_end_query(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_query *query = replay_object(r, replay_arg(call, "query"));
+
+   if (!pipe || !query)
+      return;
+
+   replay_time_begin(r);
+   pipe->end_query(pipe, query);
+   replay_time_end(r);
+}
+
+
+static void
+replay_get_query_result(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_query *query = replay_object(r, replay_arg(call, "query"));
+   union pipe_query_result result;
+
+   /* Older traces don't say which query was waited for */
+   if (!pipe || !query)
+      return;
+
+   replay_time_begin(r);
+   pipe->get_query_result(pipe, query,
+                          replay_uint(replay_arg(call, "wait")), &result);
+   replay_time_end(r);
+}
+
+
+static void
+replay_render_condition(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+
+   if (!pipe)
+      return;
+
+   replay_time_begin(r);
+   pipe->render_condition(pipe, replay_object(r, replay_arg(call, "query")),
+                          replay_uint(replay_arg(call, "mode")));
+   replay_time_end(r);
+}
+
+
+static void
+replay_create_state(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct replay_value *value = replay_arg(call, "state");
+   void *result = NULL;
+
+   if (!pipe)
+      return;
+
+   if (strcmp(call->method, "create_blend_state") == 0) {
+      struct pipe_blend_state state;
+      replay_blend_state(value, &state);
+      replay_time_begin(r);
+      result = pipe->create_blend_state(pipe, &state);
+      replay_time_end(r);
+   }
+   else if (strcmp(call->method, "create_sampler_state") == 0) {
+      struct pipe_sampler_state state;
+      replay_sampler_state(value, &state);
+      replay_time_begin(r);
+      result = pipe->create_sampler_state(pipe, &state);
+      replay_time_end(r);
+   }
+   else if (strcmp(call->method, "create_rasterizer_state") == 0) {
+      struct pipe_rasterizer_state state;
+      replay_rasterizer_state(value, &state);
+      replay_time_begin(r);
+      result = pipe->create_rasterizer_state(pipe, &state);
+      replay_time_end(r);
+   }
+   else if (strcmp(call->method, "create_depth_stencil_alpha_state") == 0) {
+      struct pipe_depth_stencil_alpha_state state;
+      replay_depth_stencil_alpha_state(value, &state);
+      replay_time_begin(r);
+      result = pipe->create_depth_stencil_alpha_state(pipe, &state);
+      replay_time_end(r);
+   }
+   else if (strcmp(call->method, "create_vs_state") == 0) {
+      result = replay_shader_state(r, pipe, PIPE_SHADER_VERTEX, value);
+   }
+   else if (strcmp(call->method, "create_fs_state") == 0) {
+      result = replay_shader_state(r, pipe, PIPE_SHADER_FRAGMENT, value);
+   }
+   else if (strcmp(call->method, "create_gs_state") == 0) {
+      result = replay_shader_state(r, pipe, PIPE_SHADER_GEOMETRY, value);
+   }
+   else if (strcmp(call->method, "create_vertex_elements_state") == 0) {
+      const struct replay_value *elements = replay_arg(call, "elements");
+      struct pipe_vertex_element velems[PIPE_MAX_ATTRIBS];
+      unsigned num = MIN2(elements->num, PIPE_MAX_ATTRIBS);
+      unsigned i;
+
+      memset(velems, 0, sizeof velems);
+      for (i = 0; i < num; ++i) {
+         const struct replay_value *elem = replay_elem(elements, i);
+         REPLAY_MEMBER(&velems[i], elem, src_offset);
+         REPLAY_MEMBER(&velems[i], elem, instance_divisor);
+         REPLAY_MEMBER(&velems[i], elem, vertex_buffer_index);
+         velems[i].src_format = replay_format(replay_member(elem, "src_format"));
+      }
+
+      replay_time_begin(r);
+      result = pipe->create_vertex_elements_state(pipe, num, velems);
+      replay_time_end(r);
+   }
+
+   replay_object_add(r, &call->ret, REPLAY_OBJECT_OTHER, result);
+}
+
+
+static void
+replay_bind_state(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   void *state = replay_object(r, replay_arg(call, "state"));
+   void (*bind)(struct pipe_context *, void *) = NULL;
+
+   if (!pipe)
+      return;
+
+   if (strcmp(call->method, "bind_blend_state") == 0)
+      bind = pipe->bind_blend_state;
+   else if (strcmp(call->method, "bind_rasterizer_state") == 0)
+      bind = pipe->bind_rasterizer_state;
+   else if (strcmp(call->method, "bind_depth_stencil_alpha_state") == 0)
+      bind = pipe->bind_depth_stencil_alpha_state;
+   else if (strcmp(call->method, "bind_vs_state") == 0)
+      bind = pipe->bind_vs_state;
+   else if (strcmp(call->method, "bind_fs_state") == 0)
+      bind = pipe->bind_fs_state;
+   else if (strcmp(call->method, "bind_gs_state") == 0)
+      bind = pipe->bind_gs_state;
+   else if (strcmp(call->method, "bind_vertex_elements_state") == 0)
+      bind = pipe->bind_vertex_elements_state;
+
+   if (bind) {
+      replay_time_begin(r);
+      bind(pipe, state);
+      replay_time_end(r);
+   }
+}
+
+
+static void
+replay_delete_state(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct replay_object *object = replay_object_find(r, replay_arg(call, "state"));
+   void (*delete)(struct pipe_context *, void *) = NULL;
+
+   if (!pipe || !object)
+      return;
+
+   if (strcmp(call->method, "delete_blend_state") == 0)
+      delete = pipe->delete_blend_state;
+   else if (strcmp(call->method, "delete_sampler_state") == 0)
+      delete = pipe->delete_sampler_state;
+   else if (strcmp(call->method, "delete_rasterizer_state") == 0)
+      delete = pipe->delete_rasterizer_state;
+   else if (strcmp(call->method, "delete_depth_stencil_alpha_state") == 0)
+      delete = pipe->delete_depth_stencil_alpha_state;
+   else if (strcmp(call->method, "delete_vs_state") == 0)
+      delete = pipe->delete_vs_state;
+   else if (strcmp(call->method, "delete_fs_state") == 0)
+      delete = pipe->delete_fs_state;
+   else if (strcmp(call->method, "delete_gs_state") == 0)
+      delete = pipe->delete_gs_state;
+   else if (strcmp(call->method, "delete_vertex_elements_state") == 0)
+      delete = pipe->delete_vertex_elements_state;
+
+   if (delete) {
+      replay_time_begin(r);
+      delete(pipe, object->obj);
+      replay_time_end(r);
+   }
+
+   replay_object_remove(r, object);
+}
+
+
+static void
+replay_bind_sampler_states(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct replay_value *states = replay_arg(call, "states");
+   void *samplers[PIPE_MAX_SAMPLERS];
+   unsigned num = MIN2(replay_uint(replay_arg(call, "num_states")),
+                       PIPE_MAX_SAMPLERS);
+   unsigned i;
+
+   if (!pipe)
+      return;
+
+   for (i = 0; i < num; ++i)
+      samplers[i] = replay_object(r, replay_elem(states, i));
+
+   replay_time_begin(r);
+   if (strcmp(call->method, "bind_vertex_sampler_states") == 0)
+      pipe->bind_vertex_sampler_states(pipe, num, samplers);
+   else if (strcmp(call->method, "bind_geometry_sampler_states") == 0)
+      pipe->bind_geometry_sampler_states(pipe, num, samplers);
+   else
+      pipe->bind_fragment_sampler_states(pipe, num, samplers);
+   replay_time_end(r);
+}
+
+
+static void
+replay_set_sampler_views(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct replay_value *views = replay_arg(call, "views");
+   struct pipe_sampler_view *unwrapped[PIPE_MAX_SAMPLERS];
+   unsigned num = MIN2(replay_uint(replay_arg(call, "num")),
+                       PIPE_MAX_SAMPLERS);
+   unsigned i;
+
+   if (!pipe)
+      return;
+
+   for (i = 0; i < num; ++i)
+      unwrapped[i] = replay_object(r, replay_elem(views, i));
+
+   replay_time_begin(r);
+   if (strcmp(call->method, "set_vertex_sampler_views") == 0)
+      pipe->set_vertex_sampler_views(pipe, num, unwrapped);
+   else if (strcmp(call->method, "set_geometry_sampler_views") == 0)
+      pipe->set_geometry_sampler_views(pipe, num, unwrapped);
+   else
+      pipe->set_fragment_sampler_views(pipe, num, unwrapped);
+   replay_time_end(r);
+}
+
+
+static void
+replay_set_blend_color(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_blend_color state;
+
+   if (!pipe)
+      return;
+
+   replay_floats(replay_member(replay_arg(call, "state"), "color"),
+                 state.color, 4);
+
+   replay_time_begin(r);
+   pipe->set_blend_color(pipe, &state);
+   replay_time_end(r);
+}
+
+
+static void
+replay_set_stencil_ref(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct replay_value *ref =
+      replay_member(replay_arg(call, "state"), "ref_value");
+   struct pipe_stencil_ref state;
+
+   if (!pipe)
+      return;
+
+   state.ref_value[0] = replay_uint(replay_elem(ref, 0));
+   state.ref_value[1] = replay_uint(replay_elem(ref, 1));
+
+   replay_time_begin(r);
+   pipe->set_stencil_ref(pipe, &state);
+   replay_time_end(r);
+}
+
+
+static void
+replay_set_clip_state(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct replay_value *ucp =
+      replay_member(replay_arg(call, "state"), "ucp");
+   struct pipe_clip_state state;
+   unsigned i;
+
+   if (!pipe)
+      return;
+
+   for (i = 0; i < PIPE_MAX_CLIP_PLANES; ++i)
+      replay_floats(replay_elem(ucp, i), state.ucp[i], 4);
+
+   replay_time_begin(r);
+   pipe->set_clip_state(pipe, &state);
+   replay_time_end(r);
+}
+
+
+static void
+replay_set_sample_mask(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+
+   if (!pipe)
+      return;
+
+   replay_time_begin(r);
+   pipe->set_sample_mask(pipe, replay_uint(replay_arg(call, "sample_mask")));
+   replay_time_end(r);
+}
+
+
+static void
+replay_set_constant_buffer(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct replay_value *value = replay_arg(call, "constant_buffer");
+   const struct replay_value *user_buffer = replay_member(value, "user_buffer");
+   struct pipe_constant_buffer cb;
+
+   if (!pipe)
+      return;
+
+   memset(&cb, 0, sizeof cb);
+   cb.buffer = replay_object(r, replay_member(value, "buffer"));
+   REPLAY_MEMBER(&cb, value, buffer_offset);
+   REPLAY_MEMBER(&cb, value, buffer_size);
+   if (user_buffer->type == REPLAY_BYTES)
+      cb.user_buffer = user_buffer->u.data;
+
+   replay_time_begin(r);
+   pipe->set_constant_buffer(pipe,
+                             replay_uint(replay_arg(call, "shader")),
+                             replay_uint(replay_arg(call, "index")),
+                             value->type == REPLAY_NULL ? NULL : &cb);
+   replay_time_end(r);
+}
+
+
+static void
+replay_set_framebuffer_state(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct replay_value *value = replay_arg(call, "state");
+   const struct replay_value *cbufs = replay_member(value, "cbufs");
+   struct pipe_framebuffer_state state;
+   unsigned i;
+
+   if (!pipe)
+      return;
+
+   memset(&state, 0, sizeof state);
+   REPLAY_MEMBER(&state, value, width);
+   REPLAY_MEMBER(&state, value, height);
+   REPLAY_MEMBER(&state, value, nr_cbufs);
+   state.nr_cbufs = MIN2(state.nr_cbufs, PIPE_MAX_COLOR_BUFS);
+   for (i = 0; i < state.nr_cbufs; ++i)
+      state.cbufs[i] = replay_object(r, replay_elem(cbufs, i));
+   state.zsbuf = replay_object(r, replay_member(value, "zsbuf"));
+
+   replay_time_begin(r);
+   pipe->set_framebuffer_state(pipe, &state);
+   replay_time_end(r);
+}
+
+
+static void
+replay_set_polygon_stipple(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct replay_value *stipple =
+      replay_member(replay_arg(call, "state"), "stipple");
+   struct pipe_poly_stipple state;
+   unsigned i;
+
+   if (!pipe)
+      return;
+
+   for (i = 0; i < Elements(state.stipple); ++i)
+      state.stipple[i] = replay_uint(replay_elem(stipple, i));
+
+   replay_time_begin(r);
+   pipe->set_polygon_stipple(pipe, &state);
+   replay_time_end(r);
+}
+
+
+static void
+replay_set_scissor_state(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct replay_value *value = replay_arg(call, "state");
+   struct pipe_scissor_state state;
+
+   if (!pipe)
+      return;
+
+   REPLAY_MEMBER(&state, value, minx);
+   REPLAY_MEMBER(&state, value, miny);
+   REPLAY_MEMBER(&state, value, maxx);
+   REPLAY_MEMBER(&state, value, maxy);
+
+   replay_time_begin(r);
+   pipe->set_scissor_state(pipe, &state);
+   replay_time_end(r);
+}
+
+
+static void
+replay_set_viewport_state(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct replay_value *value = replay_arg(call, "state");
+   struct pipe_viewport_state state;
+
+   if (!pipe)
+      return;
+
+   replay_floats(replay_member(value, "scale"), state.scale, 4);
+   replay_floats(replay_member(value, "translate"), state.translate, 4);
+
+   replay_time_begin(r);
+   pipe->set_viewport_state(pipe, &state);
+   replay_time_end(r);
+}
+
+
+static void
+replay_create_sampler_view(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_resource *resource = replay_object(r, replay_arg(call, "resource"));
+   const struct replay_value *value = replay_arg(call, "templ");
+   const struct replay_value *u = replay_member(value, "u");
+   const struct replay_value *buf = replay_member(u, "buf");
+   const struct replay_value *tex = replay_member(u, "tex");
+   struct pipe_sampler_view templ;
+   struct pipe_sampler_view *view;
+
+   if (!pipe || !resource)
+      return;
+
+   memset(&templ, 0, sizeof templ);
+   templ.format = replay_format(replay_member(value, "format"));
+   if (buf->type == REPLAY_STRUCT) {
+      REPLAY_MEMBER(&templ.u.buf, buf, first_element);
+      REPLAY_MEMBER(&templ.u.buf, buf, last_element);
+   }
+   else {
+      REPLAY_MEMBER(&templ.u.tex, tex, first_layer);
+      REPLAY_MEMBER(&templ.u.tex, tex, last_layer);
+      REPLAY_MEMBER(&templ.u.tex, tex, first_level);
+      REPLAY_MEMBER(&templ.u.tex, tex, last_level);
+   }
+   REPLAY_MEMBER(&templ, value, swizzle_r);
+   REPLAY_MEMBER(&templ, value, swizzle_g);
+   REPLAY_MEMBER(&templ, value, swizzle_b);
+   REPLAY_MEMBER(&templ, value, swizzle_a);
+
+   replay_time_begin(r);
+   view = pipe->create_sampler_view(pipe, resource, &templ);
+   replay_time_end(r);
+
+   replay_object_add(r, &call->ret, REPLAY_OBJECT_SAMPLER_VIEW, view);
+}
+
+
+static void
+replay_create_surface(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_resource *resource = replay_object(r, replay_arg(call, "resource"));
+   const struct replay_value *value = replay_arg(call, "surf_tmpl");
+   const struct replay_value *u = replay_member(value, "u");
+   const struct replay_value *buf = replay_member(u, "buf");
+   const struct replay_value *tex = replay_member(u, "tex");
+   struct pipe_surface templ;
+   struct pipe_surface *surface;
+
+   if (!pipe || !resource)
+      return;
+
+   memset(&templ, 0, sizeof templ);
+   templ.format = replay_format(replay_member(value, "format"));
+   REPLAY_MEMBER(&templ, value, width);
+   REPLAY_MEMBER(&templ, value, height);
+   if (buf->type == REPLAY_STRUCT) {
+      REPLAY_MEMBER(&templ.u.buf, buf, first_element);
+      REPLAY_MEMBER(&templ.u.buf, buf, last_element);
+   }
+   else {
+      REPLAY_MEMBER(&templ.u.tex, tex, level);
+      REPLAY_MEMBER(&templ.u.tex, tex, first_layer);
+      REPLAY_MEMBER(&templ.u.tex, tex, last_layer);
+   }
+
+   replay_time_begin(r);
+   surface = pipe->create_surface(pipe, resource, &templ);
+   replay_time_end(r);
+
+   replay_object_add(r, &call->ret, REPLAY_OBJECT_SURFACE, surface);
+}
+
+
+static void
+replay_object_destroy_call(struct replay *r, const struct replay_call *call)
+{
+   const char *names[] = { "view", "surface", "target" };
+   unsigned i;
+
+   replay_context(r, call);
+
+   for (i = 0; i < Elements(names); ++i) {
+      const struct replay_value *value = replay_arg(call, names[i]);
+      if (value->type == REPLAY_PTR) {
+         replay_time_begin(r);
+         replay_object_destroy(r, value);
+         replay_time_end(r);
+      }
+   }
+}
+
+
+static void
+replay_set_vertex_buffers(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct replay_value *buffers = replay_arg(call, "buffers");
+   struct pipe_vertex_buffer vbs[PIPE_MAX_ATTRIBS];
+   unsigned start_slot = replay_uint(replay_arg(call, "start_slot"));
+   unsigned num = replay_uint(replay_arg(call, "num_buffers"));
+   unsigned i;
+
+   if (!pipe || start_slot + num > PIPE_MAX_ATTRIBS)
+      return;
+
+   for (i = 0; i < num; ++i) {
+      const struct replay_value *vb = replay_elem(buffers, i);
+      unsigned slot = 1u << (start_slot + i);
+
+      memset(&vbs[i], 0, sizeof vbs[i]);
+      REPLAY_MEMBER(&vbs[i], vb, stride);
+      REPLAY_MEMBER(&vbs[i], vb, buffer_offset);
+      vbs[i].buffer = replay_object(r, replay_member(vb, "buffer"));
+
+      if (replay_uint(replay_member(vb, "user_buffer")))
+         r->ctx->user_vertex_buffers |= slot;
+      else
+         r->ctx->user_vertex_buffers &= ~slot;
+   }
+
+   replay_time_begin(r);
+   pipe->set_vertex_buffers(pipe, start_slot, num,
+                            buffers->type == REPLAY_NULL ? NULL : vbs);
+   replay_time_end(r);
+
+   if (buffers->type == REPLAY_NULL)
+      r->ctx->user_vertex_buffers &= ~(((1u << num) - 1) << start_slot);
+}
+
+
+static void
+replay_set_index_buffer(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct replay_value *value = replay_arg(call, "ib");
+   struct pipe_index_buffer ib;
+
+   if (!pipe)
+      return;
+
+   memset(&ib, 0, sizeof ib);
+   REPLAY_MEMBER(&ib, value, index_size);
+   REPLAY_MEMBER(&ib, value, offset);
+   ib.buffer = replay_object(r, replay_member(value, "buffer"));
+   r->ctx->user_index_buffer =
+      replay_uint(replay_member(value, "user_buffer")) != 0;
+
+   replay_time_begin(r);
+   pipe->set_index_buffer(pipe, value->type == REPLAY_NULL ? NULL : &ib);
+   replay_time_end(r);
+}
+
+
+static void
+replay_create_stream_output_target(struct replay *r,
+                                   const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_resource *res = replay_object(r, replay_arg(call, "res"));
+   struct pipe_stream_output_target *target;
+
+   if (!pipe || !res)
+      return;
+
+   replay_time_begin(r);
+   target = pipe->create_stream_output_target(pipe, res,
+                                              replay_uint(replay_arg(call, "buffer_offset")),
+                                              replay_uint(replay_arg(call, "buffer_size")));
+   replay_time_end(r);
+
+   replay_object_add(r, &call->ret, REPLAY_OBJECT_SO_TARGET, target);
+}
+
+
+static void
+replay_set_stream_output_targets(struct replay *r,
+                                 const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct replay_value *tgs = replay_arg(call, "tgs");
+   struct pipe_stream_output_target *targets[PIPE_MAX_SO_BUFFERS];
+   unsigned num = MIN2(replay_uint(replay_arg(call, "num_targets")),
+                       PIPE_MAX_SO_BUFFERS);
+   unsigned i;
+
+   if (!pipe)
+      return;
+
+   for (i = 0; i < num; ++i)
+      targets[i] = replay_object(r, replay_elem(tgs, i));
+
+   replay_time_begin(r);
+   pipe->set_stream_output_targets(pipe, num, targets,
+                                   replay_uint(replay_arg(call, "append_bitmask")));
+   replay_time_end(r);
+}
+
+
+static void
+replay_resource_copy_region(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_resource *dst = replay_object(r, replay_arg(call, "dst"));
+   struct pipe_resource *src = replay_object(r, replay_arg(call, "src"));
+   struct pipe_box box;
+
+   if (!pipe || !dst || !src)
+      return;
+
+   replay_box(replay_arg(call, "src_box"), &box);
+
+   replay_time_begin(r);
+   pipe->resource_copy_region(pipe,
+                              dst, replay_uint(replay_arg(call, "dst_level")),
+                              replay_uint(replay_arg(call, "dstx")),
+                              replay_uint(replay_arg(call, "dsty")),
+                              replay_uint(replay_arg(call, "dstz")),
+                              src, replay_uint(replay_arg(call, "src_level")),
+                              &box);
+   replay_time_end(r);
+}
+
+
+static void
+replay_blit(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   const struct replay_value *value = replay_arg(call, "_info");
+   const struct replay_value *dst = replay_member(value, "dst");
+   const struct replay_value *src = replay_member(value, "src");
+   const struct replay_value *mask = replay_member(value, "mask");
+   struct pipe_blit_info info;
+
+   if (!pipe)
+      return;
+
+   memset(&info, 0, sizeof info);
+   info.dst.resource = replay_object(r, replay_member(dst, "resource"));
+   info.dst.level = replay_uint(replay_member(dst, "level"));
+   info.dst.format = replay_format(replay_member(dst, "format"));
+   replay_box(replay_member(dst, "box"), &info.dst.box);
+   info.src.resource = replay_object(r, replay_member(src, "resource"));
+   info.src.level = replay_uint(replay_member(src, "level"));
+   info.src.format = replay_format(replay_member(src, "format"));
+   replay_box(replay_member(src, "box"), &info.src.box);
+
+   if (mask->type == REPLAY_STRING) {
+      const char *m = mask->u.data;
+      if (strchr(m, 'R')) info.mask |= PIPE_MASK_R;
+      if (strchr(m, 'G')) info.mask |= PIPE_MASK_G;
+      if (strchr(m, 'B')) info.mask |= PIPE_MASK_B;
+      if (strchr(m, 'A')) info.mask |= PIPE_MASK_A;
+      if (strchr(m, 'Z')) info.mask |= PIPE_MASK_Z;
+      if (strchr(m, 'S')) info.mask |= PIPE_MASK_S;
+   }
+
+   REPLAY_MEMBER(&info, value, filter);
+   REPLAY_MEMBER(&info, value, scissor_enable);
+   if (info.scissor_enable) {
+      const struct replay_value *scissor = replay_member(value, "scissor");
+      REPLAY_MEMBER(&info.scissor, scissor, minx);
+      REPLAY_MEMBER(&info.scissor, scissor, miny);
+      REPLAY_MEMBER(&info.scissor, scissor, maxx);
+      REPLAY_MEMBER(&info.scissor, scissor, maxy);
+   }
+
+   if (!info.dst.resource || !info.src.resource)
+      return;
+
+   replay_time_begin(r);
+   pipe->blit(pipe, &info);
+   replay_time_end(r);
+}
+
+
+static void
+replay_clear(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   union pipe_color_union color;
+
+   if (!pipe)
+      return;
+
+   replay_floats(replay_arg(call, "color"), color.f, 4);
+
+   replay_time_begin(r);
+   pipe->clear(pipe, replay_uint(replay_arg(call, "buffers")), &color,
+               replay_float(replay_arg(call, "depth")),
+               replay_uint(replay_arg(call, "stencil")));
+   replay_time_end(r);
+}
+
+
+static void
+replay_clear_render_target(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_surface *dst = replay_object(r, replay_arg(call, "dst"));
+   union pipe_color_union color;
+
+   if (!pipe || !dst)
+      return;
+
+   replay_floats(replay_arg(call, "color->f"), color.f, 4);
+
+   replay_time_begin(r);
+   pipe->clear_render_target(pipe, dst, &color,
+                             replay_uint(replay_arg(call, "dstx")),
+                             replay_uint(replay_arg(call, "dsty")),
+                             replay_uint(replay_arg(call, "width")),
+                             replay_uint(replay_arg(call, "height")));
+   replay_time_end(r);
+}
+
+
+static void
+replay_clear_depth_stencil(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_surface *dst = replay_object(r, replay_arg(call, "dst"));
+
+   if (!pipe || !dst)
+      return;
+
+   replay_time_begin(r);
+   pipe->clear_depth_stencil(pipe, dst,
+                             replay_uint(replay_arg(call, "clear_flags")),
+                             replay_float(replay_arg(call, "depth")),
+                             replay_uint(replay_arg(call, "stencil")),
+                             replay_uint(replay_arg(call, "dstx")),
+                             replay_uint(replay_arg(call, "dsty")),
+                             replay_uint(replay_arg(call, "width")),
+                             replay_uint(replay_arg(call, "height")));
+   replay_time_end(r);
+}
+
+
+static void
+replay_flush(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_fence_handle *fence = NULL;
+
+   if (!pipe)
+      return;
+
+   replay_time_begin(r);
+   pipe->flush(pipe, call->ret.type == REPLAY_PTR ? &fence : NULL,
+               replay_uint(replay_arg(call, "flags")));
+   replay_time_end(r);
+
+   replay_object_add(r, &call->ret, REPLAY_OBJECT_FENCE, fence);
+}
+
+
+static void
+replay_transfer_inline_write(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+   struct pipe_resource *resource = replay_object(r, replay_arg(call, "resource"));
+   const struct replay_value *data = replay_arg(call, "data");
+   struct pipe_box box;
+
+   if (!pipe || !resource || data->type != REPLAY_BYTES)
+      return;
+
+   replay_box(replay_arg(call, "box"), &box);
+
+   replay_time_begin(r);
+   pipe->transfer_inline_write(pipe, resource,
+                               replay_uint(replay_arg(call, "level")),
+                               replay_uint(replay_arg(call, "usage")),
+                               &box, data->u.data,
+                               replay_uint(replay_arg(call, "stride")),
+                               replay_uint(replay_arg(call, "layer_stride")));
+   replay_time_end(r);
+}
+
+
+static void
+replay_texture_barrier(struct replay *r, const struct replay_call *call)
+{
+   struct pipe_context *pipe = replay_context(r, call);
+
+   if (!pipe)
+      return;
+
+   replay_time_begin(r);
+   pipe->texture_barrier(pipe);
+   replay_time_end(r);
+}
+
+
+static const struct replay_method replay_methods[] = {
+   { "pipe_screen", "context_create", replay_context_create },
+   { "pipe_screen", "resource_create", replay_resource_create },
+   { "pipe_screen", "resource_destroy", replay_resource_destroy },
+   { "pipe_screen", "fence_finish", replay_fence_finish },
+   { "pipe_screen", "flush_frontbuffer", replay_flush_frontbuffer },
+   { "pipe_screen", "destroy", NULL },
+   { "pipe_screen", "fence_reference", NULL },
+   { "pipe_screen", "fence_signalled", NULL },
+   { "pipe_screen", "get_name", NULL },
+   { "pipe_screen", "get_vendor", NULL },
+   { "pipe_screen", "get_param", NULL },
+   { "pipe_screen", "get_paramf", NULL },
+   { "pipe_screen", "get_shader_param", NULL },
+   { "pipe_screen", "get_timestamp", NULL },
+   { "pipe_screen", "is_format_supported", NULL },
+   { "", "pipe_screen_create", NULL },
+   { "pipe_context", "destroy", replay_destroy },
+   { "pipe_context", "draw_vbo", replay_draw_vbo },
+   { "pipe_context", "create_query", replay_create_query },
+   { "pipe_context", "destroy_query", replay_destroy_query },
+   { "pipe_context", "begin_query", replay_begin_query },
+   { "pipe_context", "end_query", replay_end_query },
+   { "pipe_context", "get_query_result", replay_get_query_result },
+   { "pipe_context", "render_condition", replay_render_condition },
+   { "pipe_context", "create_blend_state", replay_create_state },
+   { "pipe_context", "bind_blend_state", replay_bind_state },
+   { "pipe_context", "delete_blend_state", replay_delete_state },
+   { "pipe_context", "create_sampler_state", replay_create_state },
+   { "pipe_context", "bind_fragment_sampler_states", replay_bind_sampler_states },
+   { "pipe_context", "bind_vertex_sampler_states", replay_bind_sampler_states },
+   { "pipe_context", "bind_geometry_sampler_states", replay_bind_sampler_states },
+   { "pipe_context", "delete_sampler_state", replay_delete_state },
+   { "pipe_context", "create_rasterizer_state", replay_create_state },
+   { "pipe_context", "bind_rasterizer_state", replay_bind_state },
+   { "pipe_context", "delete_rasterizer_state", replay_delete_state },
+   { "pipe_context", "create_depth_stencil_alpha_state", replay_create_state },
+   { "pipe_context", "bind_depth_stencil_alpha_state", replay_bind_state },
+   { "pipe_context", "delete_depth_stencil_alpha_state", replay_delete_state },
+   { "pipe_context", "create_fs_state", replay_create_state },
+   { "pipe_context", "bind_fs_state", replay_bind_state },
+   { "pipe_context", "delete_fs_state", replay_delete_state },
+   { "pipe_context", "create_vs_state", replay_create_state },
+   { "pipe_context", "bind_vs_state", replay_bind_state },
+   { "pipe_context", "delete_vs_state", replay_delete_state },
+   { "pipe_context", "create_gs_state", replay_create_state },
+   { "pipe_context", "bind_gs_state", replay_bind_state },
+   { "pipe_context", "delete_gs_state", replay_delete_state },
+   { "pipe_context", "create_vertex_elements_state", replay_create_state },
+   { "pipe_context", "bind_vertex_elements_state", replay_bind_state },
+   { "pipe_context", "delete_vertex_elements_state", replay_delete_state },
+   { "pipe_context", "set_blend_color", replay_set_blend_color },
+   { "pipe_context", "set_stencil_ref", replay_set_stencil_ref },
+   { "pipe_context", "set_clip_state", replay_set_clip_state },
+   { "pipe_context", "set_sample_mask", replay_set_sample_mask },
+   { "pipe_context", "set_constant_buffer", replay_set_constant_buffer },
+   { "pipe_context", "set_framebuffer_state", replay_set_framebuffer_state },
+   { "pipe_context", "set_polygon_stipple", replay_set_polygon_stipple },
+   { "pipe_context", "set_scissor_state", replay_set_scissor_state },
+   { "pipe_context", "set_viewport_state", replay_set_viewport_state },
+   { "pipe_context", "create_sampler_view", replay_create_sampler_view },
+   { "pipe_context", "sampler_view_destroy", replay_object_destroy_call },
+   { "pipe_context", "create_surface", replay_create_surface },
+   { "pipe_context", "surface_destroy", replay_object_destroy_call },
+   { "pipe_context", "set_fragment_sampler_views", replay_set_sampler_views },
+   { "pipe_context", "set_vertex_sampler_views", replay_set_sampler_views },
+   { "pipe_context", "set_geometry_sampler_views", replay_set_sampler_views },
+   { "pipe_context", "set_vertex_buffers", replay_set_vertex_buffers },
+   { "pipe_context", "set_index_buffer", replay_set_index_buffer },
+   { "pipe_context", "create_stream_output_target", replay_create_stream_output_target },
+   { "pipe_context", "stream_output_target_destroy", replay_object_destroy_call },
+   { "pipe_context", "set_stream_output_targets", replay_set_stream_output_targets },
+   { "pipe_context", "resource_copy_region", replay_resource_copy_region },
+   { "pipe_context", "blit", replay_blit },
+   { "pipe_context", "clear", replay_clear },
+   { "pipe_context", "clear_render_target", replay_clear_render_target },
+   { "pipe_context", "clear_depth_stencil", replay_clear_depth_stencil },
+   { "pipe_context", "flush", replay_flush },
+   { "pipe_context", "transfer_inline_write", replay_transfer_inline_write },
+   { "pipe_context", "texture_barrier", replay_texture_barrier },
+};
+
+
+static int
+replay_find_method(const char *klass, const char *method)
+{
+   unsigned i;
+
+   for (i = 0; i < Elements(replay_methods); ++i) {
+      if (strcmp(replay_methods[i].klass, klass) == 0 &&
+          strcmp(replay_methods[i].method, method) == 0)
+         return i;
+   }
+
+   return -1;
+}
+
+
+/*
+ * Replaying and reporting
+ */
+
+static void
+replay_frame_end(struct replay *r)
+{
+   int64_t now = os_time_get_nano();
+
+   r->frame.wall = now - r->frame_start;
+   r->frame_start = now;
+
+   if (r->num_frames >= r->max_frames)
+      r->frames = replay_grow(r->frames, &r->max_frames, r->num_frames,
+                              sizeof *r->frames);
+   r->frames[r->num_frames++] = r->frame;
+   memset(&r->frame, 0, sizeof r->frame);
+}
+
+
+static void
+replay_run(struct replay *r)
+{
+   unsigned i;
+
+   r->frame_start = os_time_get_nano();
+
+   for (i = 0; i < r->num_calls; ++i) {
+      const struct replay_call *call = &r->calls[i];
+      struct replay_stats *stats;
+
+      if (call->method_index < 0) {
+         if (r->verbose)
+            fprintf(stderr, "warning: call %u: %s::%s not replayed\n",
+                    call->no, call->klass, call->method);
+         ++r->unknown_calls;
+         continue;
+      }
+
+      if (!replay_methods[call->method_index].func)
+         continue;
+
+      r->call_time = 0;
+      replay_methods[call->method_index].func(r, call);
+
+      stats = &r->stats[call->method_index];
+      stats->count++;
+      stats->total += r->call_time;
+      stats->max = MAX2(stats->max, r->call_time);
+      stats->traced += call->time;
+
+      r->frame.calls++;
+      r->frame.driver += r->call_time;
+      r->frame.traced += call->time;
+      if (replay_methods[call->method_index].func == replay_flush_frontbuffer)
+         replay_frame_end(r);
+   }
+
+   /* A trace without frames counts as one */
+   if (r->frame.calls && r->num_frames == 0)
+      replay_frame_end(r);
+}
+
+
+static int
+replay_compare_stats(const void *a, const void *b)
+{
+   const struct replay_stats *stats1 = *(const struct replay_stats * const *)a;
+   const struct replay_stats *stats2 = *(const struct replay_stats * const *)b;
+
+   if (stats1->total != stats2->total)
+      return stats1->total < stats2->total ? 1 : -1;
+   return 0;
+}
+
+
+static int
+replay_compare_time(const void *a, const void *b)
+{
+   uint64_t time1 = *(const uint64_t *)a;
+   uint64_t time2 = *(const uint64_t *)b;
+
+   return time1 < time2 ? -1 : time1 > time2 ? 1 : 0;
+}
+
+
+static void
+replay_report(struct replay *r, unsigned limit)
+{
+   const struct replay_stats *sorted[Elements(replay_methods)];
+   uint64_t total = 0;
+   int64_t traced = 0;
+   unsigned calls = 0;
+   unsigned num = 0;
+   unsigned i;
+
+   for (i = 0; i < Elements(replay_methods); ++i) {
+      if (!r->stats[i].count)
+         continue;
+      total += r->stats[i].total;
+      traced += r->stats[i].traced;
+      calls += r->stats[i].count;
+      sorted[num++] = &r->stats[i];
+   }
+
+   printf("replay: %.0f us in %u calls, traced %lld us\n",
+          total / 1000.0, calls, (long long)traced);
+   if (r->skipped_draws)
+      printf("%u draws skipped, they read user buffers\n", r->skipped_draws);
+   if (r->unknown_calls)
+      printf("%u calls not replayed\n", r->unknown_calls);
+
+   if (r->num_frames) {
+      uint64_t *wall = MALLOC(r->num_frames * sizeof *wall);
+      uint64_t sum = 0;
+
+      for (i = 0; i < r->num_frames; ++i) {
+         wall[i] = r->frames[i].wall;
+         sum += wall[i];
+      }
+      qsort(wall, r->num_frames, sizeof *wall, replay_compare_time);
+
+      printf("%u frames: average %.1f us, median %.1f us, max %.1f us\n",
+             r->num_frames,
+             sum / 1000.0 / r->num_frames,
+             wall[r->num_frames / 2] / 1000.0,
+             wall[r->num_frames - 1] / 1000.0);
+      FREE(wall);
+   }
+   printf("\n");
+
+   qsort(sorted, num, sizeof sorted[0], replay_compare_stats);
+
+   printf("%10s %8s %10s %10s %10s  %s\n",
+          "total us", "calls", "avg us", "max us", "traced us", "call");
+   for (i = 0; i < num && i < limit; ++i) {
+      const struct replay_stats *stats = sorted[i];
+      const struct replay_method *method = &replay_methods[stats - r->stats];
+      printf("%10.0f %8u %10.1f %10.1f %10lld  %s::%s\n",
+             stats->total / 1000.0, stats->count,
+             stats->total / 1000.0 / stats->count, stats->max / 1000.0,
+             (long long)stats->traced, method->klass, method->method);
+   }
+   printf("\n");
+
+   if (r->verbose && r->num_frames) {
+      printf("%8s %8s %10s %10s %10s\n",
+             "frame", "calls", "wall us", "driver us", "traced us");
+      for (i = 0; i < r->num_frames; ++i) {
+         const struct replay_frame *frame = &r->frames[i];
+         printf("%8u %8u %10.1f %10.1f %10lld\n",
+                i, frame->calls, frame->wall / 1000.0, frame->driver / 1000.0,
+                (long long)frame->traced);
+      }
+      printf("\n");
+   }
+}
+
+
+static void
+usage(void)
+{
+   fprintf(stderr,
+           "usage: replay [-d device] [-l] [-n limit] [-v] trace\n"
+           "\n"
+           "Replay a trace captured with GALLIUM_TRACE_FORMAT=binary and\n"
+           "report the time spent in each call and frame.\n"
+           "\n"
+           "  -d device  replay on the given device [default: 0]\n"
+           "  -l         list the devices and exit\n"
+           "  -n limit   number of calls to list [default: 20]\n"
+           "  -v         list every frame and warn about calls not replayed\n"
+           "\n"
+           "GALLIUM_DRIVER selects the software driver, e.g. llvmpipe or\n"
+           "softpipe.\n");
+   exit(1);
+}
+
+
+int main(int argc, char **argv)
+{
+   struct pipe_loader_device *devs[8];
+   struct replay r;
+   const char *filename = NULL;
+   unsigned device = 0;
+   unsigned limit = 20;
+   boolean list = FALSE;
+   int num_devs;
+   uint8_t *data;
+   long size;
+   FILE *fp;
+   int i;
+
+   memset(&r, 0, sizeof r);
+
+   for (i = 1; i < argc; ++i) {
+      if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+         device = atoi(argv[++i]);
+      else if (strcmp(argv[i], "-l") == 0)
+         list = TRUE;
+      else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+         limit = atoi(argv[++i]);
+      else if (strcmp(argv[i], "-v") == 0)
+         r.verbose = TRUE;
+      else if (argv[i][0] != '-' && !filename)
+         filename = argv[i];
+      else
+         usage();
+   }
+
+   num_devs = pipe_loader_probe(devs, Elements(devs));
+   num_devs = MIN2(num_devs, (int)Elements(devs));
+   if (list) {
+      for (i = 0; i < num_devs; ++i)
+         printf("%d: %s\n", i, devs[i]->driver_name);
+      pipe_loader_release(devs, num_devs);
+      return 0;
+   }
+
+   if (!filename)
+      usage();
+
+   if ((int)device >= num_devs) {
+      fprintf(stderr, "error: no device %u\n", device);
+      return 1;
+   }
+
+   fp = fopen(filename, "rb");
+   if (!fp) {
+      fprintf(stderr, "error: failed to open %s\n", filename);
+      return 1;
+   }
+   fseek(fp, 0, SEEK_END);
+   size = ftell(fp);
+   fseek(fp, 0, SEEK_SET);
+   data = MALLOC(size > 0 ? size : 1);
+   if (!data || fread(data, 1, size, fp) != (size_t)size) {
+      fprintf(stderr, "error: failed to read %s\n", filename);
+      return 1;
+   }
+   fclose(fp);
+
+   if (!replay_decode(&r, data, size)) {
+      FREE(data);
+      return 1;
+   }
+   if (r.error)
+      fprintf(stderr, "warning: replaying the first %u calls\n", r.num_calls);
+
+   r.screen = pipe_loader_create_screen(devs[device], PIPE_SEARCH_DIR);
+   if (!r.screen) {
+      fprintf(stderr, "error: failed to create a screen for %s\n",
+              devs[device]->driver_name);
+      return 1;
+   }
+   printf("%s: %u calls on %s\n", filename, r.num_calls,
+          r.screen->get_name(r.screen));
+
+   r.objects = util_hash_table_create(replay_object_hash,
+                                      replay_object_compare);
+   LIST_INITHEAD(&r.object_list);
+   r.stats = CALLOC(Elements(replay_methods), sizeof *r.stats);
+
+   replay_run(&r);
+   replay_report(&r, limit);
+
+   replay_release_objects(&r, NULL);
+   util_hash_table_destroy(r.objects);
+   r.screen->destroy(r.screen);
+   pipe_loader_release(devs, num_devs);
+
+   while (r.chunks) {
+      struct replay_chunk *next = r.chunks->next;
+      FREE(r.chunks);
+      r.chunks = next;
+   }
+   for (i = 0; i < (int)r.max_strings; ++i)
+      FREE(r.strings[i]);
+   FREE(r.strings);
+   FREE(r.blobs);
+   FREE(r.blob_sizes);
+   FREE(r.calls);
+   FREE(r.frames);
+   FREE(r.stats);
+   FREE(data);
+
+   return 0;
+}
@@ -0,0 +1,166 @@
+#!/usr/bin/env python
+##########################################################################
+# 
+# Copyright 2026 agent <agent@local>
+# 
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the
+# "Software"), to deal in the Software without restriction, including
+# without limitation the rights to use, copy, modify, merge, publish,
+# distribute, sub license, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to
+# the following conditions:
+# 
+# The above copyright notice and this permission notice (including the
+# next paragraph) shall be included in all copies or substantial portions
+# of the Software.
+# 
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+# OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+# IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR
+# ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+# TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+# SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+# 
+##########################################################################
+
+
+'''Summarize the time spent in each call of one or more traces.
+
+The time of each call is the time spent in the real driver, as measured by
+the trace driver, in microseconds.  When several traces of the same
+application are given, e.g. recorded with different drivers or different
+builds of the same driver, the totals are compared against the first one.
+'''
+
+
+from parse import *
+
+
+class CallStats:
+
+    def __init__(self):
+        self.count = 0
+        self.total = 0
+        self.max = 0
+
+    def add(self, time):
+        self.count += 1
+        self.total += time
+        self.max = max(self.max, time)
+
+    def average(self):
+        if not self.count:
+            return 0.0
+        return float(self.total)/self.count
+
+
+class TraceTimings(TraceParser):
+
+    def __init__(self, fp, frame_call):
+        TraceParser.__init__(self, fp)
+        self.frame_call = frame_call
+        self.calls = {}
+        self.frames = []
+        self.frame_time = 0
+        self.total = 0
+
+    def handle_call(self, call):
+        time = call.time
+        if isinstance(time, Literal):
+            time = time.value
+        name = call.klass + '::' + call.method
+
+        try:
+            stats = self.calls[name]
+        except KeyError:
+            stats = self.calls[name] = CallStats()
+        stats.add(time)
+
+        self.total += time
+        self.frame_time += time
+        if name == self.frame_call:
+            self.frames.append(self.frame_time)
+            self.frame_time = 0
+
+
+class TimingsMain(Main):
+
+    def main(self):
+        self.traces = []
+        Main.main(self)
+
+        if not self.traces:
+            return
+        base_name, base = self.traces[0]
+        self.report(base_name, base)
+        for name, timings in self.traces[1:]:
+            self.compare(base_name, base, name, timings)
+
+    def get_optparser(self):
+        optparser = Main.get_optparser(self)
+        optparser.add_option(
+            '-f', '--frame-call', metavar='CLASS::METHOD',
+            type='string', dest='frame_call', default='pipe_screen::flush_frontbuffer',
+            help='call ending each frame [default: %default]')
+        optparser.add_option(
+            '-n', '--limit', metavar='N',
+            type='int', dest='limit', default=20,
+            help='number of calls to list [default: %default]')
+        return optparser
+
+    def process_arg(self, stream, options):
+        self.options = options
+        timings = TraceTimings(stream, options.frame_call)
+        timings.parse()
+        self.traces.append((getattr(stream, 'name', '?'), timings))
+
+    def report(self, name, timings):
+        sys.stdout.write('%s: %u us in %u calls\n' % (name, timings.total, sum([stats.count for stats in timings.calls.itervalues()])))
+
+        frames = timings.frames
+        if frames:
+            sorted_frames = sorted(frames)
+            sys.stdout.write('%u frames: average %.1f us, median %u us, max %u us\n' % (
+                len(frames),
+                float(sum(frames))/len(frames),
+                sorted_frames[len(frames)//2],
+                sorted_frames[-1]))
+        sys.stdout.write('\n')
+
+        sys.stdout.write('%10s %8s %10s %10s  %s\n' % ('total us', 'calls', 'avg us', 'max us', 'call'))
+        calls = timings.calls.items()
+        calls.sort(key = lambda item: item[1].total, reverse = True)
+        for call, stats in calls[:self.options.limit]:
+            sys.stdout.write('%10u %8u %10.1f %10u  %s\n' % (stats.total, stats.count, stats.average(), stats.max, call))
+        sys.stdout.write('\n')
+
+    def compare(self, base_name, base, name, timings):
+        sys.stdout.write('%s vs %s: %s\n' % (name, base_name, self.delta(base.total, timings.total)))
+        if base.frames and timings.frames:
+            base_average = float(sum(base.frames))/len(base.frames)
+            average = float(sum(timings.frames))/len(timings.frames)
+            sys.stdout.write('average frame: %.1f us vs %.1f us (%s)\n' % (average, base_average, self.delta(base_average, average)))
+        sys.stdout.write('\n')
+
+        sys.stdout.write('%10s %10s %10s  %s\n' % ('total us', 'base us', 'change', 'call'))
+        names = set(base.calls.keys()) | set(timings.calls.keys())
+        rows = []
+        for call in names:
+            base_total = call in base.calls and base.calls[call].total or 0
+            total = call in timings.calls and timings.calls[call].total or 0
+            rows.append((total - base_total, call, base_total, total))
+        rows.sort(key = lambda row: abs(row[0]), reverse = True)
+        for difference, call, base_total, total in rows[:self.options.limit]:
+            sys.stdout.write('%10u %10u %10s  %s\n' % (total, base_total, self.delta(base_total, total), call))
+        sys.stdout.write('\n')
+
+    def delta(self, base, value):
+        if not base:
+            return 'new'
+        return '%+.1f%%' % ((value - base)*100.0/base)
+
+
+if __name__ == '__main__':
+    TimingsMain().main()
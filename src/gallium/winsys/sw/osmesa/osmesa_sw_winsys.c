@@ -0,0 +1,266 @@
+/**************************************************************************
+ *
+ * Copyright 2013 VMware, Inc.
+ * All Rights Reserved.
+ * Copyright 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT. IN NO EVENT SHALL
+ * THE COPYRIGHT HOLDERS, AUTHORS AND/OR ITS SUPPLIERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ **************************************************************************/
+
+/**
+ * @file
+ * Software rasterizer winsys for OSMesa.
+ *
+ * There is no present support.  Display targets either wrap the memory
+ * the application passed to OSMesaMakeCurrent, or are ordinary memory the
+ * state tracker copies from.
+ */
+
+#include "pipe/p_format.h"
+#include "util/u_format.h"
+#include "util/u_math.h"
+#include "util/u_memory.h"
+#include "state_tracker/sw_winsys.h"
+#include "state_tracker/osmesa_sw_winsys.h"
+
+
+struct osmesa_sw_displaytarget
+{
+   enum pipe_format format;
+   unsigned width;
+   unsigned height;
+   unsigned stride;
+
+   void *data;
+
+   /** Whether data belongs to the application */
+   boolean user_memory;
+};
+
+
+struct osmesa_sw_winsys
+{
+   struct sw_winsys base;
+
+   /** Application buffer offered for the next display target */
+   void *user_data;
+   unsigned user_stride;
+   unsigned user_rows;
+   boolean user_taken;
+};
+
+
+static INLINE struct osmesa_sw_displaytarget *
+osmesa_sw_displaytarget( struct sw_displaytarget *dt )
+{
+   return (struct osmesa_sw_displaytarget *) dt;
+}
+
+
+static INLINE struct osmesa_sw_winsys *
+osmesa_sw_winsys( struct sw_winsys *ws )
+{
+   return (struct osmesa_sw_winsys *) ws;
+}
+
+
+static boolean
+osmesa_sw_is_displaytarget_format_supported( struct sw_winsys *ws,
+                                             unsigned tex_usage,
+                                             enum pipe_format format )
+{
+   const struct util_format_description *desc = util_format_description(format);
+
+   return desc &&
+          desc->layout == UTIL_FORMAT_LAYOUT_PLAIN &&
+          desc->colorspace == UTIL_FORMAT_COLORSPACE_RGB;
+}
+
+
+static void *
+osmesa_sw_displaytarget_map(struct sw_winsys *ws,
+                            struct sw_displaytarget *dt,
+                            unsigned flags )
+{
+   struct osmesa_sw_displaytarget *osdt = osmesa_sw_displaytarget(dt);
+   return osdt->data;
+}
+
+
+static void
+osmesa_sw_displaytarget_unmap(struct sw_winsys *ws,
+                              struct sw_displaytarget *dt )
+{
+}
+
+
+static void
+osmesa_sw_displaytarget_destroy(struct sw_winsys *winsys,
+                                struct sw_displaytarget *dt)
+{
+   struct osmesa_sw_displaytarget *osdt = osmesa_sw_displaytarget(dt);
+
+   if (!osdt->user_memory)
+      align_free(osdt->data);
+
+   FREE(osdt);
+}
+
+
+static struct sw_displaytarget *
+osmesa_sw_displaytarget_create(struct sw_winsys *winsys,
+                               unsigned tex_usage,
+                               enum pipe_format format,
+                               unsigned width, unsigned height,
+                               unsigned alignment,
+                               unsigned *stride)
+{
+   struct osmesa_sw_winsys *osws = osmesa_sw_winsys(winsys);
+   struct osmesa_sw_displaytarget *osdt;
+   unsigned nblocksy, row_size;
+
+   osdt = CALLOC_STRUCT(osmesa_sw_displaytarget);
+   if (!osdt)
+      return NULL;
+
+   osdt->format = format;
+   osdt->width = width;
+   osdt->height = height;
+
+   nblocksy = util_format_get_nblocksy(format, height);
+   row_size = util_format_get_stride(format, width);
+
+   /* Use the application's buffer when it can hold the image as laid out
+    * by the driver, padding included.
+    */
+   if (osws->user_data &&
+       !osws->user_taken &&
+       osws->user_stride >= row_size &&
+       osws->user_rows >= nblocksy &&
+       osws->user_stride % alignment == 0 &&
+       (uintptr_t) osws->user_data % alignment == 0) {
+      osdt->data = osws->user_data;
+      osdt->stride = osws->user_stride;
+      osdt->user_memory = TRUE;
+      osws->user_taken = TRUE;
+   }
+   else {
+      osdt->stride = align(row_size, alignment);
+      osdt->data = align_malloc(osdt->stride * nblocksy, alignment);
+      if (!osdt->data) {
+         FREE(osdt);
+         return NULL;
+      }
+   }
+
+   *stride = osdt->stride;
+
+   return (struct sw_displaytarget *) osdt;
+}
+
+
+static struct sw_displaytarget *
+osmesa_sw_displaytarget_from_handle(struct sw_winsys *winsys,
+                                    const struct pipe_resource *templat,
+                                    struct winsys_handle *whandle,
+                                    unsigned *stride)
+{
+   return NULL;
+}
+
+
+static boolean
+osmesa_sw_displaytarget_get_handle(struct sw_winsys *winsys,
+                                   struct sw_displaytarget *dt,
+                                   struct winsys_handle *whandle)
+{
+   return FALSE;
+}
+
+
+static void
+osmesa_sw_displaytarget_display(struct sw_winsys *winsys,
+                                struct sw_displaytarget *dt,
+                                void *context_private)
+{
+   /* Nothing to do, the state tracker reads the buffers directly. */
+}
+
+
+static void
+osmesa_sw_destroy(struct sw_winsys *winsys)
+{
+   FREE(winsys);
+}
+
+
+void
+osmesa_sw_winsys_offer_buffer(struct sw_winsys *ws,
+                              void *data,
+                              unsigned stride,
+                              unsigned rows)
+{
+   struct osmesa_sw_winsys *osws = osmesa_sw_winsys(ws);
+
+   osws->user_data = data;
+   osws->user_stride = stride;
+   osws->user_rows = rows;
+   osws->user_taken = FALSE;
+}
+
+
+boolean
+osmesa_sw_winsys_withdraw_buffer(struct sw_winsys *ws)
+{
+   struct osmesa_sw_winsys *osws = osmesa_sw_winsys(ws);
+   boolean taken = osws->user_taken;
+
+   osws->user_data = NULL;
+   osws->user_stride = 0;
+   osws->user_rows = 0;
+   osws->user_taken = FALSE;
+
+   return taken;
+}
+
+
+struct sw_winsys *
+osmesa_create_sw_winsys(void)
+{
+   struct osmesa_sw_winsys *osws;
+
+   osws = CALLOC_STRUCT(osmesa_sw_winsys);
+   if (!osws)
+      return NULL;
+
+   osws->base.destroy = osmesa_sw_destroy;
+   osws->base.is_displaytarget_format_supported = osmesa_sw_is_displaytarget_format_supported;
+   osws->base.displaytarget_create = osmesa_sw_displaytarget_create;
+   osws->base.displaytarget_from_handle = osmesa_sw_displaytarget_from_handle;
+   osws->base.displaytarget_get_handle = osmesa_sw_displaytarget_get_handle;
+   osws->base.displaytarget_map = osmesa_sw_displaytarget_map;
+   osws->base.displaytarget_unmap = osmesa_sw_displaytarget_unmap;
+   osws->base.displaytarget_display = osmesa_sw_displaytarget_display;
+   osws->base.displaytarget_destroy = osmesa_sw_displaytarget_destroy;
+
+   return &osws->base;
+}
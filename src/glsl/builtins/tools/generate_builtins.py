@@ -231,12 +231,19 @@ read_builtins(GLenum target, const char *protos, const char **functions, unsigne
     print """
 static void *builtin_mem_ctx = NULL;
 
+/* Protects builtin_mem_ctx and builtin_profiles, which are shared by every
+ * context and filled in lazily by whichever thread compiles first.
+ */
+_glthread_DECLARE_STATIC_MUTEX(builtins_mutex);
+
 void
 _mesa_glsl_release_functions(void)
 {
+   _glthread_LOCK_MUTEX(builtins_mutex);
    ralloc_free(builtin_mem_ctx);
    builtin_mem_ctx = NULL;
    memset(builtin_profiles, 0, sizeof(builtin_profiles));
+   _glthread_UNLOCK_MUTEX(builtins_mutex);
 }
 
 static void
@@ -265,6 +272,8 @@ _mesa_glsl_initialize_functions(struct _mesa_glsl_parse_state *state)
    if (state->num_builtins_to_link > 0)
       return;
 
+   _glthread_LOCK_MUTEX(builtins_mutex);
+
    if (builtin_mem_ctx == NULL) {
       builtin_mem_ctx = ralloc_context(NULL); // "GLSL built-in functions"
       memset(&builtin_profiles, 0, sizeof(builtin_profiles));
@@ -298,5 +307,6 @@ _mesa_glsl_initialize_functions(struct _mesa_glsl_parse_state *state)
         print '   }'
         print
         i = i + 1
+    print '   _glthread_UNLOCK_MUTEX(builtins_mutex);'
     print '}'
 
@@ -63,6 +63,7 @@ _mesa_glsl_parse_state::_mesa_glsl_parse_state(struct gl_context *_ctx,
    }
 
    this->scanner = NULL;
+   this->linalloc = linear_alloc_parent(this, 0);
    this->translation_unit.make_empty();
    this->symbols = new(mem_ctx) glsl_symbol_table;
    this->info_log = ralloc_strdup(mem_ctx, "");
@@ -154,7 +155,8 @@ _mesa_glsl_parse_state::_mesa_glsl_parse_state(struct gl_context *_ctx,
    if (ctx->Const.ForceGLSLExtensionsWarn)
       _mesa_glsl_process_extension("all", NULL, "warn", NULL, this);
 
-   this->default_uniform_qualifier = new(this) ast_type_qualifier();
+   this->default_uniform_qualifier =
+      new(this->linalloc) ast_type_qualifier();
    this->default_uniform_qualifier->flags.q.shared = 1;
    this->default_uniform_qualifier->flags.q.column_major = 1;
 }
@@ -1173,12 +1175,13 @@ ast_struct_specifier::print(void) const
 }
 
 
-ast_struct_specifier::ast_struct_specifier(const char *identifier,
+ast_struct_specifier::ast_struct_specifier(void *lin_ctx,
+					   const char *identifier,
 					   ast_declarator_list *declarator_list)
 {
    if (identifier == NULL) {
       static unsigned anon_count = 1;
-      identifier = ralloc_asprintf(this, "#anon_struct_%04x", anon_count);
+      identifier = linear_asprintf(lin_ctx, "#anon_struct_%04x", anon_count);
       anon_count++;
    }
    name = identifier;
@@ -1219,6 +1222,8 @@ do_common_optimization(exec_list *ir, bool linked,
    progress = do_if_simplification(ir) || progress;
    progress = do_copy_propagation(ir) || progress;
    progress = do_copy_propagation_elements(ir) || progress;
+   if (linked)
+      progress = do_cse(ir) || progress;
    if (linked)
       progress = do_dead_code(ir, uniform_locations_assigned) || progress;
    else
@@ -141,6 +141,13 @@ struct _mesa_glsl_parse_state {
 
    struct gl_context *const ctx;
    void *scanner;
+
+   /**
+    * Linear context holding the AST and the identifier strings it refers to.
+    * Freed along with the parse state.
+    */
+   void *linalloc;
+
    exec_list translation_unit;
    glsl_symbol_table *symbols;
 
@@ -28,15 +28,23 @@
 #include "glsl_parser_extras.h"
 #include "glsl_types.h"
 #include "builtin_types.h"
-extern "C" {
-#include "program/hash_table.h"
-}
+#include "main/hash_table.h"
 
 hash_table *glsl_type::array_types = NULL;
 hash_table *glsl_type::record_types = NULL;
 hash_table *glsl_type::interface_types = NULL;
 void *glsl_type::mem_ctx = NULL;
 
+/**
+ * Protects glsl_type::mem_ctx and the type hash tables.
+ *
+ * Types are shared by every context in the process, and shaders may be
+ * compiled and linked on several threads at once.  The built-in types are
+ * constructed statically; every type created afterwards, and every
+ * allocation made out of glsl_type::mem_ctx, happens with this held.
+ */
+_glthread_DECLARE_STATIC_MUTEX(glsl_type_mutex);
+
 void
 glsl_type::init_ralloc_type_ctx(void)
 {
@@ -476,15 +484,21 @@ const glsl_type *glsl_type::get_scalar_type() const
 void
 _mesa_glsl_release_types(void)
 {
-   if (glsl_type::array_types != NULL) {
-      hash_table_dtor(glsl_type::array_types);
-      glsl_type::array_types = NULL;
-   }
+   _glthread_LOCK_MUTEX(glsl_type_mutex);
 
-   if (glsl_type::record_types != NULL) {
-      hash_table_dtor(glsl_type::record_types);
-      glsl_type::record_types = NULL;
-   }
+   /* The types themselves, and the keys pointing at them, live in
+    * glsl_type::mem_ctx and are freed at exit.
+    */
+   _mesa_hash_table_destroy(glsl_type::array_types, NULL);
+   glsl_type::array_types = NULL;
+
+   _mesa_hash_table_destroy(glsl_type::record_types, NULL);
+   glsl_type::record_types = NULL;
+
+   _mesa_hash_table_destroy(glsl_type::interface_types, NULL);
+   glsl_type::interface_types = NULL;
+
+   _glthread_UNLOCK_MUTEX(glsl_type_mutex);
 }
 
 
@@ -576,89 +590,166 @@ glsl_type::get_instance(unsigned base_type, unsigned rows, unsigned columns)
 }
 
 
-const glsl_type *
-glsl_type::get_array_instance(const glsl_type *base, unsigned array_size)
+namespace {
+
+/**
+ * Key for the array type table.
+ */
+struct array_key {
+   const glsl_type *element;
+   unsigned length;
+};
+
+/**
+ * Key for the record and interface type tables.
+ *
+ * Lookups point this at the caller's field list, so finding a type that
+ * already exists doesn't allocate anything.  Keys stored in the tables point
+ * at the interned type's own copies.
+ */
+struct record_key {
+   const glsl_struct_field *fields;
+   unsigned num_fields;
+   unsigned packing;
+   const char *name;
+};
+
+} /* unnamed namespace */
+
+static uint32_t
+array_key_hash(const array_key *key)
 {
+   return _mesa_hash_pointer(key->element) ^ (key->length * 2654435761u);
+}
 
-   if (array_types == NULL) {
-      array_types = hash_table_ctor(64, hash_table_string_hash,
-				    hash_table_string_compare);
-   }
+static bool
+array_key_equal(const void *a, const void *b)
+{
+   const array_key *const key1 = (const array_key *) a;
+   const array_key *const key2 = (const array_key *) b;
 
-   /* Generate a name using the base type pointer in the key.  This is
-    * done because the name of the base type may not be unique across
-    * shaders.  For example, two shaders may have different record types
-    * named 'foo'.
-    */
-   char key[128];
-   snprintf(key, sizeof(key), "%p[%u]", (void *) base, array_size);
+   return key1->element == key2->element && key1->length == key2->length;
+}
 
-   const glsl_type *t = (glsl_type *) hash_table_find(array_types, key);
-   if (t == NULL) {
-      t = new glsl_type(base, array_size);
+static uint32_t
+record_key_hash(const record_key *key)
+{
+   uint32_t hash = _mesa_hash_string(key->name);
 
-      hash_table_insert(array_types, (void *) t, ralloc_strdup(mem_ctx, key));
+   hash ^= key->num_fields * 2654435761u;
+   hash ^= key->packing << 29;
+
+   for (unsigned i = 0; i < key->num_fields; i++) {
+      hash = hash * 31 + _mesa_hash_pointer(key->fields[i].type);
+      hash ^= _mesa_hash_string(key->fields[i].name);
    }
 
-   assert(t->base_type == GLSL_TYPE_ARRAY);
-   assert(t->length == array_size);
-   assert(t->fields.array == base);
+   return hash;
+}
 
-   return t;
+static bool
+record_key_equal(const void *a, const void *b)
+{
+   const record_key *const key1 = (const record_key *) a;
+   const record_key *const key2 = (const record_key *) b;
+
+   if (key1->num_fields != key2->num_fields)
+      return false;
+
+   if (key1->packing != key2->packing)
+      return false;
+
+   if (strcmp(key1->name, key2->name) != 0)
+      return false;
+
+   for (unsigned i = 0; i < key1->num_fields; i++) {
+      if (key1->fields[i].type != key2->fields[i].type)
+	 return false;
+      if (strcmp(key1->fields[i].name, key2->fields[i].name) != 0)
+	 return false;
+      if (key1->fields[i].row_major != key2->fields[i].row_major)
+	 return false;
+   }
+
+   return true;
 }
 
 
-int
-glsl_type::record_key_compare(const void *a, const void *b)
+const glsl_type *
+glsl_type::get_array_instance(const glsl_type *base, unsigned array_size)
 {
-   const glsl_type *const key1 = (glsl_type *) a;
-   const glsl_type *const key2 = (glsl_type *) b;
-
-   /* Return zero is the types match (there is zero difference) or non-zero
-    * otherwise.
+   /* The key uses the base type pointer rather than its name because the
+    * name of the base type may not be unique across shaders.  For example,
+    * two shaders may have different record types named 'foo'.
+    *
+    * The hash is computed before taking the lock; the table keeps it with
+    * the entry, so it is never recomputed when the table grows.
     */
-   if (strcmp(key1->name, key2->name) != 0)
-      return 1;
+   const array_key key = { base, array_size };
+   const uint32_t hash = array_key_hash(&key);
 
-   if (key1->length != key2->length)
-      return 1;
+   _glthread_LOCK_MUTEX(glsl_type_mutex);
 
-   if (key1->interface_packing != key2->interface_packing)
-      return 1;
+   if (array_types == NULL)
+      array_types = _mesa_hash_table_create(NULL, array_key_equal);
 
-   for (unsigned i = 0; i < key1->length; i++) {
-      if (key1->fields.structure[i].type != key2->fields.structure[i].type)
-	 return 1;
-      if (strcmp(key1->fields.structure[i].name,
-		 key2->fields.structure[i].name) != 0)
-	 return 1;
-      if (key1->fields.structure[i].row_major
-         != key2->fields.structure[i].row_major)
-        return 1;
+   const glsl_type *t;
+   struct hash_entry *entry =
+      _mesa_hash_table_search(array_types, hash, &key);
+   if (entry == NULL) {
+      t = new glsl_type(base, array_size);
+
+      array_key *stored_key = ralloc(mem_ctx, array_key);
+      *stored_key = key;
+      _mesa_hash_table_insert(array_types, hash, stored_key, (void *) t);
+   } else {
+      t = (const glsl_type *) entry->data;
    }
 
-   return 0;
+   _glthread_UNLOCK_MUTEX(glsl_type_mutex);
+
+   assert(t->base_type == GLSL_TYPE_ARRAY);
+   assert(t->length == array_size);
+   assert(t->fields.array == base);
+
+   return t;
 }
 
 
-unsigned
-glsl_type::record_key_hash(const void *a)
+/**
+ * Finds or creates the record or interface type described by \c key.
+ *
+ * Must be called with the type mutex held.
+ */
+const glsl_type *
+glsl_type::intern_record_type(struct hash_table **types, uint32_t hash,
+			      const void *lookup_key)
 {
-   const glsl_type *const key = (glsl_type *) a;
-   char hash_key[128];
-   unsigned size = 0;
+   const record_key *key = (const record_key *) lookup_key;
 
-   size = snprintf(hash_key, sizeof(hash_key), "%08x", key->length);
+   if (*types == NULL)
+      *types = _mesa_hash_table_create(NULL, record_key_equal);
 
-   for (unsigned i = 0; i < key->length; i++) {
-      if (size >= sizeof(hash_key))
-	 break;
+   struct hash_entry *entry = _mesa_hash_table_search(*types, hash, key);
+   if (entry != NULL)
+      return (const glsl_type *) entry->data;
 
-      size += snprintf(& hash_key[size], sizeof(hash_key) - size,
-		       "%p", (void *) key->fields.structure[i].type);
+   const glsl_type *t;
+   if (types == &interface_types) {
+      t = new glsl_type(key->fields, key->num_fields,
+			(enum glsl_interface_packing) key->packing, key->name);
+   } else {
+      t = new glsl_type(key->fields, key->num_fields, key->name);
    }
 
-   return hash_table_string_hash(& hash_key);
+   record_key *stored_key = ralloc(mem_ctx, record_key);
+   stored_key->fields = t->fields.structure;
+   stored_key->num_fields = t->length;
+   stored_key->packing = t->interface_packing;
+   stored_key->name = t->name;
+   _mesa_hash_table_insert(*types, hash, stored_key, (void *) t);
+
+   return t;
 }
 
 
@@ -667,18 +758,12 @@ glsl_type::get_record_instance(const glsl_struct_field *fields,
 			       unsigned num_fields,
 			       const char *name)
 {
-   const glsl_type key(fields, num_fields, name);
-
-   if (record_types == NULL) {
-      record_types = hash_table_ctor(64, record_key_hash, record_key_compare);
-   }
+   const record_key key = { fields, num_fields, 0, name };
+   const uint32_t hash = record_key_hash(&key);
 
-   const glsl_type *t = (glsl_type *) hash_table_find(record_types, & key);
-   if (t == NULL) {
-      t = new glsl_type(fields, num_fields, name);
-
-      hash_table_insert(record_types, (void *) t, t);
-   }
+   _glthread_LOCK_MUTEX(glsl_type_mutex);
+   const glsl_type *t = intern_record_type(&record_types, hash, &key);
+   _glthread_UNLOCK_MUTEX(glsl_type_mutex);
 
    assert(t->base_type == GLSL_TYPE_STRUCT);
    assert(t->length == num_fields);
@@ -694,18 +779,12 @@ glsl_type::get_interface_instance(const glsl_struct_field *fields,
 				  enum glsl_interface_packing packing,
 				  const char *name)
 {
-   const glsl_type key(fields, num_fields, packing, name);
+   const record_key key = { fields, num_fields, (unsigned) packing, name };
+   const uint32_t hash = record_key_hash(&key);
 
-   if (interface_types == NULL) {
-      interface_types = hash_table_ctor(64, record_key_hash, record_key_compare);
-   }
-
-   const glsl_type *t = (glsl_type *) hash_table_find(interface_types, & key);
-   if (t == NULL) {
-      t = new glsl_type(fields, num_fields, packing, name);
-
-      hash_table_insert(interface_types, (void *) t, t);
-   }
+   _glthread_LOCK_MUTEX(glsl_type_mutex);
+   const glsl_type *t = intern_record_type(&interface_types, hash, &key);
+   _glthread_UNLOCK_MUTEX(glsl_type_mutex);
 
    assert(t->base_type == GLSL_TYPE_INTERFACE);
    assert(t->length == num_fields);
@@ -95,13 +95,13 @@ struct glsl_type {
    unsigned interface_packing:2;
 
    /* Callers of this ralloc-based new need not call delete. It's
-    * easier to just ralloc_free 'mem_ctx' (or any of its ancestors). */
+    * easier to just ralloc_free 'mem_ctx' (or any of its ancestors).
+    *
+    * Must be called with the type mutex in glsl_types.cpp held.
+    */
    static void* operator new(size_t size)
    {
-      if (glsl_type::mem_ctx == NULL) {
-	 glsl_type::mem_ctx = ralloc_context(NULL);
-	 assert(glsl_type::mem_ctx != NULL);
-      }
+      init_ralloc_type_ctx();
 
       void *type;
 
@@ -503,11 +503,12 @@ private:
    /**
     * ralloc context for all glsl_type allocations
     *
-    * Set on the first call to \c glsl_type::new.
+    * Set on the first call to \c glsl_type::new.  Only accessed with the
+    * type mutex held.
     */
    static void *mem_ctx;
 
-   void init_ralloc_type_ctx(void);
+   static void init_ralloc_type_ctx(void);
 
    /** Constructor for vector and matrix types */
    glsl_type(GLenum gl_type,
@@ -539,8 +540,9 @@ private:
    /** Hash table containing the known interface types. */
    static struct hash_table *interface_types;
 
-   static int record_key_compare(const void *a, const void *b);
-   static unsigned record_key_hash(const void *key);
+   static const glsl_type *intern_record_type(struct hash_table **types,
+					      uint32_t hash,
+					      const void *key);
 
    /**
     * \name Pointers to various type singletons
@@ -107,6 +107,19 @@ public:
    virtual ir_instruction *clone(void *mem_ctx,
 				 struct hash_table *ht) const = 0;
 
+   /**
+    * Determine whether this instruction computes the same value as \c ir
+    *
+    * The comparison is purely structural: two instructions are equal when
+    * they have the same node type, the same operation and operands that are
+    * themselves equal.  It says nothing about whether the variables involved
+    * may change between the two instructions; callers are responsible for
+    * that.
+    *
+    * The base implementation always returns \c false.
+    */
+   virtual bool equals(ir_instruction *ir);
+
    /**
     * \name IR instruction downcast functions
     *
@@ -1205,6 +1218,8 @@ public:
 
    virtual ir_visitor_status accept(ir_hierarchical_visitor *);
 
+   virtual bool equals(ir_instruction *ir);
+
    ir_expression_operation operation;
    ir_rvalue *operands[4];
 };
@@ -1470,6 +1485,8 @@ public:
 
    virtual ir_visitor_status accept(ir_hierarchical_visitor *);
 
+   virtual bool equals(ir_instruction *ir);
+
    /**
     * Return a string representing the ir_texture_opcode.
     */
@@ -1573,6 +1590,8 @@ public:
 
    virtual ir_visitor_status accept(ir_hierarchical_visitor *);
 
+   virtual bool equals(ir_instruction *ir);
+
    bool is_lvalue() const
    {
       return val->is_lvalue() && !mask.has_duplicates;
@@ -1672,6 +1691,8 @@ public:
 
    virtual ir_visitor_status accept(ir_hierarchical_visitor *);
 
+   virtual bool equals(ir_instruction *ir);
+
    /**
     * Object being dereferenced.
     */
@@ -1719,6 +1740,8 @@ public:
 
    virtual ir_visitor_status accept(ir_hierarchical_visitor *);
 
+   virtual bool equals(ir_instruction *ir);
+
    ir_rvalue *array;
    ir_rvalue *array_index;
 
@@ -1762,6 +1785,8 @@ public:
 
    virtual ir_visitor_status accept(ir_hierarchical_visitor *);
 
+   virtual bool equals(ir_instruction *ir);
+
    ir_rvalue *record;
    const char *field;
 };
@@ -1824,6 +1849,8 @@ public:
 
    virtual ir_visitor_status accept(ir_hierarchical_visitor *);
 
+   virtual bool equals(ir_instruction *ir);
+
    /**
     * Get a particular component of a constant as a specific type
     *
@@ -109,6 +109,7 @@ int dump_ast = 0;
 int dump_hir = 0;
 int dump_lir = 0;
 int do_link = 0;
+int dump_mem_stats = 0;
 
 const struct option compiler_opts[] = {
    { "glsl-es",  0, &glsl_es,  1 },
@@ -116,6 +117,7 @@ const struct option compiler_opts[] = {
    { "dump-hir", 0, &dump_hir, 1 },
    { "dump-lir", 0, &dump_lir, 1 },
    { "link",     0, &do_link,  1 },
+   { "dump-mem-stats", 0, &dump_mem_stats, 1 },
    { NULL, 0, NULL, 0 }
 };
 
@@ -137,10 +139,29 @@ usage_fail(const char *name)
    exit(EXIT_FAILURE);
 }
 
+/**
+ * Print the allocation statistics of a compilation phase, and start counting
+ * the next one.
+ */
+static void
+print_mem_stats(const char *phase)
+{
+   struct ralloc_stats stats;
+
+   ralloc_get_stats(&stats);
+   printf("%s memory: %lu allocations, %lu linear allocations, "
+          "%lu bytes peak\n", phase, stats.num_allocations,
+          stats.num_linear_allocations, (unsigned long) stats.bytes_peak);
+   ralloc_reset_stats();
+}
+
 
 void
 compile_shader(struct gl_context *ctx, struct gl_shader *shader)
 {
+   if (dump_mem_stats)
+      ralloc_reset_stats();
+
    struct _mesa_glsl_parse_state *state =
       new(shader) _mesa_glsl_parse_state(ctx, shader->Type, shader);
 
@@ -166,6 +187,17 @@ compile_shader(struct gl_context *ctx, struct gl_shader *shader)
    if (!state->error && !state->translation_unit.is_empty())
       _mesa_ast_to_hir(shader->ir, state);
 
+   if (dump_mem_stats) {
+      struct linear_stats stats;
+
+      linear_get_stats(state->linalloc, &stats);
+      printf("AST memory: %u allocations, %lu bytes used, "
+             "%lu bytes reserved in %u buffers\n",
+             stats.num_allocations, (unsigned long) stats.bytes_allocated,
+             (unsigned long) stats.bytes_reserved, stats.num_buffers);
+      print_mem_stats("Parser");
+   }
+
    /* Print out the unoptimized IR. */
    if (!state->error && dump_hir) {
       validate_ir_tree(shader->ir);
@@ -201,6 +233,9 @@ compile_shader(struct gl_context *ctx, struct gl_shader *shader)
 
    shader->InfoLog = state->info_log;
 
+   if (dump_mem_stats)
+      print_mem_stats("Optimizer");
+
    /* Retain any live IR, but trash the rest. */
    reparent_ir(shader->ir, shader);
 
@@ -227,6 +262,9 @@ main(int argc, char **argv)
 
    initialize_context(ctx, (glsl_es) ? API_OPENGLES2 : API_OPENGL_COMPAT);
 
+   if (dump_mem_stats)
+      ralloc_enable_stats();
+
    struct gl_shader_program *whole_program;
 
    whole_program = rzalloc (NULL, struct gl_shader_program);
@@ -274,7 +312,13 @@ main(int argc, char **argv)
    }
 
    if ((status == EXIT_SUCCESS) && do_link)  {
+      if (dump_mem_stats)
+         ralloc_reset_stats();
+
       link_shaders(ctx, whole_program);
+
+      if (dump_mem_stats)
+         print_mem_stats("Linker");
       status = (whole_program->LinkStatus) ? EXIT_SUCCESS : EXIT_FAILURE;
 
       if (strlen(whole_program->InfoLog) > 0)
@@ -0,0 +1,409 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file opt_cse.cpp
+ *
+ * Value numbering of expressions whose operands never change.
+ *
+ * An expression tree whose leaves are all read-only variables (uniforms,
+ * shader inputs, constants) computes the same value wherever it appears, so
+ * we don't have to track kills to reuse it.  The pass keeps a list of such
+ * "available expressions" along the dominating path to the current
+ * instruction.  When an expression is seen again, the first occurrence is
+ * moved into a temporary and both uses read the temporary instead.
+ *
+ * Expressions that only read uniforms and shader inputs are also invariant
+ * across every loop in the shader, so when one shows up inside a loop body
+ * it is hoisted in front of the outermost loop instead of being recomputed
+ * each iteration.
+ *
+ * The temporaries we create are assigned exactly once and are themselves
+ * treated as read-only leaves, so larger trees built on top of an already
+ * numbered subexpression get numbered too.
+ */
+
+#include "ir.h"
+#include "ir_visitor.h"
+#include "ir_rvalue_visitor.h"
+#include "ir_optimization.h"
+#include "glsl_types.h"
+#include "program/hash_table.h"
+
+namespace {
+
+static bool debug = false;
+
+/**
+ * An available expression
+ */
+class ae_entry : public exec_node
+{
+public:
+   DECLARE_LINEAR_ALLOC_CXX_OPERATORS;
+
+   ae_entry(ir_instruction *base_ir, ir_rvalue **val, unsigned depth,
+            bool invariant)
+      : val(val), base_ir(base_ir), var(NULL), depth(depth),
+        invariant(invariant)
+   {
+      assert(val);
+      assert(*val);
+      assert(base_ir);
+      this->expr = *val;
+   }
+
+   /**
+    * The expression tree that computes the value.
+    *
+    * Once the value has been moved into \c var, this is the RHS of the
+    * assignment to \c var.
+    */
+   ir_rvalue *expr;
+
+   /**
+    * The location in the IR of the first occurrence, which gets rewritten
+    * to a dereference of \c var when the expression is first reused.
+    */
+   ir_rvalue **val;
+
+   /**
+    * The statement containing the first occurrence.  The temporary holding
+    * the value is declared and assigned right before it.
+    */
+   ir_instruction *base_ir;
+
+   /** Temporary holding the value, or \c NULL until the first reuse. */
+   ir_variable *var;
+
+   /** Nesting depth of the instruction list containing \c base_ir. */
+   unsigned depth;
+
+   /** Whether the expression only reads uniforms and shader inputs. */
+   bool invariant;
+};
+
+/**
+ * Determines whether an rvalue only reads values that can't change.
+ */
+class is_cse_candidate_visitor : public ir_hierarchical_visitor
+{
+public:
+
+   is_cse_candidate_visitor(struct hash_table *temps)
+      : ok(true), invariant(true), temps(temps)
+   {
+   }
+
+   virtual ir_visitor_status visit(ir_dereference_variable *ir);
+
+   bool ok;
+   bool invariant;
+
+private:
+   struct hash_table *temps;
+};
+
+class cse_visitor : public ir_rvalue_visitor {
+public:
+   cse_visitor()
+   {
+      progress = false;
+      depth = 0;
+      loop = NULL;
+      loop_depth = 0;
+      in_signature = false;
+      mem_ctx = ralloc_context(NULL);
+      lin_ctx = linear_alloc_parent(mem_ctx, 0);
+      temps = hash_table_ctor(0, hash_table_pointer_hash,
+                              hash_table_pointer_compare);
+   }
+
+   ~cse_visitor()
+   {
+      hash_table_dtor(temps);
+      ralloc_free(mem_ctx);
+   }
+
+   virtual ir_visitor_status visit_enter(ir_function_signature *ir);
+   virtual ir_visitor_status visit_enter(ir_loop *ir);
+   virtual ir_visitor_status visit_enter(ir_if *ir);
+
+   virtual void handle_rvalue(ir_rvalue **rvalue);
+
+   bool progress;
+
+private:
+   bool is_cse_candidate(ir_rvalue *ir, bool *invariant);
+   ae_entry *find(ir_rvalue *ir);
+   ir_variable *move_to_temporary(ir_instruction *before, ir_rvalue *expr);
+   void visit_block(exec_list *instructions);
+
+   /** List of ae_entry: the available expressions. */
+   exec_list ae;
+
+   /** Whether we're inside a function body. */
+   bool in_signature;
+
+   /** Nesting depth of the instruction list being visited. */
+   unsigned depth;
+
+   /** Outermost loop enclosing the current instruction, if any. */
+   ir_loop *loop;
+
+   /** Nesting depth of the instruction list containing \c loop. */
+   unsigned loop_depth;
+
+   /** Temporaries created by this pass, mapped to their ae_entry. */
+   struct hash_table *temps;
+
+   void *mem_ctx;
+   void *lin_ctx;
+};
+
+} /* unnamed namespace */
+
+ir_visitor_status
+is_cse_candidate_visitor::visit(ir_dereference_variable *ir)
+{
+   ir_variable *var = ir->var;
+
+   if (var->mode == ir_var_uniform || var->mode == ir_var_shader_in)
+      return visit_continue;
+
+   /* The temporaries created by the pass are assigned exactly once, before
+    * any of their uses.
+    */
+   ae_entry *entry = (ae_entry *) hash_table_find(temps, var);
+   if (entry) {
+      invariant = invariant && entry->invariant;
+      return visit_continue;
+   }
+
+   /* Other read-only variables (consts and "const in" parameters) are
+    * assigned once as well, but that assignment may sit inside a loop, so
+    * their uses can't be moved around.
+    */
+   if (var->read_only) {
+      invariant = false;
+      return visit_continue;
+   }
+
+   ok = false;
+   return visit_stop;
+}
+
+bool
+cse_visitor::is_cse_candidate(ir_rvalue *ir, bool *invariant)
+{
+   /* Bare dereferences, swizzles and constants are no cheaper to read out of
+    * a temporary, so only consider actual computation.
+    */
+   if (ir->ir_type != ir_type_expression && ir->ir_type != ir_type_texture)
+      return false;
+
+   is_cse_candidate_visitor v(temps);
+
+   ir->accept(&v);
+
+   /* Texturing with implicit derivatives isn't safe to move out of its
+    * control flow.
+    */
+   *invariant = v.invariant && ir->ir_type == ir_type_expression;
+
+   return v.ok;
+}
+
+ae_entry *
+cse_visitor::find(ir_rvalue *ir)
+{
+   foreach_list(node, &this->ae) {
+      ae_entry *entry = (ae_entry *) node;
+
+      if (entry->expr->equals(ir))
+         return entry;
+   }
+
+   return NULL;
+}
+
+/**
+ * Declares a temporary in front of \c before and assigns \c expr to it.
+ */
+ir_variable *
+cse_visitor::move_to_temporary(ir_instruction *before, ir_rvalue *expr)
+{
+   void *ctx = ralloc_parent(before);
+
+   ir_variable *var = new(ctx) ir_variable(expr->type, "cse",
+                                           ir_var_temporary);
+   before->insert_before(var);
+
+   ir_assignment *assignment =
+      new(ctx) ir_assignment(new(ctx) ir_dereference_variable(var), expr,
+                             NULL);
+   before->insert_before(assignment);
+
+   return var;
+}
+
+void
+cse_visitor::handle_rvalue(ir_rvalue **rvalue)
+{
+   if (!*rvalue || !this->in_signature)
+      return;
+
+   bool invariant;
+   if (!is_cse_candidate(*rvalue, &invariant))
+      return;
+
+   void *ctx = ralloc_parent(this->base_ir);
+
+   ae_entry *entry = find(*rvalue);
+   if (entry) {
+      if (!entry->var) {
+         if (debug) {
+            printf("CSE: reusing ");
+            entry->expr->print();
+            printf("\n");
+         }
+
+         entry->var = move_to_temporary(entry->base_ir, entry->expr);
+         *entry->val = new(ctx) ir_dereference_variable(entry->var);
+         entry->val = NULL;
+         hash_table_insert(temps, entry, entry->var);
+      }
+
+      *rvalue = new(ctx) ir_dereference_variable(entry->var);
+      this->progress = true;
+      return;
+   }
+
+   if (invariant && this->loop) {
+      if (debug) {
+         printf("CSE: hoisting ");
+         (*rvalue)->print();
+         printf("\n");
+      }
+
+      entry = new(lin_ctx) ae_entry(this->loop, rvalue, this->loop_depth,
+                                    true);
+      entry->var = move_to_temporary(this->loop, entry->expr);
+      *rvalue = new(ctx) ir_dereference_variable(entry->var);
+      entry->val = NULL;
+      hash_table_insert(temps, entry, entry->var);
+      this->ae.push_tail(entry);
+      this->progress = true;
+      return;
+   }
+
+   entry = new(lin_ctx) ae_entry(this->base_ir, rvalue, this->depth,
+                                 invariant);
+   this->ae.push_tail(entry);
+}
+
+/**
+ * Visits a nested instruction list.
+ *
+ * Available expressions from the enclosing lists dominate the nested one
+ * and stay usable, but anything found inside goes away on the way out.
+ */
+void
+cse_visitor::visit_block(exec_list *instructions)
+{
+   this->depth++;
+
+   visit_list_elements(this, instructions);
+
+   this->depth--;
+
+   foreach_list_safe(node, &this->ae) {
+      ae_entry *entry = (ae_entry *) node;
+
+      if (entry->depth > this->depth)
+         entry->remove();
+   }
+}
+
+ir_visitor_status
+cse_visitor::visit_enter(ir_function_signature *ir)
+{
+   /* Each function body is numbered separately.  Any instructions at global
+    * scope will be shuffled into main() at link time, so they're irrelevant
+    * to us.
+    */
+   this->ae.make_empty();
+   this->depth = 0;
+   this->loop = NULL;
+   this->in_signature = true;
+
+   visit_list_elements(this, &ir->body);
+
+   this->in_signature = false;
+   this->ae.make_empty();
+
+   return visit_continue_with_parent;
+}
+
+ir_visitor_status
+cse_visitor::visit_enter(ir_if *ir)
+{
+   ir->condition->accept(this);
+   handle_rvalue(&ir->condition);
+
+   visit_block(&ir->then_instructions);
+   visit_block(&ir->else_instructions);
+
+   return visit_continue_with_parent;
+}
+
+ir_visitor_status
+cse_visitor::visit_enter(ir_loop *ir)
+{
+   bool outermost = this->loop == NULL;
+
+   if (outermost) {
+      this->loop = ir;
+      this->loop_depth = this->depth;
+   }
+
+   visit_block(&ir->body_instructions);
+
+   if (outermost)
+      this->loop = NULL;
+
+   return visit_continue_with_parent;
+}
+
+/**
+ * Does a value numbering pass on the code present in the instruction stream.
+ */
+bool
+do_cse(exec_list *instructions)
+{
+   cse_visitor v;
+
+   visit_list_elements(&v, instructions);
+
+   return v.progress;
+}
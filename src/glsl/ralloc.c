@@ -56,6 +56,9 @@ struct ralloc_header
    /* A canary value used to determine whether a pointer is ralloc'd. */
    unsigned canary;
 
+   /* Size of the block, or zero if it isn't counted in the statistics. */
+   unsigned size;
+
    struct ralloc_header *parent;
 
    /* The first child (head of a linked list) */
@@ -73,6 +76,19 @@ typedef struct ralloc_header ralloc_header;
 static void unlink_block(ralloc_header *info);
 static void unsafe_free(ralloc_header *info);
 
+static bool stats_enabled = false;
+static struct ralloc_stats global_stats;
+
+static void
+count_bytes(ralloc_header *info, size_t size)
+{
+   global_stats.bytes_live += size - info->size;
+   info->size = size;
+
+   if (global_stats.bytes_live > global_stats.bytes_peak)
+      global_stats.bytes_peak = global_stats.bytes_live;
+}
+
 static ralloc_header *
 get_header(const void *ptr)
 {
@@ -115,6 +131,11 @@ ralloc_size(const void *ctx, size_t size)
 
    info->canary = CANARY;
 
+   if (unlikely(stats_enabled)) {
+      global_stats.num_allocations++;
+      count_bytes(info, size);
+   }
+
    return PTR_FROM_HEADER(info);
 }
 
@@ -155,6 +176,9 @@ resize(void *ptr, size_t size)
    for (child = info->child; child != NULL; child = child->next)
       child->parent = info;
 
+   if (unlikely(stats_enabled))
+      count_bytes(info, size);
+
    return PTR_FROM_HEADER(info);
 }
 
@@ -242,6 +266,9 @@ unsafe_free(ralloc_header *info)
    if (info->destructor != NULL)
       info->destructor(PTR_FROM_HEADER(info));
 
+   if (unlikely(info->size != 0))
+      global_stats.bytes_live -= info->size;
+
    free(info);
 }
 
@@ -480,3 +507,227 @@ ralloc_vasprintf_rewrite_tail(char **str, size_t *start, const char *fmt,
    *start += new_length;
    return true;
 }
+
+/*
+ * Linear allocator: allocations are carved out of large ralloc'd buffers by
+ * bumping an offset.  The first buffer is allocated in the caller's ralloc
+ * context, and any additional buffers are ralloc children of the first one,
+ * so freeing the first buffer releases the whole arena.
+ */
+
+#define LINEAR_MAGIC 0x87b9c7d3
+
+#define MIN_LINEAR_BUFSIZE 4096
+#define SUBALLOC_ALIGNMENT 8
+
+#define ALIGN_POT(x, pot) (((x) + (pot) - 1) & ~((pot) - 1))
+
+struct linear_header {
+   unsigned magic;
+
+   /* Offset of the first unused byte in this buffer. */
+   unsigned offset;
+
+   /* Size of the buffer, not counting this header. */
+   unsigned size;
+
+   /* The buffer new allocations come from.  Only valid in the first buffer
+    * of an arena.
+    */
+   struct linear_header *latest;
+
+   /* Statistics for the whole arena.  Only valid in the first buffer. */
+   struct linear_stats stats;
+};
+
+typedef struct linear_header linear_header;
+
+#define LINEAR_HEADER_SIZE ALIGN_POT(sizeof(linear_header), SUBALLOC_ALIGNMENT)
+
+#define LINEAR_PARENT_TO_HEADER(parent) \
+   ((linear_header *) ((char *) (parent) - LINEAR_HEADER_SIZE))
+
+#define LINEAR_BUFFER(node) (((char *) (node)) + LINEAR_HEADER_SIZE)
+
+static linear_header *
+get_linear_header(const void *parent)
+{
+   linear_header *first = LINEAR_PARENT_TO_HEADER(parent);
+   assert(first->magic == LINEAR_MAGIC);
+   return first;
+}
+
+static linear_header *
+create_linear_node(void *ralloc_ctx, unsigned min_size)
+{
+   linear_header *node;
+
+   if (min_size < MIN_LINEAR_BUFSIZE)
+      min_size = MIN_LINEAR_BUFSIZE;
+
+   node = ralloc_size(ralloc_ctx, LINEAR_HEADER_SIZE + min_size);
+   if (unlikely(node == NULL))
+      return NULL;
+
+   node->magic = LINEAR_MAGIC;
+   node->offset = 0;
+   node->size = min_size;
+   node->latest = node;
+   memset(&node->stats, 0, sizeof(node->stats));
+
+   return node;
+}
+
+void *
+linear_alloc_parent(void *ralloc_ctx, unsigned size)
+{
+   linear_header *first;
+
+   size = ALIGN_POT(size, SUBALLOC_ALIGNMENT);
+
+   first = create_linear_node(ralloc_ctx, size);
+   if (unlikely(first == NULL))
+      return NULL;
+
+   first->offset = size;
+   first->stats.num_allocations = 1;
+   first->stats.num_buffers = 1;
+   first->stats.bytes_allocated = size;
+   first->stats.bytes_reserved = first->size;
+
+   if (unlikely(stats_enabled))
+      global_stats.num_linear_allocations++;
+
+   return LINEAR_BUFFER(first);
+}
+
+void *
+linear_zalloc_parent(void *ralloc_ctx, unsigned size)
+{
+   void *ptr = linear_alloc_parent(ralloc_ctx, size);
+   if (likely(ptr != NULL))
+      memset(ptr, 0, size);
+   return ptr;
+}
+
+void *
+linear_alloc_child(void *parent, unsigned size)
+{
+   linear_header *first = get_linear_header(parent);
+   linear_header *node = first->latest;
+   void *ptr;
+
+   size = ALIGN_POT(size, SUBALLOC_ALIGNMENT);
+
+   if (unlikely(node->offset + size > node->size)) {
+      node = create_linear_node(first, size);
+      if (unlikely(node == NULL))
+	 return NULL;
+
+      first->stats.num_buffers++;
+      first->stats.bytes_reserved += node->size;
+
+      /* Keep allocating from the old buffer if an oversized request left
+       * the new one with less room than it has.
+       */
+      if (node->size - size > first->latest->size - first->latest->offset)
+	 first->latest = node;
+   }
+
+   ptr = LINEAR_BUFFER(node) + node->offset;
+   node->offset += size;
+
+   first->stats.num_allocations++;
+   first->stats.bytes_allocated += size;
+
+   if (unlikely(stats_enabled))
+      global_stats.num_linear_allocations++;
+
+   return ptr;
+}
+
+void *
+linear_zalloc_child(void *parent, unsigned size)
+{
+   void *ptr = linear_alloc_child(parent, size);
+   if (likely(ptr != NULL))
+      memset(ptr, 0, size);
+   return ptr;
+}
+
+void
+linear_free_parent(void *ptr)
+{
+   if (unlikely(ptr == NULL))
+      return;
+
+   ralloc_free(get_linear_header(ptr));
+}
+
+void
+linear_get_stats(void *parent, struct linear_stats *stats)
+{
+   *stats = get_linear_header(parent)->stats;
+}
+
+char *
+linear_strdup(void *parent, const char *str)
+{
+   size_t n;
+   char *ptr;
+
+   if (unlikely(str == NULL))
+      return NULL;
+
+   n = strlen(str);
+   ptr = linear_alloc_child(parent, n + 1);
+   if (unlikely(ptr == NULL))
+      return NULL;
+
+   memcpy(ptr, str, n);
+   ptr[n] = '\0';
+   return ptr;
+}
+
+char *
+linear_asprintf(void *parent, const char *fmt, ...)
+{
+   char *ptr;
+   va_list args;
+   va_start(args, fmt);
+   ptr = linear_vasprintf(parent, fmt, args);
+   va_end(args);
+   return ptr;
+}
+
+char *
+linear_vasprintf(void *parent, const char *fmt, va_list args)
+{
+   size_t size = printf_length(fmt, args) + 1;
+
+   char *ptr = linear_alloc_child(parent, size);
+   if (ptr != NULL)
+      vsnprintf(ptr, size, fmt, args);
+
+   return ptr;
+}
+
+void
+ralloc_enable_stats(void)
+{
+   stats_enabled = true;
+}
+
+void
+ralloc_get_stats(struct ralloc_stats *stats)
+{
+   *stats = global_stats;
+}
+
+void
+ralloc_reset_stats(void)
+{
+   global_stats.num_allocations = 0;
+   global_stats.num_linear_allocations = 0;
+   global_stats.bytes_peak = global_stats.bytes_live;
+}
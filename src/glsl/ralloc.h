@@ -400,8 +400,148 @@ bool ralloc_asprintf_append (char **str, const char *fmt, ...)
 bool ralloc_vasprintf_append(char **str, const char *fmt, va_list args);
 /// @}
 
+/// \defgroup linear Linear (Arena) Allocators @{
+/**
+ * Linear allocation is an alternative to ralloc for large numbers of small,
+ * short-lived objects that are all released together, such as the nodes of
+ * an AST or the bookkeeping of an optimization pass.
+ *
+ * A linear context is created with linear_alloc_parent(), which returns the
+ * first allocation of the arena; that pointer is then passed as the parent of
+ * every further allocation.  Children are carved out of large buffers by
+ * bumping an offset: they carry no header, can't be freed, resized or stolen
+ * individually, and must not be passed to any ralloc function.  The whole
+ * arena is released by linear_free_parent(), or when the ralloc context it
+ * was created in is freed.
+ */
+
+/**
+ * Create a linear context and return its first allocation.
+ *
+ * \param ralloc_ctx  ralloc context that owns the arena.  May be NULL.
+ * \param size        Size of the first allocation.  May be 0 when the
+ *                    returned pointer is only used as a parent.
+ */
+void *linear_alloc_parent(void *ralloc_ctx, unsigned size);
+
+/**
+ * Same as linear_alloc_parent(), but the first allocation is zeroed.
+ */
+void *linear_zalloc_parent(void *ralloc_ctx, unsigned size);
+
+/**
+ * Allocate memory out of a linear context.
+ *
+ * \param parent  Pointer returned by linear_alloc_parent().
+ */
+void *linear_alloc_child(void *parent, unsigned size);
+
+/**
+ * Allocate zero-initialized memory out of a linear context.
+ */
+void *linear_zalloc_child(void *parent, unsigned size);
+
+/**
+ * Free a linear context and everything allocated out of it.
+ */
+void linear_free_parent(void *ptr);
+
+/**
+ * Allocation statistics of a linear context.
+ */
+struct linear_stats {
+   unsigned num_allocations; /**< Number of allocations, including the parent */
+   unsigned num_buffers;     /**< Number of buffers backing the arena */
+   size_t bytes_allocated;   /**< Bytes handed out, after alignment */
+   size_t bytes_reserved;    /**< Bytes of backing storage */
+};
+
+/**
+ * Query the allocation statistics of a linear context.
+ */
+void linear_get_stats(void *parent, struct linear_stats *stats);
+
+/**
+ * Duplicate a string, allocating the memory out of a linear context.
+ */
+char *linear_strdup(void *parent, const char *str);
+
+/**
+ * Print to a string allocated out of a linear context.
+ */
+char *linear_asprintf(void *parent, const char *fmt, ...) PRINTFLIKE(2, 3);
+
+/**
+ * Print to a string allocated out of a linear context, given a va_list.
+ */
+char *linear_vasprintf(void *parent, const char *fmt, va_list args);
+/// @}
+
+/// \defgroup stats Allocation Statistics @{
+/**
+ * Process-wide allocation statistics, for tools like glsl_compiler.
+ *
+ * Nothing is counted until ralloc_enable_stats() is called, and blocks
+ * allocated before that are ignored when they are freed.  The counters are
+ * not protected by a lock, so they are only meaningful in single-threaded
+ * programs.
+ */
+struct ralloc_stats {
+   unsigned long num_allocations;        /**< Blocks ralloc'd */
+   unsigned long num_linear_allocations; /**< Allocations out of linear contexts */
+   size_t bytes_live;                    /**< Bytes held by counted blocks */
+   size_t bytes_peak;                    /**< High-water mark of bytes_live */
+};
+
+/**
+ * Start collecting allocation statistics.
+ */
+void ralloc_enable_stats(void);
+
+/**
+ * Query the allocation statistics collected since the last reset.
+ */
+void ralloc_get_stats(struct ralloc_stats *stats);
+
+/**
+ * Zero the allocation counts and restart the high-water mark from the bytes
+ * currently live.
+ */
+void ralloc_reset_stats(void);
+/// @}
+
 #ifdef __cplusplus
 } /* end of extern "C" */
 #endif
 
+#ifdef __cplusplus
+/**
+ * Declare C++ placement new and delete operators that allocate out of a
+ * linear context.
+ *
+ * Objects declared this way must be created with the pointer returned by
+ * linear_alloc_parent() as the placement argument.  Deleting them is a no-op;
+ * their memory is reclaimed when the linear context is freed.
+ */
+#define LINEAR_CXX_OPERATORS(ALLOC_FUNC)                               \
+public:                                                                \
+   static void* operator new(size_t size, void *mem_ctx)               \
+   {                                                                   \
+      void *p = ALLOC_FUNC(mem_ctx, size);                             \
+      assert(p != NULL);                                               \
+      return p;                                                        \
+   }                                                                   \
+                                                                       \
+   static void operator delete(void *p)                                \
+   {                                                                   \
+      (void) p;                                                        \
+   }
+
+#define DECLARE_LINEAR_ALLOC_CXX_OPERATORS \
+   LINEAR_CXX_OPERATORS(linear_alloc_child)
+
+#define DECLARE_LINEAR_ZALLOC_CXX_OPERATORS \
+   LINEAR_CXX_OPERATORS(linear_zalloc_child)
+#endif
+
 #endif
@@ -36,3 +36,105 @@ TEST(ralloc_test, null_parent)
    EXPECT_EQ(NULL, ralloc_parent(mem_ctx));
 }
 /*@}*/
+
+/**
+ * \name Linear allocation
+ */
+/*@{*/
+TEST(ralloc_test, linear_children_are_distinct_and_aligned)
+{
+   void *mem_ctx = ralloc_context(NULL);
+   void *lin_ctx = linear_alloc_parent(mem_ctx, 0);
+   char *prev = NULL;
+
+   for (unsigned i = 1; i < 1000; i++) {
+      char *p = (char *) linear_alloc_child(lin_ctx, i % 37 + 1);
+
+      ASSERT_NE((char *) NULL, p);
+      EXPECT_EQ(0u, (unsigned) ((uintptr_t) p % 8));
+      if (prev != NULL)
+         EXPECT_NE(prev, p);
+
+      memset(p, 0xff, i % 37 + 1);
+      prev = p;
+   }
+
+   ralloc_free(mem_ctx);
+}
+
+TEST(ralloc_test, linear_zalloc_and_strings)
+{
+   void *lin_ctx = linear_zalloc_parent(NULL, 64);
+   unsigned char *zeroed = (unsigned char *) lin_ctx;
+
+   for (unsigned i = 0; i < 64; i++)
+      EXPECT_EQ(0, zeroed[i]);
+
+   char *big = (char *) linear_zalloc_child(lin_ctx, 100000);
+   ASSERT_NE((char *) NULL, big);
+   EXPECT_EQ(0, big[0]);
+   EXPECT_EQ(0, big[99999]);
+
+   EXPECT_STREQ("gl_Position", linear_strdup(lin_ctx, "gl_Position"));
+   EXPECT_STREQ("#anon_struct_0001",
+                linear_asprintf(lin_ctx, "#anon_struct_%04x", 1));
+
+   linear_free_parent(lin_ctx);
+}
+
+TEST(ralloc_test, linear_stats)
+{
+   void *lin_ctx = linear_alloc_parent(NULL, 4);
+   struct linear_stats stats;
+
+   linear_get_stats(lin_ctx, &stats);
+   EXPECT_EQ(1u, stats.num_allocations);
+   EXPECT_EQ(1u, stats.num_buffers);
+   EXPECT_EQ(8u, stats.bytes_allocated);
+
+   for (unsigned i = 0; i < 10000; i++)
+      linear_alloc_child(lin_ctx, 16);
+
+   linear_get_stats(lin_ctx, &stats);
+   EXPECT_EQ(10001u, stats.num_allocations);
+   EXPECT_EQ(8u + 16u * 10000u, stats.bytes_allocated);
+   EXPECT_LT(1u, stats.num_buffers);
+   EXPECT_LE(stats.bytes_allocated, stats.bytes_reserved);
+
+   linear_free_parent(lin_ctx);
+}
+
+TEST(ralloc_test, global_stats)
+{
+   struct ralloc_stats stats;
+
+   ralloc_enable_stats();
+   ralloc_reset_stats();
+
+   void *mem_ctx = ralloc_context(NULL);
+   char *str = (char *) ralloc_size(mem_ctx, 100);
+   str = (char *) reralloc_size(mem_ctx, str, 1000);
+
+   void *lin_ctx = linear_alloc_parent(mem_ctx, 0);
+   for (unsigned i = 0; i < 10; i++)
+      linear_alloc_child(lin_ctx, 16);
+
+   ralloc_get_stats(&stats);
+   EXPECT_EQ(3u, stats.num_allocations);
+   EXPECT_EQ(11u, stats.num_linear_allocations);
+   EXPECT_LE(1000u, stats.bytes_live);
+   EXPECT_EQ(stats.bytes_live, stats.bytes_peak);
+
+   size_t live = stats.bytes_live;
+   ralloc_free(str);
+   ralloc_get_stats(&stats);
+   EXPECT_EQ(live - 1000, stats.bytes_live);
+   EXPECT_EQ(live, stats.bytes_peak);
+
+   ralloc_free(mem_ctx);
+   ralloc_reset_stats();
+   ralloc_get_stats(&stats);
+   EXPECT_EQ(0u, stats.num_allocations);
+   EXPECT_EQ(0u, stats.bytes_peak);
+}
+/*@}*/
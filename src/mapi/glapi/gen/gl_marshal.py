@@ -0,0 +1,447 @@
+#!/usr/bin/env python
+
+# Copyright (C) 2026 agent <agent@local>
+#
+# Permission is hereby granted, free of charge, to any person obtaining a
+# copy of this software and associated documentation files (the "Software"),
+# to deal in the Software without restriction, including without limitation
+# the rights to use, copy, modify, merge, publish, distribute, sublicense,
+# and/or sell copies of the Software, and to permit persons to whom the
+# Software is furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice (including the next
+# paragraph) shall be included in all copies or substantial portions of the
+# Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+# THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+# IN THE SOFTWARE.
+
+# This script generates the file marshal_generated.c, which contains the
+# functions that record GL calls into glthread command batches
+# (_mesa_marshal_*), the functions that execute them on the server thread
+# (_mesa_unmarshal_*), and _mesa_create_marshal_table().
+#
+# Each command is a struct holding every parameter by value.  Arrays that
+# the XML gives a size for are copied into the batch right after the struct.
+# Calls that can't be recorded that way (because they return something, or
+# take a pointer we can't copy) are recorded the same way without copying,
+# and the application thread then waits for them to be executed.
+
+import license
+import gl_XML
+import re
+import sys, getopt
+
+
+header = """/**
+ * \\file marshal_generated.c
+ * Marshalling of GL calls for glthread.
+ */
+
+#include "main/api_exec.h"
+#include "main/context.h"
+#include "main/dispatch.h"
+#include "main/glthread.h"
+#include "main/imports.h"
+#include "main/marshal.h"
+"""
+
+
+# Calls that must not return before they have been executed.
+sync_functions = set(['Finish'])
+
+# Calls after which the current batch is handed to the server thread.
+flush_functions = set(['Flush'])
+
+# Vertex array tracking, called with the call's parameters before the call
+# is recorded.
+hook_functions = {
+    'BindBuffer': '_mesa_glthread_BindBuffer',
+    'DeleteBuffers': '_mesa_glthread_DeleteBuffers',
+    'BindVertexArray': '_mesa_glthread_BindVertexArray',
+    'BindVertexArrayAPPLE': '_mesa_glthread_BindVertexArray',
+    'DeleteVertexArrays': '_mesa_glthread_DeleteVertexArrays',
+    'ClientActiveTexture': '_mesa_glthread_ClientActiveTexture',
+    'Enable': '_mesa_glthread_Enable',
+    'Disable': '_mesa_glthread_Disable',
+    'EnableClientState': '_mesa_glthread_EnableClientState',
+    'DisableClientState': '_mesa_glthread_DisableClientState',
+    'EnableVertexAttribArray': '_mesa_glthread_EnableVertexAttribArray',
+    'DisableVertexAttribArray': '_mesa_glthread_DisableVertexAttribArray',
+    }
+
+# Calls that change the vertex arrays in ways not tracked above.  They are
+# synchronous, and the tracked state is read back from the context after
+# them.
+client_array_functions = set([
+    'PopClientAttrib',
+    'InterleavedArrays',
+    'ColorPointerListIBM',
+    'EdgeFlagPointerListIBM',
+    'FogCoordPointerListIBM',
+    'IndexPointerListIBM',
+    'NormalPointerListIBM',
+    'SecondaryColorPointerListIBM',
+    'TexCoordPointerListIBM',
+    'VertexPointerListIBM',
+    'ColorPointervINTEL',
+    'NormalPointervINTEL',
+    'TexCoordPointervINTEL',
+    'VertexPointervINTEL',
+    ])
+
+# Calls that may read vertices (and indices) from the current vertex
+# arrays.  Their pointer parameter is an offset into the element array
+# buffer when they can be deferred.
+draw_re = re.compile(r'^(ArrayElement|Draw(Arrays|Elements|RangeElements|TransformFeedback))')
+
+# gl*Pointer calls.  Their pointer parameter is an offset into the array
+# buffer when they can be deferred.
+pointer_re = re.compile(r'^(\w+Pointer)(ARB|EXT|NV|OES)?$')
+
+# The VERT_ATTRIB_* value of the array set by gl*Pointer calls.  Arrays that
+# draws don't read aren't tracked.
+pointer_attribs = {
+    'VertexPointer': 'VERT_ATTRIB_POS',
+    'NormalPointer': 'VERT_ATTRIB_NORMAL',
+    'ColorPointer': 'VERT_ATTRIB_COLOR0',
+    'SecondaryColorPointer': 'VERT_ATTRIB_COLOR1',
+    'FogCoordPointer': 'VERT_ATTRIB_FOG',
+    'IndexPointer': 'VERT_ATTRIB_COLOR_INDEX',
+    'EdgeFlagPointer': 'VERT_ATTRIB_EDGEFLAG',
+    'TexCoordPointer': 'VERT_ATTRIB_TEX(ctx->GLThread->ClientActiveTexture)',
+    'PointSizePointer': 'VERT_ATTRIB_POINT_SIZE',
+    }
+generic_pointer_functions = set(['VertexAttribPointer', 'VertexAttribIPointer'])
+
+# Uniform arrays.  The XML doesn't say how large the value array is.
+uniform_re = re.compile(r'^(Program)?Uniform(Matrix)?([1-4])(x([2-4]))?(f|i|ui|d)v$')
+
+unsigned_types = set(['GLuint', 'GLenum', 'GLbitfield', 'GLubyte',
+                      'GLushort', 'GLboolean'])
+
+
+class marshal_item(object):
+    """How a GL function is marshalled."""
+
+    def __init__(self, func):
+        self.func = func
+        self.name = func.name
+        self.params = [p for p in func.parameters if not p.is_padding]
+
+        # Pointer parameters whose data is copied into the batch, as
+        # (parameter, size expression, counter parameter or None).
+        self.copied = []
+
+        # Expression that must hold for the call to be deferred, or None.
+        self.condition = None
+
+        # Statement to run before the call is recorded, or None.
+        self.hook = None
+
+        # Statement to run after a synchronous call, or None.
+        self.post_hook = None
+
+        self.sync = self.name in sync_functions
+        self.flush = self.name in flush_functions
+
+        if func.return_type != 'void':
+            self.sync = True
+
+        if self.name in hook_functions:
+            self.hook = '{0}(ctx, {1});'.format(
+                hook_functions[self.name], func.get_called_parameter_string())
+        elif self.name in client_array_functions:
+            self.post_hook = '_mesa_glthread_update_arrays(ctx);'
+            self.sync = True
+
+        by_value = None
+        if draw_re.match(self.name) and 'Indirect' not in self.name:
+            indexed = 'Elements' in self.name
+            self.condition = '_mesa_glthread_can_defer_draw(ctx, {0})'.format(
+                'true' if indexed else 'false')
+            by_value = 'indices'
+        elif pointer_re.match(self.name) and not self.name.startswith('Get'):
+            m = pointer_re.match(self.name)
+            if m.group(1) in generic_pointer_functions and m.group(2) != 'NV':
+                self.condition = \
+                    '_mesa_glthread_generic_attrib_pointer(ctx, index)'
+            else:
+                attrib = 'VERT_ATTRIB_MAX'
+                if m.group(2) != 'NV':
+                    attrib = pointer_attribs.get(m.group(1), attrib)
+                self.condition = \
+                    '_mesa_glthread_attrib_pointer(ctx, {0})'.format(attrib)
+            by_value = 'pointer'
+
+        names = [p.name for p in self.params]
+        for p in self.params:
+            if not p.is_pointer() or p.name == by_value:
+                continue
+
+            size = self.copy_size(p, names)
+            if size is None:
+                self.sync = True
+            else:
+                self.copied.append((p, size[0], size[1]))
+
+        if self.sync:
+            self.copied = []
+            self.condition = None
+            self.flush = False
+
+    def copy_size(self, p, names):
+        """Return (size expression, counter) for a pointer parameter that
+        can be copied into the batch, or None."""
+        t = p.type_string()
+        if (not t.startswith('const ') or t.count('*') != 1 or
+            p.is_output or p.is_image() or p.count_parameter_list):
+            return None
+
+        if p.count:
+            return ('{0}'.format(p.size()), None)
+
+        if p.counter and p.counter in names:
+            return ('(size_t) {0} * {1}'.format(p.counter, p.size()),
+                    p.counter)
+
+        m = uniform_re.match(self.name)
+        if m and p.name == 'value' and 'count' in names:
+            components = int(m.group(3))
+            if m.group(2):
+                components *= int(m.group(5) or m.group(3))
+            return ('(size_t) count * {0}'.format(components * p.size()),
+                    'count')
+
+        return None
+
+    def counter_is_signed(self, counter):
+        for p in self.params:
+            if p.name == counter:
+                return p.type_string() not in unsigned_types
+        return True
+
+
+class PrintCode(gl_XML.gl_print_base):
+    def __init__(self):
+        gl_XML.gl_print_base.__init__(self)
+
+        self.name = 'gl_marshal.py'
+        self.license = license.bsd_license_template % (
+            'Copyright (C) 2013 Intel Corporation', 'INTEL')
+
+    def printRealHeader(self):
+        print header
+
+    def printRealFooter(self):
+        pass
+
+    def print_struct(self, item):
+        print 'struct marshal_cmd_{0}'.format(item.name)
+        print '{'
+        print '   struct marshal_cmd_base cmd_base;'
+        for p in item.params:
+            print '   {0};'.format(p.string())
+        if item.func.return_type != 'void':
+            print '   {0} *result;'.format(item.func.return_type)
+        print '};'
+
+    def print_unmarshal(self, item):
+        print 'static inline void'
+        print '_mesa_unmarshal_{0}(struct gl_context *ctx, ' \
+            'const struct marshal_cmd_{0} *cmd)'.format(item.name)
+        print '{'
+        args = ', '.join(['cmd->{0}'.format(p.name) for p in item.params])
+        if item.func.return_type != 'void':
+            print '   *cmd->result = CALL_{0}(ctx->CurrentDispatch, ({1}));' \
+                .format(item.name, args)
+        else:
+            print '   CALL_{0}(ctx->CurrentDispatch, ({1}));'.format(
+                item.name, args)
+        print '}'
+
+    def print_sync_call(self, item, indent):
+        print '{0}cmd = _mesa_glthread_allocate_command(ctx, ' \
+            'DISPATCH_CMD_{1}, MARSHAL_ALIGN(sizeof(*cmd)));'.format(
+            indent, item.name)
+        for p in item.params:
+            print '{0}cmd->{1} = {1};'.format(indent, p.name)
+        if item.func.return_type != 'void':
+            print '{0}cmd->result = &result;'.format(indent)
+        print '{0}_mesa_glthread_finish(ctx);'.format(indent)
+
+    def print_async_call(self, item, indent):
+        print '{0}cmd = _mesa_glthread_allocate_command(ctx, ' \
+            'DISPATCH_CMD_{1}, cmd_size);'.format(indent, item.name)
+        copied = [c[0].name for c in item.copied]
+        for p in item.params:
+            if p.name not in copied:
+                print '{0}cmd->{1} = {1};'.format(indent, p.name)
+        if item.copied:
+            print '{0}variable_data = (uint8_t *) cmd + ' \
+                'MARSHAL_ALIGN(sizeof(*cmd));'.format(indent)
+        for (p, size, counter) in item.copied:
+            print '{0}if ({1}) {{'.format(indent, p.name)
+            print '{0}   memcpy(variable_data, {1}, {1}_size);'.format(
+                indent, p.name)
+            print '{0}   cmd->{1} = ({2}) variable_data;'.format(
+                indent, p.name, p.type_string())
+            print '{0}   variable_data += MARSHAL_ALIGN({1}_size);'.format(
+                indent, p.name)
+            print '{0}}} else {{'.format(indent)
+            print '{0}   cmd->{1} = NULL;'.format(indent, p.name)
+            print '{0}}}'.format(indent)
+        if item.flush:
+            print '{0}_mesa_glthread_flush_batch(ctx);'.format(indent)
+
+    def print_marshal(self, item):
+        func = item.func
+        print 'static {0} GLAPIENTRY'.format(func.return_type)
+        print '_mesa_marshal_{0}({1})'.format(
+            item.name, func.get_parameter_string())
+        print '{'
+        print '   GET_CURRENT_CONTEXT(ctx);'
+        print '   struct marshal_cmd_{0} *cmd;'.format(item.name)
+        if func.return_type != 'void':
+            print '   {0} result;'.format(func.return_type)
+
+        if item.sync:
+            if item.hook:
+                print '   {0}'.format(item.hook)
+            self.print_sync_call(item, '   ')
+            if item.post_hook:
+                print '   {0}'.format(item.post_hook)
+            if func.return_type != 'void':
+                print '   return result;'
+            print '}'
+            return
+
+        print '   size_t cmd_size = MARSHAL_ALIGN(sizeof(*cmd));'
+        if item.copied:
+            print '   uint8_t *variable_data;'
+            print '   bool async = true;'
+            for (p, size, counter) in item.copied:
+                print '   size_t {0}_size = 0;'.format(p.name)
+        print
+
+        if item.hook:
+            print '   {0}'.format(item.hook)
+
+        for (p, size, counter) in item.copied:
+            print '   if ({0}) {{'.format(p.name)
+            if counter:
+                checks = []
+                if item.counter_is_signed(counter):
+                    checks.append('{0} < 0'.format(counter))
+                checks.append('{0} > MARSHAL_MAX_CMD_SIZE'.format(counter))
+                print '      if ({0})'.format(' || '.join(checks))
+                print '         async = false;'
+                print '      else'
+                print '         {0}_size = {1};'.format(p.name, size)
+            else:
+                print '      {0}_size = {1};'.format(p.name, size)
+            print '      cmd_size += MARSHAL_ALIGN({0}_size);'.format(p.name)
+            print '   }'
+
+        if item.copied:
+            async = 'async && cmd_size <= MARSHAL_MAX_CMD_SIZE'
+            if item.condition:
+                async += ' && ' + item.condition
+        else:
+            async = item.condition
+
+        if async:
+            print '   if ({0}) {{'.format(async)
+            self.print_async_call(item, '      ')
+            print '   } else {'
+            self.print_sync_call(item, '      ')
+            print '   }'
+        else:
+            self.print_async_call(item, '   ')
+        print '}'
+
+    def printBody(self, api):
+        items = [marshal_item(f) for f in api.functionIterateByOffset()]
+
+        print 'enum marshal_dispatch_cmd_id'
+        print '{'
+        for item in items:
+            print '   DISPATCH_CMD_{0},'.format(item.name)
+        print '};'
+        print
+
+        for item in items:
+            print '/* {0}: {1} */'.format(item.name,
+                                          'sync' if item.sync else 'async')
+            self.print_struct(item)
+            print
+            self.print_unmarshal(item)
+            print
+            self.print_marshal(item)
+            print
+            print
+
+        print 'size_t'
+        print '_mesa_unmarshal_dispatch_cmd(struct gl_context *ctx, ' \
+            'const void *cmd)'
+        print '{'
+        print '   const struct marshal_cmd_base *cmd_base = cmd;'
+        print
+        print '   switch (cmd_base->cmd_id) {'
+        for item in items:
+            print '   case DISPATCH_CMD_{0}:'.format(item.name)
+            print '      _mesa_unmarshal_{0}(ctx, ' \
+                '(const struct marshal_cmd_{0} *) cmd);'.format(item.name)
+            print '      break;'
+        print '   default:'
+        print '      assert(!"Unrecognized command ID");'
+        print '      break;'
+        print '   }'
+        print
+        print '   return cmd_base->cmd_size;'
+        print '}'
+        print
+        print
+
+        print 'struct _glapi_table *'
+        print '_mesa_create_marshal_table(void)'
+        print '{'
+        print '   struct _glapi_table *table;'
+        print
+        print '   table = _mesa_alloc_dispatch_table();'
+        print '   if (table == NULL)'
+        print '      return NULL;'
+        print
+        for item in items:
+            print '   SET_{0}(table, _mesa_marshal_{0});'.format(item.name)
+        print
+        print '   return table;'
+        print '}'
+
+
+def show_usage():
+    print "Usage: %s [-f input_file_name]" % sys.argv[0]
+    sys.exit(1)
+
+
+if __name__ == '__main__':
+    file_name = "gl_and_es_API.xml"
+
+    try:
+        (args, trail) = getopt.getopt(sys.argv[1:], "f:")
+    except Exception,e:
+        show_usage()
+
+    for (arg,val) in args:
+        if arg == "-f":
+            file_name = val
+
+    printer = PrintCode()
+
+    api = gl_XML.parse_GL_API(file_name)
+    printer.Print(api)
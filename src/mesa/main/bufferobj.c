@@ -34,6 +34,7 @@
 #include "glheader.h"
 #include "enums.h"
 #include "hash.h"
+#include "hash_table.h"
 #include "imports.h"
 #include "image.h"
 #include "context.h"
@@ -260,6 +261,7 @@ _mesa_delete_buffer_object(struct gl_context *ctx,
    (void) ctx;
 
    free(bufObj->Data);
+   _mesa_hash_table_destroy(bufObj->MinMaxCache, NULL);
 
    /* assign strange values here to help w/ debugging */
    bufObj->RefCount = -1000;
@@ -725,6 +727,12 @@ bind_buffer_object(struct gl_context *ctx, GLenum target, GLuint buffer)
          return;
    }
    
+   /* Buffers which the GPU writes to can't have their index scans cached,
+    * as we would not notice when the contents change.
+    */
+   if (target == GL_PIXEL_PACK_BUFFER || target == GL_TRANSFORM_FEEDBACK_BUFFER)
+      newBufObj->MinMaxCacheDisabled = GL_TRUE;
+
    /* bind new buffer */
    _mesa_reference_buffer_object(ctx, bindTarget, newBufObj);
 
@@ -1064,6 +1072,7 @@ _mesa_BufferData(GLenum target, GLsizeiptrARB size,
    FLUSH_VERTICES(ctx, _NEW_BUFFER_OBJECT);
 
    bufObj->Written = GL_TRUE;
+   bufObj->MinMaxCacheDirty = GL_TRUE;
 
 #ifdef VBO_DEBUG
    printf("glBufferDataARB(%u, sz %ld, from %p, usage 0x%x)\n",
@@ -1099,6 +1108,7 @@ _mesa_BufferSubData(GLenum target, GLintptrARB offset,
       return;
 
    bufObj->Written = GL_TRUE;
+   bufObj->MinMaxCacheDirty = GL_TRUE;
 
    ASSERT(ctx->Driver.BufferSubData);
    ctx->Driver.BufferSubData( ctx, offset, size, data, bufObj );
@@ -1190,8 +1200,10 @@ _mesa_MapBuffer(GLenum target, GLenum access)
       bufObj->AccessFlags = accessFlags;
    }
 
-   if (access == GL_WRITE_ONLY_ARB || access == GL_READ_WRITE_ARB)
+   if (access == GL_WRITE_ONLY_ARB || access == GL_READ_WRITE_ARB) {
       bufObj->Written = GL_TRUE;
+      bufObj->MinMaxCacheDirty = GL_TRUE;
+   }
 
 #ifdef VBO_DEBUG
    printf("glMapBufferARB(%u, sz %ld, access 0x%x)\n",
@@ -1477,6 +1489,8 @@ _mesa_CopyBufferSubData(GLenum readTarget, GLenum writeTarget,
       }
    }
 
+   dst->MinMaxCacheDirty = GL_TRUE;
+
    ctx->Driver.CopyBufferSubData(ctx, src, dst, readOffset, writeOffset, size);
 }
 
@@ -1606,6 +1620,9 @@ _mesa_MapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length,
       ASSERT(bufObj->AccessFlags == access);
    }
 
+   if (access & GL_MAP_WRITE_BIT)
+      bufObj->MinMaxCacheDirty = GL_TRUE;
+
    return map;
 }
 
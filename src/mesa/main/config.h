@@ -259,6 +259,9 @@
 #define MAX_DEBUG_MESSAGE_LENGTH    4096
 /*@}*/
 
+/** For GL_ARB_parallel_shader_compile: most worker threads per share group */
+#define MAX_SHADER_COMPILER_THREADS 16
+
 
 /*
  * Color channel component order
@@ -99,6 +99,7 @@
 #include "fog.h"
 #include "formats.h"
 #include "framebuffer.h"
+#include "glthread.h"
 #include "hint.h"
 #include "hash.h"
 #include "light.h"
@@ -117,6 +118,7 @@
 #include "scissor.h"
 #include "shared.h"
 #include "shaderobj.h"
+#include "shaderqueue.h"
 #include "simple_list.h"
 #include "state.h"
 #include "stencil.h"
@@ -666,6 +668,11 @@ _mesa_init_constants(struct gl_context *ctx)
    ctx->Const.MaxColorTextureSamples = 1;
    ctx->Const.MaxDepthTextureSamples = 1;
    ctx->Const.MaxIntegerSamples = 1;
+
+   /* GL_ARB_parallel_shader_compile; drivers that can compile off the
+    * application thread raise this.
+    */
+   ctx->Const.MaxShaderCompilerThreads = 0;
 }
 
 
@@ -1142,6 +1149,12 @@ _mesa_create_context(gl_api api,
 void
 _mesa_free_context_data( struct gl_context *ctx )
 {
+   /* Execute any queued calls and go back to direct dispatch. */
+   _mesa_glthread_destroy(ctx);
+
+   /* Shader jobs still running on other threads use this context. */
+   _mesa_shader_queue_finish(ctx);
+
    if (!_mesa_get_current_context()){
       /* No current context, but we may need one in order to delete
        * texture objs, etc.  So temporarily bind the context now.
@@ -1476,6 +1489,14 @@ _mesa_make_current( struct gl_context *newCtx,
       }
    }
 
+   /* Calls queued by glthread must be executed while their context is still
+    * bound to their framebuffers.
+    */
+   if (curCtx)
+      _mesa_glthread_finish(curCtx);
+   if (newCtx && newCtx != curCtx)
+      _mesa_glthread_finish(newCtx);
+
    if (curCtx && 
       (curCtx->WinSysDrawBuffer || curCtx->WinSysReadBuffer) &&
        /* make sure this context is valid for flushing */
@@ -1490,7 +1511,10 @@ _mesa_make_current( struct gl_context *newCtx,
       _glapi_set_dispatch(NULL);  /* none current */
    }
    else {
-      _glapi_set_dispatch(newCtx->CurrentDispatch);
+      if (newCtx->MarshalExec)
+         _glapi_set_dispatch(newCtx->MarshalExec);
+      else
+         _glapi_set_dispatch(newCtx->CurrentDispatch);
 
       if (drawBuffer && readBuffer) {
          ASSERT(_mesa_is_winsys_fbo(drawBuffer));
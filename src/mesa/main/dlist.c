@@ -2363,6 +2363,8 @@ save_EvalMesh1(GLenum mode, GLint i1, GLint i2)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   /* evaluators may set current attributes */
+   ctx->ListState.Current.AttribsUnknown = GL_TRUE;
    n = alloc_instruction(ctx, OPCODE_EVALMESH1, 3);
    if (n) {
       n[1].e = mode;
@@ -2381,6 +2383,8 @@ save_EvalMesh2(GLenum mode, GLint i1, GLint i2, GLint j1, GLint j2)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   /* evaluators may set current attributes */
+   ctx->ListState.Current.AttribsUnknown = GL_TRUE;
    n = alloc_instruction(ctx, OPCODE_EVALMESH2, 5);
    if (n) {
       n[1].e = mode;
@@ -3370,6 +3374,10 @@ save_PopAttrib(void)
 {
    GET_CURRENT_CONTEXT(ctx);
    ASSERT_OUTSIDE_SAVE_BEGIN_END_AND_FLUSH(ctx);
+   /* This may restore current attributes and materials the list doesn't
+    * know about.
+    */
+   ctx->ListState.Current.AttribsUnknown = GL_TRUE;
    (void) alloc_instruction(ctx, OPCODE_POP_ATTRIB, 0);
    if (ctx->ExecuteFlag) {
       CALL_PopAttrib(ctx->Exec, ());
@@ -5274,11 +5282,38 @@ save_SetFragmentShaderConstantATI(GLuint dst, const GLfloat *value)
    }
 }
 
+/**
+ * Is setting conventional attribute \p attr to (x, y, z, w) with \p size
+ * components a no-op at this point of the list being compiled?
+ *
+ * Such calls are dropped when only compiling, so that they don't split the
+ * vertex list being built by the VBO module.  Setting the position emits a
+ * vertex, so it's never redundant.
+ */
+static inline GLboolean
+save_attr_is_redundant(struct gl_context *ctx, GLenum attr, GLuint size,
+                       GLfloat x, GLfloat y, GLfloat z, GLfloat w)
+{
+   GLfloat v[4];
+
+   if (ctx->ExecuteFlag ||
+       ctx->ListState.Current.AttribsUnknown ||
+       attr == VERT_ATTRIB_POS ||
+       ctx->ListState.ActiveAttribSize[attr] != size)
+      return GL_FALSE;
+
+   ASSIGN_4V(v, x, y, z, w);
+   return memcmp(ctx->ListState.CurrentAttrib[attr], v, sizeof(v)) == 0;
+}
+
 static void GLAPIENTRY
 save_Attr1fNV(GLenum attr, GLfloat x)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
+   if (save_attr_is_redundant(ctx, attr, 1, x, 0, 0, 1))
+      return;
+
    SAVE_FLUSH_VERTICES(ctx);
    n = alloc_instruction(ctx, OPCODE_ATTR_1F_NV, 2);
    if (n) {
@@ -5300,6 +5335,9 @@ save_Attr2fNV(GLenum attr, GLfloat x, GLfloat y)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
+   if (save_attr_is_redundant(ctx, attr, 2, x, y, 0, 1))
+      return;
+
    SAVE_FLUSH_VERTICES(ctx);
    n = alloc_instruction(ctx, OPCODE_ATTR_2F_NV, 3);
    if (n) {
@@ -5322,6 +5360,9 @@ save_Attr3fNV(GLenum attr, GLfloat x, GLfloat y, GLfloat z)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
+   if (save_attr_is_redundant(ctx, attr, 3, x, y, z, 1))
+      return;
+
    SAVE_FLUSH_VERTICES(ctx);
    n = alloc_instruction(ctx, OPCODE_ATTR_3F_NV, 4);
    if (n) {
@@ -5345,6 +5386,9 @@ save_Attr4fNV(GLenum attr, GLfloat x, GLfloat y, GLfloat z, GLfloat w)
 {
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
+   if (save_attr_is_redundant(ctx, attr, 4, x, y, z, w))
+      return;
+
    SAVE_FLUSH_VERTICES(ctx);
    n = alloc_instruction(ctx, OPCODE_ATTR_4F_NV, 5);
    if (n) {
@@ -5462,6 +5506,8 @@ save_EvalCoord1f(GLfloat x)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
+   /* evaluators may set current attributes */
+   ctx->ListState.Current.AttribsUnknown = GL_TRUE;
    n = alloc_instruction(ctx, OPCODE_EVAL_C1, 1);
    if (n) {
       n[1].f = x;
@@ -5483,6 +5529,8 @@ save_EvalCoord2f(GLfloat x, GLfloat y)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
+   /* evaluators may set current attributes */
+   ctx->ListState.Current.AttribsUnknown = GL_TRUE;
    n = alloc_instruction(ctx, OPCODE_EVAL_C2, 2);
    if (n) {
       n[1].f = x;
@@ -5506,6 +5554,8 @@ save_EvalPoint1(GLint x)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
+   /* evaluators may set current attributes */
+   ctx->ListState.Current.AttribsUnknown = GL_TRUE;
    n = alloc_instruction(ctx, OPCODE_EVAL_P1, 1);
    if (n) {
       n[1].i = x;
@@ -5521,6 +5571,8 @@ save_EvalPoint2(GLint x, GLint y)
    GET_CURRENT_CONTEXT(ctx);
    Node *n;
    SAVE_FLUSH_VERTICES(ctx);
+   /* evaluators may set current attributes */
+   ctx->ListState.Current.AttribsUnknown = GL_TRUE;
    n = alloc_instruction(ctx, OPCODE_EVAL_P2, 2);
    if (n) {
       n[1].i = x;
@@ -5614,7 +5666,8 @@ save_Materialfv(GLenum face, GLenum pname, const GLfloat * param)
     */
    for (i = 0; i < MAT_ATTRIB_MAX; i++) {
       if (bitmask & (1 << i)) {
-         if (ctx->ListState.ActiveMaterialSize[i] == args &&
+         if (!ctx->ListState.Current.AttribsUnknown &&
+             ctx->ListState.ActiveMaterialSize[i] == args &&
              compare_vec(ctx->ListState.CurrentMaterial[i], param, args)) {
             /* no change in material value */
             bitmask &= ~(1 << i);
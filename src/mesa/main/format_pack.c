@@ -882,7 +882,7 @@ pack_float_R8(const GLfloat src[4], void *dst)
 static void
 pack_ubyte_GR88(const GLubyte src[4], void *dst)
 {
-   GLubyte *d = ((GLubyte *) dst);
+   GLushort *d = ((GLushort *) dst);
    *d = PACK_COLOR_88(src[GCOMP], src[RCOMP]);
 }
 
@@ -902,7 +902,7 @@ pack_float_GR88(const GLfloat src[4], void *dst)
 static void
 pack_ubyte_RG88(const GLubyte src[4], void *dst)
 {
-   GLubyte *d = ((GLubyte *) dst);
+   GLushort *d = ((GLushort *) dst);
    *d = PACK_COLOR_88(src[RCOMP], src[GCOMP]);
 }
 
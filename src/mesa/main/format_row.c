@@ -0,0 +1,540 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file format_row.c
+ * Table driven row converters for pixels made of 8-bit components.
+ */
+
+
+#include "glheader.h"
+#include "colormac.h"
+#include "format_row.h"
+#include "format_unpack.h"
+#include "imports.h"
+#include "macros.h"
+
+
+#define ZERO ROW_CONV_ZERO
+#define ONE  ROW_CONV_ONE
+
+
+/**
+ * Shift of byte \p b of a 32-bit word as laid out in memory.
+ */
+#ifdef MESA_LITTLE_ENDIAN
+#define ROW_SHIFT(b) (8 * (b))
+#else
+#define ROW_SHIFT(b) (24 - 8 * (b))
+#endif
+
+/**
+ * Destination byte \p j of a pixel word, taken from source word \p p.
+ * \p m is a constant, so all but one arm folds away.
+ */
+#define ROW_PICK(p, m, j)                                               \
+   ((m) == ZERO ? 0u :                                                  \
+    (m) == ONE ? 0xffu << ROW_SHIFT(j) :                                \
+    (((p) >> ROW_SHIFT((m) & 3)) & 0xff) << ROW_SHIFT(j))
+
+/** Destination byte taken from source pixel \p s, \p m is a constant */
+#define ROW_BYTE(s, m)                                                  \
+   ((m) == ZERO ? 0x0 : (m) == ONE ? 0xff : (s)[(m) & 3])
+
+
+/**
+ * 4 to 4 component kernels work on whole pixel words.
+ */
+#define ROW_KERNEL_4_4(name, m0, m1, m2, m3)                            \
+static void                                                             \
+row_4_4_##name(const struct mesa_row_conv *conv, GLuint n,              \
+               const GLubyte *src, GLubyte *dst)                        \
+{                                                                       \
+   const GLubyte *end = src + 4 * n;                                    \
+   (void) conv;                                                         \
+   for (; src != end; src += 4, dst += 4) {                             \
+      GLuint p, q;                                                      \
+      memcpy(&p, src, 4);                                               \
+      q = ROW_PICK(p, m0, 0) | ROW_PICK(p, m1, 1) |                     \
+          ROW_PICK(p, m2, 2) | ROW_PICK(p, m3, 3);                      \
+      memcpy(dst, &q, 4);                                               \
+   }                                                                    \
+}
+
+/**
+ * Smaller pixels gather their bytes into a word and store whole words.
+ */
+#define ROW_KERNEL_N_4(name, sc, m0, m1, m2, m3)                        \
+static void                                                             \
+row_##name(const struct mesa_row_conv *conv, GLuint n,                  \
+           const GLubyte *src, GLubyte *dst)                            \
+{                                                                       \
+   const GLubyte *end = src + sc * n;                                   \
+   (void) conv;                                                         \
+   for (; src != end; src += sc, dst += 4) {                            \
+      GLuint p, q;                                                      \
+      p = (GLuint) src[0] << ROW_SHIFT(0);                              \
+      if (sc > 1)                                                       \
+         p |= (GLuint) src[1] << ROW_SHIFT(1);                          \
+      if (sc > 2)                                                       \
+         p |= (GLuint) src[2] << ROW_SHIFT(2);                          \
+      q = ROW_PICK(p, m0, 0) | ROW_PICK(p, m1, 1) |                     \
+          ROW_PICK(p, m2, 2) | ROW_PICK(p, m3, 3);                      \
+      memcpy(dst, &q, 4);                                               \
+   }                                                                    \
+}
+
+/**
+ * Narrower destinations go a byte at a time.
+ */
+#define ROW_KERNEL_BYTES(name, sc, dc, m0, m1, m2, m3)                  \
+static void                                                             \
+row_##name(const struct mesa_row_conv *conv, GLuint n,                  \
+           const GLubyte *src, GLubyte *dst)                            \
+{                                                                       \
+   const GLubyte *end = src + sc * n;                                   \
+   (void) conv;                                                         \
+   for (; src != end; src += sc, dst += dc) {                           \
+      dst[0] = ROW_BYTE(src, m0);                                       \
+      if (dc > 1)                                                       \
+         dst[1] = ROW_BYTE(src, m1);                                    \
+      if (dc > 2)                                                       \
+         dst[2] = ROW_BYTE(src, m2);                                    \
+      if (dc > 3)                                                       \
+         dst[3] = ROW_BYTE(src, m3);                                    \
+   }                                                                    \
+}
+
+/* In kernel names 'z' stands for ROW_CONV_ZERO and 'x' for ROW_CONV_ONE. */
+ROW_KERNEL_4_4(3210, 3, 2, 1, 0)
+ROW_KERNEL_4_4(2103, 2, 1, 0, 3)
+ROW_KERNEL_4_4(1230, 1, 2, 3, 0)
+ROW_KERNEL_4_4(3012, 3, 0, 1, 2)
+ROW_KERNEL_4_4(012x, 0, 1, 2, ONE)
+ROW_KERNEL_4_4(210x, 2, 1, 0, ONE)
+ROW_KERNEL_4_4(123x, 1, 2, 3, ONE)
+ROW_KERNEL_4_4(321x, 3, 2, 1, ONE)
+ROW_KERNEL_4_4(x012, ONE, 0, 1, 2)
+ROW_KERNEL_4_4(x210, ONE, 2, 1, 0)
+
+ROW_KERNEL_N_4(3_4_012x, 3, 0, 1, 2, ONE)
+ROW_KERNEL_N_4(3_4_210x, 3, 2, 1, 0, ONE)
+ROW_KERNEL_N_4(3_4_x210, 3, ONE, 2, 1, 0)
+ROW_KERNEL_N_4(3_4_x012, 3, ONE, 0, 1, 2)
+ROW_KERNEL_BYTES(4_3_012, 4, 3, 0, 1, 2, ZERO)
+ROW_KERNEL_BYTES(4_3_210, 4, 3, 2, 1, 0, ZERO)
+ROW_KERNEL_BYTES(4_3_123, 4, 3, 1, 2, 3, ZERO)
+ROW_KERNEL_BYTES(4_3_321, 4, 3, 3, 2, 1, ZERO)
+ROW_KERNEL_N_4(2_4_0001, 2, 0, 0, 0, 1)
+ROW_KERNEL_N_4(2_4_1110, 2, 1, 1, 1, 0)
+ROW_KERNEL_N_4(2_4_01zx, 2, 0, 1, ZERO, ONE)
+ROW_KERNEL_N_4(2_4_10zx, 2, 1, 0, ZERO, ONE)
+ROW_KERNEL_N_4(1_4_000x, 1, 0, 0, 0, ONE)
+ROW_KERNEL_N_4(1_4_zzz0, 1, ZERO, ZERO, ZERO, 0)
+ROW_KERNEL_N_4(1_4_0000, 1, 0, 0, 0, 0)
+ROW_KERNEL_N_4(1_4_0zzx, 1, 0, ZERO, ZERO, ONE)
+
+
+static void
+row_copy(const struct mesa_row_conv *conv, GLuint n,
+         const GLubyte *src, GLubyte *dst)
+{
+   memcpy(dst, src, n * conv->DstComps);
+}
+
+
+/**
+ * Any map the table below doesn't have.
+ */
+static void
+row_generic(const struct mesa_row_conv *conv, GLuint n,
+            const GLubyte *src, GLubyte *dst)
+{
+   const GLuint srcComps = conv->SrcComps, dstComps = conv->DstComps;
+   GLubyte tmp[6];
+   GLuint i, j;
+
+   tmp[ZERO] = 0x0;
+   tmp[ONE] = 0xff;
+
+   for (i = 0; i < n; i++) {
+      for (j = 0; j < srcComps; j++)
+         tmp[j] = src[j];
+      for (j = 0; j < dstComps; j++)
+         dst[j] = tmp[conv->Map[j]];
+      src += srcComps;
+      dst += dstComps;
+   }
+}
+
+
+static const struct {
+   GLubyte SrcComps, DstComps;
+   GLubyte Map[4];
+   mesa_row_conv_func Func;
+} row_kernels[] = {
+   { 4, 4, { 3, 2, 1, 0 }, row_4_4_3210 },
+   { 4, 4, { 2, 1, 0, 3 }, row_4_4_2103 },
+   { 4, 4, { 1, 2, 3, 0 }, row_4_4_1230 },
+   { 4, 4, { 3, 0, 1, 2 }, row_4_4_3012 },
+   { 4, 4, { 0, 1, 2, ONE }, row_4_4_012x },
+   { 4, 4, { 2, 1, 0, ONE }, row_4_4_210x },
+   { 4, 4, { 1, 2, 3, ONE }, row_4_4_123x },
+   { 4, 4, { 3, 2, 1, ONE }, row_4_4_321x },
+   { 4, 4, { ONE, 0, 1, 2 }, row_4_4_x012 },
+   { 4, 4, { ONE, 2, 1, 0 }, row_4_4_x210 },
+   { 3, 4, { 0, 1, 2, ONE }, row_3_4_012x },
+   { 3, 4, { 2, 1, 0, ONE }, row_3_4_210x },
+   { 3, 4, { ONE, 2, 1, 0 }, row_3_4_x210 },
+   { 3, 4, { ONE, 0, 1, 2 }, row_3_4_x012 },
+   { 4, 3, { 0, 1, 2 }, row_4_3_012 },
+   { 4, 3, { 2, 1, 0 }, row_4_3_210 },
+   { 4, 3, { 1, 2, 3 }, row_4_3_123 },
+   { 4, 3, { 3, 2, 1 }, row_4_3_321 },
+   { 2, 4, { 0, 0, 0, 1 }, row_2_4_0001 },
+   { 2, 4, { 1, 1, 1, 0 }, row_2_4_1110 },
+   { 2, 4, { 0, 1, ZERO, ONE }, row_2_4_01zx },
+   { 2, 4, { 1, 0, ZERO, ONE }, row_2_4_10zx },
+   { 1, 4, { 0, 0, 0, ONE }, row_1_4_000x },
+   { 1, 4, { ZERO, ZERO, ZERO, 0 }, row_1_4_zzz0 },
+   { 1, 4, { 0, 0, 0, 0 }, row_1_4_0000 },
+   { 1, 4, { 0, ZERO, ZERO, ONE }, row_1_4_0zzx },
+};
+
+
+/**
+ * Float kernels, one per source pixel size, plus opaque variants that
+ * store alpha 1.0 without a lookup.
+ */
+#define ROW_FLOAT_KERNEL(name, sc, opaque)                              \
+static void                                                             \
+row_float_##name(const struct mesa_row_conv *conv, GLuint n,            \
+                 const GLubyte *src, GLfloat dst[][4])                  \
+{                                                                       \
+   const GLfloat *r = conv->Lut[0], *g = conv->Lut[1];                  \
+   const GLfloat *b = conv->Lut[2], *a = conv->Lut[3];                  \
+   const GLuint mr = conv->LutSrc[0], mg = conv->LutSrc[1];             \
+   const GLuint mb = conv->LutSrc[2], ma = conv->LutSrc[3];             \
+   GLuint i;                                                            \
+   for (i = 0; i < n; i++, src += sc) {                                 \
+      dst[i][RCOMP] = r[src[sc > 1 ? mr : 0]];                          \
+      dst[i][GCOMP] = g[src[sc > 1 ? mg : 0]];                          \
+      dst[i][BCOMP] = b[src[sc > 1 ? mb : 0]];                          \
+      dst[i][ACOMP] = opaque ? 1.0F : a[src[sc > 1 ? ma : 0]];          \
+   }                                                                    \
+}
+
+/**
+ * Luminance and intensity: R, G and B share a source byte and a table.
+ * The opaque variant stores alpha 1.0 without a lookup.
+ */
+#define ROW_FLOAT_LUM_KERNEL(name, sc, opaque)                          \
+static void                                                             \
+row_float_lum_##name(const struct mesa_row_conv *conv, GLuint n,        \
+                     const GLubyte *src, GLfloat dst[][4])              \
+{                                                                       \
+   const GLfloat *l = conv->Lut[0], *a = conv->Lut[3];                  \
+   const GLuint ml = conv->LutSrc[0], ma = conv->LutSrc[3];             \
+   GLuint i;                                                            \
+   for (i = 0; i < n; i++, src += sc) {                                 \
+      dst[i][RCOMP] =                                                   \
+      dst[i][GCOMP] =                                                   \
+      dst[i][BCOMP] = l[src[sc > 1 ? ml : 0]];                          \
+      dst[i][ACOMP] = opaque ? 1.0F : a[src[sc > 1 ? ma : 0]];          \
+   }                                                                    \
+}
+
+ROW_FLOAT_KERNEL(1, 1, GL_FALSE)
+ROW_FLOAT_KERNEL(2, 2, GL_FALSE)
+ROW_FLOAT_KERNEL(3, 3, GL_FALSE)
+ROW_FLOAT_KERNEL(4, 4, GL_FALSE)
+ROW_FLOAT_KERNEL(1x, 1, GL_TRUE)
+ROW_FLOAT_KERNEL(2x, 2, GL_TRUE)
+ROW_FLOAT_KERNEL(3x, 3, GL_TRUE)
+ROW_FLOAT_KERNEL(4x, 4, GL_TRUE)
+ROW_FLOAT_LUM_KERNEL(1, 1, GL_FALSE)
+ROW_FLOAT_LUM_KERNEL(1x, 1, GL_TRUE)
+ROW_FLOAT_LUM_KERNEL(2, 2, GL_FALSE)
+
+static const mesa_row_conv_float_func row_float_kernels[2][5] = {
+   { NULL, row_float_1, row_float_2, row_float_3, row_float_4 },
+   { NULL, row_float_1x, row_float_2x, row_float_3x, row_float_4x },
+};
+
+
+static GLfloat srgb_lut[256], zero_lut[256], one_lut[256];
+
+/**
+ * Fill the sRGB decode table and the constant tables that stand in for
+ * ROW_CONV_ZERO and ROW_CONV_ONE.
+ */
+static void
+init_luts(void)
+{
+   static GLboolean tableReady = GL_FALSE;
+
+   if (!tableReady) {
+      GLuint i;
+      for (i = 0; i < 256; i++) {
+         srgb_lut[i] = _mesa_nonlinear_to_linear(i);
+         one_lut[i] = 1.0F;
+      }
+      tableReady = GL_TRUE;
+   }
+}
+
+
+/**
+ * Set up a converter from \p srcComps to \p dstComps byte pixels.
+ * \param map  map[j] is the source byte for destination byte j, or
+ *             ROW_CONV_ZERO / ROW_CONV_ONE
+ * \param srgbMask  destination components (bit 0 = first) that
+ *                  _mesa_row_conv_float() decodes as sRGB; alpha never is
+ */
+void
+_mesa_init_row_conv(struct mesa_row_conv *conv,
+                    GLuint srcComps, GLuint dstComps,
+                    const GLubyte map[4], GLbitfield srgbMask)
+{
+   GLboolean identity = srcComps == dstComps;
+   GLuint i, j;
+
+   ASSERT(srcComps >= 1 && srcComps <= 4);
+   ASSERT(dstComps >= 1 && dstComps <= 4);
+
+   init_luts();
+
+   conv->SrcComps = srcComps;
+   conv->DstComps = dstComps;
+   for (j = 0; j < 4; j++) {
+      conv->Map[j] = j < dstComps ? map[j] : ZERO;
+      ASSERT(conv->Map[j] < srcComps || conv->Map[j] >= ZERO);
+      if (j < dstComps && map[j] != j)
+         identity = GL_FALSE;
+
+      if (conv->Map[j] == ZERO || conv->Map[j] == ONE) {
+         conv->LutSrc[j] = 0;
+         conv->Lut[j] = conv->Map[j] == ZERO ? zero_lut : one_lut;
+      }
+      else {
+         conv->LutSrc[j] = conv->Map[j];
+         conv->Lut[j] = (srgbMask & (1 << j)) ? srgb_lut
+                                              : _mesa_ubyte_to_float_color_tab;
+      }
+   }
+
+   if (dstComps != 4)
+      conv->FloatFunc = NULL;
+   else if (srcComps <= 2 &&
+            conv->Map[0] < ZERO &&
+            conv->Map[1] == conv->Map[0] && conv->Map[2] == conv->Map[0] &&
+            conv->Lut[1] == conv->Lut[0] && conv->Lut[2] == conv->Lut[0])
+      conv->FloatFunc = srcComps == 2 ? row_float_lum_2 :
+                        conv->Lut[3] == one_lut ? row_float_lum_1x :
+                        row_float_lum_1;
+   else
+      conv->FloatFunc = row_float_kernels[conv->Lut[3] == one_lut][srcComps];
+
+   if (identity) {
+      conv->Func = row_copy;
+      return;
+   }
+
+   for (i = 0; i < Elements(row_kernels); i++) {
+      if (row_kernels[i].SrcComps == srcComps &&
+          row_kernels[i].DstComps == dstComps &&
+          memcmp(row_kernels[i].Map, conv->Map, dstComps) == 0) {
+         conv->Func = row_kernels[i].Func;
+         return;
+      }
+   }
+
+   conv->Func = row_generic;
+}
+
+
+/**
+ * The 8-bit unorm and sRGB formats.  Packed formats give the byte of each
+ * component within the little endian 16 or 32-bit word (shift / 8); the
+ * others give the byte within the pixel.
+ */
+static const struct {
+   gl_format Format;
+   GLubyte Bytes;
+   GLboolean Packed;
+   GLubyte Map[4];
+   GLbitfield Srgb;
+} format_row_maps[] = {
+   { MESA_FORMAT_RGBA8888,      4, GL_TRUE,  { 3, 2, 1, 0 }, 0x0 },
+   { MESA_FORMAT_RGBA8888_REV,  4, GL_TRUE,  { 0, 1, 2, 3 }, 0x0 },
+   { MESA_FORMAT_ARGB8888,      4, GL_TRUE,  { 2, 1, 0, 3 }, 0x0 },
+   { MESA_FORMAT_ARGB8888_REV,  4, GL_TRUE,  { 1, 2, 3, 0 }, 0x0 },
+   { MESA_FORMAT_RGBX8888,      4, GL_TRUE,  { 3, 2, 1, ONE }, 0x0 },
+   { MESA_FORMAT_RGBX8888_REV,  4, GL_TRUE,  { 0, 1, 2, ONE }, 0x0 },
+   { MESA_FORMAT_XRGB8888,      4, GL_TRUE,  { 2, 1, 0, ONE }, 0x0 },
+   { MESA_FORMAT_XRGB8888_REV,  4, GL_TRUE,  { 1, 2, 3, ONE }, 0x0 },
+   { MESA_FORMAT_RGB888,        3, GL_FALSE, { 2, 1, 0, ONE }, 0x0 },
+   { MESA_FORMAT_BGR888,        3, GL_FALSE, { 0, 1, 2, ONE }, 0x0 },
+   { MESA_FORMAT_AL88,          2, GL_TRUE,  { 0, 0, 0, 1 }, 0x0 },
+   { MESA_FORMAT_AL88_REV,      2, GL_TRUE,  { 1, 1, 1, 0 }, 0x0 },
+   { MESA_FORMAT_A8,            1, GL_FALSE, { ZERO, ZERO, ZERO, 0 }, 0x0 },
+   { MESA_FORMAT_L8,            1, GL_FALSE, { 0, 0, 0, ONE }, 0x0 },
+   { MESA_FORMAT_I8,            1, GL_FALSE, { 0, 0, 0, 0 }, 0x0 },
+   { MESA_FORMAT_R8,            1, GL_FALSE, { 0, ZERO, ZERO, ONE }, 0x0 },
+   { MESA_FORMAT_GR88,          2, GL_TRUE,  { 0, 1, ZERO, ONE }, 0x0 },
+   { MESA_FORMAT_RG88,          2, GL_TRUE,  { 1, 0, ZERO, ONE }, 0x0 },
+   { MESA_FORMAT_SRGB8,         3, GL_FALSE, { 2, 1, 0, ONE }, 0x7 },
+   { MESA_FORMAT_SRGBA8,        4, GL_TRUE,  { 3, 2, 1, 0 }, 0x7 },
+   { MESA_FORMAT_SARGB8,        4, GL_TRUE,  { 2, 1, 0, 3 }, 0x7 },
+   { MESA_FORMAT_SL8,           1, GL_FALSE, { 0, 0, 0, ONE }, 0x7 },
+   { MESA_FORMAT_SLA8,          2, GL_TRUE,  { 0, 0, 0, 1 }, 0x7 },
+   { MESA_FORMAT_XBGR8888_SRGB, 4, GL_TRUE,  { 0, 1, 2, ONE }, 0x7 },
+};
+
+
+/**
+ * Describe how the RGBA components of a format's texels sit in memory.
+ * \param comps  returns the bytes per texel
+ * \param map  returns a map to RGBA suitable for _mesa_init_row_conv()
+ * \param srgbMask  returns the sRGB encoded components
+ * \return GL_FALSE if the format isn't made of 8-bit unorm components
+ */
+GLboolean
+_mesa_get_format_row_map(gl_format format, GLuint *comps, GLubyte map[4],
+                         GLbitfield *srgbMask)
+{
+   GLuint i, j;
+
+   for (i = 0; i < Elements(format_row_maps); i++) {
+      if (format_row_maps[i].Format == format) {
+         const GLuint bytes = format_row_maps[i].Bytes;
+
+         for (j = 0; j < 4; j++) {
+            map[j] = format_row_maps[i].Map[j];
+#ifdef MESA_BIG_ENDIAN
+            if (format_row_maps[i].Packed && map[j] < ZERO)
+               map[j] = bytes - 1 - map[j];
+#endif
+         }
+         *comps = bytes;
+         *srgbMask = format_row_maps[i].Srgb;
+         return GL_TRUE;
+      }
+   }
+
+   return GL_FALSE;
+}
+
+
+/**
+ * Describe client pixels of 8-bit components.
+ * \param comps  returns the bytes per pixel
+ * \param chans  returns the RGBA component (0-3) in each byte
+ * \return GL_FALSE if \p format / \p type aren't 8-bit color components
+ */
+GLboolean
+_mesa_get_ubyte_pixel_layout(GLenum format, GLenum type, GLboolean swapBytes,
+                             GLuint *comps, GLubyte chans[4])
+{
+   static const GLubyte rgba[4] = { RCOMP, GCOMP, BCOMP, ACOMP };
+   static const GLubyte bgra[4] = { BCOMP, GCOMP, RCOMP, ACOMP };
+   static const GLubyte abgr[4] = { ACOMP, BCOMP, GCOMP, RCOMP };
+   const GLubyte *order;
+   GLboolean reverse;
+   GLuint n, i;
+
+   switch (format) {
+   case GL_RGBA:
+      order = rgba;
+      n = 4;
+      break;
+   case GL_BGRA:
+      order = bgra;
+      n = 4;
+      break;
+   case GL_ABGR_EXT:
+      order = abgr;
+      n = 4;
+      break;
+   case GL_RGB:
+      order = rgba;
+      n = 3;
+      break;
+   case GL_BGR:
+      order = bgra;
+      n = 3;
+      break;
+   case GL_RG:
+      order = rgba;
+      n = 2;
+      break;
+   case GL_RED:
+      order = rgba;
+      n = 1;
+      break;
+   case GL_GREEN:
+      order = rgba + 1;
+      n = 1;
+      break;
+   case GL_BLUE:
+      order = rgba + 2;
+      n = 1;
+      break;
+   case GL_ALPHA:
+      order = rgba + 3;
+      n = 1;
+      break;
+   default:
+      return GL_FALSE;
+   }
+
+   /* The packed types put the first component in the most significant
+    * (_REV: least significant) byte of a 32-bit word, and byte swapping
+    * reverses the word once more.
+    */
+   switch (type) {
+   case GL_UNSIGNED_BYTE:
+      reverse = GL_FALSE;
+      break;
+   case GL_UNSIGNED_INT_8_8_8_8:
+   case GL_UNSIGNED_INT_8_8_8_8_REV:
+      if (n != 4)
+         return GL_FALSE;
+#ifdef MESA_LITTLE_ENDIAN
+      reverse = type == GL_UNSIGNED_INT_8_8_8_8;
+#else
+      reverse = type == GL_UNSIGNED_INT_8_8_8_8_REV;
+#endif
+      if (swapBytes)
+         reverse = !reverse;
+      break;
+   default:
+      return GL_FALSE;
+   }
+
+   for (i = 0; i < n; i++)
+      chans[i] = order[reverse ? n - 1 - i : i];
+   *comps = n;
+
+   return GL_TRUE;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file format_row.h
+ * Row converters for pixels made of 8-bit components.
+ *
+ * A converter is described by a map: destination byte j of each pixel is
+ * source byte map[j], or 0x00 / 0xff for ROW_CONV_ZERO / ROW_CONV_ONE.
+ * Byte order, byte swapping and channel order all reduce to such a map, so
+ * texture stores, unpacking and glReadPixels share one set of kernels.
+ * _mesa_init_row_conv() picks a kernel from a table of the common maps once,
+ * and the per-row calls just run it.
+ */
+
+
+#ifndef FORMAT_ROW_H
+#define FORMAT_ROW_H
+
+
+#include "glheader.h"
+#include "formats.h"
+
+
+/** Special source byte indexes in a row converter map */
+#define ROW_CONV_ZERO 4
+#define ROW_CONV_ONE  5
+
+
+struct mesa_row_conv;
+
+typedef void (*mesa_row_conv_func)(const struct mesa_row_conv *conv,
+                                   GLuint n, const GLubyte *src,
+                                   GLubyte *dst);
+
+typedef void (*mesa_row_conv_float_func)(const struct mesa_row_conv *conv,
+                                         GLuint n, const GLubyte *src,
+                                         GLfloat dst[][4]);
+
+/**
+ * A converter from pixels of SrcComps bytes to pixels of DstComps bytes.
+ */
+struct mesa_row_conv
+{
+   GLuint SrcComps;
+   GLuint DstComps;
+   GLubyte Map[4];
+   mesa_row_conv_func Func;
+
+   /**
+    * Float conversion, 4 destination components only: component c is
+    * Lut[c][src[LutSrc[c]]], with unorm, sRGB, all 0 or all 1 tables.
+    */
+   GLubyte LutSrc[4];
+   const GLfloat *Lut[4];
+   mesa_row_conv_float_func FloatFunc;
+};
+
+
+extern void
+_mesa_init_row_conv(struct mesa_row_conv *conv,
+                    GLuint srcComps, GLuint dstComps,
+                    const GLubyte map[4], GLbitfield srgbMask);
+
+extern GLboolean
+_mesa_get_format_row_map(gl_format format, GLuint *comps, GLubyte map[4],
+                         GLbitfield *srgbMask);
+
+extern GLboolean
+_mesa_get_ubyte_pixel_layout(GLenum format, GLenum type, GLboolean swapBytes,
+                             GLuint *comps, GLubyte chans[4]);
+
+
+/**
+ * Convert \p n pixels from \p src to \p dst.
+ */
+static inline void
+_mesa_row_conv_ubyte(const struct mesa_row_conv *conv, GLuint n,
+                     const GLubyte *src, GLubyte *dst)
+{
+   conv->Func(conv, n, src, dst);
+}
+
+
+/**
+ * Convert \p n pixels from \p src to normalized floats.
+ */
+static inline void
+_mesa_row_conv_float(const struct mesa_row_conv *conv, GLuint n,
+                     const GLubyte *src, GLfloat dst[][4])
+{
+   conv->FloatFunc(conv, n, src, dst);
+}
+
+
+#endif /* FORMAT_ROW_H */
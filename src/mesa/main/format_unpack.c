@@ -23,6 +23,7 @@
 
 
 #include "colormac.h"
+#include "format_row.h"
 #include "format_unpack.h"
 #include "macros.h"
 #include "../../gallium/auxiliary/util/u_format_rgb9e5.h"
@@ -87,136 +88,6 @@ _mesa_nonlinear_to_linear(GLubyte cs8)
 typedef void (*unpack_rgba_func)(const void *src, GLfloat dst[][4], GLuint n);
 
 
-static void
-unpack_RGBA8888(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLuint *s = ((const GLuint *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = UBYTE_TO_FLOAT( (s[i] >> 24)        );
-      dst[i][GCOMP] = UBYTE_TO_FLOAT( (s[i] >> 16) & 0xff );
-      dst[i][BCOMP] = UBYTE_TO_FLOAT( (s[i] >>  8) & 0xff );
-      dst[i][ACOMP] = UBYTE_TO_FLOAT( (s[i]      ) & 0xff );
-   }
-}
-
-static void
-unpack_RGBA8888_REV(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLuint *s = ((const GLuint *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = UBYTE_TO_FLOAT( (s[i]      ) & 0xff );
-      dst[i][GCOMP] = UBYTE_TO_FLOAT( (s[i] >>  8) & 0xff );
-      dst[i][BCOMP] = UBYTE_TO_FLOAT( (s[i] >> 16) & 0xff );
-      dst[i][ACOMP] = UBYTE_TO_FLOAT( (s[i] >> 24)        );
-   }
-}
-
-static void
-unpack_ARGB8888(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLuint *s = ((const GLuint *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = UBYTE_TO_FLOAT( (s[i] >> 16) & 0xff );
-      dst[i][GCOMP] = UBYTE_TO_FLOAT( (s[i] >>  8) & 0xff );
-      dst[i][BCOMP] = UBYTE_TO_FLOAT( (s[i]      ) & 0xff );
-      dst[i][ACOMP] = UBYTE_TO_FLOAT( (s[i] >> 24)        );
-   }
-}
-
-static void
-unpack_ARGB8888_REV(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLuint *s = ((const GLuint *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = UBYTE_TO_FLOAT( (s[i] >>  8) & 0xff );
-      dst[i][GCOMP] = UBYTE_TO_FLOAT( (s[i] >> 16) & 0xff );
-      dst[i][BCOMP] = UBYTE_TO_FLOAT( (s[i] >> 24)        );
-      dst[i][ACOMP] = UBYTE_TO_FLOAT( (s[i]      ) & 0xff );
-   }
-}
-
-static void
-unpack_RGBX8888(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLuint *s = ((const GLuint *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = UBYTE_TO_FLOAT( (s[i] >> 24)        );
-      dst[i][GCOMP] = UBYTE_TO_FLOAT( (s[i] >> 16) & 0xff );
-      dst[i][BCOMP] = UBYTE_TO_FLOAT( (s[i] >>  8) & 0xff );
-      dst[i][ACOMP] = 1.0f;
-   }
-}
-
-static void
-unpack_RGBX8888_REV(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLuint *s = ((const GLuint *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = UBYTE_TO_FLOAT( (s[i]      ) & 0xff );
-      dst[i][GCOMP] = UBYTE_TO_FLOAT( (s[i] >>  8) & 0xff );
-      dst[i][BCOMP] = UBYTE_TO_FLOAT( (s[i] >> 16) & 0xff );
-      dst[i][ACOMP] = 1.0f;
-   }
-}
-
-static void
-unpack_XRGB8888(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLuint *s = ((const GLuint *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = UBYTE_TO_FLOAT( (s[i] >> 16) & 0xff );
-      dst[i][GCOMP] = UBYTE_TO_FLOAT( (s[i] >>  8) & 0xff );
-      dst[i][BCOMP] = UBYTE_TO_FLOAT( (s[i]      ) & 0xff );
-      dst[i][ACOMP] = 1.0f;
-   }
-}
-
-static void
-unpack_XRGB8888_REV(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLuint *s = ((const GLuint *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = UBYTE_TO_FLOAT( (s[i] >>  8) & 0xff );
-      dst[i][GCOMP] = UBYTE_TO_FLOAT( (s[i] >> 16) & 0xff );
-      dst[i][BCOMP] = UBYTE_TO_FLOAT( (s[i] >> 24)        );
-      dst[i][ACOMP] = 1.0f;
-   }
-}
-
-static void
-unpack_RGB888(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLubyte *s = (const GLubyte *) src;
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = UBYTE_TO_FLOAT( s[i*3+2] );
-      dst[i][GCOMP] = UBYTE_TO_FLOAT( s[i*3+1] );
-      dst[i][BCOMP] = UBYTE_TO_FLOAT( s[i*3+0] );
-      dst[i][ACOMP] = 1.0F;
-   }
-}
-
-static void
-unpack_BGR888(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLubyte *s = (const GLubyte *) src;
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = UBYTE_TO_FLOAT( s[i*3+0] );
-      dst[i][GCOMP] = UBYTE_TO_FLOAT( s[i*3+1] );
-      dst[i][BCOMP] = UBYTE_TO_FLOAT( s[i*3+2] );
-      dst[i][ACOMP] = 1.0F;
-   }
-}
-
 static void
 unpack_RGB565(const void *src, GLfloat dst[][4], GLuint n)
 {
@@ -323,32 +194,6 @@ unpack_AL44(const void *src, GLfloat dst[][4], GLuint n)
    }
 }
 
-static void
-unpack_AL88(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLushort *s = ((const GLushort *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = 
-      dst[i][GCOMP] = 
-      dst[i][BCOMP] = UBYTE_TO_FLOAT( s[i] & 0xff );
-      dst[i][ACOMP] = UBYTE_TO_FLOAT( s[i] >> 8 );
-   }
-}
-
-static void
-unpack_AL88_REV(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLushort *s = ((const GLushort *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = 
-      dst[i][GCOMP] = 
-      dst[i][BCOMP] = UBYTE_TO_FLOAT( s[i] >> 8 );
-      dst[i][ACOMP] = UBYTE_TO_FLOAT( s[i] & 0xff );
-   }
-}
-
 static void
 unpack_AL1616(const void *src, GLfloat dst[][4], GLuint n)
 {
@@ -389,19 +234,6 @@ unpack_RGB332(const void *src, GLfloat dst[][4], GLuint n)
 }
 
 
-static void
-unpack_A8(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLubyte *s = ((const GLubyte *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] =
-      dst[i][GCOMP] =
-      dst[i][BCOMP] = 0.0F;
-      dst[i][ACOMP] = UBYTE_TO_FLOAT(s[i]);
-   }
-}
-
 static void
 unpack_A16(const void *src, GLfloat dst[][4], GLuint n)
 {
@@ -415,19 +247,6 @@ unpack_A16(const void *src, GLfloat dst[][4], GLuint n)
    }
 }
 
-static void
-unpack_L8(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLubyte *s = ((const GLubyte *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] =
-      dst[i][GCOMP] =
-      dst[i][BCOMP] = UBYTE_TO_FLOAT(s[i]);
-      dst[i][ACOMP] = 1.0F;
-   }
-}
-
 static void
 unpack_L16(const void *src, GLfloat dst[][4], GLuint n)
 {
@@ -441,19 +260,6 @@ unpack_L16(const void *src, GLfloat dst[][4], GLuint n)
    }
 }
 
-static void
-unpack_I8(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLubyte *s = ((const GLubyte *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] =
-      dst[i][GCOMP] =
-      dst[i][BCOMP] =
-      dst[i][ACOMP] = UBYTE_TO_FLOAT(s[i]);
-   }
-}
-
 static void
 unpack_I16(const void *src, GLfloat dst[][4], GLuint n)
 {
@@ -517,45 +323,6 @@ unpack_YCBCR_REV(const void *src, GLfloat dst[][4], GLuint n)
    }
 }
 
-static void
-unpack_R8(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLubyte *s = ((const GLubyte *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][0] = UBYTE_TO_FLOAT(s[i]);
-      dst[i][1] =
-      dst[i][2] = 0.0F;
-      dst[i][3] = 1.0F;
-   }
-}
-
-static void
-unpack_GR88(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLushort *s = ((const GLushort *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = UBYTE_TO_FLOAT( s[i] & 0xff );
-      dst[i][GCOMP] = UBYTE_TO_FLOAT( s[i] >> 8 );
-      dst[i][BCOMP] = 0.0;
-      dst[i][ACOMP] = 1.0;
-   }
-}
-
-static void
-unpack_RG88(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLushort *s = ((const GLushort *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = UBYTE_TO_FLOAT( s[i] >> 8 );
-      dst[i][GCOMP] = UBYTE_TO_FLOAT( s[i] & 0xff );
-      dst[i][BCOMP] = 0.0;
-      dst[i][ACOMP] = 1.0;
-   }
-}
-
 static void
 unpack_R16(const void *src, GLfloat dst[][4], GLuint n)
 {
@@ -736,71 +503,6 @@ unpack_S8(const void *src, GLfloat dst[][4], GLuint n)
 }
 
 
-static void
-unpack_SRGB8(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLubyte *s = (const GLubyte *) src;
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = _mesa_nonlinear_to_linear(s[i*3+2]);
-      dst[i][GCOMP] = _mesa_nonlinear_to_linear(s[i*3+1]);
-      dst[i][BCOMP] = _mesa_nonlinear_to_linear(s[i*3+0]);
-      dst[i][ACOMP] = 1.0F;
-   }
-}
-
-static void
-unpack_SRGBA8(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLuint *s = ((const GLuint *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = _mesa_nonlinear_to_linear( (s[i] >> 24) );
-      dst[i][GCOMP] = _mesa_nonlinear_to_linear( (s[i] >> 16) & 0xff );
-      dst[i][BCOMP] = _mesa_nonlinear_to_linear( (s[i] >>  8) & 0xff );
-      dst[i][ACOMP] = UBYTE_TO_FLOAT( s[i] & 0xff ); /* linear! */
-   }
-}
-
-static void
-unpack_SARGB8(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLuint *s = ((const GLuint *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = _mesa_nonlinear_to_linear( (s[i] >> 16) & 0xff );
-      dst[i][GCOMP] = _mesa_nonlinear_to_linear( (s[i] >>  8) & 0xff );
-      dst[i][BCOMP] = _mesa_nonlinear_to_linear( (s[i]      ) & 0xff );
-      dst[i][ACOMP] = UBYTE_TO_FLOAT( s[i] >> 24 ); /* linear! */
-   }
-}
-
-static void
-unpack_SL8(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLubyte *s = ((const GLubyte *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = 
-      dst[i][GCOMP] = 
-      dst[i][BCOMP] = _mesa_nonlinear_to_linear(s[i]);
-      dst[i][ACOMP] = 1.0F;
-   }
-}
-
-static void
-unpack_SLA8(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLushort *s = (const GLushort *) src;
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] =
-      dst[i][GCOMP] =
-      dst[i][BCOMP] = _mesa_nonlinear_to_linear(s[i] & 0xff);
-      dst[i][ACOMP] = UBYTE_TO_FLOAT(s[i] >> 8); /* linear! */
-   }
-}
-
 static void
 unpack_SRGB_DXT1(const void *src, GLfloat dst[][4], GLuint n)
 {
@@ -1563,19 +1265,6 @@ unpack_XBGR8888_SNORM(const void *src, GLfloat dst[][4], GLuint n)
    }
 }
 
-static void
-unpack_XBGR8888_SRGB(const void *src, GLfloat dst[][4], GLuint n)
-{
-   const GLuint *s = ((const GLuint *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = _mesa_nonlinear_to_linear( (s[i]      ) & 0xff );
-      dst[i][GCOMP] = _mesa_nonlinear_to_linear( (s[i] >>  8) & 0xff );
-      dst[i][BCOMP] = _mesa_nonlinear_to_linear( (s[i] >> 16) & 0xff );
-      dst[i][ACOMP] = UBYTE_TO_FLOAT( s[i] >> 24 ); /* linear! */
-   }
-}
-
 static void
 unpack_XBGR8888_UINT(const void *src, GLfloat dst[][4], GLuint n)
 {
@@ -1720,6 +1409,35 @@ unpack_XBGR32323232_SINT(const void *src, GLfloat dst[][4], GLuint n)
 }
 
 
+/**
+ * Return the row converter for formats made of 8-bit unorm or sRGB
+ * components, or NULL if the format has its own unpack functions.
+ */
+static const struct mesa_row_conv *
+get_unpack_row_conv(gl_format format)
+{
+   static struct mesa_row_conv table[MESA_FORMAT_COUNT];
+   static GLboolean initialized = GL_FALSE;
+
+   if (!initialized) {
+      GLuint f;
+
+      for (f = 0; f < MESA_FORMAT_COUNT; f++) {
+         GLuint comps;
+         GLubyte map[4];
+         GLbitfield srgbMask;
+
+         if (_mesa_get_format_row_map(f, &comps, map, &srgbMask))
+            _mesa_init_row_conv(&table[f], comps, 4, map, srgbMask);
+      }
+
+      initialized = GL_TRUE;
+   }
+
+   return table[format].Func ? &table[format] : NULL;
+}
+
+
 /**
  * Return the unpacker function for the given format.
  */
@@ -1732,16 +1450,6 @@ get_unpack_rgba_function(gl_format format)
    if (!initialized) {
       table[MESA_FORMAT_NONE] = NULL;
 
-      table[MESA_FORMAT_RGBA8888] = unpack_RGBA8888;
-      table[MESA_FORMAT_RGBA8888_REV] = unpack_RGBA8888_REV;
-      table[MESA_FORMAT_ARGB8888] = unpack_ARGB8888;
-      table[MESA_FORMAT_ARGB8888_REV] = unpack_ARGB8888_REV;
-      table[MESA_FORMAT_RGBX8888] = unpack_RGBX8888;
-      table[MESA_FORMAT_RGBX8888_REV] = unpack_RGBX8888_REV;
-      table[MESA_FORMAT_XRGB8888] = unpack_XRGB8888;
-      table[MESA_FORMAT_XRGB8888_REV] = unpack_XRGB8888_REV;
-      table[MESA_FORMAT_RGB888] = unpack_RGB888;
-      table[MESA_FORMAT_BGR888] = unpack_BGR888;
       table[MESA_FORMAT_RGB565] = unpack_RGB565;
       table[MESA_FORMAT_RGB565_REV] = unpack_RGB565_REV;
       table[MESA_FORMAT_ARGB4444] = unpack_ARGB4444;
@@ -1750,22 +1458,14 @@ get_unpack_rgba_function(gl_format format)
       table[MESA_FORMAT_ARGB1555] = unpack_ARGB1555;
       table[MESA_FORMAT_ARGB1555_REV] = unpack_ARGB1555_REV;
       table[MESA_FORMAT_AL44] = unpack_AL44;
-      table[MESA_FORMAT_AL88] = unpack_AL88;
-      table[MESA_FORMAT_AL88_REV] = unpack_AL88_REV;
       table[MESA_FORMAT_AL1616] = unpack_AL1616;
       table[MESA_FORMAT_AL1616_REV] = unpack_AL1616_REV;
       table[MESA_FORMAT_RGB332] = unpack_RGB332;
-      table[MESA_FORMAT_A8] = unpack_A8;
       table[MESA_FORMAT_A16] = unpack_A16;
-      table[MESA_FORMAT_L8] = unpack_L8;
       table[MESA_FORMAT_L16] = unpack_L16;
-      table[MESA_FORMAT_I8] = unpack_I8;
       table[MESA_FORMAT_I16] = unpack_I16;
       table[MESA_FORMAT_YCBCR] = unpack_YCBCR;
       table[MESA_FORMAT_YCBCR_REV] = unpack_YCBCR_REV;
-      table[MESA_FORMAT_R8] = unpack_R8;
-      table[MESA_FORMAT_GR88] = unpack_GR88;
-      table[MESA_FORMAT_RG88] = unpack_RG88;
       table[MESA_FORMAT_R16] = unpack_R16;
       table[MESA_FORMAT_GR1616] = unpack_GR1616;
       table[MESA_FORMAT_RG1616] = unpack_RG1616;
@@ -1778,11 +1478,6 @@ get_unpack_rgba_function(gl_format format)
       table[MESA_FORMAT_Z24_X8] = unpack_Z24_X8;
       table[MESA_FORMAT_Z32] = unpack_Z32;
       table[MESA_FORMAT_S8] = unpack_S8;
-      table[MESA_FORMAT_SRGB8] = unpack_SRGB8;
-      table[MESA_FORMAT_SRGBA8] = unpack_SRGBA8;
-      table[MESA_FORMAT_SARGB8] = unpack_SARGB8;
-      table[MESA_FORMAT_SL8] = unpack_SL8;
-      table[MESA_FORMAT_SLA8] = unpack_SLA8;
       table[MESA_FORMAT_SRGB_DXT1] = unpack_SRGB_DXT1;
       table[MESA_FORMAT_SRGBA_DXT1] = unpack_SRGBA_DXT1;
       table[MESA_FORMAT_SRGBA_DXT3] = unpack_SRGBA_DXT3;
@@ -1872,7 +1567,6 @@ get_unpack_rgba_function(gl_format format)
       table[MESA_FORMAT_XRGB4444_UNORM] = unpack_XRGB4444_UNORM;
       table[MESA_FORMAT_XRGB1555_UNORM] = unpack_XRGB1555_UNORM;
       table[MESA_FORMAT_XBGR8888_SNORM] = unpack_XBGR8888_SNORM;
-      table[MESA_FORMAT_XBGR8888_SRGB] = unpack_XBGR8888_SRGB;
       table[MESA_FORMAT_XBGR8888_UINT] = unpack_XBGR8888_UINT;
       table[MESA_FORMAT_XBGR8888_SINT] = unpack_XBGR8888_SINT;
       table[MESA_FORMAT_XRGB2101010_UNORM] = unpack_XRGB2101010_UNORM;
@@ -1904,145 +1598,22 @@ void
 _mesa_unpack_rgba_row(gl_format format, GLuint n,
                       const void *src, GLfloat dst[][4])
 {
-   unpack_rgba_func unpack = get_unpack_rgba_function(format);
-   unpack(src, dst, n);
-}
-
-
-/**********************************************************************/
-/*  Unpack, returning GLubyte colors                                  */
-/**********************************************************************/
-
-
-static void
-unpack_ubyte_RGBA8888(const void *src, GLubyte dst[][4], GLuint n)
-{
-   const GLuint *s = ((const GLuint *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = (s[i] >> 24);
-      dst[i][GCOMP] = (s[i] >> 16) & 0xff;
-      dst[i][BCOMP] = (s[i] >>  8) & 0xff;
-      dst[i][ACOMP] = (s[i]      ) & 0xff;
-   }
-}
-
-static void
-unpack_ubyte_RGBA8888_REV(const void *src, GLubyte dst[][4], GLuint n)
-{
-   const GLuint *s = ((const GLuint *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = (s[i]      ) & 0xff;
-      dst[i][GCOMP] = (s[i] >>  8) & 0xff;
-      dst[i][BCOMP] = (s[i] >> 16) & 0xff;
-      dst[i][ACOMP] = (s[i] >> 24);
-   }
-}
-
-static void
-unpack_ubyte_ARGB8888(const void *src, GLubyte dst[][4], GLuint n)
-{
-   const GLuint *s = ((const GLuint *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = (s[i] >> 16) & 0xff;
-      dst[i][GCOMP] = (s[i] >>  8) & 0xff;
-      dst[i][BCOMP] = (s[i]      ) & 0xff;
-      dst[i][ACOMP] = (s[i] >> 24);
-   }
-}
-
-static void
-unpack_ubyte_ARGB8888_REV(const void *src, GLubyte dst[][4], GLuint n)
-{
-   const GLuint *s = ((const GLuint *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = (s[i] >>  8) & 0xff;
-      dst[i][GCOMP] = (s[i] >> 16) & 0xff;
-      dst[i][BCOMP] = (s[i] >> 24);
-      dst[i][ACOMP] = (s[i]      ) & 0xff;
-   }
-}
-
-static void
-unpack_ubyte_RGBX8888(const void *src, GLubyte dst[][4], GLuint n)
-{
-   const GLuint *s = ((const GLuint *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = (s[i] >> 24);
-      dst[i][GCOMP] = (s[i] >> 16) & 0xff;
-      dst[i][BCOMP] = (s[i] >>  8) & 0xff;
-      dst[i][ACOMP] = 0xff;
-   }
-}
+   const struct mesa_row_conv *conv = get_unpack_row_conv(format);
 
-static void
-unpack_ubyte_RGBX8888_REV(const void *src, GLubyte dst[][4], GLuint n)
-{
-   const GLuint *s = ((const GLuint *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = (s[i]      ) & 0xff;
-      dst[i][GCOMP] = (s[i] >>  8) & 0xff;
-      dst[i][BCOMP] = (s[i] >> 16) & 0xff;
-      dst[i][ACOMP] = 0xff;
+   if (conv) {
+      _mesa_row_conv_float(conv, n, src, dst);
    }
-}
-
-static void
-unpack_ubyte_XRGB8888(const void *src, GLubyte dst[][4], GLuint n)
-{
-   const GLuint *s = ((const GLuint *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = (s[i] >> 16) & 0xff;
-      dst[i][GCOMP] = (s[i] >>  8) & 0xff;
-      dst[i][BCOMP] = (s[i]      ) & 0xff;
-      dst[i][ACOMP] = 0xff;
+   else {
+      unpack_rgba_func unpack = get_unpack_rgba_function(format);
+      unpack(src, dst, n);
    }
 }
 
-static void
-unpack_ubyte_XRGB8888_REV(const void *src, GLubyte dst[][4], GLuint n)
-{
-   const GLuint *s = ((const GLuint *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = (s[i] >>  8) & 0xff;
-      dst[i][GCOMP] = (s[i] >> 16) & 0xff;
-      dst[i][BCOMP] = (s[i] >> 24);
-      dst[i][ACOMP] = 0xff;
-   }
-}
 
-static void
-unpack_ubyte_RGB888(const void *src, GLubyte dst[][4], GLuint n)
-{
-   const GLubyte *s = (const GLubyte *) src;
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = s[i*3+2];
-      dst[i][GCOMP] = s[i*3+1];
-      dst[i][BCOMP] = s[i*3+0];
-      dst[i][ACOMP] = 0xff;
-   }
-}
+/**********************************************************************/
+/*  Unpack, returning GLubyte colors                                  */
+/**********************************************************************/
 
-static void
-unpack_ubyte_BGR888(const void *src, GLubyte dst[][4], GLuint n)
-{
-   const GLubyte *s = (const GLubyte *) src;
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = s[i*3+0];
-      dst[i][GCOMP] = s[i*3+1];
-      dst[i][BCOMP] = s[i*3+2];
-      dst[i][ACOMP] = 0xff;
-   }
-}
 
 static void
 unpack_ubyte_RGB565(const void *src, GLubyte dst[][4], GLuint n)
@@ -2150,32 +1721,6 @@ unpack_ubyte_AL44(const void *src, GLubyte dst[][4], GLuint n)
    }
 }
 
-static void
-unpack_ubyte_AL88(const void *src, GLubyte dst[][4], GLuint n)
-{
-   const GLushort *s = ((const GLushort *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = 
-      dst[i][GCOMP] = 
-      dst[i][BCOMP] = EXPAND_4_8(s[i] & 0xff);
-      dst[i][ACOMP] = EXPAND_4_8(s[i] >> 8);
-   }
-}
-
-static void
-unpack_ubyte_AL88_REV(const void *src, GLubyte dst[][4], GLuint n)
-{
-   const GLushort *s = ((const GLushort *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = 
-      dst[i][GCOMP] = 
-      dst[i][BCOMP] = EXPAND_4_8(s[i] >> 8);
-      dst[i][ACOMP] = EXPAND_4_8(s[i] & 0xff);
-   }
-}
-
 static void
 unpack_ubyte_RGB332(const void *src, GLubyte dst[][4], GLuint n)
 {
@@ -2189,84 +1734,6 @@ unpack_ubyte_RGB332(const void *src, GLubyte dst[][4], GLuint n)
    }
 }
 
-static void
-unpack_ubyte_A8(const void *src, GLubyte dst[][4], GLuint n)
-{
-   const GLubyte *s = ((const GLubyte *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] =
-      dst[i][GCOMP] =
-      dst[i][BCOMP] = 0;
-      dst[i][ACOMP] = s[i];
-   }
-}
-
-static void
-unpack_ubyte_L8(const void *src, GLubyte dst[][4], GLuint n)
-{
-   const GLubyte *s = ((const GLubyte *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] =
-      dst[i][GCOMP] =
-      dst[i][BCOMP] = s[i];
-      dst[i][ACOMP] = 0xff;
-   }
-}
-
-
-static void
-unpack_ubyte_I8(const void *src, GLubyte dst[][4], GLuint n)
-{
-   const GLubyte *s = ((const GLubyte *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] =
-      dst[i][GCOMP] =
-      dst[i][BCOMP] =
-      dst[i][ACOMP] = s[i];
-   }
-}
-
-static void
-unpack_ubyte_R8(const void *src, GLubyte dst[][4], GLuint n)
-{
-   const GLubyte *s = ((const GLubyte *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][0] = s[i];
-      dst[i][1] =
-      dst[i][2] = 0;
-      dst[i][3] = 0xff;
-   }
-}
-
-static void
-unpack_ubyte_GR88(const void *src, GLubyte dst[][4], GLuint n)
-{
-   const GLushort *s = ((const GLushort *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = s[i] & 0xff;
-      dst[i][GCOMP] = s[i] >> 8;
-      dst[i][BCOMP] = 0;
-      dst[i][ACOMP] = 0xff;
-   }
-}
-
-static void
-unpack_ubyte_RG88(const void *src, GLubyte dst[][4], GLuint n)
-{
-   const GLushort *s = ((const GLushort *) src);
-   GLuint i;
-   for (i = 0; i < n; i++) {
-      dst[i][RCOMP] = s[i] >> 8;
-      dst[i][GCOMP] = s[i] & 0xff;
-      dst[i][BCOMP] = 0;
-      dst[i][ACOMP] = 0xff;
-   }
-}
 
 
 /**
@@ -2277,37 +1744,15 @@ void
 _mesa_unpack_ubyte_rgba_row(gl_format format, GLuint n,
                             const void *src, GLubyte dst[][4])
 {
+   const struct mesa_row_conv *conv = get_unpack_row_conv(format);
+
+   /* sRGB formats are decoded through the float path below */
+   if (conv && _mesa_get_format_color_encoding(format) == GL_LINEAR) {
+      _mesa_row_conv_ubyte(conv, n, src, &dst[0][0]);
+      return;
+   }
+
    switch (format) {
-   case MESA_FORMAT_RGBA8888:
-      unpack_ubyte_RGBA8888(src, dst, n);
-      break;
-   case MESA_FORMAT_RGBA8888_REV:
-      unpack_ubyte_RGBA8888_REV(src, dst, n);
-      break;
-   case MESA_FORMAT_ARGB8888:
-      unpack_ubyte_ARGB8888(src, dst, n);
-      break;
-   case MESA_FORMAT_ARGB8888_REV:
-      unpack_ubyte_ARGB8888_REV(src, dst, n);
-      break;
-   case MESA_FORMAT_RGBX8888:
-      unpack_ubyte_RGBX8888(src, dst, n);
-      break;
-   case MESA_FORMAT_RGBX8888_REV:
-      unpack_ubyte_RGBX8888_REV(src, dst, n);
-      break;
-   case MESA_FORMAT_XRGB8888:
-      unpack_ubyte_XRGB8888(src, dst, n);
-      break;
-   case MESA_FORMAT_XRGB8888_REV:
-      unpack_ubyte_XRGB8888_REV(src, dst, n);
-      break;
-   case MESA_FORMAT_RGB888:
-      unpack_ubyte_RGB888(src, dst, n);
-      break;
-   case MESA_FORMAT_BGR888:
-      unpack_ubyte_BGR888(src, dst, n);
-      break;
    case MESA_FORMAT_RGB565:
       unpack_ubyte_RGB565(src, dst, n);
       break;
@@ -2332,33 +1777,9 @@ _mesa_unpack_ubyte_rgba_row(gl_format format, GLuint n,
    case MESA_FORMAT_AL44:
       unpack_ubyte_AL44(src, dst, n);
       break;
-   case MESA_FORMAT_AL88:
-      unpack_ubyte_AL88(src, dst, n);
-      break;
-   case MESA_FORMAT_AL88_REV:
-      unpack_ubyte_AL88_REV(src, dst, n);
-      break;
    case MESA_FORMAT_RGB332:
       unpack_ubyte_RGB332(src, dst, n);
       break;
-   case MESA_FORMAT_A8:
-      unpack_ubyte_A8(src, dst, n);
-      break;
-   case MESA_FORMAT_L8:
-      unpack_ubyte_L8(src, dst, n);
-      break;
-   case MESA_FORMAT_I8:
-      unpack_ubyte_I8(src, dst, n);
-      break;
-   case MESA_FORMAT_R8:
-      unpack_ubyte_R8(src, dst, n);
-      break;
-   case MESA_FORMAT_GR88:
-      unpack_ubyte_GR88(src, dst, n);
-      break;
-   case MESA_FORMAT_RG88:
-      unpack_ubyte_RG88(src, dst, n);
-      break;
    default:
       /* get float values, convert to ubyte */
       {
@@ -3211,7 +2632,6 @@ _mesa_unpack_rgba_block(gl_format format,
                         GLfloat dst[][4], GLint dstRowStride,
                         GLuint x, GLuint y, GLuint width, GLuint height)
 {
-   unpack_rgba_func unpack = get_unpack_rgba_function(format);
    const GLuint srcPixStride = _mesa_get_format_bytes(format);
    const GLuint dstPixStride = 4 * sizeof(GLfloat);
    const GLubyte *srcRow;
@@ -3224,7 +2644,7 @@ _mesa_unpack_rgba_block(gl_format format,
    dstRow = ((GLubyte *) dst) + dstRowStride * y + dstPixStride * x;
 
    for (i = 0; i < height; i++) {
-      unpack(srcRow, (GLfloat (*)[4]) dstRow, width);
+      _mesa_unpack_rgba_row(format, width, srcRow, (GLfloat (*)[4]) dstRow);
 
       dstRow += dstRowStride;
       srcRow += srcRowStride;
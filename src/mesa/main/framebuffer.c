@@ -132,6 +132,7 @@ _mesa_initialize_window_framebuffer(struct gl_framebuffer *fb,
    _glthread_INIT_MUTEX(fb->Mutex);
 
    fb->RefCount = 1;
+   fb->FlipY = GL_TRUE;
 
    /* save the visual */
    fb->Visual = *visual;
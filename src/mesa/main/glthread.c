@@ -0,0 +1,633 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file glthread.c
+ * Threaded GL command dispatch.
+ *
+ * When enabled, the application thread's dispatch table is a "marshal"
+ * table whose entry points record each call into a command batch instead of
+ * executing it.  Full batches are executed in order by a server thread that
+ * has the context bound, through the context's real dispatch table.
+ *
+ * Calls that return a value or write through a pointer, or whose pointer
+ * arguments can't be copied, are still recorded in the batch, but the
+ * application thread waits for the server thread to execute them.  Every GL
+ * call is therefore executed on the server thread, in order.
+ *
+ * Window-system code that touches the context from the application thread
+ * (SwapBuffers, MakeCurrent, context destruction) must call
+ * _mesa_glthread_finish() first.
+ */
+
+#include "main/glheader.h"
+#include "main/bufferobj.h"
+#include "main/context.h"
+#include "main/hash.h"
+#include "main/imports.h"
+#include "main/marshal.h"
+#include "main/mtypes.h"
+#include "glapi/glapi.h"
+
+
+#ifdef HAVE_PTHREAD
+
+static void
+glthread_execute_batch(struct gl_context *ctx, struct glthread_batch *batch)
+{
+   size_t pos = 0;
+
+   while (pos < batch->used)
+      pos += _mesa_unmarshal_dispatch_cmd(ctx, (uint8_t *) batch->buffer + pos);
+
+   assert(pos == batch->used);
+   batch->used = 0;
+}
+
+
+static void *
+glthread_worker(void *data)
+{
+   struct gl_context *ctx = data;
+   struct glthread_state *glthread = ctx->GLThread;
+
+   /* The context is current on this thread for as long as it exists; all of
+    * its GL calls are executed here.
+    */
+   _glapi_check_multithread();
+   _glapi_set_context(ctx);
+   _glapi_set_dispatch(ctx->CurrentDispatch);
+
+   pthread_mutex_lock(&glthread->mutex);
+
+   for (;;) {
+      struct glthread_batch *batch;
+
+      while (!glthread->queue && !glthread->shutdown)
+         pthread_cond_wait(&glthread->new_work, &glthread->mutex);
+
+      batch = glthread->queue;
+      if (!batch)
+         break;
+
+      glthread->queue = batch->next;
+      if (!glthread->queue)
+         glthread->queue_tail = &glthread->queue;
+      glthread->busy = true;
+      pthread_mutex_unlock(&glthread->mutex);
+
+      glthread_execute_batch(ctx, batch);
+
+      pthread_mutex_lock(&glthread->mutex);
+      batch->next = glthread->free_batches;
+      glthread->free_batches = batch;
+      glthread->busy = false;
+      pthread_cond_broadcast(&glthread->work_done);
+   }
+
+   pthread_mutex_unlock(&glthread->mutex);
+
+   _glapi_set_context(NULL);
+   _glapi_set_dispatch(NULL);
+
+   return NULL;
+}
+
+
+/**
+ * Start marshalling GL calls for \p ctx onto a server thread.
+ *
+ * Called by drivers after the context's dispatch tables are set up, if the
+ * MESA_GLTHREAD environment variable is set.  The driver is responsible for
+ * calling _mesa_glthread_finish() before touching the context from its
+ * window-system entry points.
+ */
+void
+_mesa_glthread_init(struct gl_context *ctx)
+{
+   struct glthread_state *glthread;
+   unsigned i;
+
+   if (ctx->GLThread)
+      return;
+
+   glthread = calloc(1, sizeof(*glthread));
+   if (!glthread)
+      return;
+
+   glthread->VAOs = _mesa_NewHashTable();
+   if (!glthread->VAOs) {
+      free(glthread);
+      return;
+   }
+
+   ctx->MarshalExec = _mesa_create_marshal_table();
+   if (!ctx->MarshalExec) {
+      _mesa_DeleteHashTable(glthread->VAOs);
+      free(glthread);
+      return;
+   }
+
+   glthread->queue_tail = &glthread->queue;
+   glthread->batch = &glthread->batches[0];
+   for (i = 1; i < MARSHAL_MAX_BATCHES; i++) {
+      glthread->batches[i].next = glthread->free_batches;
+      glthread->free_batches = &glthread->batches[i];
+   }
+   glthread->DefaultVAO.UserPointerMask = VERT_BIT_ALL;
+   glthread->CurrentVAO = &glthread->DefaultVAO;
+
+   pthread_mutex_init(&glthread->mutex, NULL);
+   pthread_cond_init(&glthread->new_work, NULL);
+   pthread_cond_init(&glthread->work_done, NULL);
+
+   ctx->GLThread = glthread;
+
+   if (pthread_create(&glthread->thread, NULL, glthread_worker, ctx) != 0) {
+      ctx->GLThread = NULL;
+      pthread_cond_destroy(&glthread->work_done);
+      pthread_cond_destroy(&glthread->new_work);
+      pthread_mutex_destroy(&glthread->mutex);
+      free(ctx->MarshalExec);
+      ctx->MarshalExec = NULL;
+      _mesa_DeleteHashTable(glthread->VAOs);
+      free(glthread);
+      return;
+   }
+
+   /* If the context is already current, switch its thread over. */
+   if (_mesa_get_current_context() == ctx)
+      _glapi_set_dispatch(ctx->MarshalExec);
+}
+
+
+static void
+free_vao(GLuint key, void *data, void *userData)
+{
+   free(data);
+}
+
+
+/**
+ * Execute everything that is queued, stop the server thread and go back to
+ * executing GL calls directly.
+ */
+void
+_mesa_glthread_destroy(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (!glthread)
+      return;
+
+   _mesa_glthread_flush_batch(ctx);
+
+   pthread_mutex_lock(&glthread->mutex);
+   glthread->shutdown = true;
+   pthread_cond_signal(&glthread->new_work);
+   pthread_mutex_unlock(&glthread->mutex);
+
+   pthread_join(glthread->thread, NULL);
+
+   pthread_cond_destroy(&glthread->work_done);
+   pthread_cond_destroy(&glthread->new_work);
+   pthread_mutex_destroy(&glthread->mutex);
+
+   _mesa_HashDeleteAll(glthread->VAOs, free_vao, NULL);
+   _mesa_DeleteHashTable(glthread->VAOs);
+   free(glthread);
+   ctx->GLThread = NULL;
+
+   free(ctx->MarshalExec);
+   ctx->MarshalExec = NULL;
+
+   if (_mesa_get_current_context() == ctx)
+      _glapi_set_dispatch(ctx->CurrentDispatch);
+}
+
+
+/**
+ * Hand the current batch to the server thread and start a new one.
+ */
+void
+_mesa_glthread_flush_batch(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   struct glthread_batch *batch = glthread->batch;
+
+   if (batch->used == 0)
+      return;
+
+   pthread_mutex_lock(&glthread->mutex);
+
+   batch->next = NULL;
+   *glthread->queue_tail = batch;
+   glthread->queue_tail = &batch->next;
+   pthread_cond_signal(&glthread->new_work);
+
+   while (!glthread->free_batches)
+      pthread_cond_wait(&glthread->work_done, &glthread->mutex);
+
+   glthread->batch = glthread->free_batches;
+   glthread->free_batches = glthread->batch->next;
+
+   pthread_mutex_unlock(&glthread->mutex);
+}
+
+
+/**
+ * Wait for the server thread to execute every call made so far.
+ *
+ * Afterwards the context can safely be inspected or modified from the
+ * calling thread until the next marshalled call.
+ */
+void
+_mesa_glthread_finish(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   if (!glthread)
+      return;
+
+   /* Driver code running on the server thread may end up here. */
+   if (pthread_equal(pthread_self(), glthread->thread))
+      return;
+
+   _mesa_glthread_flush_batch(ctx);
+
+   pthread_mutex_lock(&glthread->mutex);
+   while (glthread->queue || glthread->busy)
+      pthread_cond_wait(&glthread->work_done, &glthread->mutex);
+   pthread_mutex_unlock(&glthread->mutex);
+}
+
+#else /* HAVE_PTHREAD */
+
+void
+_mesa_glthread_init(struct gl_context *ctx)
+{
+}
+
+void
+_mesa_glthread_destroy(struct gl_context *ctx)
+{
+}
+
+void
+_mesa_glthread_flush_batch(struct gl_context *ctx)
+{
+}
+
+void
+_mesa_glthread_finish(struct gl_context *ctx)
+{
+}
+
+#endif /* HAVE_PTHREAD */
+
+
+/**
+ * \name Vertex array tracking
+ *
+ * These are called by the marshalling functions on the application thread,
+ * before the call is recorded.
+ */
+/*@{*/
+
+void
+_mesa_glthread_BindBuffer(struct gl_context *ctx, GLenum target,
+                          GLuint buffer)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+
+   switch (target) {
+   case GL_ARRAY_BUFFER:
+      glthread->CurrentArrayBufferName = buffer;
+      break;
+   case GL_ELEMENT_ARRAY_BUFFER:
+      if (glthread->CurrentVAO)
+         glthread->CurrentVAO->CurrentElementBufferName = buffer;
+      break;
+   }
+}
+
+
+void
+_mesa_glthread_DeleteBuffers(struct gl_context *ctx, GLsizei n,
+                             const GLuint *buffers)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   GLsizei i;
+
+   if (!buffers)
+      return;
+
+   /* Deleting a buffer unbinds it from the current bindings. */
+   for (i = 0; i < n; i++) {
+      if (buffers[i] == 0)
+         continue;
+      if (buffers[i] == glthread->CurrentArrayBufferName)
+         glthread->CurrentArrayBufferName = 0;
+      if (glthread->CurrentVAO &&
+          buffers[i] == glthread->CurrentVAO->CurrentElementBufferName)
+         glthread->CurrentVAO->CurrentElementBufferName = 0;
+   }
+}
+
+
+static struct glthread_vao *
+lookup_vao(struct gl_context *ctx, GLuint id)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   struct glthread_vao *vao;
+
+   if (id == 0)
+      return &glthread->DefaultVAO;
+
+   vao = _mesa_HashLookup(glthread->VAOs, id);
+   if (!vao) {
+      /* First bind of a new name: it starts out with nothing bound, and
+       * with all arrays disabled and pointing to (NULL) user memory.
+       */
+      vao = calloc(1, sizeof(*vao));
+      if (!vao)
+         return NULL;
+      vao->Name = id;
+      vao->UserPointerMask = VERT_BIT_ALL;
+      _mesa_HashInsert(glthread->VAOs, id, vao);
+   }
+
+   return vao;
+}
+
+
+void
+_mesa_glthread_BindVertexArray(struct gl_context *ctx, GLuint id)
+{
+   /* If we're out of memory, draws are synchronous until the next bind. */
+   ctx->GLThread->CurrentVAO = lookup_vao(ctx, id);
+}
+
+
+void
+_mesa_glthread_DeleteVertexArrays(struct gl_context *ctx, GLsizei n,
+                                  const GLuint *ids)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   GLsizei i;
+
+   if (!ids)
+      return;
+
+   for (i = 0; i < n; i++) {
+      struct glthread_vao *vao;
+
+      if (ids[i] == 0)
+         continue;
+
+      vao = _mesa_HashLookup(glthread->VAOs, ids[i]);
+      if (!vao)
+         continue;
+
+      /* Deleting the bound VAO reverts to the default one. */
+      if (glthread->CurrentVAO == vao)
+         glthread->CurrentVAO = &glthread->DefaultVAO;
+
+      _mesa_HashRemove(glthread->VAOs, ids[i]);
+      free(vao);
+   }
+}
+
+
+void
+_mesa_glthread_ClientActiveTexture(struct gl_context *ctx, GLenum texture)
+{
+   const GLuint unit = texture - GL_TEXTURE0;
+
+   if (unit < ctx->Const.MaxTextureCoordUnits)
+      ctx->GLThread->ClientActiveTexture = unit;
+}
+
+
+/**
+ * Track glEnable/DisableClientState, which affect the bound VAO.  This
+ * mirrors client_state() in enable.c.
+ */
+static void
+client_state(struct gl_context *ctx, GLenum cap, bool state)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   struct glthread_vao *vao = glthread->CurrentVAO;
+   GLbitfield64 flag;
+
+   switch (cap) {
+   case GL_VERTEX_ARRAY:
+      flag = VERT_BIT_POS;
+      break;
+   case GL_NORMAL_ARRAY:
+      flag = VERT_BIT_NORMAL;
+      break;
+   case GL_COLOR_ARRAY:
+      flag = VERT_BIT_COLOR0;
+      break;
+   case GL_INDEX_ARRAY:
+      flag = VERT_BIT_COLOR_INDEX;
+      break;
+   case GL_TEXTURE_COORD_ARRAY:
+      flag = VERT_BIT_TEX(glthread->ClientActiveTexture);
+      break;
+   case GL_EDGE_FLAG_ARRAY:
+      flag = VERT_BIT_EDGEFLAG;
+      break;
+   case GL_FOG_COORDINATE_ARRAY_EXT:
+      flag = VERT_BIT_FOG;
+      break;
+   case GL_SECONDARY_COLOR_ARRAY_EXT:
+      flag = VERT_BIT_COLOR1;
+      break;
+   case GL_POINT_SIZE_ARRAY_OES:
+      flag = VERT_BIT_POINT_SIZE;
+      break;
+   default:
+      return;
+   }
+
+   if (!vao)
+      return;
+
+   if (state)
+      vao->Enabled |= flag;
+   else
+      vao->Enabled &= ~flag;
+}
+
+
+void
+_mesa_glthread_Enable(struct gl_context *ctx, GLenum cap)
+{
+   client_state(ctx, cap, true);
+}
+
+
+void
+_mesa_glthread_Disable(struct gl_context *ctx, GLenum cap)
+{
+   client_state(ctx, cap, false);
+}
+
+
+void
+_mesa_glthread_EnableClientState(struct gl_context *ctx, GLenum cap)
+{
+   client_state(ctx, cap, true);
+}
+
+
+void
+_mesa_glthread_DisableClientState(struct gl_context *ctx, GLenum cap)
+{
+   client_state(ctx, cap, false);
+}
+
+
+static void
+generic_array_state(struct gl_context *ctx, GLuint index, bool state)
+{
+   struct glthread_vao *vao = ctx->GLThread->CurrentVAO;
+
+   if (!vao || index >= ctx->Const.VertexProgram.MaxAttribs)
+      return;
+
+   if (state)
+      vao->Enabled |= VERT_BIT_GENERIC(index);
+   else
+      vao->Enabled &= ~VERT_BIT_GENERIC(index);
+}
+
+
+void
+_mesa_glthread_EnableVertexAttribArray(struct gl_context *ctx, GLuint index)
+{
+   generic_array_state(ctx, index, true);
+}
+
+
+void
+_mesa_glthread_DisableVertexAttribArray(struct gl_context *ctx, GLuint index)
+{
+   generic_array_state(ctx, index, false);
+}
+
+
+/**
+ * Called for gl*Pointer, which sets the array of the VERT_ATTRIB_* value
+ * \p attrib (or of none that draws read, for VERT_ATTRIB_MAX).  Returns
+ * whether the pointer is an offset into a buffer object, in which case the
+ * call can be deferred.  Otherwise it points to user memory, and draws have
+ * to wait while that array is enabled.
+ */
+bool
+_mesa_glthread_attrib_pointer(struct gl_context *ctx, unsigned attrib)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   struct glthread_vao *vao = glthread->CurrentVAO;
+   const bool is_offset = glthread->CurrentArrayBufferName != 0;
+
+   if (vao && attrib < VERT_ATTRIB_MAX) {
+      if (is_offset)
+         vao->UserPointerMask &= ~VERT_BIT(attrib);
+      else
+         vao->UserPointerMask |= VERT_BIT(attrib);
+   }
+
+   return is_offset;
+}
+
+
+/**
+ * Called for glVertexAttribPointer and glVertexAttribIPointer.
+ */
+bool
+_mesa_glthread_generic_attrib_pointer(struct gl_context *ctx, GLuint index)
+{
+   if (index >= ctx->Const.VertexProgram.MaxAttribs)
+      return _mesa_glthread_attrib_pointer(ctx, VERT_ATTRIB_MAX);
+
+   return _mesa_glthread_attrib_pointer(ctx, VERT_ATTRIB_GENERIC(index));
+}
+
+
+/**
+ * Called after calls that change the vertex arrays in ways not tracked
+ * here (glPopClientAttrib, glInterleavedArrays, the IBM and INTEL pointer
+ * lists).  Those are executed synchronously, so the server thread is idle
+ * and the state can be read back from the context.
+ */
+void
+_mesa_glthread_update_arrays(struct gl_context *ctx)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   const struct gl_array_object *obj = ctx->Array.ArrayObj;
+   struct glthread_vao *vao = lookup_vao(ctx, obj->Name);
+   unsigned i;
+
+   glthread->CurrentVAO = vao;
+   glthread->CurrentArrayBufferName = ctx->Array.ArrayBufferObj->Name;
+   glthread->ClientActiveTexture = ctx->Array.ActiveTexture;
+
+   if (!vao)
+      return;
+
+   vao->CurrentElementBufferName = obj->ElementArrayBufferObj->Name;
+   vao->Enabled = obj->_Enabled;
+   vao->UserPointerMask = 0;
+   for (i = 0; i < VERT_ATTRIB_MAX; i++) {
+      if (!_mesa_is_bufferobj(obj->VertexAttrib[i].BufferObj))
+         vao->UserPointerMask |= VERT_BIT(i);
+   }
+}
+
+
+/**
+ * Whether a draw call can be deferred.  That's the case unless it may read
+ * vertices or indices from user memory, which is decided from the arrays
+ * enabled at the time of the draw.
+ */
+bool
+_mesa_glthread_can_defer_draw(struct gl_context *ctx, bool indexed)
+{
+   const struct glthread_vao *vao = ctx->GLThread->CurrentVAO;
+
+   if (!vao)
+      return false;
+
+   if (vao->Enabled & vao->UserPointerMask)
+      return false;
+
+   if (indexed && vao->CurrentElementBufferName == 0)
+      return false;
+
+   return true;
+}
+
+/*@}*/
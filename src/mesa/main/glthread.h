@@ -0,0 +1,195 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _GLTHREAD_H
+#define _GLTHREAD_H
+
+#include <stdbool.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#include "glheader.h"
+#include "mtypes.h"
+
+struct gl_context;
+
+
+/**
+ * Size of a command batch, and thus the largest command that can be
+ * marshalled.
+ */
+#define MARSHAL_MAX_CMD_SIZE (8 * 1024)
+
+/**
+ * Number of batches per context.  While the server thread executes one, the
+ * application fills the next one.
+ */
+#define MARSHAL_MAX_BATCHES 4
+
+
+struct glthread_batch
+{
+   /** Next batch in the work queue or the free list */
+   struct glthread_batch *next;
+
+   /** Bytes of \c buffer filled with commands */
+   size_t used;
+
+   /** Commands, 8-byte aligned so that they can hold doubles and pointers */
+   uint64_t buffer[MARSHAL_MAX_CMD_SIZE / 8];
+};
+
+
+/**
+ * What the application thread knows about a vertex array object.
+ */
+struct glthread_vao
+{
+   GLuint Name;
+   GLuint CurrentElementBufferName;
+
+   /** Mask of VERT_BIT_* values for the enabled arrays */
+   GLbitfield64 Enabled;
+
+   /** Mask of VERT_BIT_* values for the arrays that point to user memory */
+   GLbitfield64 UserPointerMask;
+};
+
+
+/**
+ * State of a context's command marshalling.
+ *
+ * Everything but the queue is only touched by the application thread.
+ */
+struct glthread_state
+{
+#ifdef HAVE_PTHREAD
+   pthread_t thread;
+   pthread_mutex_t mutex;
+
+   /** Signalled when a batch is queued or the thread must exit */
+   pthread_cond_t new_work;
+
+   /** Signalled when the server thread finished a batch */
+   pthread_cond_t work_done;
+#endif
+
+   /** Batches waiting to be executed, oldest first */
+   struct glthread_batch *queue;
+   struct glthread_batch **queue_tail;
+
+   /** Batches that have been executed and can be refilled */
+   struct glthread_batch *free_batches;
+
+   /** Whether the server thread is executing a batch */
+   bool busy;
+
+   /** Tells the server thread to exit once the queue is empty */
+   bool shutdown;
+
+   /** The batch the application thread is filling */
+   struct glthread_batch *batch;
+
+   struct glthread_batch batches[MARSHAL_MAX_BATCHES];
+
+   /**
+    * \name Vertex array state tracked on the application thread
+    *
+    * Draw calls and gl*Pointer calls can only be deferred when they refer
+    * to buffer objects; anything in user memory may be changed by the
+    * application as soon as the call returns.
+    */
+   /*@{*/
+   struct _mesa_HashTable *VAOs;
+   struct glthread_vao DefaultVAO;
+
+   /** NULL if the bound VAO couldn't be tracked; draws are then synchronous */
+   struct glthread_vao *CurrentVAO;
+
+   GLuint CurrentArrayBufferName;
+   GLuint ClientActiveTexture;
+   /*@}*/
+};
+
+
+extern void
+_mesa_glthread_init(struct gl_context *ctx);
+
+extern void
+_mesa_glthread_destroy(struct gl_context *ctx);
+
+extern void
+_mesa_glthread_flush_batch(struct gl_context *ctx);
+
+extern void
+_mesa_glthread_finish(struct gl_context *ctx);
+
+extern void
+_mesa_glthread_BindBuffer(struct gl_context *ctx, GLenum target,
+                          GLuint buffer);
+
+extern void
+_mesa_glthread_DeleteBuffers(struct gl_context *ctx, GLsizei n,
+                             const GLuint *buffers);
+
+extern void
+_mesa_glthread_BindVertexArray(struct gl_context *ctx, GLuint id);
+
+extern void
+_mesa_glthread_DeleteVertexArrays(struct gl_context *ctx, GLsizei n,
+                                  const GLuint *ids);
+
+extern void
+_mesa_glthread_ClientActiveTexture(struct gl_context *ctx, GLenum texture);
+
+extern void
+_mesa_glthread_Enable(struct gl_context *ctx, GLenum cap);
+
+extern void
+_mesa_glthread_Disable(struct gl_context *ctx, GLenum cap);
+
+extern void
+_mesa_glthread_EnableClientState(struct gl_context *ctx, GLenum cap);
+
+extern void
+_mesa_glthread_DisableClientState(struct gl_context *ctx, GLenum cap);
+
+extern void
+_mesa_glthread_EnableVertexAttribArray(struct gl_context *ctx, GLuint index);
+
+extern void
+_mesa_glthread_DisableVertexAttribArray(struct gl_context *ctx, GLuint index);
+
+extern bool
+_mesa_glthread_attrib_pointer(struct gl_context *ctx, unsigned attrib);
+
+extern bool
+_mesa_glthread_generic_attrib_pointer(struct gl_context *ctx, GLuint index);
+
+extern void
+_mesa_glthread_update_arrays(struct gl_context *ctx);
+
+extern bool
+_mesa_glthread_can_defer_draw(struct gl_context *ctx, bool indexed);
+
+#endif /* _GLTHREAD_H */
@@ -53,17 +53,98 @@
  */
 #define DELETED_KEY_VALUE 1
 
+/**
+ * Keys below this are also mirrored in a flat array that _mesa_HashLookup()
+ * reads without taking the table's mutex.
+ *
+ * glGen*() hands out small contiguous names, so in practice every object an
+ * application binds ends up in the array, and the per-draw lookups of bound
+ * objects from several shared contexts no longer serialize on the mutex.
+ * The array grows geometrically up to this many entries.
+ */
+#define DIRECT_MAX_KEYS (64 * 1024)
+
+#define DIRECT_MIN_KEYS 64
+
+/**
+ * Number of slots in the cache of recently looked up keys that aren't in
+ * the flat array.
+ *
+ * glGen*() keeps handing out names past the highest one in use, so an
+ * application that keeps creating and deleting objects ends up binding
+ * names past DIRECT_MAX_KEYS.  The few objects bound at a time are looked
+ * up over and over; the cache lets those lookups skip the mutex too.
+ */
+#define HOT_SLOTS 256
+
+/**
+ * Lock-less lookups need the stores of a new array (or of a new entry's
+ * object) to be visible before the pointer to it, and the hot cache needs
+ * the loads of a slot to happen in order.  Compilers we don't know how to
+ * emit barriers for just take the mutex for every lookup.  On x86 stores are
+ * not reordered with each other, nor loads with each other, so MSVC only
+ * needs compiler barriers there.
+ */
+#if defined(__GNUC__)
+#define HASH_LOCKLESS_LOOKUP 1
+#define HASH_WRITE_BARRIER() __sync_synchronize()
+#ifdef __ATOMIC_ACQUIRE
+#define HASH_READ_BARRIER() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#else
+#define HASH_READ_BARRIER() __sync_synchronize()
+#endif
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define HASH_LOCKLESS_LOOKUP 1
+#define HASH_WRITE_BARRIER() _ReadWriteBarrier()
+#define HASH_READ_BARRIER() _ReadWriteBarrier()
+#endif
+
+/**
+ * Flat key -> data array for the keys below DIRECT_MAX_KEYS.
+ *
+ * It is only written with the table's mutex held.  When it has to grow, a
+ * larger one is filled from the hash table and published, and the old one is
+ * kept on the \c Prev list until the table is deleted, since a lock-less
+ * reader may still be looking at it.
+ * Because the size doubles each time, the retired arrays never take more
+ * memory than the current one.
+ */
+struct hash_direct {
+   struct hash_direct *Prev;
+   GLuint Size;
+   void *Data[1];
+};
+
+/**
+ * A slot of the hot cache, indexed by key % HOT_SLOTS.
+ *
+ * Slots are only written with the table's mutex held.  \c Seq is odd while
+ * a slot is being written, so a lock-less reader that sees the same even
+ * \c Seq before and after reading the key and data knows they belong
+ * together.  A zero key is an empty slot.
+ */
+struct hash_hot {
+   volatile GLuint Seq;
+   volatile GLuint Key;
+   void * volatile Data;
+};
+
 /**
  * The hash table data structure.  
  */
 struct _mesa_HashTable {
    struct hash_table *ht;
+   struct hash_direct * volatile Direct; /**< mirror of the low keys */
    GLuint MaxKey;                        /**< highest key inserted so far */
    _glthread_Mutex Mutex;                /**< mutual exclusion lock */
    _glthread_Mutex WalkMutex;            /**< for _mesa_HashWalk() */
    GLboolean InDeleteAll;                /**< Debug check */
    /** Value that would be in the table for DELETED_KEY_VALUE. */
    void *deleted_key_data;
+#ifdef HASH_LOCKLESS_LOOKUP
+   struct hash_hot Hot[HOT_SLOTS]; /**< recently looked up high keys */
+#endif
 };
 
 /** @{
@@ -104,6 +185,137 @@ uint_key(GLuint id)
 }
 /** @} */
 
+
+#ifdef HASH_LOCKLESS_LOOKUP
+/**
+ * Allocate a flat array of \p size entries and fill it from the hash table.
+ * Called with the table's mutex held.
+ */
+static struct hash_direct *
+direct_create(struct _mesa_HashTable *table, GLuint size)
+{
+   struct hash_direct *direct =
+      calloc(1, sizeof(*direct) + (size - 1) * sizeof(direct->Data[0]));
+   struct hash_entry *entry;
+
+   if (!direct)
+      return NULL;
+
+   direct->Prev = table->Direct;
+   direct->Size = size;
+
+   hash_table_foreach(table->ht, entry) {
+      GLuint key = (GLuint) (uintptr_t) entry->key;
+      if (key < size)
+         direct->Data[key] = entry->data;
+   }
+   direct->Data[DELETED_KEY_VALUE] = table->deleted_key_data;
+
+   return direct;
+}
+#endif
+
+
+/**
+ * Mirror the hash table's (new) \p data for \p key in the flat array,
+ * growing it if needed.  Called with the table's mutex held, after the hash
+ * table itself has been updated.
+ */
+static void
+direct_store(struct _mesa_HashTable *table, GLuint key, void *data)
+{
+#ifdef HASH_LOCKLESS_LOOKUP
+   struct hash_direct *direct = table->Direct;
+
+   if (!direct || key >= DIRECT_MAX_KEYS)
+      return;
+
+   if (key >= direct->Size) {
+      GLuint size = direct->Size;
+
+      if (!data)
+         return; /* keys past the end aren't mirrored in the first place */
+
+      while (key >= size)
+         size *= 2;
+
+      /* Lookups of keys past the end of the array take the locked path, so
+       * if we fail to grow it they still find the entry in the hash table.
+       */
+      direct = direct_create(table, size);
+      if (!direct)
+         return;
+
+      HASH_WRITE_BARRIER();
+      table->Direct = direct;
+      return;
+   }
+
+   /* Make sure whatever \p data points to is visible to other threads
+    * before the pointer itself is.
+    */
+   HASH_WRITE_BARRIER();
+   direct->Data[key] = data;
+#endif
+}
+
+
+#ifdef HASH_LOCKLESS_LOOKUP
+/**
+ * Set hot cache slot \p slot to \p key and \p data.  Called with the
+ * table's mutex held.
+ */
+static void
+hot_store(struct _mesa_HashTable *table, GLuint slot, GLuint key, void *data)
+{
+   struct hash_hot *hot = &table->Hot[slot % HOT_SLOTS];
+
+   hot->Seq++;
+   HASH_WRITE_BARRIER();
+   hot->Key = key;
+   hot->Data = data;
+   HASH_WRITE_BARRIER();
+   hot->Seq++;
+}
+
+
+/**
+ * Look \p key up in the hot cache without locking.
+ *
+ * \return GL_TRUE and the key's data in \p data on a hit.
+ */
+static inline GLboolean
+hot_lookup(const struct _mesa_HashTable *table, GLuint key, void **data)
+{
+   const struct hash_hot *hot = &table->Hot[key % HOT_SLOTS];
+   GLuint seq = hot->Seq;
+
+   HASH_READ_BARRIER();
+   if ((seq & 1) || hot->Key != key)
+      return GL_FALSE;
+
+   *data = hot->Data;
+   HASH_READ_BARRIER();
+   return hot->Seq == seq;
+}
+#endif
+
+
+/**
+ * Keep the hot cache in sync with a change of \p key's data.  Called with
+ * the table's mutex held.  Removed keys are dropped from the cache, so it
+ * never returns data for a key that isn't in the table.
+ */
+static void
+hot_update(struct _mesa_HashTable *table, GLuint key, void *data)
+{
+#ifdef HASH_LOCKLESS_LOOKUP
+   if (table->Hot[key % HOT_SLOTS].Key == key)
+      hot_store(table, key, data ? key : 0, data);
+#endif
+}
+
+
 /**
  * Create a new hash table.
  * 
@@ -119,6 +331,9 @@ _mesa_NewHashTable(void)
    if (table) {
       _glthread_INIT_MUTEX(table->Mutex);
       _glthread_INIT_MUTEX(table->WalkMutex);
+#ifdef HASH_LOCKLESS_LOOKUP
+      table->Direct = direct_create(table, DIRECT_MIN_KEYS);
+#endif
    }
    return table;
 }
@@ -144,6 +359,12 @@ _mesa_DeleteHashTable(struct _mesa_HashTable *table)
 
    _mesa_hash_table_destroy(table->ht, NULL);
 
+   while (table->Direct) {
+      struct hash_direct *prev = table->Direct->Prev;
+      free(table->Direct);
+      table->Direct = prev;
+   }
+
    _glthread_DESTROY_MUTEX(table->Mutex);
    _glthread_DESTROY_MUTEX(table->WalkMutex);
    free(table);
@@ -181,14 +402,33 @@ _mesa_HashLookup_unlocked(struct _mesa_HashTable *table, GLuint key)
  * \param key the key.
  * 
  * \return pointer to user's data or NULL if key not in table
+ *
+ * Keys covered by the flat array are looked up without locking.  This gives
+ * the same guarantees as the locked path: the entry may be replaced or
+ * removed as soon as the mutex would have been dropped anyway.
  */
 void *
 _mesa_HashLookup(struct _mesa_HashTable *table, GLuint key)
 {
    void *res;
+#ifdef HASH_LOCKLESS_LOOKUP
+   const struct hash_direct *direct = table->Direct;
+
+   assert(key);
+   if (likely(direct && key < direct->Size))
+      return direct->Data[key];
+
+   if (hot_lookup(table, key, &res))
+      return res;
+#endif
+
    assert(table);
    _glthread_LOCK_MUTEX(table->Mutex);
    res = _mesa_HashLookup_unlocked(table, key);
+#ifdef HASH_LOCKLESS_LOOKUP
+   if (res)
+      hot_store(table, key, key, res);
+#endif
    _glthread_UNLOCK_MUTEX(table->Mutex);
    return res;
 }
@@ -227,6 +467,9 @@ _mesa_HashInsert(struct _mesa_HashTable *table, GLuint key, void *data)
       }
    }
 
+   direct_store(table, key, data);
+   hot_update(table, key, data);
+
    _glthread_UNLOCK_MUTEX(table->Mutex);
 }
 
@@ -263,6 +506,8 @@ _mesa_HashRemove(struct _mesa_HashTable *table, GLuint key)
       entry = _mesa_hash_table_search(table->ht, uint_hash(key), uint_key(key));
       _mesa_hash_table_remove(table->ht, entry);
    }
+   direct_store(table, key, NULL);
+   hot_update(table, key, NULL);
    _glthread_UNLOCK_MUTEX(table->Mutex);
 }
 
@@ -283,6 +528,9 @@ _mesa_HashDeleteAll(struct _mesa_HashTable *table,
                     void *userData)
 {
    struct hash_entry *entry;
+#ifdef HASH_LOCKLESS_LOOKUP
+   GLuint i;
+#endif
 
    ASSERT(table);
    ASSERT(callback);
@@ -296,6 +544,16 @@ _mesa_HashDeleteAll(struct _mesa_HashTable *table,
       callback(DELETED_KEY_VALUE, table->deleted_key_data, userData);
       table->deleted_key_data = NULL;
    }
+   if (table->Direct) {
+      memset(table->Direct->Data, 0,
+             table->Direct->Size * sizeof(table->Direct->Data[0]));
+   }
+#ifdef HASH_LOCKLESS_LOOKUP
+   for (i = 0; i < HOT_SLOTS; i++) {
+      if (table->Hot[i].Key)
+         hot_store(table, i, 0, NULL);
+   }
+#endif
    table->InDeleteAll = GL_FALSE;
    _glthread_UNLOCK_MUTEX(table->Mutex);
 }
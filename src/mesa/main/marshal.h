@@ -0,0 +1,90 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file marshal.h
+ * Encoding of GL calls into glthread command batches.
+ *
+ * The marshalling and unmarshalling functions themselves are generated
+ * from the API XML by gl_marshal.py into marshal_generated.c.
+ */
+
+#ifndef MARSHAL_H
+#define MARSHAL_H
+
+#include "main/context.h"
+#include "main/glthread.h"
+
+
+/**
+ * Header at the start of every command in a batch.
+ */
+struct marshal_cmd_base
+{
+   /** Which of the generated DISPATCH_CMD_x this is */
+   uint16_t cmd_id;
+
+   /** Size of the command in bytes, including this header */
+   uint16_t cmd_size;
+};
+
+
+/**
+ * Reserve \p size bytes for a command in the current batch, flushing the
+ * batch first if it doesn't fit.
+ *
+ * \p size must be a multiple of 8 and no larger than MARSHAL_MAX_CMD_SIZE.
+ */
+static inline void *
+_mesa_glthread_allocate_command(struct gl_context *ctx,
+                                uint16_t cmd_id, size_t size)
+{
+   struct glthread_state *glthread = ctx->GLThread;
+   struct marshal_cmd_base *cmd_base;
+
+   assert(size % 8 == 0 && size <= MARSHAL_MAX_CMD_SIZE);
+
+   if (glthread->batch->used + size > MARSHAL_MAX_CMD_SIZE)
+      _mesa_glthread_flush_batch(ctx);
+
+   cmd_base = (struct marshal_cmd_base *)
+      ((uint8_t *) glthread->batch->buffer + glthread->batch->used);
+   glthread->batch->used += size;
+   cmd_base->cmd_id = cmd_id;
+   cmd_base->cmd_size = size;
+
+   return cmd_base;
+}
+
+
+/** Round a command size up so that the next command stays aligned */
+#define MARSHAL_ALIGN(size) (((size) + 7) & ~(size_t) 7)
+
+
+extern size_t
+_mesa_unmarshal_dispatch_cmd(struct gl_context *ctx, const void *cmd);
+
+extern struct _glapi_table *
+_mesa_create_marshal_table(void);
+
+#endif /* MARSHAL_H */
@@ -137,6 +137,49 @@ bytes_per_pixel(GLenum datatype, GLuint comps)
 /*@}*/
 
 
+/**
+ * Halve a row of 4 x GLubyte pixels, four texels to one.
+ *
+ * Only this case (RGBA8 with the width halved) is specialized; other
+ * formats, and rows whose width isn't halved, use the loops in do_row().
+ * Rather than averaging one channel at a time, all four channels of a pixel
+ * are summed at once in a 32-bit word: the even and odd bytes are masked
+ * apart so that each gets a 16-bit lane, where the sum of four texels can't
+ * overflow into its neighbour.  The result is identical to the per-channel
+ * (a + b + c + d) / 4, independently of the host's byte order.
+ */
+static void
+do_row_ubyte4_halve(const GLubyte *rowA, const GLubyte *rowB,
+                    GLint dstWidth, GLubyte *dst)
+{
+   const GLuint mask = 0x00ff00ff;
+   GLint i;
+
+   for (i = 0; i < dstWidth; i++) {
+      GLuint aj, ak, bj, bk, even, odd, res;
+
+      /* memcpy() rather than pointer casts, since image rows are only
+       * guaranteed to be byte aligned.  Compilers turn these into loads.
+       */
+      memcpy(&aj, rowA, 4);
+      memcpy(&ak, rowA + 4, 4);
+      memcpy(&bj, rowB, 4);
+      memcpy(&bk, rowB + 4, 4);
+
+      even = (aj & mask) + (ak & mask) + (bj & mask) + (bk & mask);
+      odd = ((aj >> 8) & mask) + ((ak >> 8) & mask) +
+            ((bj >> 8) & mask) + ((bk >> 8) & mask);
+      res = ((even >> 2) & mask) | (((odd >> 2) & mask) << 8);
+
+      memcpy(dst, &res, 4);
+
+      rowA += 8;
+      rowB += 8;
+      dst += 4;
+   }
+}
+
+
 /**
  * Average together two rows of a source image to produce a single new
  * row in the dest image.  It's legal for the two source rows to point
@@ -160,7 +203,11 @@ do_row(GLenum datatype, GLuint comps, GLint srcWidth,
    assert(srcWidth == dstWidth || srcWidth == 2 * dstWidth);
    */
 
-   if (datatype == GL_UNSIGNED_BYTE && comps == 4) {
+   if (datatype == GL_UNSIGNED_BYTE && comps == 4 && srcWidth == 2 * dstWidth) {
+      do_row_ubyte4_halve((const GLubyte *) srcRowA, (const GLubyte *) srcRowB,
+                          dstWidth, (GLubyte *) dstRow);
+   }
+   else if (datatype == GL_UNSIGNED_BYTE && comps == 4) {
       GLuint i, j, k;
       const GLubyte(*rowA)[4] = (const GLubyte(*)[4]) srcRowA;
       const GLubyte(*rowB)[4] = (const GLubyte(*)[4]) srcRowB;
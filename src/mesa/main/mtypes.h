@@ -1538,6 +1538,13 @@ struct gl_buffer_object
    GLboolean DeletePending;   /**< true if buffer object is removed from the hash */
    GLboolean Written;   /**< Ever written to? (for debugging) */
    GLboolean Purgeable; /**< Is the buffer purgeable under memory pressure? */
+
+   /** Fields for caching index buffer scans, see vbo_minmax_index.c */
+   /*@{*/
+   struct hash_table *MinMaxCache;
+   GLboolean MinMaxCacheDirty;    /**< contents changed since last scan */
+   GLboolean MinMaxCacheDisabled; /**< buffer may be written by the GPU */
+   /*@}*/
 };
 
 
@@ -2230,6 +2237,17 @@ struct gl_shader
    GLint RefCount;  /**< Reference count */
    GLboolean DeletePending;
    GLboolean CompileStatus;
+
+   /**
+    * \name Compilation on the share group's shader queue
+    *
+    * Only changed with the queue's mutex held; see shaderqueue.c.
+    */
+   /*@{*/
+   GLboolean CompilePending;  /**< Compile is queued or running */
+   GLuint PendingLinks;       /**< Queued or running links that use this */
+   /*@}*/
+
    const GLchar *Source;  /**< Source code string */
    GLuint SourceChecksum;       /**< for debug/logging purposes */
    struct gl_program *Program;  /**< Post-compile assembly code */
@@ -2466,6 +2484,7 @@ struct gl_shader_program
    gl_texture_index SamplerTargets[MAX_SAMPLERS];
 
    GLboolean LinkStatus;   /**< GL_LINK_STATUS */
+   GLboolean LinkPending;  /**< Link is queued or running, see shaderqueue.c */
    GLboolean Validated;
    GLboolean _Used;        /**< Ever used for drawing? */
    GLchar *InfoLog;
@@ -2521,6 +2540,9 @@ struct gl_shader_state
    struct gl_shader_program *ActiveProgram;
 
    GLbitfield Flags;                    /**< Mask of GLSL_x flags */
+
+   /** GL_ARB_parallel_shader_compile: MAX_SHADER_COMPILER_THREADS_ARB */
+   GLuint MaxCompilerThreads;
 };
 
 
@@ -2666,6 +2688,9 @@ struct gl_shared_state
 
    /** GL_ARB_sampler_objects */
    struct _mesa_HashTable *SamplerObjects;
+
+   /** Worker threads compiling and linking shaders (see shaderqueue.c) */
+   struct gl_shader_queue *ShaderQueue;
 };
 
 
@@ -2745,6 +2770,13 @@ struct gl_framebuffer
     */
    GLuint Name;
 
+   /**
+    * Whether the first row of the renderbuffers is the top of the image,
+    * which is how window system framebuffers are usually stored, rather
+    * than the bottom as with FBOs.  If so, drivers flip Y when rendering.
+    */
+   GLboolean FlipY;
+
    GLint RefCount;
    GLboolean DeletePending;
 
@@ -3046,6 +3078,13 @@ struct gl_constants
    GLint MaxColorTextureSamples;
    GLint MaxDepthTextureSamples;
    GLint MaxIntegerSamples;
+
+   /**
+    * Number of threads the share group may use to compile and link shaders
+    * off the application thread.  Zero, the default, compiles and links
+    * every shader synchronously and hides GL_ARB_parallel_shader_compile.
+    */
+   GLuint MaxShaderCompilerThreads;
 };
 
 
@@ -3086,6 +3125,7 @@ struct gl_extensions
    GLboolean ARB_map_buffer_range;
    GLboolean ARB_occlusion_query;
    GLboolean ARB_occlusion_query2;
+   GLboolean ARB_parallel_shader_compile;
    GLboolean ARB_point_sprite;
    GLboolean ARB_seamless_cube_map;
    GLboolean ARB_shader_bit_encoding;
@@ -3365,6 +3405,13 @@ struct gl_dlist_state
        * list.  Used to eliminate some redundant state changes.
        */
       GLenum ShadeModel;
+
+      /**
+       * Set once the list has done something (glPopAttrib, evaluators)
+       * that may change current attributes or materials behind the back
+       * of CurrentAttrib and CurrentMaterial.
+       */
+      GLboolean AttribsUnknown;
    } Current;
 };
 
@@ -3520,8 +3567,17 @@ struct gl_context
     * re-set on glXMakeCurrent().
     */
    struct _glapi_table *CurrentDispatch;
+   /**
+    * The dispatch table installed on the application thread when glthread
+    * is enabled.  It records calls for the server thread, which executes
+    * them through CurrentDispatch.
+    */
+   struct _glapi_table *MarshalExec;
    /*@}*/
 
+   /** Threaded dispatch state, NULL unless glthread is enabled */
+   struct glthread_state *GLThread;
+
    struct gl_config Visual;
    struct gl_framebuffer *DrawBuffer;	/**< buffer for writing */
    struct gl_framebuffer *ReadBuffer;	/**< buffer for reading */
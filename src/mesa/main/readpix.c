@@ -30,6 +30,7 @@
 #include "readpix.h"
 #include "framebuffer.h"
 #include "formats.h"
+#include "format_row.h"
 #include "format_unpack.h"
 #include "image.h"
 #include "mtypes.h"
@@ -211,6 +212,60 @@ read_stencil_pixels( struct gl_context *ctx,
 }
 
 
+/**
+ * Set up a row converter from an 8-bit renderbuffer to 8-bit client pixels.
+ * The result matches what slow_read_rgba_pixels() would produce: sRGB
+ * values are read as-is and components outside the renderbuffer's base
+ * format read as 0 (alpha: 1).  Luminance destinations aren't handled.
+ * \return GL_FALSE if the format/type combination isn't supported
+ */
+static GLboolean
+get_read_row_conv(const struct gl_renderbuffer *rb, GLenum format,
+                  GLenum type, GLboolean swapBytes,
+                  struct mesa_row_conv *conv)
+{
+   const gl_format rbFormat = _mesa_get_srgb_format_linear(rb->Format);
+   GLuint srcComps, dstComps, j;
+   GLubyte rgba[4], chans[4], map[4];
+   GLbitfield srgbMask;
+
+   if (!_mesa_get_format_row_map(rbFormat, &srcComps, rgba, &srgbMask) ||
+       !_mesa_get_ubyte_pixel_layout(format, type, swapBytes,
+                                     &dstComps, chans))
+      return GL_FALSE;
+
+   switch (rb->_BaseFormat) {
+   case GL_ALPHA:
+      rgba[RCOMP] = rgba[GCOMP] = rgba[BCOMP] = ROW_CONV_ZERO;
+      break;
+   case GL_INTENSITY:
+   case GL_LUMINANCE:
+   case GL_RED:
+      rgba[GCOMP] = rgba[BCOMP] = ROW_CONV_ZERO;
+      rgba[ACOMP] = ROW_CONV_ONE;
+      break;
+   case GL_LUMINANCE_ALPHA:
+      rgba[GCOMP] = rgba[BCOMP] = ROW_CONV_ZERO;
+      break;
+   case GL_RG:
+      rgba[BCOMP] = ROW_CONV_ZERO;
+      rgba[ACOMP] = ROW_CONV_ONE;
+      break;
+   case GL_RGB:
+      rgba[ACOMP] = ROW_CONV_ONE;
+      break;
+   default:
+      ;
+   }
+
+   for (j = 0; j < dstComps; j++)
+      map[j] = rgba[chans[j]];
+
+   _mesa_init_row_conv(conv, srcComps, dstComps, map, 0x0);
+   return GL_TRUE;
+}
+
+
 /**
  * Try to do glReadPixels of RGBA data using a simple memcpy or swizzle.
  * \return GL_TRUE if successful, GL_FALSE otherwise (use the slow path)
@@ -227,24 +282,15 @@ fast_read_rgba_pixels_memcpy( struct gl_context *ctx,
    struct gl_renderbuffer *rb = ctx->ReadBuffer->_ColorReadBuffer;
    GLubyte *dst, *map;
    int dstStride, stride, j, texelBytes;
-   GLboolean swizzle_rb = GL_FALSE, copy_xrgb = GL_FALSE;
-
-   /* XXX we could check for other swizzle/special cases here as needed */
-   if (rb->Format == MESA_FORMAT_RGBA8888_REV &&
-       format == GL_BGRA &&
-       type == GL_UNSIGNED_INT_8_8_8_8_REV &&
-       !ctx->Pack.SwapBytes) {
-      swizzle_rb = GL_TRUE;
-   }
-   else if (rb->Format == MESA_FORMAT_XRGB8888 &&
-       format == GL_BGRA &&
-       type == GL_UNSIGNED_INT_8_8_8_8_REV &&
-       !ctx->Pack.SwapBytes) {
-      copy_xrgb = GL_TRUE;
-   }
-   else if (!_mesa_format_matches_format_and_type(rb->Format, format, type,
-                                                  ctx->Pack.SwapBytes))
-      return GL_FALSE;
+   struct mesa_row_conv conv;
+   GLboolean convert = GL_FALSE;
+
+   if (!_mesa_format_matches_format_and_type(rb->Format, format, type,
+                                             ctx->Pack.SwapBytes)) {
+      if (!get_read_row_conv(rb, format, type, ctx->Pack.SwapBytes, &conv))
+         return GL_FALSE;
+      convert = GL_TRUE;
+   }
 
    /* If the format is unsigned normalized then we can ignore clamping
     * because the values are already in the range [0,1] so it won't
@@ -269,28 +315,9 @@ fast_read_rgba_pixels_memcpy( struct gl_context *ctx,
 
    texelBytes = _mesa_get_format_bytes(rb->Format);
 
-   if (swizzle_rb) {
-      /* swap R/B */
+   if (convert) {
       for (j = 0; j < height; j++) {
-         int i;
-         for (i = 0; i < width; i++) {
-            GLuint *dst4 = (GLuint *) dst, *map4 = (GLuint *) map;
-            GLuint pixel = map4[i];
-            dst4[i] = (pixel & 0xff00ff00)
-                   | ((pixel & 0x00ff0000) >> 16)
-                   | ((pixel & 0x000000ff) << 16);
-         }
-         dst += dstStride;
-         map += stride;
-      }
-   } else if (copy_xrgb) {
-      /* convert xrgb -> argb */
-      for (j = 0; j < height; j++) {
-         GLuint *dst4 = (GLuint *) dst, *map4 = (GLuint *) map;
-         int i;
-         for (i = 0; i < width; i++) {
-            dst4[i] = map4[i] | 0xff000000;  /* set A=0xff */
-         }
+         _mesa_row_conv_ubyte(&conv, width, map, dst);
          dst += dstStride;
          map += stride;
       }
@@ -45,6 +45,7 @@
 #include "main/mtypes.h"
 #include "main/shaderapi.h"
 #include "main/shaderobj.h"
+#include "main/shaderqueue.h"
 #include "main/transformfeedback.h"
 #include "main/uniforms.h"
 #include "program/program.h"
@@ -115,6 +116,11 @@ _mesa_init_shader_state(struct gl_context *ctx)
       memcpy(&ctx->ShaderCompilerOptions[sh], &options, sizeof(options));
 
    ctx->Shader.Flags = get_shader_flags();
+
+   /* GL_ARB_parallel_shader_compile: use as many threads as the driver
+    * allows.
+    */
+   ctx->Shader.MaxCompilerThreads = 0xffffffff;
 }
 
 
@@ -488,6 +494,15 @@ get_programiv(struct gl_context *ctx, GLuint program, GLenum pname, GLint *param
       return;
    }
 
+   /* Polling for the link mustn't wait for it. */
+   if (pname == GL_COMPLETION_STATUS_ARB &&
+       ctx->Extensions.ARB_parallel_shader_compile) {
+      *params = !_mesa_shader_program_is_pending(ctx, shProg);
+      return;
+   }
+
+   _mesa_wait_shader_program(ctx, shProg);
+
    switch (pname) {
    case GL_DELETE_STATUS:
       *params = shProg->DeletePending;
@@ -634,6 +649,15 @@ get_shaderiv(struct gl_context *ctx, GLuint name, GLenum pname, GLint *params)
       return;
    }
 
+   /* Polling for the compile mustn't wait for it. */
+   if (pname == GL_COMPLETION_STATUS_ARB &&
+       ctx->Extensions.ARB_parallel_shader_compile) {
+      *params = !_mesa_shader_is_pending(ctx, shader);
+      return;
+   }
+
+   _mesa_wait_shader(ctx, shader);
+
    switch (pname) {
    case GL_SHADER_TYPE:
       *params = shader->Type;
@@ -667,6 +691,7 @@ get_program_info_log(struct gl_context *ctx, GLuint program, GLsizei bufSize,
       _mesa_error(ctx, GL_INVALID_VALUE, "glGetProgramInfoLog(program)");
       return;
    }
+   _mesa_wait_shader_program(ctx, shProg);
    _mesa_copy_string(infoLog, bufSize, length, shProg->InfoLog);
 }
 
@@ -680,6 +705,7 @@ get_shader_info_log(struct gl_context *ctx, GLuint shader, GLsizei bufSize,
       _mesa_error(ctx, GL_INVALID_VALUE, "glGetShaderInfoLog(shader)");
       return;
    }
+   _mesa_wait_shader(ctx, sh);
    _mesa_copy_string(infoLog, bufSize, length, sh->InfoLog);
 }
 
@@ -713,6 +739,8 @@ shader_source(struct gl_context *ctx, GLuint shader, const GLchar *source)
    if (!sh)
       return;
 
+   _mesa_wait_shader_idle(ctx, sh);
+
    /* free old shader source string and install new one */
    free((void *)sh->Source);
    sh->Source = source;
@@ -736,21 +764,15 @@ compile_shader(struct gl_context *ctx, GLuint shaderObj)
    if (!sh)
       return;
 
+   /* A previous compile, or a link still reading the old IR. */
+   _mesa_wait_shader_idle(ctx, sh);
+
    options = &ctx->ShaderCompilerOptions[_mesa_shader_type_to_index(sh->Type)];
 
    /* set default pragma state for shader */
    sh->Pragmas = options->DefaultPragmas;
 
-   /* this call will set the sh->CompileStatus field to indicate if
-    * compilation was successful.
-    */
-   _mesa_glsl_compile_shader(ctx, sh);
-
-   if (sh->CompileStatus == GL_FALSE && 
-       (ctx->Shader.Flags & GLSL_REPORT_ERRORS)) {
-      _mesa_debug(ctx, "Error compiling shader %u:\n%s\n",
-                  sh->Name, sh->InfoLog);
-   }
+   _mesa_queue_compile_shader(ctx, sh);
 }
 
 
@@ -779,28 +801,7 @@ link_program(struct gl_context *ctx, GLuint program)
 
    FLUSH_VERTICES(ctx, _NEW_PROGRAM);
 
-   _mesa_glsl_link_shader(ctx, shProg);
-
-   if (shProg->LinkStatus == GL_FALSE && 
-       (ctx->Shader.Flags & GLSL_REPORT_ERRORS)) {
-      _mesa_debug(ctx, "Error linking program %u:\n%s\n",
-                  shProg->Name, shProg->InfoLog);
-   }
-
-   /* debug code */
-   if (0) {
-      GLuint i;
-
-      printf("Link %u shaders in program %u: %s\n",
-                   shProg->NumShaders, shProg->Name,
-                   shProg->LinkStatus ? "Success" : "Failed");
-
-      for (i = 0; i < shProg->NumShaders; i++) {
-         printf(" shader %u, type 0x%x\n",
-                      shProg->Shaders[i]->Name,
-                      shProg->Shaders[i]->Type);
-      }
-   }
+   _mesa_queue_link_program(ctx, shProg);
 }
 
 
@@ -1803,3 +1804,23 @@ _mesa_CreateShaderProgramEXT(GLenum type, const GLchar *string)
 
    return program;
 }
+
+
+/**
+ * For GL_ARB_parallel_shader_compile
+ */
+void GLAPIENTRY
+_mesa_MaxShaderCompilerThreadsARB(GLuint count)
+{
+   GET_CURRENT_CONTEXT(ctx);
+
+   if (!ctx->Extensions.ARB_parallel_shader_compile) {
+      _mesa_error(ctx, GL_INVALID_OPERATION, "glMaxShaderCompilerThreadsARB");
+      return;
+   }
+
+   /* Zero makes compiles and links synchronous; jobs that are already
+    * queued keep running on the worker threads.
+    */
+   ctx->Shader.MaxCompilerThreads = count;
+}
@@ -0,0 +1,585 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file shaderqueue.c
+ * Compiling and linking GLSL shaders on worker threads.
+ *
+ * glCompileShader and glLinkProgram hand the work to the share group's
+ * shader queue and return.  A small pool of worker threads, started on
+ * first use, runs the jobs with the context that queued them passed in but
+ * not bound.  While a job is queued or running its object is marked
+ * pending, and every entry point that reads or replaces the results waits
+ * for it first (see _mesa_wait_shader() and _mesa_wait_shader_program()).
+ * The GL_COMPLETION_STATUS_ARB queries only look at the pending flags.
+ *
+ * Jobs start in the order they were queued.  A link waits for the compiles
+ * of its attached shaders, which were queued before it and have therefore
+ * already started, and a shader is not recompiled while a queued link
+ * still uses it.
+ *
+ * A program that is current in the linking context is linked
+ * synchronously, as the next draw would have to wait for it anyway.
+ */
+
+#include "main/glheader.h"
+#include "main/context.h"
+#include "main/imports.h"
+#include "main/macros.h"
+#include "main/mtypes.h"
+#include "main/shaderobj.h"
+#include "main/shaderqueue.h"
+#include "program/ir_to_mesa.h"
+#include <stdbool.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+
+struct shader_job
+{
+   /** Next job in the queue */
+   struct shader_job *next;
+
+   struct gl_context *ctx;
+
+   /** The shader to compile, or NULL for a link */
+   struct gl_shader *shader;
+
+   /** The program to link, or NULL for a compile */
+   struct gl_shader_program *program;
+
+   /**
+    * The queuing context's GL_MAX_SHADER_COMPILER_THREADS_ARB.  The job
+    * doesn't start while this many jobs are running.
+    */
+   GLuint max_threads;
+};
+
+
+/**
+ * Worker threads and jobs of a share group.
+ *
+ * Everything here, and the pending flags of the shaders and programs that
+ * have jobs, is protected by \c mutex.
+ */
+struct gl_shader_queue
+{
+#ifdef HAVE_PTHREAD
+   pthread_mutex_t mutex;
+
+   /** Signalled when a job is queued or the threads must exit */
+   pthread_cond_t new_job;
+
+   /** Signalled when a job has finished */
+   pthread_cond_t job_done;
+
+   pthread_t threads[MAX_SHADER_COMPILER_THREADS];
+#endif
+   unsigned num_threads;
+
+   /** Jobs waiting for a thread, oldest first */
+   struct shader_job *jobs;
+   struct shader_job **jobs_tail;
+
+   /** Number of jobs queued or running */
+   unsigned num_pending;
+
+   /** Number of jobs running */
+   unsigned num_running;
+
+   /** Tells the threads to exit once the queue is empty */
+   bool shutdown;
+};
+
+
+static void
+compile_shader(struct gl_context *ctx, struct gl_shader *sh)
+{
+   /* this call will set the sh->CompileStatus field to indicate if
+    * compilation was successful.
+    */
+   _mesa_glsl_compile_shader(ctx, sh);
+
+   if (sh->CompileStatus == GL_FALSE &&
+       (ctx->Shader.Flags & GLSL_REPORT_ERRORS)) {
+      _mesa_debug(ctx, "Error compiling shader %u:\n%s\n",
+                  sh->Name, sh->InfoLog);
+   }
+}
+
+
+static void
+link_program(struct gl_context *ctx, struct gl_shader_program *shProg)
+{
+   _mesa_glsl_link_shader(ctx, shProg);
+
+   if (shProg->LinkStatus == GL_FALSE &&
+       (ctx->Shader.Flags & GLSL_REPORT_ERRORS)) {
+      _mesa_debug(ctx, "Error linking program %u:\n%s\n",
+                  shProg->Name, shProg->InfoLog);
+   }
+
+   /* debug code */
+   if (0) {
+      GLuint i;
+
+      printf("Link %u shaders in program %u: %s\n",
+                   shProg->NumShaders, shProg->Name,
+                   shProg->LinkStatus ? "Success" : "Failed");
+
+      for (i = 0; i < shProg->NumShaders; i++) {
+         printf(" shader %u, type 0x%x\n",
+                      shProg->Shaders[i]->Name,
+                      shProg->Shaders[i]->Type);
+      }
+   }
+}
+
+
+#ifdef HAVE_PTHREAD
+
+/**
+ * Mark the job's objects as no longer pending.  Called with the mutex held.
+ */
+static void
+finish_job(struct shader_job *job)
+{
+   if (job->shader) {
+      job->shader->CompilePending = GL_FALSE;
+   }
+   else {
+      struct gl_shader_program *shProg = job->program;
+      GLuint i;
+
+      shProg->LinkPending = GL_FALSE;
+      for (i = 0; i < shProg->NumShaders; i++)
+         shProg->Shaders[i]->PendingLinks--;
+   }
+}
+
+
+static void
+run_job(struct gl_shader_queue *queue, struct shader_job *job)
+{
+   if (job->shader) {
+      compile_shader(job->ctx, job->shader);
+   }
+   else {
+      struct gl_shader_program *shProg = job->program;
+      GLuint i;
+
+      pthread_mutex_lock(&queue->mutex);
+      for (i = 0; i < shProg->NumShaders; i++) {
+         while (shProg->Shaders[i]->CompilePending)
+            pthread_cond_wait(&queue->job_done, &queue->mutex);
+      }
+      pthread_mutex_unlock(&queue->mutex);
+
+      link_program(job->ctx, shProg);
+   }
+}
+
+
+static void *
+shader_queue_worker(void *data)
+{
+   struct gl_shader_queue *queue = data;
+
+   pthread_mutex_lock(&queue->mutex);
+
+   for (;;) {
+      struct shader_job *job = queue->jobs;
+
+      if (!job) {
+         if (queue->shutdown)
+            break;
+         pthread_cond_wait(&queue->new_job, &queue->mutex);
+         continue;
+      }
+
+      /* The thread limit is counted over the whole share group.  A thread
+       * that finishes a job comes back here, so nobody has to be woken when
+       * the limit stops applying.
+       */
+      if (queue->num_running >= job->max_threads) {
+         pthread_cond_wait(&queue->new_job, &queue->mutex);
+         continue;
+      }
+
+      queue->jobs = job->next;
+      if (!queue->jobs)
+         queue->jobs_tail = &queue->jobs;
+      queue->num_running++;
+      pthread_mutex_unlock(&queue->mutex);
+
+      run_job(queue, job);
+
+      pthread_mutex_lock(&queue->mutex);
+      finish_job(job);
+      queue->num_running--;
+      queue->num_pending--;
+      pthread_cond_broadcast(&queue->job_done);
+      free(job);
+   }
+
+   pthread_mutex_unlock(&queue->mutex);
+
+   return NULL;
+}
+
+
+/**
+ * Whether jobs from \p ctx should go to worker threads at all.
+ */
+static bool
+use_threads(const struct gl_context *ctx)
+{
+   return ctx->Shared->ShaderQueue &&
+          ctx->Const.MaxShaderCompilerThreads > 0 &&
+          ctx->Shader.MaxCompilerThreads > 0;
+}
+
+
+/**
+ * Start as many threads as \p ctx may use, if they aren't running yet.
+ * Called with the mutex held.
+ *
+ * \return whether there is at least one thread to run jobs
+ */
+static bool
+start_threads(struct gl_context *ctx, struct gl_shader_queue *queue)
+{
+   unsigned count = MIN3(ctx->Const.MaxShaderCompilerThreads,
+                         ctx->Shader.MaxCompilerThreads,
+                         MAX_SHADER_COMPILER_THREADS);
+
+   while (queue->num_threads < count) {
+      if (pthread_create(&queue->threads[queue->num_threads], NULL,
+                         shader_queue_worker, queue) != 0)
+         break;
+      queue->num_threads++;
+   }
+
+   return queue->num_threads > 0;
+}
+
+
+/**
+ * Append \p job to the queue.  Called with the mutex held.
+ */
+static void
+add_job(struct gl_shader_queue *queue, struct shader_job *job)
+{
+   job->max_threads = job->ctx->Shader.MaxCompilerThreads;
+   job->next = NULL;
+   *queue->jobs_tail = job;
+   queue->jobs_tail = &job->next;
+   queue->num_pending++;
+   pthread_cond_signal(&queue->new_job);
+}
+
+
+/**
+ * Free what the program's previous link left behind, which the link would
+ * otherwise do on the worker thread.  Releasing the linked shaders may
+ * delete their gl_programs, and drivers free those with the help of their
+ * rendering context.
+ */
+static void
+clear_link_results(struct gl_context *ctx, struct gl_shader_program *shProg)
+{
+   gl_shader_type i;
+
+   _mesa_clear_shader_program_data(ctx, shProg);
+
+   for (i = 0; i < MESA_SHADER_TYPES; i++) {
+      if (shProg->_LinkedShaders[i] != NULL) {
+         ctx->Driver.DeleteShader(ctx, shProg->_LinkedShaders[i]);
+         shProg->_LinkedShaders[i] = NULL;
+      }
+   }
+}
+
+#endif /* HAVE_PTHREAD */
+
+
+/**
+ * Allocate the shader queue of a new share group.  No threads are started
+ * until a job is queued.
+ */
+struct gl_shader_queue *
+_mesa_shader_queue_create(void)
+{
+   struct gl_shader_queue *queue = CALLOC_STRUCT(gl_shader_queue);
+
+   if (!queue)
+      return NULL;
+
+   queue->jobs_tail = &queue->jobs;
+
+#ifdef HAVE_PTHREAD
+   pthread_mutex_init(&queue->mutex, NULL);
+   pthread_cond_init(&queue->new_job, NULL);
+   pthread_cond_init(&queue->job_done, NULL);
+#endif
+
+   return queue;
+}
+
+
+/**
+ * Run the remaining jobs, stop the threads and free the queue.
+ */
+void
+_mesa_shader_queue_destroy(struct gl_shader_queue *queue)
+{
+#ifdef HAVE_PTHREAD
+   unsigned i;
+
+   if (!queue)
+      return;
+
+   pthread_mutex_lock(&queue->mutex);
+   queue->shutdown = true;
+   pthread_cond_broadcast(&queue->new_job);
+   pthread_mutex_unlock(&queue->mutex);
+
+   for (i = 0; i < queue->num_threads; i++)
+      pthread_join(queue->threads[i], NULL);
+
+   pthread_cond_destroy(&queue->job_done);
+   pthread_cond_destroy(&queue->new_job);
+   pthread_mutex_destroy(&queue->mutex);
+#endif
+
+   free(queue);
+}
+
+
+/**
+ * Wait until every job of the share group has finished.  Called before a
+ * context's state is torn down, since its jobs use it.
+ */
+void
+_mesa_shader_queue_finish(struct gl_context *ctx)
+{
+#ifdef HAVE_PTHREAD
+   struct gl_shader_queue *queue = ctx->Shared->ShaderQueue;
+
+   if (!queue)
+      return;
+
+   pthread_mutex_lock(&queue->mutex);
+   while (queue->num_pending)
+      pthread_cond_wait(&queue->job_done, &queue->mutex);
+   pthread_mutex_unlock(&queue->mutex);
+#endif
+}
+
+
+/**
+ * Compile \p sh, on a worker thread if possible.
+ *
+ * The caller must have waited for \p sh with _mesa_wait_shader_idle().
+ */
+void
+_mesa_queue_compile_shader(struct gl_context *ctx, struct gl_shader *sh)
+{
+#ifdef HAVE_PTHREAD
+   struct gl_shader_queue *queue = ctx->Shared->ShaderQueue;
+   struct shader_job *job;
+
+   if (use_threads(ctx) && (job = CALLOC_STRUCT(shader_job))) {
+      job->ctx = ctx;
+      job->shader = sh;
+
+      pthread_mutex_lock(&queue->mutex);
+      assert(!sh->CompilePending && sh->PendingLinks == 0);
+      if (start_threads(ctx, queue)) {
+         sh->CompilePending = GL_TRUE;
+         add_job(queue, job);
+         pthread_mutex_unlock(&queue->mutex);
+         return;
+      }
+      pthread_mutex_unlock(&queue->mutex);
+      free(job);
+   }
+#endif
+
+   compile_shader(ctx, sh);
+}
+
+
+/**
+ * Link \p shProg, on a worker thread if possible.
+ *
+ * The caller must have waited for \p shProg with
+ * _mesa_wait_shader_program().  The attached shaders may still be
+ * compiling.
+ */
+void
+_mesa_queue_link_program(struct gl_context *ctx,
+                         struct gl_shader_program *shProg)
+{
+#ifdef HAVE_PTHREAD
+   struct gl_shader_queue *queue = ctx->Shared->ShaderQueue;
+   struct shader_job *job;
+
+   if (use_threads(ctx) &&
+       shProg != ctx->Shader.CurrentVertexProgram &&
+       shProg != ctx->Shader.CurrentGeometryProgram &&
+       shProg != ctx->Shader.CurrentFragmentProgram &&
+       shProg != ctx->Shader.ActiveProgram &&
+       (job = CALLOC_STRUCT(shader_job))) {
+      GLuint i;
+
+      job->ctx = ctx;
+      job->program = shProg;
+
+      clear_link_results(ctx, shProg);
+
+      pthread_mutex_lock(&queue->mutex);
+      assert(!shProg->LinkPending);
+      if (start_threads(ctx, queue)) {
+         shProg->LinkPending = GL_TRUE;
+         for (i = 0; i < shProg->NumShaders; i++)
+            shProg->Shaders[i]->PendingLinks++;
+         add_job(queue, job);
+         pthread_mutex_unlock(&queue->mutex);
+         return;
+      }
+      pthread_mutex_unlock(&queue->mutex);
+      free(job);
+   }
+#endif
+
+   link_program(ctx, shProg);
+}
+
+
+/**
+ * Wait until \p sh has been compiled, so that its results can be read.
+ */
+void
+_mesa_wait_shader(struct gl_context *ctx, const struct gl_shader *sh)
+{
+#ifdef HAVE_PTHREAD
+   struct gl_shader_queue *queue = ctx->Shared->ShaderQueue;
+
+   if (!queue)
+      return;
+
+   pthread_mutex_lock(&queue->mutex);
+   while (sh->CompilePending)
+      pthread_cond_wait(&queue->job_done, &queue->mutex);
+   pthread_mutex_unlock(&queue->mutex);
+#endif
+}
+
+
+/**
+ * Wait until \p sh has been compiled and no queued link uses it anymore,
+ * so that it can be changed or freed.
+ */
+void
+_mesa_wait_shader_idle(struct gl_context *ctx, const struct gl_shader *sh)
+{
+#ifdef HAVE_PTHREAD
+   struct gl_shader_queue *queue = ctx->Shared->ShaderQueue;
+
+   if (!queue)
+      return;
+
+   pthread_mutex_lock(&queue->mutex);
+   while (sh->CompilePending || sh->PendingLinks)
+      pthread_cond_wait(&queue->job_done, &queue->mutex);
+   pthread_mutex_unlock(&queue->mutex);
+#endif
+}
+
+
+/**
+ * Wait until \p shProg has been linked, so that it can be read or changed.
+ */
+void
+_mesa_wait_shader_program(struct gl_context *ctx,
+                          const struct gl_shader_program *shProg)
+{
+#ifdef HAVE_PTHREAD
+   struct gl_shader_queue *queue = ctx->Shared->ShaderQueue;
+
+   if (!queue)
+      return;
+
+   pthread_mutex_lock(&queue->mutex);
+   while (shProg->LinkPending)
+      pthread_cond_wait(&queue->job_done, &queue->mutex);
+   pthread_mutex_unlock(&queue->mutex);
+#endif
+}
+
+
+/**
+ * Whether the compile of \p sh hasn't finished yet, for
+ * GL_COMPLETION_STATUS_ARB.
+ */
+GLboolean
+_mesa_shader_is_pending(struct gl_context *ctx, const struct gl_shader *sh)
+{
+   GLboolean pending = GL_FALSE;
+#ifdef HAVE_PTHREAD
+   struct gl_shader_queue *queue = ctx->Shared->ShaderQueue;
+
+   if (!queue)
+      return GL_FALSE;
+
+   pthread_mutex_lock(&queue->mutex);
+   pending = sh->CompilePending;
+   pthread_mutex_unlock(&queue->mutex);
+#endif
+   return pending;
+}
+
+
+/**
+ * Whether the link of \p shProg, including the compiles it waits for,
+ * hasn't finished yet, for GL_COMPLETION_STATUS_ARB.
+ */
+GLboolean
+_mesa_shader_program_is_pending(struct gl_context *ctx,
+                                const struct gl_shader_program *shProg)
+{
+   GLboolean pending = GL_FALSE;
+#ifdef HAVE_PTHREAD
+   struct gl_shader_queue *queue = ctx->Shared->ShaderQueue;
+
+   if (!queue)
+      return GL_FALSE;
+
+   pthread_mutex_lock(&queue->mutex);
+   pending = shProg->LinkPending;
+   pthread_mutex_unlock(&queue->mutex);
+#endif
+   return pending;
+}
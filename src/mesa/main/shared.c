@@ -40,6 +40,7 @@
 #include "samplerobj.h"
 #include "set.h"
 #include "shaderobj.h"
+#include "shaderqueue.h"
 #include "syncobj.h"
 
 
@@ -79,6 +80,7 @@ _mesa_alloc_shared_state(struct gl_context *ctx)
    shared->DefaultFragmentShader = _mesa_new_ati_fragment_shader(ctx, 0);
 
    shared->ShaderObjects = _mesa_NewHashTable();
+   shared->ShaderQueue = _mesa_shader_queue_create();
 
    shared->BufferObjects = _mesa_NewHashTable();
 
@@ -294,6 +296,10 @@ free_shared_state(struct gl_context *ctx, struct gl_shared_state *shared)
 {
    GLuint i;
 
+   /* Every context has finished its shader jobs by now. */
+   _mesa_shader_queue_destroy(shared->ShaderQueue);
+   shared->ShaderQueue = NULL;
+
    /* Free the dummy/fallback texture objects */
    for (i = 0; i < NUM_TEXTURE_TARGETS; i++) {
       if (shared->FallbackTex[i])
@@ -0,0 +1,547 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Checks the 8-bit row converters of format_row.c against a byte at a time
+ * reference, and the format and client pixel layouts they are built from
+ * against the texel packing code and the GL spec.
+ *
+ * With -b, measures the bandwidth of the conversion paths that use them
+ * instead: texture uploads through _mesa_texstore(), the
+ * _mesa_unpack_*_row() functions and glReadPixels through
+ * _mesa_readpixels().  The numbers are megabytes of source pixels converted
+ * per second over a 1024x1024 image.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "main/mtypes.h"
+#include "main/enums.h"
+#include "main/formats.h"
+#include "main/format_pack.h"
+#include "main/format_row.h"
+#include "main/format_unpack.h"
+#include "main/glformats.h"
+#include "main/macros.h"
+#include "main/readpix.h"
+#include "main/texstore.h"
+
+#define WIDTH 1024
+#define HEIGHT 1024
+#define ROUNDS 5
+#define ROUND_NS 50000000LL
+
+#define CHECK_PIXELS 37
+
+static int failures;
+
+static void
+fail(const char *what, GLuint srcComps, GLuint dstComps, const GLubyte map[4])
+{
+   if (failures++ < 10)
+      fprintf(stderr, "%s: %u to %u components, map %u %u %u %u\n", what,
+              srcComps, dstComps, map[0], map[1], map[2], map[3]);
+}
+
+/**
+ * Run one map through both conversions and compare with the reference.
+ */
+static void
+check_map(GLuint srcComps, GLuint dstComps, const GLubyte map[4],
+          GLbitfield srgbMask, const GLubyte *src)
+{
+   struct mesa_row_conv conv;
+   GLubyte dst[CHECK_PIXELS * 4 + 4];
+   GLfloat rgba[CHECK_PIXELS][4];
+   GLuint i, j;
+
+   _mesa_init_row_conv(&conv, srcComps, dstComps, map, srgbMask);
+
+   memset(dst, 0xcd, sizeof(dst));
+   _mesa_row_conv_ubyte(&conv, CHECK_PIXELS, src, dst);
+   for (i = 0; i < CHECK_PIXELS; i++) {
+      for (j = 0; j < dstComps; j++) {
+         const GLubyte *s = src + i * srcComps;
+         const GLubyte expected = map[j] == ROW_CONV_ZERO ? 0x0 :
+                                  map[j] == ROW_CONV_ONE ? 0xff : s[map[j]];
+         if (dst[i * dstComps + j] != expected) {
+            fail("ubyte mismatch", srcComps, dstComps, map);
+            return;
+         }
+      }
+   }
+   for (i = CHECK_PIXELS * dstComps; i < sizeof(dst); i++) {
+      if (dst[i] != 0xcd) {
+         fail("ubyte overrun", srcComps, dstComps, map);
+         return;
+      }
+   }
+
+   if (dstComps != 4)
+      return;
+
+   _mesa_row_conv_float(&conv, CHECK_PIXELS, src, rgba);
+   for (i = 0; i < CHECK_PIXELS; i++) {
+      for (j = 0; j < 4; j++) {
+         const GLubyte b = src[i * srcComps + (map[j] & 3)];
+         const GLfloat expected =
+            map[j] == ROW_CONV_ZERO ? 0.0F :
+            map[j] == ROW_CONV_ONE ? 1.0F :
+            (srgbMask & (1 << j)) ? _mesa_nonlinear_to_linear(b) :
+            (GLfloat) b / 255.0F;
+         if (rgba[i][j] != expected) {
+            fail("float mismatch", srcComps, dstComps, map);
+            return;
+         }
+      }
+   }
+}
+
+/**
+ * Every map of every pixel size, which covers each kernel in the table as
+ * well as the generic fallback.
+ */
+static void
+check_maps(void)
+{
+   GLubyte src[CHECK_PIXELS * 4];
+   GLuint srcComps, dstComps, i, j;
+
+   for (i = 0; i < sizeof(src); i++)
+      src[i] = (GLubyte) (i * 73 + 11);
+
+   for (srcComps = 1; srcComps <= 4; srcComps++) {
+      const GLuint choices = srcComps + 2;
+      for (dstComps = 1; dstComps <= 4; dstComps++) {
+         GLuint count = 1;
+
+         for (j = 0; j < dstComps; j++)
+            count *= choices;
+
+         for (i = 0; i < count; i++) {
+            GLubyte map[4] = { ROW_CONV_ZERO, ROW_CONV_ZERO,
+                               ROW_CONV_ZERO, ROW_CONV_ZERO };
+            GLuint k = i;
+
+            for (j = 0; j < dstComps; j++, k /= choices) {
+               map[j] = k % choices;
+               if (map[j] >= srcComps)
+                  map[j] = ROW_CONV_ZERO + map[j] - srcComps;
+            }
+
+            check_map(srcComps, dstComps, map, 0x0, src);
+            if (dstComps == 4)
+               check_map(srcComps, dstComps, map, 0x7, src);
+         }
+      }
+   }
+}
+
+/**
+ * Texels packed by format_pack.c must have each component in the byte the
+ * map names.  The sRGB formats must look like their linear counterparts.
+ */
+static void
+check_format_maps(void)
+{
+   static const GLubyte rgba[1][4] = { { 0x11, 0x22, 0x33, 0x44 } };
+   gl_format f;
+
+   for (f = MESA_FORMAT_NONE + 1; f < MESA_FORMAT_COUNT; f++) {
+      GLuint comps, linearComps, c;
+      GLubyte map[4], linearMap[4], texel[4];
+      GLbitfield srgbMask, linearSrgbMask;
+      const gl_format linear = _mesa_get_srgb_format_linear(f);
+
+      if (!_mesa_get_format_row_map(f, &comps, map, &srgbMask))
+         continue;
+
+      if (comps != _mesa_get_format_bytes(f))
+         fail(_mesa_get_format_name(f), comps, 4, map);
+
+      if (linear != f) {
+         if (srgbMask != 0x7)
+            fail(_mesa_get_format_name(f), comps, 4, map);
+         if (_mesa_get_format_row_map(linear, &linearComps, linearMap,
+                                      &linearSrgbMask) &&
+             (linearComps != comps || memcmp(linearMap, map, 4) != 0))
+            fail(_mesa_get_format_name(f), comps, 4, map);
+         continue;
+      }
+
+      if (srgbMask != 0x0)
+         fail(_mesa_get_format_name(f), comps, 4, map);
+
+      memset(texel, 0, sizeof(texel));
+      _mesa_pack_ubyte_rgba_row(f, 1, rgba, texel);
+      for (c = 0; c < 4; c++) {
+         /* Luminance and intensity formats store R for the later ones */
+         if (map[c] < comps && memchr(map, map[c], c) == NULL &&
+             texel[map[c]] != rgba[0][c])
+            fail(_mesa_get_format_name(f), comps, 4, map);
+      }
+   }
+}
+
+/**
+ * Client pixels laid out the way the GL spec describes them must have each
+ * component in the byte _mesa_get_ubyte_pixel_layout() names.
+ */
+static void
+check_pixel_layouts(void)
+{
+   static const struct {
+      GLenum format;
+      GLuint comps;
+      GLubyte order[4];
+   } formats[] = {
+      { GL_RGBA, 4, { RCOMP, GCOMP, BCOMP, ACOMP } },
+      { GL_BGRA, 4, { BCOMP, GCOMP, RCOMP, ACOMP } },
+      { GL_ABGR_EXT, 4, { ACOMP, BCOMP, GCOMP, RCOMP } },
+      { GL_RGB, 3, { RCOMP, GCOMP, BCOMP } },
+      { GL_BGR, 3, { BCOMP, GCOMP, RCOMP } },
+      { GL_RG, 2, { RCOMP, GCOMP } },
+      { GL_RED, 1, { RCOMP } },
+      { GL_GREEN, 1, { GCOMP } },
+      { GL_BLUE, 1, { BCOMP } },
+      { GL_ALPHA, 1, { ACOMP } },
+   };
+   static const GLenum types[] = {
+      GL_UNSIGNED_BYTE,
+      GL_UNSIGNED_INT_8_8_8_8,
+      GL_UNSIGNED_INT_8_8_8_8_REV,
+   };
+   static const GLubyte value[4] = { 0x11, 0x22, 0x33, 0x44 };
+   GLuint i, t, swap, j;
+
+   for (i = 0; i < Elements(formats); i++) {
+      for (t = 0; t < Elements(types); t++) {
+         for (swap = 0; swap < 2; swap++) {
+            const GLuint n = formats[i].comps;
+            GLubyte pixel[4], chans[4];
+            GLuint comps;
+            GLboolean ok;
+
+            ok = _mesa_get_ubyte_pixel_layout(formats[i].format, types[t],
+                                              swap, &comps, chans);
+            if (types[t] != GL_UNSIGNED_BYTE && n != 4) {
+               if (ok)
+                  fail(_mesa_lookup_enum_by_nr(formats[i].format), n, n,
+                       chans);
+               continue;
+            }
+            if (!ok || comps != n) {
+               fail(_mesa_lookup_enum_by_nr(formats[i].format), n, n,
+                    formats[i].order);
+               continue;
+            }
+
+            if (types[t] == GL_UNSIGNED_BYTE) {
+               /* Components in order, byte swapping doesn't apply */
+               for (j = 0; j < n; j++)
+                  pixel[j] = value[formats[i].order[j]];
+            }
+            else {
+               /* First component in the most significant byte */
+               GLuint word = 0;
+               for (j = 0; j < 4; j++) {
+                  const GLuint c = types[t] == GL_UNSIGNED_INT_8_8_8_8 ?
+                                   j : 3 - j;
+                  word |= (GLuint) value[formats[i].order[c]] << (24 - 8 * j);
+               }
+               if (swap)
+                  word = (word >> 24) | ((word >> 8) & 0xff00) |
+                         ((word << 8) & 0xff0000) | (word << 24);
+               memcpy(pixel, &word, 4);
+            }
+
+            for (j = 0; j < n; j++) {
+               if (pixel[j] != value[chans[j]]) {
+                  fail(_mesa_lookup_enum_by_nr(types[t]), n, n, chans);
+                  break;
+               }
+            }
+         }
+      }
+   }
+}
+
+
+static GLubyte *src_image;
+static GLubyte *dst_image;
+static GLfloat (*rgba_row)[4];
+
+struct bench_case
+{
+   struct gl_context *ctx;
+   gl_format format;
+   GLenum baseFormat;
+   GLenum srcFormat;
+   GLenum srcType;
+};
+
+typedef void (*bench_func)(const struct bench_case *c);
+
+static long long
+now_ns(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * Run \p func over and over and print the best of a few rounds, which is
+ * steadier than the average on a loaded machine.
+ */
+static void
+run(const char *path, const char *what, bench_func func,
+    const struct bench_case *c, GLuint bytesPerCall)
+{
+   double best = 0.0;
+   GLuint round;
+
+   for (round = 0; round < ROUNDS; round++) {
+      long long start = now_ns(), ns, bytes = 0;
+      do {
+         func(c);
+         bytes += bytesPerCall;
+         ns = now_ns() - start;
+      } while (ns < ROUND_NS);
+      best = MAX2(best, (double) bytes * 1000.0 / (double) ns);
+   }
+
+   printf("%-10s %-62s %6.0f MB/s\n", path, what, best);
+}
+
+
+static void
+unpack_float(const struct bench_case *c)
+{
+   const GLuint bpp = _mesa_get_format_bytes(c->format);
+   GLuint row;
+
+   for (row = 0; row < HEIGHT; row++)
+      _mesa_unpack_rgba_row(c->format, WIDTH, src_image + row * WIDTH * bpp,
+                            rgba_row);
+}
+
+static void
+unpack_ubyte(const struct bench_case *c)
+{
+   const GLuint bpp = _mesa_get_format_bytes(c->format);
+   GLuint row;
+
+   for (row = 0; row < HEIGHT; row++)
+      _mesa_unpack_ubyte_rgba_row(c->format, WIDTH,
+                                  src_image + row * WIDTH * bpp,
+                                  (GLubyte (*)[4]) dst_image);
+}
+
+static void
+bench_unpack(gl_format format, GLboolean ubyte)
+{
+   struct bench_case c;
+
+   memset(&c, 0, sizeof(c));
+   c.format = format;
+   run(ubyte ? "unpack-ub" : "unpack-f", _mesa_get_format_name(format),
+       ubyte ? unpack_ubyte : unpack_float, &c,
+       WIDTH * HEIGHT * _mesa_get_format_bytes(format));
+}
+
+
+static void
+texstore(const struct bench_case *c)
+{
+   GLubyte *slices[1] = { dst_image };
+
+   _mesa_texstore(c->ctx, 2, c->baseFormat, c->format,
+                  WIDTH * _mesa_get_format_bytes(c->format), slices,
+                  WIDTH, HEIGHT, 1, c->srcFormat, c->srcType, src_image,
+                  &c->ctx->Unpack);
+}
+
+static void
+bench_texstore(struct gl_context *ctx, gl_format dstFormat,
+               GLenum baseFormat, GLenum srcFormat, GLenum srcType)
+{
+   struct bench_case c;
+   char what[64];
+
+   c.ctx = ctx;
+   c.format = dstFormat;
+   c.baseFormat = baseFormat;
+   c.srcFormat = srcFormat;
+   c.srcType = srcType;
+
+   snprintf(what, sizeof(what), "%s <- %s/%s",
+            _mesa_get_format_name(dstFormat),
+            _mesa_lookup_enum_by_nr(srcFormat),
+            _mesa_lookup_enum_by_nr(srcType));
+   run("texstore", what, texstore, &c,
+       WIDTH * HEIGHT * _mesa_bytes_per_pixel(srcFormat, srcType));
+}
+
+
+static void
+map_renderbuffer(struct gl_context *ctx, struct gl_renderbuffer *rb,
+                 GLuint x, GLuint y, GLuint w, GLuint h, GLbitfield mode,
+                 GLubyte **mapOut, GLint *rowStrideOut)
+{
+   const GLuint bpp = _mesa_get_format_bytes(rb->Format);
+
+   (void) ctx;
+   (void) w;
+   (void) h;
+   (void) mode;
+   *rowStrideOut = WIDTH * bpp;
+   *mapOut = src_image + y * WIDTH * bpp + x * bpp;
+}
+
+static void
+unmap_renderbuffer(struct gl_context *ctx, struct gl_renderbuffer *rb)
+{
+   (void) ctx;
+   (void) rb;
+}
+
+static void
+readpixels(const struct bench_case *c)
+{
+   _mesa_readpixels(c->ctx, 0, 0, WIDTH, HEIGHT, c->srcFormat, c->srcType,
+                    &c->ctx->Pack, dst_image);
+}
+
+static void
+bench_readpixels(struct gl_context *ctx, gl_format rbFormat,
+                 GLenum format, GLenum type)
+{
+   struct gl_renderbuffer *rb = ctx->ReadBuffer->_ColorReadBuffer;
+   struct bench_case c;
+   char what[64];
+
+   rb->Format = rbFormat;
+   rb->_BaseFormat = _mesa_get_format_base_format(rbFormat);
+
+   c.ctx = ctx;
+   c.srcFormat = format;
+   c.srcType = type;
+
+   snprintf(what, sizeof(what), "%s -> %s/%s",
+            _mesa_get_format_name(rbFormat),
+            _mesa_lookup_enum_by_nr(format), _mesa_lookup_enum_by_nr(type));
+   run("readpixels", what, readpixels, &c,
+       WIDTH * HEIGHT * _mesa_get_format_bytes(rbFormat));
+}
+
+
+int
+main(int argc, char **argv)
+{
+   static const gl_format unpack_formats[] = {
+      MESA_FORMAT_RGBA8888,
+      MESA_FORMAT_ARGB8888,
+      MESA_FORMAT_XRGB8888,
+      MESA_FORMAT_RGB888,
+      MESA_FORMAT_AL88,
+      MESA_FORMAT_L8,
+      MESA_FORMAT_SARGB8,
+      MESA_FORMAT_SRGB8,
+   };
+   struct gl_context *ctx;
+   struct gl_framebuffer fb;
+   struct gl_renderbuffer rb;
+   GLuint i;
+
+   /* Normally filled in when the first context is created */
+   for (i = 0; i < 256; i++)
+      _mesa_ubyte_to_float_color_tab[i] = (float) i / 255.0F;
+
+   if (argc < 2 || strcmp(argv[1], "-b") != 0) {
+      check_maps();
+      check_format_maps();
+      check_pixel_layouts();
+      if (failures)
+         fprintf(stderr, "%d failures\n", failures);
+      return failures ? 1 : 0;
+   }
+
+   ctx = calloc(1, sizeof(*ctx));
+   src_image = malloc(WIDTH * HEIGHT * 16);
+   dst_image = malloc(WIDTH * HEIGHT * 16);
+   rgba_row = malloc(WIDTH * sizeof(*rgba_row));
+   for (i = 0; i < WIDTH * HEIGHT * 16; i++)
+      src_image[i] = (GLubyte) (i * 7 + (i >> 10));
+
+   ctx->Unpack.Alignment = 4;
+   ctx->Pack.Alignment = 4;
+
+   memset(&fb, 0, sizeof(fb));
+   memset(&rb, 0, sizeof(rb));
+   fb.Width = WIDTH;
+   fb.Height = HEIGHT;
+   fb._ColorReadBuffer = &rb;
+   ctx->ReadBuffer = &fb;
+   ctx->Driver.MapRenderbuffer = map_renderbuffer;
+   ctx->Driver.UnmapRenderbuffer = unmap_renderbuffer;
+
+   for (i = 0; i < Elements(unpack_formats); i++)
+      bench_unpack(unpack_formats[i], GL_FALSE);
+   for (i = 0; i < Elements(unpack_formats); i++)
+      if (_mesa_get_format_color_encoding(unpack_formats[i]) != GL_SRGB)
+         bench_unpack(unpack_formats[i], GL_TRUE);
+
+   bench_texstore(ctx, MESA_FORMAT_ARGB8888, GL_RGBA,
+                  GL_BGRA, GL_UNSIGNED_BYTE);
+   bench_texstore(ctx, MESA_FORMAT_ARGB8888, GL_RGBA,
+                  GL_RGBA, GL_UNSIGNED_INT_8_8_8_8);
+   bench_texstore(ctx, MESA_FORMAT_ARGB8888, GL_RGBA,
+                  GL_BGR, GL_UNSIGNED_BYTE);
+   bench_texstore(ctx, MESA_FORMAT_ARGB8888, GL_LUMINANCE_ALPHA,
+                  GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE);
+   bench_texstore(ctx, MESA_FORMAT_RGBA8888, GL_RGBA,
+                  GL_BGRA, GL_UNSIGNED_BYTE);
+   bench_texstore(ctx, MESA_FORMAT_RGB888, GL_RGB,
+                  GL_RGBA, GL_UNSIGNED_BYTE);
+
+   bench_readpixels(ctx, MESA_FORMAT_ARGB8888, GL_BGRA, GL_UNSIGNED_BYTE);
+   bench_readpixels(ctx, MESA_FORMAT_ARGB8888, GL_RGBA, GL_UNSIGNED_BYTE);
+   bench_readpixels(ctx, MESA_FORMAT_ARGB8888, GL_RGB, GL_UNSIGNED_BYTE);
+   bench_readpixels(ctx, MESA_FORMAT_XRGB8888, GL_BGRA,
+                    GL_UNSIGNED_INT_8_8_8_8_REV);
+   bench_readpixels(ctx, MESA_FORMAT_XRGB8888, GL_RGBA, GL_UNSIGNED_BYTE);
+   bench_readpixels(ctx, MESA_FORMAT_RGBA8888_REV, GL_BGRA,
+                    GL_UNSIGNED_INT_8_8_8_8_REV);
+   bench_readpixels(ctx, MESA_FORMAT_SARGB8, GL_RGBA, GL_UNSIGNED_BYTE);
+
+   free(rgba_row);
+   free(dst_image);
+   free(src_image);
+   free(ctx);
+
+   return 0;
+}
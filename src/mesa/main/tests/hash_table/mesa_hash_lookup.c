@@ -0,0 +1,250 @@
+/*
+ * Copyright © 2026 agent <agent@local>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Tests that _mesa_HashLookup() agrees with the hash table contents for keys
+ * below, across and past the flat lookup array as it grows.
+ *
+ * With -b, measures the lookup throughput from 1 to 16 threads instead.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+#include "glheader.h"
+#include "hash.h"
+
+#define BENCH_THREADS 16
+
+/** Objects each benchmark thread has bound and keeps looking up */
+#define BENCH_BOUND 8
+
+/** Names in the table besides the bound ones */
+#define BENCH_NAMES 4096
+
+struct bench_thread {
+   pthread_t thread;
+   struct _mesa_HashTable *table;
+   GLuint names[BENCH_BOUND];
+   uint64_t lookups;
+};
+
+static volatile int bench_running;
+
+static void *
+key_data(GLuint key)
+{
+   return (void *)(uintptr_t) (key * 2 + 1);
+}
+
+static void
+count_entry(GLuint key, void *data, void *userData)
+{
+   GLuint *count = userData;
+
+   assert(data == key_data(key));
+   (*count)++;
+}
+
+static uint64_t
+bench_time_ns(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+static void *
+bench_thread_func(void *arg)
+{
+   struct bench_thread *t = arg;
+   uint64_t lookups = 0;
+   uintptr_t sum = 0;
+   unsigned i;
+
+   while (!bench_running)
+      ;
+
+   while (bench_running) {
+      for (i = 0; i < 1024; i++)
+         sum += (uintptr_t) _mesa_HashLookup(t->table,
+                                             t->names[i % BENCH_BOUND]);
+      lookups += 1024;
+   }
+
+   t->lookups = lookups + (sum & 1);
+   return NULL;
+}
+
+
+/**
+ * Return the total throughput, in millions of lookups per second, of
+ * \p nr_threads threads each looking up its own bound objects, whose names
+ * start at \p base.
+ */
+static double
+bench_lookups(struct _mesa_HashTable *table, GLuint base, unsigned nr_threads)
+{
+   struct bench_thread threads[BENCH_THREADS];
+   uint64_t start, end, lookups = 0;
+   struct timespec duration = { 0, 200 * 1000 * 1000 };
+   unsigned i, j;
+
+   for (i = 0; i < nr_threads; i++) {
+      threads[i].table = table;
+      for (j = 0; j < BENCH_BOUND; j++)
+         threads[i].names[j] = base + i * BENCH_BOUND + j;
+      if (pthread_create(&threads[i].thread, NULL, bench_thread_func,
+                         &threads[i]) != 0)
+         abort();
+   }
+
+   start = bench_time_ns();
+   bench_running = 1;
+   nanosleep(&duration, NULL);
+   bench_running = 0;
+   end = bench_time_ns();
+
+   for (i = 0; i < nr_threads; i++) {
+      pthread_join(threads[i].thread, NULL);
+      lookups += threads[i].lookups;
+   }
+
+   return (double) lookups * 1000.0 / (end - start);
+}
+
+
+/**
+ * Look up the objects bound by 1 to 16 threads, with names mirrored in the
+ * flat array and with names past it.
+ */
+static void
+bench_all(void)
+{
+   static const struct {
+      const char *name;
+      GLuint base;
+   } sets[] = {
+      { "low names", 1 },
+      { "high names", 1u << 20 },
+   };
+   struct _mesa_HashTable *table = _mesa_NewHashTable();
+   unsigned i, s, nr_threads;
+
+   for (s = 0; s < sizeof(sets) / sizeof(sets[0]); s++) {
+      for (i = 0; i < BENCH_NAMES + BENCH_THREADS * BENCH_BOUND; i++)
+         _mesa_HashInsert(table, sets[s].base + i, key_data(sets[s].base + i));
+   }
+
+   printf("%-12s %8s %14s\n", "names", "threads", "Mlookups/s");
+   for (s = 0; s < sizeof(sets) / sizeof(sets[0]); s++) {
+      for (nr_threads = 1; nr_threads <= BENCH_THREADS; nr_threads *= 2) {
+         printf("%-12s %8u %14.1f\n", sets[s].name, nr_threads,
+                bench_lookups(table, sets[s].base, nr_threads));
+      }
+   }
+
+   _mesa_HashDeleteAll(table, count_entry, &i);
+   _mesa_DeleteHashTable(table);
+}
+
+
+int
+main(int argc, char **argv)
+{
+   static const GLuint sparse[] = { 70000, 100000, 1u << 31, ~0u - 1 };
+   struct _mesa_HashTable *table = _mesa_NewHashTable();
+   GLuint count = 0;
+   GLuint i;
+
+   if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+      _mesa_DeleteHashTable(table);
+      bench_all();
+      return 0;
+   }
+
+   /* Contiguous names, the way glGen*() hands them out. */
+   for (i = 1; i <= 5000; i++) {
+      assert(_mesa_HashLookup(table, i) == NULL);
+      _mesa_HashInsert(table, i, key_data(i));
+      assert(_mesa_HashLookup(table, i) == key_data(i));
+      assert(_mesa_HashLookup(table, i + 1) == NULL);
+   }
+
+   for (i = 0; i < sizeof(sparse) / sizeof(sparse[0]); i++)
+      _mesa_HashInsert(table, sparse[i], key_data(sparse[i]));
+
+   for (i = 1; i <= 5000; i++)
+      assert(_mesa_HashLookup(table, i) == key_data(i));
+   for (i = 0; i < sizeof(sparse) / sizeof(sparse[0]); i++)
+      assert(_mesa_HashLookup(table, sparse[i]) == key_data(sparse[i]));
+
+   /* Replacing and removing entries must be reflected in lookups. */
+   _mesa_HashInsert(table, 10, key_data(20));
+   assert(_mesa_HashLookup(table, 10) == key_data(20));
+   _mesa_HashInsert(table, 10, key_data(10));
+
+   for (i = 2; i <= 5000; i += 2)
+      _mesa_HashRemove(table, i);
+   for (i = 1; i <= 5000; i++)
+      assert(_mesa_HashLookup(table, i) == (i & 1 ? key_data(i) : NULL));
+
+   /* The same for keys past the array, which lookups cache. */
+   _mesa_HashInsert(table, sparse[1], key_data(20));
+   assert(_mesa_HashLookup(table, sparse[1]) == key_data(20));
+   _mesa_HashInsert(table, sparse[1], key_data(sparse[1]));
+   assert(_mesa_HashLookup(table, sparse[1]) == key_data(sparse[1]));
+
+   _mesa_HashRemove(table, sparse[0]);
+   assert(_mesa_HashLookup(table, sparse[0]) == NULL);
+   _mesa_HashInsert(table, sparse[0], key_data(sparse[0]));
+   assert(_mesa_HashLookup(table, sparse[0]) == key_data(sparse[0]));
+   _mesa_HashRemove(table, sparse[0]);
+   assert(_mesa_HashLookup(table, sparse[0]) == NULL);
+
+   /* A key far past the array forces it to grow while entries exist. */
+   _mesa_HashInsert(table, 60000, key_data(60000));
+   assert(_mesa_HashLookup(table, 60000) == key_data(60000));
+   for (i = 1; i <= 5000; i++)
+      assert(_mesa_HashLookup(table, i) == (i & 1 ? key_data(i) : NULL));
+
+   _mesa_HashWalk(table, count_entry, &count);
+   assert(count == _mesa_HashNumEntries(table));
+   assert(count == 2500 + 3 + 1);
+
+   _mesa_HashDeleteAll(table, count_entry, &count);
+   for (i = 1; i <= 5000; i++)
+      assert(_mesa_HashLookup(table, i) == NULL);
+   assert(_mesa_HashLookup(table, 60000) == NULL);
+   assert(_mesa_HashLookup(table, sparse[1]) == NULL);
+
+   _mesa_DeleteHashTable(table);
+
+   return 0;
+}
@@ -40,6 +40,7 @@
 #include "transformfeedback.h"
 #include "shaderapi.h"
 #include "shaderobj.h"
+#include "shaderqueue.h"
 #include "main/dispatch.h"
 
 #include "program/prog_parameter.h"
@@ -460,6 +461,9 @@ bind_buffer_range(struct gl_context *ctx, GLuint index,
 
    obj->BufferNames[index] = bufObj->Name;
 
+   /* The GPU writes to this buffer, see vbo_minmax_index.c */
+   bufObj->MinMaxCacheDisabled = GL_TRUE;
+
    obj->Offset[index] = offset;
    obj->RequestedSize[index] = size;
 }
@@ -632,6 +636,8 @@ _mesa_TransformFeedbackVaryings(GLuint program, GLsizei count,
       return;
    }
 
+   _mesa_wait_shader_program(ctx, shProg);
+
    if (ctx->Extensions.ARB_transform_feedback3) {
       if (bufferMode == GL_INTERLEAVED_ATTRIBS) {
          unsigned buffers = 1;
@@ -713,6 +719,8 @@ _mesa_GetTransformFeedbackVarying(GLuint program, GLuint index,
       return;
    }
 
+   _mesa_wait_shader_program(ctx, shProg);
+
    linked_xfb_info = &shProg->LinkedTransformFeedback;
    if (index >= (GLuint) linked_xfb_info->NumVarying) {
       _mesa_error(ctx, GL_INVALID_VALUE,
@@ -45,11 +45,13 @@ MAIN_FILES = \
 	$(SRCDIR)main/formatquery.c \
 	$(SRCDIR)main/formats.c \
 	$(SRCDIR)main/format_pack.c \
+	$(SRCDIR)main/format_row.c \
 	$(SRCDIR)main/format_unpack.c \
 	$(SRCDIR)main/framebuffer.c \
 	$(SRCDIR)main/get.c \
 	$(SRCDIR)main/getstring.c \
 	$(SRCDIR)main/glformats.c \
+	$(SRCDIR)main/glthread.c \
 	$(SRCDIR)main/hash.c \
 	$(SRCDIR)main/hash_table.c \
 	$(SRCDIR)main/hint.c \
@@ -58,6 +60,7 @@ MAIN_FILES = \
 	$(SRCDIR)main/imports.c \
 	$(SRCDIR)main/light.c \
 	$(SRCDIR)main/lines.c \
+	$(BUILDDIR)main/marshal_generated.c \
 	$(SRCDIR)main/matrix.c \
 	$(SRCDIR)main/mipmap.c \
 	$(SRCDIR)main/mm.c \
@@ -80,6 +83,7 @@ MAIN_FILES = \
 	$(SRCDIR)main/set.c \
 	$(SRCDIR)main/shaderapi.c \
 	$(SRCDIR)main/shaderobj.c \
+	$(SRCDIR)main/shaderqueue.c \
 	$(SRCDIR)main/shader_query.cpp \
 	$(SRCDIR)main/shared.c \
 	$(SRCDIR)main/state.c \
@@ -185,6 +189,7 @@ VBO_FILES = \
 	$(SRCDIR)vbo/vbo_exec_array.c \
 	$(SRCDIR)vbo/vbo_exec_draw.c \
 	$(SRCDIR)vbo/vbo_exec_eval.c \
+	$(SRCDIR)vbo/vbo_minmax_index.c \
 	$(SRCDIR)vbo/vbo_noop.c \
 	$(SRCDIR)vbo/vbo_primitive_restart.c \
 	$(SRCDIR)vbo/vbo_rebase.c \
@@ -30,9 +30,11 @@
 #include "main/context.h"
 
 #include "pipe/p_defines.h"
+#include "util/u_math.h"
 #include "st_context.h"
 #include "st_atom.h"
 #include "st_cb_bitmap.h"
+#include "st_debug.h"
 #include "st_program.h"
 #include "st_manager.h"
 
@@ -73,36 +75,61 @@ static const struct st_tracked_state *atoms[] =
 };
 
 
+/**
+ * Build the tables of atoms to check for each dirty bit, so that
+ * st_validate_state() only has to look at the atoms that depend on the
+ * bits which are actually set.
+ */
 void st_init_atoms( struct st_context *st )
 {
-   /* no-op */
+   GLuint i, bit;
+
+   STATIC_ASSERT(Elements(atoms) <= ST_MAX_ATOMS);
+
+   memset(st->atoms_for_mesa_bit, 0, sizeof(st->atoms_for_mesa_bit));
+   memset(st->atoms_for_st_bit, 0, sizeof(st->atoms_for_st_bit));
+
+   for (i = 0; i < Elements(atoms); i++) {
+      /* Catch malformed atoms, which would never run */
+      assert(atoms[i]->update);
+      assert(atoms[i]->dirty.mesa || atoms[i]->dirty.st);
+
+      for (bit = 0; bit < 32; bit++) {
+         if (atoms[i]->dirty.mesa & (1u << bit))
+            st->atoms_for_mesa_bit[bit] |= 1u << i;
+         if (atoms[i]->dirty.st & (1u << bit))
+            st->atoms_for_st_bit[bit] |= 1u << i;
+      }
+   }
+
+   memset(st->atom_counts, 0, sizeof(st->atom_counts));
 }
 
 
 void st_destroy_atoms( struct st_context *st )
 {
-   /* no-op */
+   if (ST_DEBUG & DEBUG_ATOMS)
+      st_print_atom_counts(st);
 }
 
 
-/***********************************************************************
- */
-
-static GLboolean check_state( const struct st_state_flags *a,
-			      const struct st_state_flags *b )
+GLuint st_get_num_atoms( void )
 {
-   return ((a->mesa & b->mesa) ||
-	   (a->st & b->st));
+   return Elements(atoms);
 }
 
-static void accumulate_state( struct st_state_flags *a,
-			      const struct st_state_flags *b )
+
+const char *st_get_atom_name( GLuint i )
 {
-   a->mesa |= b->mesa;
-   a->st |= b->st;
+   assert(i < Elements(atoms));
+   return atoms[i]->name;
 }
 
 
+/***********************************************************************
+ */
+
+
 static void xor_states( struct st_state_flags *result,
 			     const struct st_state_flags *a,
 			      const struct st_state_flags *b )
@@ -112,6 +139,27 @@ static void xor_states( struct st_state_flags *result,
 }
 
 
+/**
+ * Return the mask of atoms depending on any of the given dirty bits.
+ */
+static GLbitfield atoms_for_state( const struct st_context *st,
+                                   const struct st_state_flags *state )
+{
+   GLbitfield mask = 0;
+   unsigned bits;
+
+   bits = state->mesa;
+   while (bits)
+      mask |= st->atoms_for_mesa_bit[u_bit_scan(&bits)];
+
+   bits = state->st;
+   while (bits)
+      mask |= st->atoms_for_st_bit[u_bit_scan(&bits)];
+
+   return mask;
+}
+
+
 /* Too complex to figure out, just check every time:
  */
 static void check_program_state( struct st_context *st )
@@ -152,6 +200,7 @@ static void check_attrib_edgeflag(struct st_context *st)
 void st_validate_state( struct st_context *st )
 {
    struct st_state_flags *state = &st->dirty;
+   GLbitfield pending;
    GLuint i;
 
    /* Get Mesa driver state. */
@@ -176,53 +225,28 @@ void st_validate_state( struct st_context *st )
 
    /*printf("%s %x/%x\n", __FUNCTION__, state->mesa, state->st);*/
 
-#ifdef DEBUG
-   if (1) {
-#else
-   if (0) {
-#endif
-      /* Debug version which enforces various sanity checks on the
-       * state flags which are generated and checked to help ensure
-       * state atoms are ordered correctly in the list.
-       */
-      struct st_state_flags examined, prev;      
-      memset(&examined, 0, sizeof(examined));
-      prev = *state;
-
-      for (i = 0; i < Elements(atoms); i++) {	 
-	 const struct st_tracked_state *atom = atoms[i];
-	 struct st_state_flags generated;
-	 
-	 /*printf("atom %s %x/%x\n", atom->name, atom->dirty.mesa, atom->dirty.st);*/
-
-	 if (!(atom->dirty.mesa || atom->dirty.st) ||
-	     !atom->update) {
-	    printf("malformed atom %s\n", atom->name);
-	    assert(0);
-	 }
-
-	 if (check_state(state, &atom->dirty)) {
-	    atoms[i]->update( st );
-	    /*printf("after: %x\n", atom->dirty.mesa);*/
-	 }
-
-	 accumulate_state(&examined, &atom->dirty);
-
-	 /* generated = (prev ^ state)
-	  * if (examined & generated)
-	  *     fail;
-	  */
-	 xor_states(&generated, &prev, state);
-	 assert(!check_state(&examined, &generated));
-	 prev = *state;
-      }
-      /*printf("\n");*/
+   pending = atoms_for_state(st, state);
 
-   }
-   else {
-      for (i = 0; i < Elements(atoms); i++) {	 
-	 if (check_state(state, &atoms[i]->dirty))
-	    atoms[i]->update( st );
+   /* Atoms run in the order of atoms[], and may dirty state that later
+    * atoms depend on, so pick up those atoms as we go.
+    */
+   while (pending) {
+      struct st_state_flags prev = *state, generated;
+
+      i = u_bit_scan(&pending);
+      atoms[i]->update( st );
+      st->atom_counts[i]++;
+
+      xor_states(&generated, &prev, state);
+      if (generated.mesa || generated.st) {
+         GLbitfield dependent = atoms_for_state(st, &generated);
+
+         /* The atoms must be ordered so that none of them dirties state
+          * checked by itself or by an earlier atom.
+          */
+         assert(!(dependent & ((2u << i) - 1)));
+
+         pending |= dependent & ~((2u << i) - 1);
       }
    }
 
@@ -45,6 +45,9 @@ void st_destroy_atoms( struct st_context *st );
 
 void st_validate_state( struct st_context *st );
 
+GLuint st_get_num_atoms( void );
+const char *st_get_atom_name( GLuint i );
+
 
 extern const struct st_tracked_state st_update_array;
 extern const struct st_tracked_state st_update_framebuffer;
@@ -229,6 +229,31 @@ st_bufferobj_data(struct gl_context *ctx,
       pipe_usage = PIPE_USAGE_DEFAULT;
    }
 
+   /* Respecifying a buffer with the same size and usage is how applications
+    * orphan its storage.  On drivers which rename buffers on discarding
+    * maps, map it discarding the old contents instead of reallocating it,
+    * which keeps views of the buffer valid.  If the driver would have to
+    * wait after all, reallocate as usual.
+    */
+   if (st->has_buffer_discard_rename &&
+       st_obj->buffer &&
+       st_obj->buffer->width0 == size &&
+       st_obj->buffer->bind == bind &&
+       st_obj->buffer->usage == pipe_usage) {
+      struct pipe_transfer *transfer;
+      void *map = pipe_buffer_map(pipe, st_obj->buffer,
+                                  PIPE_TRANSFER_WRITE |
+                                  PIPE_TRANSFER_DISCARD_WHOLE_RESOURCE |
+                                  PIPE_TRANSFER_DONTBLOCK,
+                                  &transfer);
+      if (map) {
+         if (data)
+            memcpy(map, data, size);
+         pipe_buffer_unmap(pipe, transfer);
+         return GL_TRUE;
+      }
+   }
+
    pipe_resource_reference( &st_obj->buffer, NULL );
 
    if (ST_DEBUG & DEBUG_BUFFER) {
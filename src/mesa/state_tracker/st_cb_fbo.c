@@ -708,7 +708,7 @@ st_MapRenderbuffer(struct gl_context *ctx,
    struct st_context *st = st_context(ctx);
    struct st_renderbuffer *strb = st_renderbuffer(rb);
    struct pipe_context *pipe = st->pipe;
-   const GLboolean invert = rb->Name == 0;
+   const GLboolean invert = strb->flip_y;
    unsigned usage;
    GLuint y2;
    GLubyte *map;
@@ -738,8 +738,9 @@ st_MapRenderbuffer(struct gl_context *ctx,
       usage |= PIPE_TRANSFER_DISCARD_RANGE;
 
    /* Note: y=0=bottom of buffer while y2=0=top of buffer.
-    * 'invert' will be true for window-system buffers and false for
-    * user-allocated renderbuffers and textures.
+    * 'invert' will be true for window-system buffers, unless they are
+    * stored bottom to top, and false for user-allocated renderbuffers and
+    * textures.
     */
    if (invert)
       y2 = strb->Base.Height - y - h;
@@ -49,6 +49,7 @@ struct st_renderbuffer
    struct pipe_resource *texture;
    struct pipe_surface *surface; /* temporary view into texture */
    GLboolean defined;        /**< defined contents? */
+   boolean flip_y;           /**< row 0 is the top, see gl_framebuffer::FlipY */
 
    struct pipe_transfer *transfer; /**< only used when mapping the resource */
 
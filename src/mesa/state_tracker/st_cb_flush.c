@@ -44,6 +44,7 @@
 #include "pipe/p_defines.h"
 #include "pipe/p_screen.h"
 #include "util/u_gen_mipmap.h"
+#include "util/u_upload_mgr.h"
 
 
 /** Check if we have a front color buffer and if it's been drawn to. */
@@ -79,12 +80,26 @@ void st_flush(struct st_context *st,
               struct pipe_fence_handle **fence,
               enum pipe_flush_flags flags)
 {
+   struct pipe_screen *screen = st->pipe->screen;
+   struct pipe_fence_handle *flush_fence = NULL;
+
    FLUSH_VERTICES(st->ctx, 0);
    FLUSH_CURRENT(st->ctx, 0);
 
    st_flush_bitmap_cache(st);
 
-   st->pipe->flush(st->pipe, fence, flags);
+   st->pipe->flush(st->pipe, &flush_fence, flags);
+
+   /* Let the uploaders know when they can reuse what was just submitted */
+   u_upload_fence(st->uploader, flush_fence);
+   if (st->indexbuf_uploader)
+      u_upload_fence(st->indexbuf_uploader, flush_fence);
+   if (st->constbuf_uploader)
+      u_upload_fence(st->constbuf_uploader, flush_fence);
+
+   if (fence)
+      screen->fence_reference(screen, fence, flush_fence);
+   screen->fence_reference(screen, &flush_fence, NULL);
 }
 
 
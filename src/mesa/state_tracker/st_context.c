@@ -29,8 +29,10 @@
 #include "main/accum.h"
 #include "main/api_exec.h"
 #include "main/context.h"
+#include "main/glthread.h"
 #include "main/samplerobj.h"
 #include "main/shaderobj.h"
+#include "main/shaderqueue.h"
 #include "main/version.h"
 #include "main/vtxfmt.h"
 #include "program/prog_cache.h"
@@ -124,23 +126,27 @@ st_create_context_priv( struct gl_context *ctx, struct pipe_context *pipe,
    st->dirty.mesa = ~0;
    st->dirty.st = ~0;
 
-   st->uploader = u_upload_create(st->pipe, 65536, 4, PIPE_BIND_VERTEX_BUFFER);
+   /* The uploaders are ring buffers, which st_flush() tags with fences. */
+   st->uploader = u_upload_create_ring(st->pipe, 65536, 4,
+                                       PIPE_BIND_VERTEX_BUFFER);
 
    if (!screen->get_param(screen, PIPE_CAP_USER_INDEX_BUFFERS)) {
-      st->indexbuf_uploader = u_upload_create(st->pipe, 128 * 1024, 4,
-                                              PIPE_BIND_INDEX_BUFFER);
+      st->indexbuf_uploader = u_upload_create_ring(st->pipe, 128 * 1024, 4,
+                                                   PIPE_BIND_INDEX_BUFFER);
    }
 
    if (!screen->get_param(screen, PIPE_CAP_USER_CONSTANT_BUFFERS)) {
       unsigned alignment =
          screen->get_param(screen, PIPE_CAP_CONSTANT_BUFFER_OFFSET_ALIGNMENT);
 
-      st->constbuf_uploader = u_upload_create(pipe, 128 * 1024, alignment,
-                                              PIPE_BIND_CONSTANT_BUFFER);
+      st->constbuf_uploader = u_upload_create_ring(pipe, 128 * 1024,
+                                                   alignment,
+                                                   PIPE_BIND_CONSTANT_BUFFER);
    }
 
    st->cso_context = cso_create_context(pipe);
 
+   st_init_shader_cache(st);
    st_init_atoms( st );
    st_init_bitmap(st);
    st_init_clear(st);
@@ -182,6 +188,8 @@ st_create_context_priv( struct gl_context *ctx, struct pipe_context *pipe,
    st->has_stencil_export =
       screen->get_param(screen, PIPE_CAP_SHADER_STENCIL_EXPORT);
    st->has_shader_model3 = screen->get_param(screen, PIPE_CAP_SM3);
+   st->has_buffer_discard_rename =
+      screen->get_param(screen, PIPE_CAP_BUFFER_MAP_DISCARD_RENAMES);
 
    /* GL limits and extensions */
    st_init_limits(st);
@@ -245,6 +253,7 @@ static void st_destroy_context_priv( struct st_context *st )
    st_destroy_bitmap(st);
    st_destroy_drawpix(st);
    st_destroy_drawtex(st);
+   st_destroy_shader_cache(st);
 
    for (shader = 0; shader < Elements(st->state.sampler_views); shader++) {
       for (i = 0; i < Elements(st->state.sampler_views[0]); i++) {
@@ -276,6 +285,12 @@ void st_destroy_context( struct st_context *st )
    struct gl_context *ctx = st->ctx;
    GLuint i;
 
+   /* execute any queued GL calls before tearing down driver state */
+   _mesa_glthread_destroy(ctx);
+
+   /* shaders may still be compiling with this context */
+   _mesa_shader_queue_finish(ctx);
+
    /* need to unbind and destroy CSO objects before anything else */
    cso_release_all(st->cso_context);
 
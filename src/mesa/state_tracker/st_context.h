@@ -40,6 +40,7 @@ struct draw_stage;
 struct gen_mipmap_state;
 struct st_context;
 struct st_fragment_program;
+struct st_shader_cache;
 struct u_upload_mgr;
 
 
@@ -57,6 +58,9 @@ struct st_state_flags {
    GLuint st;
 };
 
+/** Most atoms st_validate_state() can handle */
+#define ST_MAX_ATOMS 32
+
 struct st_tracked_state {
    const char *name;
    struct st_state_flags dirty;
@@ -84,6 +88,7 @@ struct st_context
    boolean has_stencil_export; /**< can do shader stencil export? */
    boolean has_time_elapsed;
    boolean has_shader_model3;
+   boolean has_buffer_discard_rename; /**< can orphan buffers in place? */
 
    /* On old libGL's for linux we need to invalidate the drawables
     * on glViewpport calls, this is set via a option.
@@ -123,6 +128,13 @@ struct st_context
 
    struct st_state_flags dirty;
 
+   /** Atoms depending on each dirty bit, as bitmasks of atom indices */
+   GLbitfield atoms_for_mesa_bit[32];
+   GLbitfield atoms_for_st_bit[32];
+
+   /** How many times each atom was updated, see ST_DEBUG=atoms */
+   unsigned atom_counts[ST_MAX_ATOMS];
+
    GLboolean missing_textures;
    GLboolean vertdata_edgeflags;
 
@@ -137,6 +149,9 @@ struct st_context
    struct st_fp_variant *fp_variant;
    struct st_gp_variant *gp_variant;
 
+   /** Driver shaders shared by variants with identical TGSI */
+   struct st_shader_cache *shader_cache;
+
    struct gl_texture_object *default_texture;
 
    struct {
@@ -233,7 +248,7 @@ void st_invalidate_state(struct gl_context * ctx, GLuint new_state);
 static INLINE GLuint
 st_fb_orientation(const struct gl_framebuffer *fb)
 {
-   if (fb && _mesa_is_winsys_fbo(fb)) {
+   if (fb && fb->FlipY) {
       /* Drawing into a window (on-screen buffer).
        *
        * Negate Y scale to flip image vertically.
@@ -246,7 +261,8 @@ st_fb_orientation(const struct gl_framebuffer *fb)
       return Y_0_TOP;
    }
    else {
-      /* Drawing into user-created FBO (very likely a texture).
+      /* Drawing into user-created FBO (very likely a texture), or a window
+       * system buffer stored bottom to top.
        *
        * For textures, T=0=Bottom, so by extension Y=0=Bottom for rendering.
        */
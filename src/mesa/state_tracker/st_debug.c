@@ -35,6 +35,7 @@
 
 #include "cso_cache/cso_cache.h"
 
+#include "st_atom.h"
 #include "st_context.h"
 #include "st_debug.h"
 #include "st_program.h"
@@ -55,6 +56,7 @@ static const struct debug_named_value st_debug_flags[] = {
    { "query",    DEBUG_QUERY, NULL },
    { "draw",     DEBUG_DRAW, NULL },
    { "buffer",   DEBUG_BUFFER, NULL },
+   { "atoms",    DEBUG_ATOMS, NULL },
    DEBUG_NAMED_VALUE_END
 };
 
@@ -102,3 +104,17 @@ st_print_current(void)
 }
 
 
+/**
+ * Print how many times each state atom was updated.  Done when the context
+ * is destroyed with ST_DEBUG=atoms, and may be called from gdb.
+ */
+void
+st_print_atom_counts(const struct st_context *st)
+{
+   GLuint i;
+
+   debug_printf("st: state atom updates:\n");
+   for (i = 0; i < st_get_num_atoms(); i++) {
+      debug_printf("  %-28s %u\n", st_get_atom_name(i), st->atom_counts[i]);
+   }
+}
@@ -46,6 +46,7 @@ st_print_current(void);
 #define DEBUG_SCREEN    0x80
 #define DEBUG_DRAW      0x100
 #define DEBUG_BUFFER    0x200
+#define DEBUG_ATOMS     0x400
 
 #ifdef DEBUG
 extern int ST_DEBUG;
@@ -57,6 +58,10 @@ extern int ST_DEBUG;
 
 void st_debug_init( void );
 
+struct st_context;
+
+void st_print_atom_counts( const struct st_context *st );
+
 static INLINE void
 ST_DBG( unsigned flag, const char *fmt, ... )
 {
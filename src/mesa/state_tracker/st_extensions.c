@@ -35,6 +35,8 @@
 #include "pipe/p_context.h"
 #include "pipe/p_defines.h"
 #include "pipe/p_screen.h"
+#include "util/u_cpu_detect.h"
+#include "util/u_debug.h"
 
 #include "st_context.h"
 #include "st_extensions.h"
@@ -677,6 +679,17 @@ void st_init_extensions(struct st_context *st)
        ctx->Extensions.ARB_draw_instanced) {
       ctx->Extensions.ARB_transform_feedback_instanced = GL_TRUE;
    }
+
+   /* Linking only queries the screen, which is thread safe, so shaders can
+    * be compiled and linked on worker threads.
+    */
+   util_cpu_detect();
+   ctx->Const.MaxShaderCompilerThreads =
+      debug_get_num_option("ST_SHADER_COMPILER_THREADS",
+                           MIN2(util_cpu_caps.nr_cpus,
+                                MAX_SHADER_COMPILER_THREADS));
+   if (ctx->Const.MaxShaderCompilerThreads)
+      ctx->Extensions.ARB_parallel_shader_compile = GL_TRUE;
    if (st->options.force_glsl_extensions_warn)
 	   ctx->Const.ForceGLSLExtensionsWarn = 1;
 
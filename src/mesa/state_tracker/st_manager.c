@@ -34,6 +34,7 @@
 #include "main/texstate.h"
 #include "main/framebuffer.h"
 #include "main/fbobject.h"
+#include "main/glthread.h"
 #include "main/renderbuffer.h"
 #include "main/version.h"
 #include "st_texture.h"
@@ -53,6 +54,10 @@
 #include "util/u_inlines.h"
 #include "util/u_atomic.h"
 #include "util/u_surface.h"
+#include "util/u_debug.h"
+
+
+DEBUG_GET_ONCE_BOOL_OPTION(mesa_glthread, "MESA_GLTHREAD", FALSE)
 
 /**
  * Cast wrapper to convert a struct gl_framebuffer to an st_framebuffer.
@@ -244,6 +249,19 @@ st_framebuffer_validate(struct st_framebuffer *stfb,
       pipe_resource_reference(&textures[i], NULL);
    }
 
+   /* The window system may have switched to storing images bottom to top */
+   if (stfb->Base.FlipY == stfb->iface->y0_bottom) {
+      stfb->Base.FlipY = !stfb->iface->y0_bottom;
+
+      for (i = 0; i < BUFFER_COUNT; i++) {
+         struct gl_renderbuffer *rb = stfb->Base.Attachment[i].Renderbuffer;
+         if (rb)
+            st_renderbuffer(rb)->flip_y = stfb->Base.FlipY;
+      }
+
+      changed = TRUE;
+   }
+
    if (changed) {
       ++stfb->stamp;
       _mesa_resize_framebuffer(st->ctx, &stfb->Base, width, height);
@@ -315,6 +333,8 @@ st_framebuffer_add_renderbuffer(struct st_framebuffer *stfb,
    if (!rb)
       return FALSE;
 
+   st_renderbuffer(rb)->flip_y = stfb->Base.FlipY;
+
    if (idx != BUFFER_DEPTH) {
       _mesa_add_renderbuffer(&stfb->Base, idx, rb);
    }
@@ -417,6 +437,7 @@ st_framebuffer_create(struct st_framebuffer_iface *stfbi)
 
    st_visual_to_context_mode(stfbi->visual, &mode);
    _mesa_initialize_window_framebuffer(&stfb->Base, &mode);
+   stfb->Base.FlipY = !stfbi->y0_bottom;
 
    stfb->iface = stfbi;
    stfb->iface_stamp = p_atomic_read(&stfbi->stamp) - 1;
@@ -457,6 +478,8 @@ st_context_flush(struct st_context_iface *stctxi, unsigned flags,
    struct st_context *st = (struct st_context *) stctxi;
    enum pipe_flush_flags pipe_flags = 0;
 
+   _mesa_glthread_finish(st->ctx);
+
    if (flags & ST_FLUSH_END_OF_FRAME) {
       pipe_flags |= PIPE_FLUSH_END_OF_FRAME;
    }
@@ -483,6 +506,8 @@ st_context_teximage(struct st_context_iface *stctxi,
    GLuint width, height, depth;
    GLenum target;
 
+   _mesa_glthread_finish(ctx);
+
    switch (tex_type) {
    case ST_TEXTURE_1D:
       target = GL_TEXTURE_1D;
@@ -578,6 +603,8 @@ st_context_copy(struct st_context_iface *stctxi,
    struct st_context *st = (struct st_context *) stctxi;
    struct st_context *src = (struct st_context *) stsrci;
 
+   _mesa_glthread_finish(src->ctx);
+   _mesa_glthread_finish(st->ctx);
    _mesa_copy_context(src->ctx, st->ctx, mask);
 }
 
@@ -674,6 +701,9 @@ st_api_create_context(struct st_api *stapi, struct st_manager *smapi,
    st->iface.cso_context = st->cso_context;
    st->iface.pipe = st->pipe;
 
+   if (debug_get_option_mesa_glthread())
+      _mesa_glthread_init(st->ctx);
+
    *error = ST_CONTEXT_SUCCESS;
    return &st->iface;
 }
@@ -719,6 +749,9 @@ st_api_make_current(struct st_api *stapi, struct st_context_iface *stctxi,
    _glapi_check_multithread();
 
    if (st) {
+      /* the framebuffers are validated on this thread */
+      _mesa_glthread_finish(st->ctx);
+
       /* reuse or create the draw fb */
       stdraw = st_framebuffer_reuse_or_create(st->ctx->WinSysDrawBuffer,
                                               stdrawi);
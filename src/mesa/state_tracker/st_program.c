@@ -44,7 +44,11 @@
 #include "pipe/p_shader_tokens.h"
 #include "draw/draw_context.h"
 #include "tgsi/tgsi_dump.h"
+#include "tgsi/tgsi_parse.h"
 #include "tgsi/tgsi_ureg.h"
+#include "util/u_double_list.h"
+#include "util/u_hash.h"
+#include "util/u_hash_table.h"
 
 #include "st_debug.h"
 #include "st_cb_bitmap.h"
@@ -56,6 +60,243 @@
 
 
 
+/**
+ * Maximum number of driver shaders kept around after the last variant
+ * using them went away.
+ */
+#define ST_MAX_UNUSED_SHADERS 64
+
+
+/**
+ * A driver shader, shared by all the variants in a context whose TGSI is
+ * identical.
+ *
+ * Relinking a GLSL program creates new gl_programs for every stage, even
+ * the ones whose source didn't change, and their variants would otherwise
+ * have the driver compile the very same TGSI again.  Since the cache is
+ * keyed on the TGSI itself, a stage whose code or interface changed simply
+ * misses.
+ */
+struct st_cached_shader
+{
+   unsigned processor;          /**< TGSI_PROCESSOR_x */
+   struct pipe_shader_state state;  /**< our own copy of the tokens */
+   unsigned num_tokens;
+   unsigned hash;
+
+   void *driver_shader;
+   unsigned refcount;           /**< number of variants using this */
+
+   /** Link in st_shader_cache::unused while refcount is zero */
+   struct list_head unused;
+};
+
+
+struct st_shader_cache
+{
+   struct util_hash_table *table;
+
+   /**
+    * Shaders no longer used by any variant, least recently released first.
+    *
+    * A relink frees the old program's variants before the new program's
+    * are created at the next draw, so these have to outlive their last
+    * user for the cache to help.
+    */
+   struct list_head unused;
+   unsigned num_unused;
+};
+
+
+static unsigned
+cached_shader_hash(void *key)
+{
+   const struct st_cached_shader *cs = (const struct st_cached_shader *) key;
+   return cs->hash;
+}
+
+
+static int
+cached_shader_compare(void *key1, void *key2)
+{
+   const struct st_cached_shader *a = (const struct st_cached_shader *) key1;
+   const struct st_cached_shader *b = (const struct st_cached_shader *) key2;
+
+   if (a->processor != b->processor ||
+       a->num_tokens != b->num_tokens)
+      return 1;
+
+   if (memcmp(&a->state.stream_output, &b->state.stream_output,
+              sizeof(a->state.stream_output)) != 0)
+      return 1;
+
+   return memcmp(a->state.tokens, b->state.tokens,
+                 a->num_tokens * sizeof(struct tgsi_token));
+}
+
+
+static void
+delete_cached_shader(struct st_context *st, struct st_cached_shader *cs)
+{
+   switch (cs->processor) {
+   case TGSI_PROCESSOR_VERTEX:
+      cso_delete_vertex_shader(st->cso_context, cs->driver_shader);
+      break;
+   case TGSI_PROCESSOR_FRAGMENT:
+      cso_delete_fragment_shader(st->cso_context, cs->driver_shader);
+      break;
+   case TGSI_PROCESSOR_GEOMETRY:
+      cso_delete_geometry_shader(st->cso_context, cs->driver_shader);
+      break;
+   default:
+      assert(0);
+   }
+
+   st_free_tokens(cs->state.tokens);
+   free(cs);
+}
+
+
+/**
+ * Find or create the driver shader for the given TGSI.
+ * The caller must release it with release_cached_shader().
+ * \return NULL if the driver failed to create the shader.
+ */
+static struct st_cached_shader *
+get_cached_shader(struct st_context *st, unsigned processor,
+                  const struct pipe_shader_state *state)
+{
+   struct st_shader_cache *cache = st->shader_cache;
+   struct pipe_context *pipe = st->pipe;
+   struct st_cached_shader key, *cs;
+
+   memset(&key, 0, sizeof(key));
+   key.processor = processor;
+   key.state = *state;
+   key.num_tokens = tgsi_num_tokens(state->tokens);
+   key.hash = util_hash_crc32(state->tokens,
+                              key.num_tokens * sizeof(struct tgsi_token));
+
+   cs = util_hash_table_get(cache->table, &key);
+   if (cs) {
+      if (cs->refcount++ == 0) {
+         LIST_DEL(&cs->unused);
+         cache->num_unused--;
+      }
+      return cs;
+   }
+
+   cs = CALLOC_STRUCT(st_cached_shader);
+   if (!cs)
+      return NULL;
+
+   *cs = key;
+   cs->state.tokens = tgsi_dup_tokens(state->tokens);
+   if (!cs->state.tokens) {
+      free(cs);
+      return NULL;
+   }
+
+   switch (processor) {
+   case TGSI_PROCESSOR_VERTEX:
+      cs->driver_shader = pipe->create_vs_state(pipe, state);
+      break;
+   case TGSI_PROCESSOR_FRAGMENT:
+      cs->driver_shader = pipe->create_fs_state(pipe, state);
+      break;
+   case TGSI_PROCESSOR_GEOMETRY:
+      cs->driver_shader = pipe->create_gs_state(pipe, state);
+      break;
+   default:
+      assert(0);
+   }
+
+   if (!cs->driver_shader ||
+       util_hash_table_set(cache->table, cs, cs) != PIPE_OK) {
+      if (cs->driver_shader)
+         delete_cached_shader(st, cs);
+      else {
+         st_free_tokens(cs->state.tokens);
+         free(cs);
+      }
+      return NULL;
+   }
+
+   cs->refcount = 1;
+   return cs;
+}
+
+
+/**
+ * Drop a variant's reference to a cached driver shader.
+ */
+static void
+release_cached_shader(struct st_context *st, struct st_cached_shader *cs)
+{
+   struct st_shader_cache *cache = st->shader_cache;
+
+   assert(cs->refcount > 0);
+   if (--cs->refcount > 0)
+      return;
+
+   LIST_ADDTAIL(&cs->unused, &cache->unused);
+   cache->num_unused++;
+
+   if (cache->num_unused > ST_MAX_UNUSED_SHADERS) {
+      struct st_cached_shader *oldest =
+         LIST_ENTRY(struct st_cached_shader, cache->unused.next, unused);
+
+      LIST_DEL(&oldest->unused);
+      cache->num_unused--;
+      util_hash_table_remove(cache->table, oldest);
+      delete_cached_shader(st, oldest);
+   }
+}
+
+
+void
+st_init_shader_cache(struct st_context *st)
+{
+   struct st_shader_cache *cache = CALLOC_STRUCT(st_shader_cache);
+
+   cache->table = util_hash_table_create(cached_shader_hash,
+                                         cached_shader_compare);
+   LIST_INITHEAD(&cache->unused);
+
+   st->shader_cache = cache;
+}
+
+
+static enum pipe_error
+free_cached_shader(void *key, void *value, void *data)
+{
+   struct st_context *st = (struct st_context *) data;
+   struct st_cached_shader *cs = (struct st_cached_shader *) value;
+
+   /* All the variants should have released their shaders by now */
+   assert(cs->refcount == 0);
+
+   delete_cached_shader(st, cs);
+   return PIPE_OK;
+}
+
+
+/**
+ * Free the shader cache, including the shaders still in use.  All the
+ * variants of this context must have been destroyed already.
+ */
+void
+st_destroy_shader_cache(struct st_context *st)
+{
+   struct st_shader_cache *cache = st->shader_cache;
+
+   util_hash_table_foreach(cache->table, free_cached_shader, st);
+   util_hash_table_destroy(cache->table);
+   free(cache);
+   st->shader_cache = NULL;
+}
+
+
 /**
  * Delete a vertex program variant.  Note the caller must unlink
  * the variant from the linked list.
@@ -63,8 +304,8 @@
 static void
 delete_vp_variant(struct st_context *st, struct st_vp_variant *vpv)
 {
-   if (vpv->driver_shader) 
-      cso_delete_vertex_shader(st->cso_context, vpv->driver_shader);
+   if (vpv->cached_shader)
+      release_cached_shader(vpv->key.st, vpv->cached_shader);
       
    if (vpv->draw_shader)
       draw_delete_vertex_shader( st->draw, vpv->draw_shader );
@@ -104,8 +345,8 @@ st_release_vp_variants( struct st_context *st,
 static void
 delete_fp_variant(struct st_context *st, struct st_fp_variant *fpv)
 {
-   if (fpv->driver_shader) 
-      cso_delete_fragment_shader(st->cso_context, fpv->driver_shader);
+   if (fpv->cached_shader)
+      release_cached_shader(fpv->key.st, fpv->cached_shader);
    if (fpv->parameters)
       _mesa_free_parameter_list(fpv->parameters);
    if (fpv->tgsi.tokens)
@@ -139,9 +380,9 @@ st_release_fp_variants(struct st_context *st, struct st_fragment_program *stfp)
 static void
 delete_gp_variant(struct st_context *st, struct st_gp_variant *gpv)
 {
-   if (gpv->driver_shader) 
-      cso_delete_geometry_shader(st->cso_context, gpv->driver_shader);
-      
+   if (gpv->cached_shader)
+      release_cached_shader(gpv->key.st, gpv->cached_shader);
+
    free(gpv);
 }
 
@@ -299,7 +540,6 @@ st_translate_vertex_program(struct st_context *st,
                             const struct st_vp_variant_key *key)
 {
    struct st_vp_variant *vpv = CALLOC_STRUCT(st_vp_variant);
-   struct pipe_context *pipe = st->pipe;
    struct ureg_program *ureg;
    enum pipe_error error;
    unsigned num_outputs;
@@ -386,7 +626,10 @@ st_translate_vertex_program(struct st_context *st,
                                       &vpv->tgsi.stream_output);
    }
 
-   vpv->driver_shader = pipe->create_vs_state(pipe, &vpv->tgsi);
+   vpv->cached_shader = get_cached_shader(st, TGSI_PROCESSOR_VERTEX,
+                                          &vpv->tgsi);
+   if (vpv->cached_shader)
+      vpv->driver_shader = vpv->cached_shader->driver_shader;
 
    if (ST_DEBUG & DEBUG_TGSI) {
       tgsi_dump( vpv->tgsi.tokens, 0 );
@@ -467,7 +710,6 @@ st_translate_fragment_program(struct st_context *st,
                               struct st_fragment_program *stfp,
                               const struct st_fp_variant_key *key)
 {
-   struct pipe_context *pipe = st->pipe;
    struct st_fp_variant *variant = CALLOC_STRUCT(st_fp_variant);
    GLboolean deleteFP = GL_FALSE;
 
@@ -743,7 +985,10 @@ st_translate_fragment_program(struct st_context *st,
    ureg_destroy( ureg );
 
    /* fill in variant */
-   variant->driver_shader = pipe->create_fs_state(pipe, &variant->tgsi);
+   variant->cached_shader = get_cached_shader(st, TGSI_PROCESSOR_FRAGMENT,
+                                              &variant->tgsi);
+   if (variant->cached_shader)
+      variant->driver_shader = variant->cached_shader->driver_shader;
    variant->key = *key;
 
    if (ST_DEBUG & DEBUG_TGSI) {
@@ -802,7 +1047,6 @@ st_translate_geometry_program(struct st_context *st,
 {
    GLuint inputMapping[GEOM_ATTRIB_MAX];
    GLuint outputMapping[GEOM_RESULT_MAX];
-   struct pipe_context *pipe = st->pipe;
    GLuint attr;
    GLbitfield64 inputsRead;
    GLuint vslot = 0;
@@ -1038,7 +1282,10 @@ st_translate_geometry_program(struct st_context *st,
    }
 
    /* fill in new variant */
-   gpv->driver_shader = pipe->create_gs_state(pipe, &stgp->tgsi);
+   gpv->cached_shader = get_cached_shader(st, TGSI_PROCESSOR_GEOMETRY,
+                                          &stgp->tgsi);
+   if (gpv->cached_shader)
+      gpv->driver_shader = gpv->cached_shader->driver_shader;
    gpv->key = *key;
 
    if ((ST_DEBUG & DEBUG_TGSI) && (ST_DEBUG & DEBUG_MESA)) {
@@ -41,6 +41,9 @@
 #include "st_glsl_to_tgsi.h"
 
 
+struct st_cached_shader;
+
+
 /** Fragment program variant key */
 struct st_fp_variant_key
 {
@@ -73,6 +76,7 @@ struct st_fp_variant
 
    /** Driver's compiled shader */
    void *driver_shader;
+   struct st_cached_shader *cached_shader;  /**< owns driver_shader */
 
    /** For glBitmap variants */
    struct gl_program_parameter_list *parameters;
@@ -126,6 +130,7 @@ struct st_vp_variant
 
    /** Driver's compiled shader */
    void *driver_shader;
+   struct st_cached_shader *cached_shader;  /**< owns driver_shader */
 
    /** For using our private draw module (glRasterPos) */
    struct draw_vertex_shader *draw_shader;
@@ -182,6 +187,7 @@ struct st_gp_variant
    struct st_gp_variant_key key;
 
    void *driver_shader;
+   struct st_cached_shader *cached_shader;  /**< owns driver_shader */
 
    struct st_gp_variant *next;
 };
@@ -314,6 +320,12 @@ st_print_shaders(struct gl_context *ctx);
 extern void
 st_destroy_program_variants(struct st_context *st);
 
+extern void
+st_init_shader_cache(struct st_context *st);
+
+extern void
+st_destroy_shader_cache(struct st_context *st);
+
 
 extern void
 st_print_current_vertex_program(void);
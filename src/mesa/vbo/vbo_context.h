@@ -147,6 +147,42 @@ vbo_draw_method(struct vbo_context *vbo, enum draw_method method)
    }
 }
 
+/**
+ * A run of indices between primitive restart indexes.
+ */
+struct vbo_sub_primitive
+{
+   GLuint start;
+   GLuint count;
+   GLuint min_index;
+   GLuint max_index;
+};
+
+
+void
+vbo_scan_index_bounds(const void *indices, GLuint index_size, GLuint count,
+                      GLboolean restart, GLuint restart_index,
+                      GLuint *min_index, GLuint *max_index);
+
+struct vbo_sub_primitive *
+vbo_find_sub_primitives(const void *elements, unsigned element_size,
+                        unsigned start, unsigned end, unsigned restart_index,
+                        unsigned *num_sub_prims);
+
+struct vbo_sub_primitive *
+vbo_get_cached_sub_primitives(struct gl_context *ctx,
+                              const struct _mesa_index_buffer *ib,
+                              GLuint restart_index,
+                              GLuint *num_sub_prims);
+
+void
+vbo_cache_sub_primitives(struct gl_context *ctx,
+                         const struct _mesa_index_buffer *ib,
+                         GLuint restart_index,
+                         const struct vbo_sub_primitive *sub_prims,
+                         GLuint num_sub_prims);
+
+
 /**
  * Return if format is integer. The immediate mode commands only emit floats
  * for non-integer types, thus everything else is integer.
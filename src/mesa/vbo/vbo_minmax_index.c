@@ -0,0 +1,737 @@
+/*
+ * Mesa 3-D graphics library
+ *
+ * Copyright 2003 Tungsten Graphics, Inc., Cedar Park, Texas.
+ * Copyright 2009 VMware, Inc.
+ * All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL TUNGSTEN GRAPHICS AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * \file vbo_minmax_index.c
+ * Index buffer scanning for glDrawElements() min/max index computation
+ * and software primitive restart.
+ *
+ * Scanning a large index buffer on every draw is expensive, so the results
+ * for index buffers living in buffer objects are cached in the buffer
+ * object itself.  The cache is thrown away whenever the buffer contents
+ * may have changed (gl_buffer_object::MinMaxCacheDirty), and it is never
+ * used for buffers which the GPU may write to behind our back.
+ */
+
+#include "main/glheader.h"
+#include "main/bufferobj.h"
+#include "main/hash_table.h"
+#include "main/macros.h"
+#include "main/mtypes.h"
+#include "main/imports.h"
+#include "../glsl/ralloc.h"
+
+#include "vbo_context.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+
+/**
+ * Limit on the number of cached ranges per buffer object.  Applications
+ * which draw from many different offsets of the same buffer mostly draw
+ * small ranges, for which caching does not pay off anyway.
+ */
+#define VBO_MINMAX_CACHE_MAX_ENTRIES 64
+
+/**
+ * Only cache scans of at least this many indices; smaller ones are
+ * cheaper to redo than to look up.
+ */
+#define VBO_MINMAX_CACHE_MIN_COUNT 64
+
+
+enum vbo_minmax_cache_kind
+{
+   VBO_MINMAX_CACHE_BOUNDS,
+   VBO_MINMAX_CACHE_SUB_PRIMS
+};
+
+struct vbo_minmax_cache_key
+{
+   GLintptr offset;
+   GLuint count;
+   GLuint index_size;
+   GLuint restart_index;
+   GLuint restart;
+   GLuint kind;
+};
+
+struct vbo_minmax_cache_entry
+{
+   struct vbo_minmax_cache_key key;
+   GLuint min_index;
+   GLuint max_index;
+   struct vbo_sub_primitive *sub_prims;
+   GLuint num_sub_prims;
+};
+
+
+static bool
+vbo_minmax_cache_key_equal(const void *a, const void *b)
+{
+   return memcmp(a, b, sizeof(struct vbo_minmax_cache_key)) == 0;
+}
+
+
+static void
+vbo_minmax_cache_key_init(struct vbo_minmax_cache_key *key,
+                          enum vbo_minmax_cache_kind kind,
+                          GLintptr offset, GLuint count, GLuint index_size,
+                          GLboolean restart, GLuint restart_index)
+{
+   /* The key is hashed and compared as raw memory */
+   memset(key, 0, sizeof *key);
+   key->offset = offset;
+   key->count = count;
+   key->index_size = index_size;
+   key->restart = restart;
+   key->restart_index = restart ? restart_index : 0;
+   key->kind = kind;
+}
+
+
+/**
+ * Can the scan results for the given buffer object be cached?
+ */
+static GLboolean
+vbo_minmax_cache_usable(const struct gl_buffer_object *obj, GLuint count)
+{
+   return _mesa_is_bufferobj(obj) &&
+          !obj->MinMaxCacheDisabled &&
+          count >= VBO_MINMAX_CACHE_MIN_COUNT;
+}
+
+
+/**
+ * Look up a cache entry.  Must be called with the buffer mutex held.
+ */
+static struct vbo_minmax_cache_entry *
+vbo_minmax_cache_search(struct gl_buffer_object *obj,
+                        const struct vbo_minmax_cache_key *key,
+                        uint32_t hash)
+{
+   struct hash_entry *entry;
+
+   if (obj->MinMaxCacheDirty) {
+      _mesa_hash_table_destroy(obj->MinMaxCache, NULL);
+      obj->MinMaxCache = NULL;
+      obj->MinMaxCacheDirty = GL_FALSE;
+   }
+
+   if (!obj->MinMaxCache)
+      return NULL;
+
+   entry = _mesa_hash_table_search(obj->MinMaxCache, hash, key);
+   return entry ? (struct vbo_minmax_cache_entry *) entry->data : NULL;
+}
+
+
+/**
+ * Add a new, zeroed cache entry.  Must be called with the buffer mutex
+ * held.  Returns NULL if out of memory.
+ */
+static struct vbo_minmax_cache_entry *
+vbo_minmax_cache_insert(struct gl_buffer_object *obj,
+                        const struct vbo_minmax_cache_key *key,
+                        uint32_t hash)
+{
+   struct vbo_minmax_cache_entry *entry;
+
+   if (obj->MinMaxCacheDirty ||
+       (obj->MinMaxCache &&
+        obj->MinMaxCache->entries >= VBO_MINMAX_CACHE_MAX_ENTRIES)) {
+      _mesa_hash_table_destroy(obj->MinMaxCache, NULL);
+      obj->MinMaxCache = NULL;
+      obj->MinMaxCacheDirty = GL_FALSE;
+   }
+
+   if (!obj->MinMaxCache) {
+      obj->MinMaxCache = _mesa_hash_table_create(NULL,
+                                                 vbo_minmax_cache_key_equal);
+      if (!obj->MinMaxCache)
+         return NULL;
+   }
+
+   entry = rzalloc(obj->MinMaxCache, struct vbo_minmax_cache_entry);
+   if (!entry)
+      return NULL;
+
+   entry->key = *key;
+   _mesa_hash_table_insert(obj->MinMaxCache, hash, &entry->key, entry);
+
+   return entry;
+}
+
+
+/*
+ * Scanning functions.
+ *
+ * Restart indexes are ignored when computing the bounds.  If all indices
+ * are restart indexes the bounds are left at min = ~0, max = 0.
+ */
+
+#define SCAN_SCALAR(TYPE)                                               \
+   do {                                                                 \
+      const TYPE *elts = (const TYPE *) indices;                        \
+      for (; i < count; i++) {                                          \
+         const GLuint index = elts[i];                                  \
+         if (!restart || index != restart_index) {                      \
+            min = MIN2(min, index);                                     \
+            max = MAX2(max, index);                                     \
+         }                                                              \
+      }                                                                 \
+   } while (0)
+
+
+static void
+scan_ubyte(const void *indices, GLuint count,
+           GLboolean restart, GLuint restart_index,
+           GLuint *min_index, GLuint *max_index)
+{
+   GLuint min = ~0U, max = 0;
+   GLuint i = 0;
+
+   /* A restart index which doesn't fit never matches */
+   if (restart_index > 0xff)
+      restart = GL_FALSE;
+
+#ifdef __SSE2__
+   if (count >= 16) {
+      const GLubyte *elts = (const GLubyte *) indices;
+      const __m128i vrestart = _mm_set1_epi8((char) restart_index);
+      __m128i vmin = _mm_set1_epi8((char) 0xff);
+      __m128i vmax = _mm_setzero_si128();
+      __m128i vvalid = _mm_setzero_si128();
+      GLubyte tmp_min[16], tmp_max[16], tmp_valid[16];
+      unsigned j;
+
+      for (; i + 16 <= count; i += 16) {
+         __m128i v = _mm_loadu_si128((const __m128i *) &elts[i]);
+         if (restart) {
+            __m128i is_restart = _mm_cmpeq_epi8(v, vrestart);
+            vmin = _mm_min_epu8(vmin, _mm_or_si128(v, is_restart));
+            vmax = _mm_max_epu8(vmax, _mm_andnot_si128(is_restart, v));
+            vvalid = _mm_or_si128(vvalid,
+                                  _mm_andnot_si128(is_restart,
+                                                   _mm_set1_epi8((char) 0xff)));
+         }
+         else {
+            vmin = _mm_min_epu8(vmin, v);
+            vmax = _mm_max_epu8(vmax, v);
+            vvalid = _mm_set1_epi8((char) 0xff);
+         }
+      }
+
+      _mm_storeu_si128((__m128i *) tmp_min, vmin);
+      _mm_storeu_si128((__m128i *) tmp_max, vmax);
+      _mm_storeu_si128((__m128i *) tmp_valid, vvalid);
+      for (j = 0; j < 16; j++) {
+         if (tmp_valid[j]) {
+            min = MIN2(min, tmp_min[j]);
+            max = MAX2(max, tmp_max[j]);
+         }
+      }
+   }
+#endif
+
+   SCAN_SCALAR(GLubyte);
+
+   *min_index = min;
+   *max_index = max;
+}
+
+
+static void
+scan_ushort(const void *indices, GLuint count,
+            GLboolean restart, GLuint restart_index,
+            GLuint *min_index, GLuint *max_index)
+{
+   GLuint min = ~0U, max = 0;
+   GLuint i = 0;
+
+   if (restart_index > 0xffff)
+      restart = GL_FALSE;
+
+#ifdef __SSE2__
+   if (count >= 8) {
+      /* SSE2 only has signed 16-bit min/max, so bias the values into the
+       * signed range first.
+       */
+      const GLushort *elts = (const GLushort *) indices;
+      const __m128i vbias = _mm_set1_epi16((short) 0x8000);
+      const __m128i vrestart = _mm_set1_epi16((short) restart_index);
+      __m128i vmin = _mm_set1_epi16(0x7fff);
+      __m128i vmax = _mm_set1_epi16((short) 0x8000);
+      __m128i vvalid = _mm_setzero_si128();
+      GLushort tmp_min[8], tmp_max[8], tmp_valid[8];
+      unsigned j;
+
+      for (; i + 8 <= count; i += 8) {
+         __m128i v = _mm_loadu_si128((const __m128i *) &elts[i]);
+         if (restart) {
+            __m128i is_restart = _mm_cmpeq_epi16(v, vrestart);
+            vmin = _mm_min_epi16(vmin,
+                                 _mm_xor_si128(_mm_or_si128(v, is_restart),
+                                               vbias));
+            vmax = _mm_max_epi16(vmax,
+                                 _mm_xor_si128(_mm_andnot_si128(is_restart, v),
+                                               vbias));
+            vvalid = _mm_or_si128(vvalid,
+                                  _mm_andnot_si128(is_restart,
+                                                   _mm_set1_epi16(-1)));
+         }
+         else {
+            v = _mm_xor_si128(v, vbias);
+            vmin = _mm_min_epi16(vmin, v);
+            vmax = _mm_max_epi16(vmax, v);
+            vvalid = _mm_set1_epi16(-1);
+         }
+      }
+
+      _mm_storeu_si128((__m128i *) tmp_min, _mm_xor_si128(vmin, vbias));
+      _mm_storeu_si128((__m128i *) tmp_max, _mm_xor_si128(vmax, vbias));
+      _mm_storeu_si128((__m128i *) tmp_valid, vvalid);
+      for (j = 0; j < 8; j++) {
+         if (tmp_valid[j]) {
+            min = MIN2(min, tmp_min[j]);
+            max = MAX2(max, tmp_max[j]);
+         }
+      }
+   }
+#endif
+
+   SCAN_SCALAR(GLushort);
+
+   *min_index = min;
+   *max_index = max;
+}
+
+
+static void
+scan_uint(const void *indices, GLuint count,
+          GLboolean restart, GLuint restart_index,
+          GLuint *min_index, GLuint *max_index)
+{
+   GLuint min = ~0U, max = 0;
+   GLuint i = 0;
+
+#ifdef __SSE2__
+   if (count >= 4) {
+      /* SSE2 has neither 32-bit min/max nor unsigned compares, so bias the
+       * values into the signed range and select with signed compares.
+       */
+      const GLuint *elts = (const GLuint *) indices;
+      const __m128i vbias = _mm_set1_epi32((int) 0x80000000);
+      const __m128i vrestart = _mm_set1_epi32((int) restart_index);
+      __m128i vmin = _mm_set1_epi32(0x7fffffff);
+      __m128i vmax = _mm_set1_epi32((int) 0x80000000);
+      __m128i vvalid = _mm_setzero_si128();
+      GLuint tmp_min[4], tmp_max[4], tmp_valid[4];
+      unsigned j;
+
+      for (; i + 4 <= count; i += 4) {
+         __m128i v = _mm_loadu_si128((const __m128i *) &elts[i]);
+         __m128i vlo, vhi, lt, gt;
+         if (restart) {
+            __m128i is_restart = _mm_cmpeq_epi32(v, vrestart);
+            vlo = _mm_xor_si128(_mm_or_si128(v, is_restart), vbias);
+            vhi = _mm_xor_si128(_mm_andnot_si128(is_restart, v), vbias);
+            vvalid = _mm_or_si128(vvalid,
+                                  _mm_andnot_si128(is_restart,
+                                                   _mm_set1_epi32(-1)));
+         }
+         else {
+            vlo = vhi = _mm_xor_si128(v, vbias);
+            vvalid = _mm_set1_epi32(-1);
+         }
+         lt = _mm_cmplt_epi32(vlo, vmin);
+         vmin = _mm_or_si128(_mm_and_si128(lt, vlo),
+                             _mm_andnot_si128(lt, vmin));
+         gt = _mm_cmpgt_epi32(vhi, vmax);
+         vmax = _mm_or_si128(_mm_and_si128(gt, vhi),
+                             _mm_andnot_si128(gt, vmax));
+      }
+
+      _mm_storeu_si128((__m128i *) tmp_min, _mm_xor_si128(vmin, vbias));
+      _mm_storeu_si128((__m128i *) tmp_max, _mm_xor_si128(vmax, vbias));
+      _mm_storeu_si128((__m128i *) tmp_valid, vvalid);
+      for (j = 0; j < 4; j++) {
+         if (tmp_valid[j]) {
+            min = MIN2(min, tmp_min[j]);
+            max = MAX2(max, tmp_max[j]);
+         }
+      }
+   }
+#endif
+
+   SCAN_SCALAR(GLuint);
+
+   *min_index = min;
+   *max_index = max;
+}
+
+#undef SCAN_SCALAR
+
+
+/**
+ * Compute the min and max of \p count indices of \p index_size bytes,
+ * ignoring \p restart_index if \p restart is set.
+ */
+void
+vbo_scan_index_bounds(const void *indices, GLuint index_size, GLuint count,
+                      GLboolean restart, GLuint restart_index,
+                      GLuint *min_index, GLuint *max_index)
+{
+   switch (index_size) {
+   case 4:
+      scan_uint(indices, count, restart, restart_index, min_index, max_index);
+      break;
+   case 2:
+      scan_ushort(indices, count, restart, restart_index, min_index, max_index);
+      break;
+   case 1:
+      scan_ubyte(indices, count, restart, restart_index, min_index, max_index);
+      break;
+   default:
+      assert(0);
+      *min_index = ~0U;
+      *max_index = 0;
+      break;
+   }
+}
+
+
+/**
+ * Return the position of the first restart index in [start, end), or
+ * \p end if there is none.
+ */
+static GLuint
+find_restart_index(const void *indices, GLuint index_size,
+                   GLuint start, GLuint end, GLuint restart_index)
+{
+   GLuint i = start;
+
+   switch (index_size) {
+   case 4: {
+      const GLuint *elts = (const GLuint *) indices;
+#ifdef __SSE2__
+      const __m128i vrestart = _mm_set1_epi32((int) restart_index);
+      for (; i + 4 <= end; i += 4) {
+         __m128i v = _mm_loadu_si128((const __m128i *) &elts[i]);
+         if (_mm_movemask_epi8(_mm_cmpeq_epi32(v, vrestart)))
+            break;
+      }
+#endif
+      for (; i < end; i++)
+         if (elts[i] == restart_index)
+            break;
+      return i;
+   }
+   case 2: {
+      const GLushort *elts = (const GLushort *) indices;
+      if (restart_index > 0xffff)
+         return end;
+#ifdef __SSE2__
+      {
+         const __m128i vrestart = _mm_set1_epi16((short) restart_index);
+         for (; i + 8 <= end; i += 8) {
+            __m128i v = _mm_loadu_si128((const __m128i *) &elts[i]);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(v, vrestart)))
+               break;
+         }
+      }
+#endif
+      for (; i < end; i++)
+         if (elts[i] == restart_index)
+            break;
+      return i;
+   }
+   case 1: {
+      const GLubyte *elts = (const GLubyte *) indices;
+      if (restart_index > 0xff)
+         return end;
+#ifdef __SSE2__
+      {
+         const __m128i vrestart = _mm_set1_epi8((char) restart_index);
+         for (; i + 16 <= end; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *) &elts[i]);
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, vrestart)))
+               break;
+         }
+      }
+#endif
+      for (; i < end; i++)
+         if (elts[i] == restart_index)
+            break;
+      return i;
+   }
+   default:
+      assert(0 && "bad index_size in find_restart_index()");
+      return end;
+   }
+}
+
+
+/**
+ * Scan the elements array to find restart indexes.  Return an array
+ * of struct vbo_sub_primitive to indicate how to draw the sub-primitives
+ * are delineated by the restart index.  The array must be freed with free().
+ */
+struct vbo_sub_primitive *
+vbo_find_sub_primitives(const void *elements, unsigned element_size,
+                        unsigned start, unsigned end, unsigned restart_index,
+                        unsigned *num_sub_prims)
+{
+   const unsigned max_prims = end - start;
+   struct vbo_sub_primitive *sub_prims;
+   unsigned cur_start, cur_end;
+   unsigned scan_num = 0;
+
+   sub_prims = malloc(MAX2(max_prims, 1) * sizeof(struct vbo_sub_primitive));
+
+   if (!sub_prims) {
+      *num_sub_prims = 0;
+      return NULL;
+   }
+
+   for (cur_start = start; cur_start < end; cur_start = cur_end + 1) {
+      cur_end = find_restart_index(elements, element_size,
+                                   cur_start, end, restart_index);
+      if (cur_end > cur_start) {
+         const void *sub_elements =
+            (const GLubyte *) elements + cur_start * element_size;
+         assert(scan_num < max_prims);
+         sub_prims[scan_num].start = cur_start;
+         sub_prims[scan_num].count = cur_end - cur_start;
+         vbo_scan_index_bounds(sub_elements, element_size, cur_end - cur_start,
+                               GL_FALSE, 0,
+                               &sub_prims[scan_num].min_index,
+                               &sub_prims[scan_num].max_index);
+         scan_num++;
+      }
+   }
+
+   *num_sub_prims = scan_num;
+
+   return sub_prims;
+}
+
+
+/**
+ * Return a copy of the cached sub-primitives for the given index buffer,
+ * or NULL if they are not cached.  The copy must be freed with free().
+ */
+struct vbo_sub_primitive *
+vbo_get_cached_sub_primitives(struct gl_context *ctx,
+                              const struct _mesa_index_buffer *ib,
+                              GLuint restart_index,
+                              GLuint *num_sub_prims)
+{
+   struct gl_buffer_object *obj = ib->obj;
+   struct vbo_minmax_cache_key key;
+   struct vbo_minmax_cache_entry *entry;
+   struct vbo_sub_primitive *sub_prims = NULL;
+   uint32_t hash;
+
+   (void) ctx;
+
+   if (!vbo_minmax_cache_usable(obj, ib->count))
+      return NULL;
+
+   vbo_minmax_cache_key_init(&key, VBO_MINMAX_CACHE_SUB_PRIMS,
+                             (GLintptr) ib->ptr, ib->count,
+                             vbo_sizeof_ib_type(ib->type),
+                             GL_TRUE, restart_index);
+   hash = _mesa_hash_data(&key, sizeof key);
+
+   _glthread_LOCK_MUTEX(obj->Mutex);
+   entry = vbo_minmax_cache_search(obj, &key, hash);
+   if (entry) {
+      sub_prims = malloc(MAX2(entry->num_sub_prims, 1) *
+                         sizeof(struct vbo_sub_primitive));
+      if (sub_prims) {
+         memcpy(sub_prims, entry->sub_prims,
+                entry->num_sub_prims * sizeof(struct vbo_sub_primitive));
+         *num_sub_prims = entry->num_sub_prims;
+      }
+   }
+   _glthread_UNLOCK_MUTEX(obj->Mutex);
+
+   return sub_prims;
+}
+
+
+/**
+ * Remember the sub-primitives found by vbo_find_sub_primitives() for the
+ * given index buffer.
+ */
+void
+vbo_cache_sub_primitives(struct gl_context *ctx,
+                         const struct _mesa_index_buffer *ib,
+                         GLuint restart_index,
+                         const struct vbo_sub_primitive *sub_prims,
+                         GLuint num_sub_prims)
+{
+   struct gl_buffer_object *obj = ib->obj;
+   struct vbo_minmax_cache_key key;
+   struct vbo_minmax_cache_entry *entry;
+   uint32_t hash;
+
+   (void) ctx;
+
+   if (!sub_prims || !vbo_minmax_cache_usable(obj, ib->count))
+      return;
+
+   vbo_minmax_cache_key_init(&key, VBO_MINMAX_CACHE_SUB_PRIMS,
+                             (GLintptr) ib->ptr, ib->count,
+                             vbo_sizeof_ib_type(ib->type),
+                             GL_TRUE, restart_index);
+   hash = _mesa_hash_data(&key, sizeof key);
+
+   _glthread_LOCK_MUTEX(obj->Mutex);
+   entry = vbo_minmax_cache_insert(obj, &key, hash);
+   if (entry) {
+      entry->sub_prims = ralloc_array(entry, struct vbo_sub_primitive,
+                                      MAX2(num_sub_prims, 1));
+      if (entry->sub_prims) {
+         memcpy(entry->sub_prims, sub_prims,
+                num_sub_prims * sizeof(struct vbo_sub_primitive));
+         entry->num_sub_prims = num_sub_prims;
+      }
+      else {
+         /* Out of memory, start over on the next lookup */
+         obj->MinMaxCacheDirty = GL_TRUE;
+      }
+   }
+   _glthread_UNLOCK_MUTEX(obj->Mutex);
+}
+
+
+/**
+ * Compute min and max elements by scanning the index buffer for
+ * glDraw[Range]Elements() calls.
+ * If primitive restart is enabled, we need to ignore restart
+ * indexes when computing min/max.
+ */
+static void
+vbo_get_minmax_index(struct gl_context *ctx,
+		     const struct _mesa_prim *prim,
+		     const struct _mesa_index_buffer *ib,
+		     GLuint *min_index, GLuint *max_index,
+		     const GLuint count)
+{
+   const GLboolean restart = ctx->Array._PrimitiveRestart;
+   const GLuint restartIndex = ctx->Array._RestartIndex;
+   const int index_size = vbo_sizeof_ib_type(ib->type);
+   const GLboolean use_cache = vbo_minmax_cache_usable(ib->obj, count);
+   struct vbo_minmax_cache_key key;
+   struct vbo_minmax_cache_entry *entry;
+   uint32_t hash = 0;
+   const char *indices;
+
+   indices = (char *) ib->ptr + prim->start * index_size;
+
+   if (use_cache) {
+      vbo_minmax_cache_key_init(&key, VBO_MINMAX_CACHE_BOUNDS,
+                                (GLintptr) indices, count, index_size,
+                                restart, restartIndex);
+      hash = _mesa_hash_data(&key, sizeof key);
+
+      _glthread_LOCK_MUTEX(ib->obj->Mutex);
+      entry = vbo_minmax_cache_search(ib->obj, &key, hash);
+      if (entry) {
+         *min_index = entry->min_index;
+         *max_index = entry->max_index;
+      }
+      _glthread_UNLOCK_MUTEX(ib->obj->Mutex);
+
+      if (entry)
+         return;
+   }
+
+   if (_mesa_is_bufferobj(ib->obj)) {
+      GLsizeiptr size = MIN2(count * index_size, ib->obj->Size);
+      indices = ctx->Driver.MapBufferRange(ctx, (GLintptr) indices, size,
+                                           GL_MAP_READ_BIT, ib->obj);
+   }
+
+   vbo_scan_index_bounds(indices, index_size, count, restart, restartIndex,
+                         min_index, max_index);
+
+   if (_mesa_is_bufferobj(ib->obj)) {
+      ctx->Driver.UnmapBuffer(ctx, ib->obj);
+   }
+
+   if (use_cache) {
+      _glthread_LOCK_MUTEX(ib->obj->Mutex);
+      entry = vbo_minmax_cache_insert(ib->obj, &key, hash);
+      if (entry) {
+         entry->min_index = *min_index;
+         entry->max_index = *max_index;
+      }
+      _glthread_UNLOCK_MUTEX(ib->obj->Mutex);
+   }
+}
+
+
+/**
+ * Compute min and max elements for nr_prims
+ */
+void
+vbo_get_minmax_indices(struct gl_context *ctx,
+                       const struct _mesa_prim *prims,
+                       const struct _mesa_index_buffer *ib,
+                       GLuint *min_index,
+                       GLuint *max_index,
+                       GLuint nr_prims)
+{
+   GLuint tmp_min, tmp_max;
+   GLuint i;
+   GLuint count;
+
+   *min_index = ~0;
+   *max_index = 0;
+
+   for (i = 0; i < nr_prims; i++) {
+      const struct _mesa_prim *start_prim;
+
+      start_prim = &prims[i];
+      count = start_prim->count;
+      /* Do combination if possible to reduce map/unmap count */
+      while ((i + 1 < nr_prims) &&
+             (prims[i].start + prims[i].count == prims[i+1].start)) {
+         count += prims[i+1].count;
+         i++;
+      }
+      vbo_get_minmax_index(ctx, start_prim, ib, &tmp_min, &tmp_max, count);
+      *min_index = MIN2(*min_index, tmp_min);
+      *max_index = MAX2(*max_index, tmp_max);
+   }
+}
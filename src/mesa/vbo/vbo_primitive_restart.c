@@ -35,9 +35,6 @@
 #include "vbo.h"
 #include "vbo_context.h"
 
-#define UPDATE_MIN2(a, b) (a) = MIN2((a), (b))
-#define UPDATE_MAX2(a, b) (a) = MAX2((a), (b))
-
 /*
  * Notes on primitive restart:
  * The code below is used when the driver does not support primitive
@@ -45,15 +42,15 @@
  *
  * We map the index buffer, find the restart indexes, unmap
  * the index buffer then draw the sub-primitives delineated by the restarts.
+ * For index buffers in buffer objects the list of sub-primitives is cached
+ * in the buffer object (see vbo_minmax_index.c), so that it's only rebuilt
+ * when the buffer contents change.
  *
- * A couple possible optimizations:
- * 1. Save the list of sub-primitive (start, count) values in a list attached
- *    to the index buffer for re-use in subsequent draws.  The list would be
- *    invalidated when the contents of the buffer changed.
- * 2. If drawing triangle strips or quad strips, create a new index buffer
- *    that uses duplicated vertices to render the disjoint strips as one
- *    long strip.  We'd have to be careful to avoid using too much memory
- *    for this.
+ * A possible optimization:
+ * If drawing triangle strips or quad strips, create a new index buffer
+ * that uses duplicated vertices to render the disjoint strips as one
+ * long strip.  We'd have to be careful to avoid using too much memory
+ * for this.
  *
  * Finally, some apps might perform better if they don't use primitive restart
  * at all rather than this fallback path.  Set MESA_EXTENSION_OVERRIDE to
@@ -61,97 +58,6 @@
  */
 
 
-struct sub_primitive
-{
-   GLuint start;
-   GLuint count;
-   GLuint min_index;
-   GLuint max_index;
-};
-
-
-/**
- * Scan the elements array to find restart indexes.  Return an array
- * of struct sub_primitive to indicate how to draw the sub-primitives
- * are delineated by the restart index.
- */
-static struct sub_primitive *
-find_sub_primitives(const void *elements, unsigned element_size,
-                    unsigned start, unsigned end, unsigned restart_index,
-                    unsigned *num_sub_prims)
-{
-   const unsigned max_prims = end - start;
-   struct sub_primitive *sub_prims;
-   unsigned i, cur_start, cur_count;
-   GLuint scan_index;
-   unsigned scan_num;
-
-   sub_prims =
-      malloc(max_prims * sizeof(struct sub_primitive));
-
-   if (!sub_prims) {
-      *num_sub_prims = 0;
-      return NULL;
-   }
-
-   cur_start = start;
-   cur_count = 0;
-   scan_num = 0;
-
-#define IB_INDEX_READ(TYPE, INDEX) (((const GL##TYPE *) elements)[INDEX])
-
-#define SCAN_ELEMENTS(TYPE) \
-   sub_prims[scan_num].min_index = (GL##TYPE) 0xffffffff; \
-   sub_prims[scan_num].max_index = 0; \
-   for (i = start; i < end; i++) { \
-      scan_index = IB_INDEX_READ(TYPE, i); \
-      if (scan_index == restart_index) { \
-         if (cur_count > 0) { \
-            assert(scan_num < max_prims); \
-            sub_prims[scan_num].start = cur_start; \
-            sub_prims[scan_num].count = cur_count; \
-            scan_num++; \
-            sub_prims[scan_num].min_index = (GL##TYPE) 0xffffffff; \
-            sub_prims[scan_num].max_index = 0; \
-         } \
-         cur_start = i + 1; \
-         cur_count = 0; \
-      } \
-      else { \
-         UPDATE_MIN2(sub_prims[scan_num].min_index, scan_index); \
-         UPDATE_MAX2(sub_prims[scan_num].max_index, scan_index); \
-         cur_count++; \
-      } \
-   } \
-   if (cur_count > 0) { \
-      assert(scan_num < max_prims); \
-      sub_prims[scan_num].start = cur_start; \
-      sub_prims[scan_num].count = cur_count; \
-      scan_num++; \
-   }
-
-   switch (element_size) {
-   case 1:
-      SCAN_ELEMENTS(ubyte);
-      break;
-   case 2:
-      SCAN_ELEMENTS(ushort);
-      break;
-   case 4:
-      SCAN_ELEMENTS(uint);
-      break;
-   default:
-      assert(0 && "bad index_size in find_sub_primitives()");
-   }
-
-#undef SCAN_ELEMENTS
-
-   *num_sub_prims = scan_num;
-
-   return sub_prims;
-}
-
-
 /**
  * Handle primitive restart in software.
  *
@@ -165,8 +71,8 @@ vbo_sw_primitive_restart(struct gl_context *ctx,
                          const struct _mesa_index_buffer *ib)
 {
    GLuint prim_num;
-   struct sub_primitive *sub_prims;
-   struct sub_primitive *sub_prim;
+   struct vbo_sub_primitive *sub_prims;
+   struct vbo_sub_primitive *sub_prim;
    GLuint num_sub_prims;
    GLuint sub_prim_num;
    GLuint end_index;
@@ -181,19 +87,26 @@ vbo_sw_primitive_restart(struct gl_context *ctx,
    /* Find the sub-primitives. These are regions in the index buffer which
     * are split based on the primitive restart index value.
     */
-   if (map_ib) {
-      ctx->Driver.MapBufferRange(ctx, 0, ib->obj->Size, GL_MAP_READ_BIT,
-                                 ib->obj);
-   }
+   sub_prims = vbo_get_cached_sub_primitives(ctx, ib, restart_index,
+                                             &num_sub_prims);
+   if (!sub_prims) {
+      if (map_ib) {
+         ctx->Driver.MapBufferRange(ctx, 0, ib->obj->Size, GL_MAP_READ_BIT,
+                                    ib->obj);
+      }
+
+      ptr = ADD_POINTERS(ib->obj->Pointer, ib->ptr);
 
-   ptr = ADD_POINTERS(ib->obj->Pointer, ib->ptr);
+      sub_prims = vbo_find_sub_primitives(ptr, vbo_sizeof_ib_type(ib->type),
+                                          0, ib->count, restart_index,
+                                          &num_sub_prims);
 
-   sub_prims = find_sub_primitives(ptr, vbo_sizeof_ib_type(ib->type),
-                                   0, ib->count, restart_index,
-                                   &num_sub_prims);
+      if (map_ib) {
+         ctx->Driver.UnmapBuffer(ctx, ib->obj);
+      }
 
-   if (map_ib) {
-      ctx->Driver.UnmapBuffer(ctx, ib->obj);
+      vbo_cache_sub_primitives(ctx, ib, restart_index,
+                               sub_prims, num_sub_prims);
    }
 
    /* Loop over the primitives, and use the located sub-primitives to draw
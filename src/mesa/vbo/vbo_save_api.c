@@ -301,9 +301,60 @@ _save_reset_counters(struct gl_context *ctx)
    save->dangling_attr_ref = 0;
 }
 
+/**
+ * Return the number of vertices per primitive for modes whose primitives
+ * are independent of each other, or 0 for the others.
+ */
+static GLuint
+vbo_independent_prim_size(GLenum mode)
+{
+   switch (mode) {
+   case GL_POINTS:
+      return 1;
+   case GL_LINES:
+      return 2;
+   case GL_TRIANGLES:
+      return 3;
+   case GL_QUADS:
+      return 4;
+   default:
+      return 0;
+   }
+}
+
+/**
+ * Can \p this_prim be drawn as part of \p prev_prim?  That's the case when
+ * both draw independent primitives of the same kind from consecutive
+ * vertices, so that the vertices of the second just continue the first.
+ */
+static GLboolean
+vbo_can_merge_prims(const struct _mesa_prim *prev_prim,
+                    const struct _mesa_prim *this_prim)
+{
+   GLuint size;
+
+   if (this_prim->mode != prev_prim->mode ||
+       this_prim->indexed != prev_prim->indexed ||
+       this_prim->weak != prev_prim->weak ||
+       this_prim->start != prev_prim->start + prev_prim->count ||
+       this_prim->basevertex != prev_prim->basevertex ||
+       this_prim->num_instances != prev_prim->num_instances ||
+       this_prim->base_instance != prev_prim->base_instance)
+      return GL_FALSE;
+
+   size = vbo_independent_prim_size(this_prim->mode);
+
+   return size != 0 &&
+          this_prim->count % size == 0 &&
+          prev_prim->count % size == 0;
+}
+
 /**
  * For a list of prims, try merging prims that can just be extensions of the
  * previous prim.
+ *
+ * Applications drawing with many small glBegin/glEnd pairs get a single
+ * draw for each run of points, lines, triangles or quads this way.
  */
 static void
 vbo_merge_prims(struct gl_context *ctx,
@@ -316,14 +367,7 @@ vbo_merge_prims(struct gl_context *ctx,
    for (i = 1; i < *prim_count; i++) {
       struct _mesa_prim *this_prim = prim_list + i;
 
-      if (this_prim->mode == prev_prim->mode &&
-          this_prim->mode == GL_QUADS &&
-          this_prim->count % 4 == 0 &&
-          prev_prim->count % 4 == 0 &&
-          this_prim->start == prev_prim->start + prev_prim->count &&
-          this_prim->basevertex == prev_prim->basevertex &&
-          this_prim->num_instances == prev_prim->num_instances &&
-          this_prim->base_instance == prev_prim->base_instance) {
+      if (vbo_can_merge_prims(prev_prim, this_prim)) {
          /* We've found a prim that just extend the previous one.  Tack it
           * onto the previous one, and let this primitive struct get dropped.
           */
@@ -981,6 +1025,13 @@ _save_End(void)
       assert(save->copied.nr == 0);
    }
 
+   /* Keep the list's view of the current attributes up to date while this
+    * vertex list is still open.  This lets dlist.c drop attribute and
+    * material changes that don't change anything, instead of splitting the
+    * vertex list for them.
+    */
+   _save_copy_to_current(ctx);
+
    /* Swap out this vertex format while outside begin/end.  Any color,
     * etc. received between here and the next begin will be compiled
     * as opcodes.